@@ -0,0 +1,109 @@
+#ifndef COMPACT_VERTEX_HOST_DEVICE
+#define COMPACT_VERTEX_HOST_DEVICE
+
+// this little "hack" is needed for using it on the
+// CPU side as well for the GPU side :)
+// inspired by the NVDIDIA tutorial:
+// https://nvpro-samples.github.io/vk_raytracing_tutorial_KHR/
+
+#ifdef __cplusplus
+#include <cstdint>
+
+#include <glm/glm.hpp>
+// GLSL Type
+using vec2 = glm::vec2;
+using vec3 = glm::vec3;
+using vec4 = glm::vec4;
+using uint = unsigned int;
+#endif
+
+// vertex layouts a vertex buffer can be in (ObjectDescription::vertex_format)
+#define VERTEX_FORMAT_FULL 0
+#define VERTEX_FORMAT_COMPACT 1
+// compact, position.w carries an RGB565 vertex color
+#define VERTEX_FORMAT_COMPACT_COLOR 2
+
+// 16 instead of 44 bytes per vertex:
+//  - position: 3 x snorm16 relative to the mesh bounds, the 4th lane is the RGB565 color (or 0)
+//  - normal: octahedral encoding, 2 x snorm16
+//  - texture_coords: 2 x half float
+// the position lanes are the first 8 bytes so they can be used as
+// VK_FORMAT_R16G16B16A16_SNORM for acceleration structure builds
+#ifdef __cplusplus
+struct CompactVertex
+{
+    int16_t position[4];
+    uint32_t normal;
+    uint32_t texture_coords;
+};
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex must stay tightly packed!");
+#else
+struct CompactVertex
+{
+    uint position_xy;
+    uint position_z_color;
+    uint normal;
+    uint texture_coords;
+};
+#endif
+
+// position = position_offset + position_scale * snorm position;
+// position_scale.w is 1 if the 4th position lane carries an RGB565 color, 0 otherwise
+struct VertexQuantization
+{
+    vec4 position_offset;
+    vec4 position_scale;
+};
+
+#ifndef __cplusplus
+vec3 decodeOctahedralNormal(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) { n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0); }
+    return normalize(n);
+}
+
+vec3 decodeRGB565(uint bits)
+{
+    return vec3(float((bits >> 11) & 31u) / 31.0, float((bits >> 5) & 63u) / 63.0, float(bits & 31u) / 31.0);
+}
+
+// -- fetches through the vertex buffer address of an ObjectDescription
+vec3 decodeCompactPosition(CompactVertex v, VertexQuantization quantization)
+{
+    vec3 snorm = vec3(unpackSnorm2x16(v.position_xy), unpackSnorm2x16(v.position_z_color).x);
+    return quantization.position_offset.xyz + quantization.position_scale.xyz * snorm;
+}
+
+vec3 decodeCompactNormal(CompactVertex v) { return decodeOctahedralNormal(unpackSnorm2x16(v.normal)); }
+
+vec2 decodeCompactTextureCoords(CompactVertex v) { return unpackHalf2x16(v.texture_coords); }
+
+// -1 is the "no vertex color" value of the full layout as well
+vec3 decodeCompactColor(CompactVertex v, uint vertex_format)
+{
+    if (vertex_format != VERTEX_FORMAT_COMPACT_COLOR) { return vec3(-1.0); }
+    return decodeRGB565(v.position_z_color >> 16);
+}
+
+#ifdef COMPACT_VERTICES
+// -- vertex attributes: the rasterizer compiles shader.vert with COMPACT_VERTICES if
+// sceneConfig::getCompactVertices() is set. Its inputs then are the ones of
+// vertex::getCompactVertexInputAttributeDesc (vec4 position, vec2 normal, uint color, vec2
+// texture_coords) and PushConstantRasterizer holds the quantization of the drawn meshes
+vec3 decodeCompactAttributePosition(vec4 position, VertexQuantization quantization)
+{
+    return quantization.position_offset.xyz + quantization.position_scale.xyz * position.xyz;
+}
+
+vec3 decodeCompactAttributeNormal(vec2 normal) { return decodeOctahedralNormal(normal); }
+
+vec3 decodeCompactAttributeColor(uint color, VertexQuantization quantization)
+{
+    if (quantization.position_scale.w == 0.0) { return vec3(-1.0); }
+    return decodeRGB565(color);
+}
+#endif
+#endif
+
+#endif
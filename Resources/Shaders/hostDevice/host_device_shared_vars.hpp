@@ -1,12 +1,23 @@
 #ifndef HOST_DEVICE_SHARED_VARS
 #define HOST_DEVICE_SHARED_VARS
 
+// size of the texture and sampler arrays the shaders declare; it also bounds the bindless texture
+// table, which may only grow beyond it once the shaders declare runtime arrays indexed with
+// nonuniformEXT(texture_id)
 #if NDEBUG
 const int MAX_TEXTURE_COUNT = 24;
 #else
 const int MAX_TEXTURE_COUNT = 1;
 #endif
 
+// ObjectDescription.material_index_address points at the material ids of the mesh, indexed by the
+// triangle's position in the mesh, but gl_PrimitiveID restarts at 0 for every draw. Every rasterizer
+// draw (submesh, LOD level or meshlet) therefore passes the index of its first triangle within the
+// mesh as firstInstance. The scene vertex shader has to forward gl_InstanceIndex as a flat output
+// and the fragment shader has to look the material up with MESH_TRIANGLE_ID(that output); the ray
+// tracing shaders get the same index from ObjectDescription.submesh_address
+#define MESH_TRIANGLE_ID(first_triangle) ((first_triangle) + uint(gl_PrimitiveID))
+
 // ----- MAIN RENDER DESCRIPTOR SET ----- START (shared between rasterizer and
 // raytracer)
 #define globalUBO_BINDING 0
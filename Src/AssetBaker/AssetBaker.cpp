@@ -0,0 +1,118 @@
+#include "AssetBaker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <thread>
+
+#include "spdlog/spdlog.h"
+
+using namespace Kataglyphis;
+
+namespace {
+
+bool isImageFile(const std::filesystem::path &file)
+{
+    std::string extension = file.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga"
+           || extension == ".bmp";
+}
+
+}// namespace
+
+AssetBaker::AssetBaker(AssetBakerSettings settings) { this->settings = settings; }
+
+AssetBakeStats AssetBaker::bake(const std::string &directory) const
+{
+    AssetBakeStats stats{};
+    const std::vector<BakeJob> jobs = collectJobs(directory);
+    if (jobs.empty()) return stats;
+
+    std::vector<BakeResult> results(jobs.size(), BakeResult::Failed);
+    std::atomic<size_t> next_job{ 0 };
+    auto work = [&]() {
+        for (size_t i = next_job.fetch_add(1); i < jobs.size(); i = next_job.fetch_add(1)) {
+            results[i] = jobs[i].is_mesh ? bakeMesh(jobs[i].source) : bakeTexture(jobs[i].source);
+        }
+    };
+
+    const uint32_t thread_count = resolveThreadCount(jobs.size());
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count);
+    for (uint32_t t = 0; t < thread_count; t++) workers.emplace_back(work);
+    for (auto &worker : workers) worker.join();
+
+    for (BakeResult result : results) {
+        if (result == BakeResult::Baked) stats.baked++;
+        if (result == BakeResult::Skipped) stats.skipped++;
+        if (result == BakeResult::Failed) stats.failed++;
+    }
+    return stats;
+}
+
+std::vector<AssetBaker::BakeJob> AssetBaker::collectJobs(const std::filesystem::path &directory) const
+{
+    std::vector<BakeJob> jobs;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+        if (!entry.is_regular_file()) continue;
+        if (entry.path().extension() == ".obj") {
+            jobs.push_back({ true, entry.path() });
+        } else if (isImageFile(entry.path())) {
+            jobs.push_back({ false, entry.path() });
+        }
+    }
+    if (error) spdlog::error("Failed to walk {}: {}", directory.string(), error.message());
+
+    // meshes take longest, start them first so they don't trail behind the textures
+    std::stable_partition(jobs.begin(), jobs.end(), [](const BakeJob &job) { return job.is_mesh; });
+    return jobs;
+}
+
+AssetBaker::BakeResult AssetBaker::bakeTexture(const std::filesystem::path &source) const
+{
+    std::filesystem::path target = source;
+    target.replace_extension(".ktx2");
+
+    std::error_code error;
+    if (!settings.force && std::filesystem::exists(target, error)
+        && std::filesystem::last_write_time(target, error) >= std::filesystem::last_write_time(source, error)) {
+        return BakeResult::Skipped;
+    }
+
+    TextureBaker baker(settings.texture);
+    if (!baker.bake(source.string(), target.string())) return BakeResult::Failed;
+
+    spdlog::info("Baked {}", target.string());
+    return BakeResult::Baked;
+}
+
+AssetBaker::BakeResult AssetBaker::bakeMesh(const std::filesystem::path &source) const
+{
+    // the cache checks the source hash and loader settings itself
+    if (settings.force) {
+        std::error_code error;
+        std::filesystem::remove(MeshCache(source.string(), 0).getCacheFile(), error);
+    }
+
+    ObjLoader loader(nullptr, VK_NULL_HANDLE, VK_NULL_HANDLE, settings.mesh);
+    switch (loader.bakeMeshCache(source.string())) {
+    case MeshCacheState::UpToDate:
+        return BakeResult::Skipped;
+    case MeshCacheState::Rebuilt:
+        spdlog::info("Baked {}", MeshCache(source.string(), 0).getCacheFile());
+        return BakeResult::Baked;
+    default:
+        return BakeResult::Failed;
+    }
+}
+
+uint32_t AssetBaker::resolveThreadCount(size_t job_count) const
+{
+    uint32_t thread_count = settings.thread_count;
+    if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<uint32_t>(std::min<size_t>(thread_count, job_count));
+}
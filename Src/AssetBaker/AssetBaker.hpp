@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "TextureBaker.hpp"
+#include "scene/ObjLoader.hpp"
+
+namespace Kataglyphis {
+
+struct AssetBakerSettings
+{
+    // files baked at once; 0 picks the core count
+    uint32_t thread_count{ 0 };
+    // rebake inputs whose outputs look up to date
+    bool force{ false };
+    TextureBakeSettings texture;
+    // has to match what the renderer loads with, the mesh cache is keyed on it
+    ObjLoaderSettings mesh;
+};
+
+struct AssetBakeStats
+{
+    uint32_t baked{ 0 };
+    uint32_t skipped{ 0 };
+    uint32_t failed{ 0 };
+};
+
+// Walks a model directory and bakes everything the renderer would otherwise
+// process at startup: images become .ktx2 files next to their source and
+// .obj files get their mesh cache (see MeshCache).
+class AssetBaker
+{
+  public:
+    explicit AssetBaker(AssetBakerSettings settings = AssetBakerSettings{});
+
+    AssetBakeStats bake(const std::string &directory) const;
+
+  private:
+    enum class BakeResult
+    {
+        Baked,
+        Skipped,
+        Failed
+    };
+
+    struct BakeJob
+    {
+        bool is_mesh{ false };
+        std::filesystem::path source;
+    };
+
+    AssetBakerSettings settings;
+
+    std::vector<BakeJob> collectJobs(const std::filesystem::path &directory) const;
+    BakeResult bakeTexture(const std::filesystem::path &source) const;
+    BakeResult bakeMesh(const std::filesystem::path &source) const;
+    uint32_t resolveThreadCount(size_t job_count) const;
+};
+
+}// namespace Kataglyphis
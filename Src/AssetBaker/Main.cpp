@@ -0,0 +1,61 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "AssetBaker.hpp"
+#include "scene/SceneConfig.hpp"
+
+using namespace Kataglyphis;
+
+namespace {
+
+void printUsage()
+{
+    std::cout << "usage: kataglyphis_bake <model directory> [--threads n] [--force] [--etc1s] [--opengl]\n"
+              << "  --threads n  number of files baked at once (default: core count)\n"
+              << "  --force      rebake inputs whose outputs are up to date\n"
+              << "  --etc1s      smaller, lower quality ETC1S textures instead of UASTC\n"
+              << "  --opengl     store textures bottom up for the OpenGL renderer\n";
+}
+
+}// namespace
+
+int main(int argc, char **argv)
+{
+    AssetBakerSettings settings{};
+    // same settings as Scene::loadModel, otherwise the renderer would not accept the caches
+    settings.mesh.optimize_mesh = sceneConfig::getOptimizeMeshes();
+    settings.mesh.split_submeshes = sceneConfig::getSplitSubmeshes();
+    settings.mesh.lod_count = sceneConfig::getMeshLodCount();
+    settings.mesh.compact_vertices = sceneConfig::getCompactVertices();
+
+    std::string directory;
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            settings.thread_count = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--force") {
+            settings.force = true;
+        } else if (argument == "--etc1s") {
+            settings.texture.uastc = false;
+        } else if (argument == "--opengl") {
+            settings.texture.flip_y = true;
+        } else if (directory.empty() && argument.rfind("--", 0) != 0) {
+            directory = argument;
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (directory.empty()) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    AssetBaker baker(settings);
+    const AssetBakeStats stats = baker.bake(directory);
+    std::cout << "baked " << stats.baked << ", up to date " << stats.skipped << ", failed " << stats.failed << "\n";
+
+    return stats.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,100 @@
+#include "TextureBaker.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+#include <encoder/basisu_comp.h>
+#include <stb_image.h>
+
+#include "spdlog/spdlog.h"
+
+using namespace Kataglyphis;
+
+namespace {
+
+basist::ktx2_transcoder::key_value makeKeyValue(const char *key, const char *value)
+{
+    basist::ktx2_transcoder::key_value key_value;
+    key_value.m_key.resize(std::strlen(key) + 1);
+    std::memcpy(key_value.m_key.data(), key, std::strlen(key) + 1);
+    key_value.m_value.resize(std::strlen(value) + 1);
+    std::memcpy(key_value.m_value.data(), value, std::strlen(value) + 1);
+    return key_value;
+}
+
+}// namespace
+
+TextureBaker::TextureBaker(TextureBakeSettings settings)
+{
+    this->settings = settings;
+
+    // builds global lookup tables; must not race with a running encoder
+    static std::once_flag encoder_initialized;
+    std::call_once(encoder_initialized, []() { basisu::basisu_encoder_init(); });
+}
+
+bool TextureBaker::bake(const std::string &source_file, const std::string &ktx2_file) const
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    stbi_uc *pixels = stbi_load(source_file.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels) {
+        spdlog::error("Failed to load a texture file! (" + source_file + ")");
+        return false;
+    }
+
+    basisu::basis_compressor_params params;
+    params.m_source_images.push_back(
+      basisu::image(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height), 4));
+    stbi_image_free(pixels);
+
+    params.m_mip_gen = true;
+    params.m_mip_srgb = true;
+    params.m_y_flip = settings.flip_y;
+    params.m_uastc = settings.uastc;
+    if (settings.uastc) {
+        params.m_ktx2_uastc_supercompression = basist::KTX2_SS_ZSTANDARD;
+    } else {
+        params.m_quality_level = settings.etc1s_quality;
+    }
+
+    params.m_create_ktx2_file = true;
+    params.m_ktx2_srgb_transfer_func = true;
+    params.m_ktx2_key_values.push_back(makeKeyValue("KTXorientation", settings.flip_y ? "ru" : "rd"));
+
+    // files are baked in parallel already, one encoder thread each
+    basisu::job_pool job_pool(1);
+    params.m_pJob_pool = &job_pool;
+    params.m_multithreading = false;
+    params.m_status_output = false;
+
+    basisu::basis_compressor compressor;
+    if (!compressor.init(params) || compressor.process() != basisu::basis_compressor::cECSuccess) {
+        spdlog::error("Failed to encode a texture file! (" + source_file + ")");
+        return false;
+    }
+
+    // write next to the target and rename, so an interrupted bake never leaves a truncated file
+    const basisu::uint8_vec &ktx2 = compressor.get_output_ktx2_file();
+    const std::string temporary_file = ktx2_file + ".tmp";
+    {
+        std::ofstream stream(temporary_file, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char *>(ktx2.data()), static_cast<std::streamsize>(ktx2.size()));
+        if (!stream) {
+            spdlog::error("Failed to write a texture file! (" + temporary_file + ")");
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_file, ktx2_file, error);
+    if (error) {
+        spdlog::error("Failed to write a texture file! (" + ktx2_file + ": " + error.message() + ")");
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+
+namespace Kataglyphis {
+
+struct TextureBakeSettings
+{
+    // UASTC keeps close to BC7 quality; ETC1S files are several times smaller but blurrier
+    bool uastc{ true };
+    // ETC1S quality level [1, 255]
+    int etc1s_quality{ 128 };
+    // store the rows bottom up for the OpenGL renderer, which flips every image on load
+    bool flip_y{ false };
+};
+
+// Encodes an image into a Basis Universal .ktx2 file with its full mip chain,
+// ready to be transcoded by Texture::decodeFile at load time.
+class TextureBaker
+{
+  public:
+    explicit TextureBaker(TextureBakeSettings settings = TextureBakeSettings{});
+
+    // safe to call from several threads at once
+    bool bake(const std::string &source_file, const std::string &ktx2_file) const;
+
+  private:
+    TextureBakeSettings settings;
+};
+
+}// namespace Kataglyphis
@@ -102,12 +102,16 @@ void GeometryPass::execute(glm::mat4 projection_matrix,
 
     std::vector<std::shared_ptr<GameObject>> game_objects = scene->get_game_objects();
 
+    // pixels covered by a world space length of one at distance one
+    const float lod_scale = projection_matrix[1][1] * static_cast<float>(window_height) * 0.5f;
+    const glm::vec3 camera_position = main_camera->get_camera_position();
+
     for (std::shared_ptr<GameObject> object : game_objects) {
         /* if (object_is_visible(object)) {*/
 
         set_game_object_uniforms(object->get_world_trafo(), object->get_normal_world_trafo());
 
-        object->render();
+        object->render(object->select_lod(camera_position, lod_scale));
         //}
     }
 
@@ -1,5 +1,8 @@
 #include "GameObject.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 GameObject::GameObject() : model(std::make_shared<Model>(Model())) {}
 
 GameObject::GameObject(const std::string &model_path, glm::vec3 translation, GLfloat scale, Rotation rot)
@@ -11,6 +14,14 @@ GameObject::GameObject(const std::string &model_path, glm::vec3 translation, GLf
     this->rot = rot;
 }
 
+GameObject::GameObject(std::shared_ptr<Model> model, glm::mat4 placement)
+  : model(model), scale_factor(1.f), rot{ 0.f, glm::vec3(0.f, 1.f, 0.f) }, translation(0.f), placement(placement)
+{
+    placement_scale = std::max({ glm::length(glm::vec3(placement[0])),
+      glm::length(glm::vec3(placement[1])),
+      glm::length(glm::vec3(placement[2])) });
+}
+
 void GameObject::init(const std::string &model_path, glm::vec3 translation, GLfloat scale, Rotation rot)
 {
     model = std::make_shared<Model>(Model());
@@ -27,7 +38,7 @@ glm::mat4 GameObject::get_world_trafo()
     model_to_world = glm::scale(model_to_world, glm::vec3(scale_factor));
     model_to_world = glm::rotate(model_to_world, glm::radians(rot.degrees), rot.axis);
 
-    return model_to_world;
+    return model_to_world * placement;
 }
 
 glm::mat4 GameObject::get_normal_world_trafo()
@@ -36,7 +47,20 @@ glm::mat4 GameObject::get_normal_world_trafo()
     return glm::transpose(glm::inverse(world_trafo));
 }
 
-void GameObject::render() { model->render(); }
+uint32_t GameObject::select_lod(glm::vec3 camera_position, float lod_scale)
+{
+    const glm::mat4 world_trafo = get_world_trafo();
+    const glm::vec4 sphere = model->get_bounding_sphere();
+    const glm::vec3 center = glm::vec3(world_trafo * glm::vec4(glm::vec3(sphere), 1.f));
+
+    // errors are in object space, the uniform scale brings them to world space
+    const float world_scale = scale_factor * placement_scale;
+    const glm::vec3 delta = center - camera_position;
+    const float distance = std::max(std::sqrt(glm::dot(delta, delta)) - sphere.w * world_scale, 0.f);
+    return selectLod(model->get_lods(), distance, lod_scale * world_scale, 1.f);
+}
+
+void GameObject::render(uint32_t lod) { model->render(lod); }
 
 std::shared_ptr<AABB> GameObject::get_aabb() { return model->get_aabb(); }
 
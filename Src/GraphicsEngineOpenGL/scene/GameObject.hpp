@@ -9,6 +9,8 @@ class GameObject
     GameObject();
 
     GameObject(const std::string &model_path, glm::vec3 translation, GLfloat scale, Rotation rot);
+    // an instance of an already loaded model; placement is applied before translation, scale and rotation
+    GameObject(std::shared_ptr<Model> model, glm::mat4 placement);
 
     void init(const std::string &model_path, glm::vec3 translation, GLfloat scale, Rotation rot);
 
@@ -22,7 +24,11 @@ class GameObject
     void scale(GLfloat scale_factor);
     void rotate(Rotation rot);
 
-    void render();
+    // coarsest LOD whose projected error stays below a pixel; lod_scale is
+    // viewport_height / (2 * tan(fov_y / 2))
+    uint32_t select_lod(glm::vec3 camera_position, float lod_scale);
+
+    void render(uint32_t lod = 0);
 
     ~GameObject();
 
@@ -32,4 +38,8 @@ class GameObject
     GLfloat scale_factor;
     Rotation rot;
     glm::vec3 translation;
+
+    glm::mat4 placement{ 1.f };
+    // largest axis scale of the placement
+    GLfloat placement_scale{ 1.f };
 };
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+
+#include "util/MappedFile.hpp"
+
+// glTF accessor component types
+enum class GltfComponentType : uint32_t {
+    BYTE = 5120,
+    UNSIGNED_BYTE = 5121,
+    SHORT = 5122,
+    UNSIGNED_SHORT = 5123,
+    UNSIGNED_INT = 5125,
+    FLOAT = 5126
+};
+
+// an accessor resolved to the mapped binary chunk; element i starts at data + i * stride
+struct GltfAccessor
+{
+    const std::byte *data{ nullptr };
+    size_t count{ 0 };
+    size_t stride{ 0 };
+    GltfComponentType component_type{ GltfComponentType::FLOAT };
+    // 1 for SCALAR up to 16 for MAT4
+    uint32_t component_count{ 0 };
+    bool normalized{ false };
+
+    size_t getElementSize() const;
+    // elements are packed back to back and aligned for their component type
+    bool isTightlyPacked() const { return stride == getElementSize(); };
+};
+
+// one placement of a glTF mesh: a node referencing it, with the transform of its whole node path
+struct GltfMeshNode
+{
+    uint32_t mesh{ 0 };
+    glm::mat4 transform{ 1.f };
+};
+
+// Binary glTF 2.0 (.glb) container. The file is memory mapped and the JSON
+// chunk parsed once; accessors are handed out as views into the mapped binary
+// chunk, so vertex and index data is never copied before the upload.
+class GlbFile
+{
+  public:
+    GlbFile();
+    GlbFile(const GlbFile &) = delete;
+    GlbFile &operator=(const GlbFile &) = delete;
+
+    bool open(const std::string &file_location);
+
+    const nlohmann::json &getJson() const { return json; };
+    const std::string &getBaseDir() const { return base_dir; };
+
+    // false (and logged) for sparse accessors, external buffers or views outside the binary chunk
+    bool getAccessor(uint32_t accessor_index, GltfAccessor &accessor) const;
+    // raw bytes of a buffer view, e.g. an embedded image
+    std::span<const std::byte> getBufferView(uint32_t buffer_view_index) const;
+
+    // walks the node hierarchy of the default scene (all root nodes if there is none);
+    // a mesh referenced by several nodes appears once per node
+    std::vector<GltfMeshNode> collectMeshNodes() const;
+
+    ~GlbFile();
+
+  private:
+    MappedFile mapping;
+    nlohmann::json json;
+    std::span<const std::byte> binary_chunk;
+    std::string file_location;
+    std::string base_dir;
+
+    glm::mat4 getNodeTransform(const nlohmann::json &node) const;
+};
@@ -0,0 +1,344 @@
+#include "scene/GltfLoader.hpp"
+#include "renderer/OpenGLRendererConfig.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "hostDevice/GlobalValues.hpp"
+#include "hostDevice/host_device_shared.hpp"
+#include "scene/MeshSimplifier.hpp"
+
+#include "spdlog/spdlog.h"
+
+namespace {
+
+constexpr uint32_t gltf_mode_triangles = 4;
+
+float readComponent(const std::byte *element, GltfComponentType component_type, bool normalized, uint32_t component)
+{
+    // normalized integers map onto [0, 1] resp. [-1, 1] (glTF 2.0, 3.11)
+    switch (component_type) {
+    case GltfComponentType::FLOAT: {
+        float value;
+        std::memcpy(&value, element + component * sizeof(float), sizeof(float));
+        return value;
+    }
+    case GltfComponentType::UNSIGNED_BYTE: {
+        const float value = static_cast<float>(std::to_integer<uint8_t>(element[component]));
+        return normalized ? value / 255.f : value;
+    }
+    case GltfComponentType::BYTE: {
+        const float value = static_cast<float>(static_cast<int8_t>(std::to_integer<uint8_t>(element[component])));
+        return normalized ? std::max(value / 127.f, -1.f) : value;
+    }
+    case GltfComponentType::UNSIGNED_SHORT: {
+        uint16_t value;
+        std::memcpy(&value, element + component * sizeof(uint16_t), sizeof(value));
+        return normalized ? static_cast<float>(value) / 65535.f : static_cast<float>(value);
+    }
+    case GltfComponentType::SHORT: {
+        int16_t value;
+        std::memcpy(&value, element + component * sizeof(int16_t), sizeof(value));
+        return normalized ? std::max(static_cast<float>(value) / 32767.f, -1.f) : static_cast<float>(value);
+    }
+    case GltfComponentType::UNSIGNED_INT: {
+        uint32_t value;
+        std::memcpy(&value, element + component * sizeof(uint32_t), sizeof(value));
+        return static_cast<float>(value);
+    }
+    }
+    return 0.f;
+}
+
+// reads the first count components of element i; missing components stay untouched
+void readFloats(const GltfAccessor &accessor, size_t i, float *out, uint32_t count)
+{
+    const std::byte *element = accessor.data + i * accessor.stride;
+    count = std::min(count, accessor.component_count);
+    if (accessor.component_type == GltfComponentType::FLOAT) {
+        std::memcpy(out, element, count * sizeof(float));
+        return;
+    }
+    for (uint32_t c = 0; c < count; c++) {
+        out[c] = readComponent(element, accessor.component_type, accessor.normalized, c);
+    }
+}
+
+// appends the indices of a primitive shifted by first_vertex
+void appendIndices(const GltfAccessor &accessor, uint32_t first_vertex, std::vector<uint32_t> &indices)
+{
+    const size_t first = indices.size();
+    indices.resize(first + accessor.count);
+    uint32_t *out = indices.data() + first;
+    size_t i = 0;
+
+    if (accessor.component_type == GltfComponentType::UNSIGNED_SHORT && accessor.isTightlyPacked()) {
+#if defined(__SSE2__) || defined(_M_X64)
+        // the common case for production assets: widen 8 indices per step and add the base vertex
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i base = _mm_set1_epi32(static_cast<int>(first_vertex));
+        for (; i + 8 <= accessor.count; i += 8) {
+            const __m128i packed =
+              _mm_loadu_si128(reinterpret_cast<const __m128i *>(accessor.data + i * sizeof(uint16_t)));
+            _mm_storeu_si128(
+              reinterpret_cast<__m128i *>(out + i), _mm_add_epi32(_mm_unpacklo_epi16(packed, zero), base));
+            _mm_storeu_si128(
+              reinterpret_cast<__m128i *>(out + i + 4), _mm_add_epi32(_mm_unpackhi_epi16(packed, zero), base));
+        }
+#endif
+    }
+
+    for (; i < accessor.count; i++) {
+        const std::byte *element = accessor.data + i * accessor.stride;
+        uint32_t index = 0;
+        switch (accessor.component_type) {
+        case GltfComponentType::UNSIGNED_BYTE:
+            index = std::to_integer<uint8_t>(element[0]);
+            break;
+        case GltfComponentType::UNSIGNED_SHORT: {
+            uint16_t value;
+            std::memcpy(&value, element, sizeof(value));
+            index = value;
+            break;
+        }
+        default:
+            std::memcpy(&index, element, sizeof(index));
+            break;
+        }
+        out[i] = index + first_vertex;
+    }
+}
+
+const nlohmann::json &getMember(const nlohmann::json &object, const char *key)
+{
+    static const nlohmann::json empty = nlohmann::json::object();
+    auto member = object.find(key);
+    return member != object.end() ? *member : empty;
+}
+
+}// namespace
+
+GltfLoader::GltfLoader() {}
+
+bool GltfLoader::load(const std::string &modelFile,
+  std::vector<Vertex> &vertices,
+  std::vector<unsigned int> &indices,
+  std::vector<std::string> &texture_list,
+  std::vector<std::span<const std::byte>> &embedded_textures,
+  std::vector<ObjMaterial> &materials,
+  std::vector<glm::vec4> &materialIndex,
+  std::vector<MeshLod> &lods)
+{
+    // texture at position 0 is plain texture to handle non existing materials
+    std::stringstream texture_base_dir;
+    std::filesystem::path cwd = std::filesystem::current_path();
+    texture_base_dir << cwd.string();
+    texture_base_dir << RELATIVE_RESOURCE_PATH << "Textures/plain.png";
+    texture_list.push_back(texture_base_dir.str());
+    embedded_textures.resize(texture_list.size());
+
+    if (!file.open(modelFile)) return false;
+
+    materials = loadMaterials(texture_list, embedded_textures);
+
+    const nlohmann::json &json_meshes = getMember(file.getJson(), "meshes");
+    std::vector<MeshData> meshes(json_meshes.size());
+    std::vector<bool> loaded(json_meshes.size(), false);
+    for (uint32_t m = 0; m < static_cast<uint32_t>(meshes.size()); m++) {
+        loaded[m] = loadMesh(m, static_cast<uint32_t>(materials.size() - 1), meshes[m]);
+        if (!loaded[m]) spdlog::warn("{}: skipping mesh {}", modelFile, m);
+    }
+
+    // bake every placement; the normal matrix keeps normals perpendicular under non uniform scale
+    for (const GltfMeshNode &mesh_node : file.collectMeshNodes()) {
+        if (mesh_node.mesh >= meshes.size() || !loaded[mesh_node.mesh]) continue;
+        const MeshData &mesh = meshes[mesh_node.mesh];
+        const glm::mat4 normal_matrix = glm::transpose(glm::inverse(mesh_node.transform));
+
+        const uint32_t first_vertex = static_cast<uint32_t>(vertices.size());
+        for (const Vertex &vertex : mesh.vertices) {
+            const glm::vec3 normal = glm::vec3(normal_matrix * glm::vec4(vertex.normal, 0.f));
+            vertices.emplace_back(glm::vec3(mesh_node.transform * glm::vec4(vertex.position, 1.f)),
+              glm::length(normal) > 0.f ? glm::normalize(normal) : normal,
+              vertex.color,
+              vertex.texture_coords);
+        }
+        for (uint32_t index : mesh.indices) indices.push_back(first_vertex + index);
+        for (float material : mesh.materials) materialIndex.push_back(glm::vec4(material, 0.0f, 0.0f, 0.0f));
+    }
+
+    if (indices.empty()) {
+        spdlog::error("{} has no triangles!", modelFile);
+        return false;
+    }
+
+    // coarser levels index the same vertices and are appended behind LOD 0
+    MeshSimplifier simplifier;
+    lods = simplifier.buildLodChain(vertices, indices, materialIndex, lod_count);
+    for (size_t i = 1; i < lods.size(); i++) {
+        spdlog::info("LOD {} of {}: {} triangles, error {:.5f}", i, modelFile, lods[i].index_count / 3, lods[i].error);
+    }
+
+    return true;
+}
+
+std::vector<ObjMaterial> GltfLoader::loadMaterials(std::vector<std::string> &texture_list,
+  std::vector<std::span<const std::byte>> &embedded_textures)
+{
+    const nlohmann::json &json = file.getJson();
+    const nlohmann::json &json_textures = getMember(json, "textures");
+    const nlohmann::json &json_images = getMember(json, "images");
+
+    // only images used as base color are loaded, in order of first use
+    std::unordered_map<uint32_t, int> image_textures;
+    auto textureOfImage = [&](uint32_t image) -> int {
+        auto known = image_textures.find(image);
+        if (known != image_textures.end()) return known->second;
+
+        const nlohmann::json &json_image = json_images[image];
+        std::span<const std::byte> encoded;
+        std::string texture_file;
+        if (json_image.contains("bufferView")) {
+            texture_file = "embedded image " + std::to_string(image);
+            encoded = file.getBufferView(json_image["bufferView"].get<uint32_t>());
+            if (encoded.empty()) return image_textures[image] = 0;
+        } else {
+            const std::string uri = json_image.value("uri", std::string());
+            if (uri.empty() || uri.rfind("data:", 0) == 0) {
+                spdlog::warn("glTF image {}: data URIs are not supported", image);
+                return image_textures[image] = 0;
+            }
+            texture_file = file.getBaseDir() + "/" + uri;
+        }
+
+        texture_list.push_back(texture_file);
+        embedded_textures.push_back(encoded);
+        return image_textures[image] = static_cast<int>(texture_list.size() - 1);
+    };
+
+    std::vector<ObjMaterial> materials;
+    for (const nlohmann::json &json_material : getMember(json, "materials")) {
+        const nlohmann::json &pbr = getMember(json_material, "pbrMetallicRoughness");
+        const std::vector<float> base_color = pbr.value("baseColorFactor", std::vector<float>{ 1.f, 1.f, 1.f, 1.f });
+        const std::vector<float> emission = json_material.value("emissiveFactor", std::vector<float>{ 0.f, 0.f, 0.f });
+        const float roughness = pbr.value("roughnessFactor", 1.f);
+
+        // the shading model is Phong-like; metallic/roughness only map onto it approximately
+        ObjMaterial material;
+        if (base_color.size() >= 3) material.diffuse = glm::vec3(base_color[0], base_color[1], base_color[2]);
+        material.ambient = material.diffuse * 0.1f;
+        material.specular = glm::vec3(1.f - roughness);
+        material.emission = emission.size() >= 3 ? glm::vec3(emission[0], emission[1], emission[2]) : glm::vec3(0.f);
+        material.shininess = (1.f - roughness) * (1.f - roughness) * 128.f;
+        material.ior = getMember(getMember(json_material, "extensions"), "KHR_materials_ior").value("ior", 1.5f);
+        material.dissolve = base_color.size() >= 4 ? base_color[3] : 1.f;
+        material.illum = 2;
+        // no texture: plain texture at position 0
+        material.textureID = 0;
+
+        const uint32_t texture = getMember(pbr, "baseColorTexture").value("index", UINT32_MAX);
+        if (texture < json_textures.size()) {
+            const uint32_t image = json_textures[texture].value("source", UINT32_MAX);
+            if (image < json_images.size()) material.textureID = textureOfImage(image);
+        }
+
+        materials.push_back(material);
+    }
+
+    // for primitives without material
+    materials.emplace_back(ObjMaterial());
+
+    if (materials.size() > static_cast<size_t>(MAX_MATERIALS)) {
+        spdlog::warn("GltfLoader: {} materials exceed MAX_MATERIALS ({})", materials.size(), MAX_MATERIALS);
+    }
+
+    return materials;
+}
+
+bool GltfLoader::loadMesh(uint32_t mesh_index, uint32_t default_material, MeshData &mesh)
+{
+    const nlohmann::json &primitives = getMember(getMember(file.getJson(), "meshes")[mesh_index], "primitives");
+    if (!primitives.is_array()) return false;
+
+    for (const nlohmann::json &json_primitive : primitives) {
+        if (json_primitive.value("mode", gltf_mode_triangles) != gltf_mode_triangles) {
+            spdlog::warn("glTF mesh {}: skipping a primitive that is no triangle list", mesh_index);
+            continue;
+        }
+        const nlohmann::json &attributes = getMember(json_primitive, "attributes");
+        if (!attributes.contains("POSITION")) continue;
+
+        GltfAccessor position, normal, color, texture_coords;
+        if (!file.getAccessor(attributes["POSITION"].get<uint32_t>(), position) || position.component_count != 3) {
+            return false;
+        }
+        auto optional = [&](const char *attribute, GltfAccessor &accessor) {
+            if (!attributes.contains(attribute)) return false;
+            return file.getAccessor(attributes[attribute].get<uint32_t>(), accessor)
+                   && accessor.count == position.count;
+        };
+        const bool has_normal = optional("NORMAL", normal);
+        const bool has_color = optional("COLOR_0", color);
+        const bool has_texture_coords = optional("TEXCOORD_0", texture_coords);
+
+        // one pass over all attribute streams; missing ones keep the defaults of the OBJ path
+        const uint32_t first_vertex = static_cast<uint32_t>(mesh.vertices.size());
+        mesh.vertices.reserve(mesh.vertices.size() + position.count);
+        for (size_t v = 0; v < position.count; v++) {
+            Vertex vertex(glm::vec3(0.f), glm::vec3(0.f), glm::vec3(-1.f), glm::vec2(0.f));
+            readFloats(position, v, &vertex.position.x, 3);
+            if (has_normal) readFloats(normal, v, &vertex.normal.x, 3);
+            if (has_color) readFloats(color, v, &vertex.color.x, 3);
+            // glTF has its origin in the upper left corner, like the flipped OBJ coordinates
+            if (has_texture_coords) readFloats(texture_coords, v, &vertex.texture_coords.x, 2);
+            mesh.vertices.push_back(vertex);
+        }
+
+        const size_t first_index = mesh.indices.size();
+        if (json_primitive.contains("indices")) {
+            GltfAccessor index_accessor;
+            if (!file.getAccessor(json_primitive["indices"].get<uint32_t>(), index_accessor)) return false;
+            appendIndices(index_accessor, first_vertex, mesh.indices);
+        } else {
+            for (uint32_t v = 0; v < position.count; v++) mesh.indices.push_back(first_vertex + v);
+        }
+        // a dangling partial triangle would shift all following ones
+        mesh.indices.resize(first_index + (mesh.indices.size() - first_index) / 3 * 3);
+
+        const uint32_t vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+        if (std::any_of(mesh.indices.begin() + first_index, mesh.indices.end(), [&](uint32_t i) {
+                return i >= vertex_count;
+            })) {
+            spdlog::error("glTF mesh {} indexes vertices it does not have!", mesh_index);
+            return false;
+        }
+
+        // precompute normals if no provided
+        if (!has_normal) {
+            for (size_t i = first_index; i < mesh.indices.size(); i += 3) {
+                Vertex &v0 = mesh.vertices[mesh.indices[i + 0]];
+                Vertex &v1 = mesh.vertices[mesh.indices[i + 1]];
+                Vertex &v2 = mesh.vertices[mesh.indices[i + 2]];
+
+                glm::vec3 n = glm::normalize(glm::cross((v1.position - v0.position), (v2.position - v0.position)));
+                v0.normal = n;
+                v1.normal = n;
+                v2.normal = n;
+            }
+        }
+
+        const uint32_t material = std::min(json_primitive.value("material", default_material), default_material);
+        mesh.materials.insert(mesh.materials.end(), (mesh.indices.size() - first_index) / 3, float(material));
+    }
+
+    return !mesh.indices.empty();
+}
+
+GltfLoader::~GltfLoader() {}
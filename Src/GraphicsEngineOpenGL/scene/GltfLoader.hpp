@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "scene/GlbFile.hpp"
+#include "scene/MeshLod.hpp"
+#include "scene/ObjMaterial.hpp"
+#include "scene/Vertex.hpp"
+
+// Loads binary glTF 2.0 files (.glb) into the same flat buffers as ObjLoader.
+// The file stays memory mapped as long as the loader lives: accessors are read
+// straight from the mapping and embedded images are handed out as views into
+// it. The renderer draws a model as a single mesh, so every node placing a mesh
+// is baked into the vertices; hierarchy and repeated meshes look as authored.
+class GltfLoader
+{
+  public:
+    GltfLoader();
+    GltfLoader(const GltfLoader &) = delete;
+    GltfLoader &operator=(const GltfLoader &) = delete;
+
+    // embedded_textures runs parallel to texture_list; empty views are plain files
+    bool load(const std::string &modelFile,
+      std::vector<Vertex> &vertices,
+      std::vector<unsigned int> &indices,
+      std::vector<std::string> &texture_list,
+      std::vector<std::span<const std::byte>> &embedded_textures,
+      std::vector<ObjMaterial> &materials,
+      std::vector<glm::vec4> &materialIndex,
+      std::vector<MeshLod> &lods);
+
+    // levels of detail generated per model, LOD 0 included. Coarser levels are opt-in: the geometry
+    // pass shaders have to look their materials up in the level's bound material id range
+    static constexpr uint32_t lod_count = 1;
+
+    ~GltfLoader();
+
+  private:
+    GlbFile file;
+
+    // one glTF mesh in mesh space, all triangle primitives back to back
+    struct MeshData
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<float> materials;
+    };
+
+    std::vector<ObjMaterial> loadMaterials(std::vector<std::string> &texture_list,
+      std::vector<std::span<const std::byte>> &embedded_textures);
+    bool loadMesh(uint32_t mesh_index, uint32_t default_material, MeshData &mesh);
+};
@@ -4,18 +4,27 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-Mesh::Mesh() : m_vao(-1), m_ibo(-1), m_drawCount(0), vertices(std::vector<Vertex>()), indices(std::vector<uint32_t>())
+#include <algorithm>
+#include <cmath>
+
+Mesh::Mesh()
+  : m_vao(-1), m_ibo(-1), m_drawCount(0), vertices(std::vector<Vertex>()), indices(std::vector<uint32_t>()),
+    bounding_sphere(0.f)
 {}
 
-Mesh::Mesh(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+Mesh::Mesh(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, std::span<const MeshLod> lods)
   :
 
-    vertices(vertices), indices(indices)
+    vertices(vertices), indices(indices), lods(lods.begin(), lods.end())
 {
     uint32_t numVertices = static_cast<uint32_t>(vertices.size());
     uint32_t num_indices = static_cast<uint32_t>(indices.size());
 
-    m_drawCount = num_indices;
+    // without a LOD chain the whole index buffer is the only level
+    if (this->lods.empty()) this->lods.push_back(MeshLod{ 0, num_indices, 0.f });
+    computeBoundingSphere();
+
+    m_drawCount = this->lods[0].index_count;
     glGenVertexArrays(1, &m_vao);
     glBindVertexArray(m_vao);
 
@@ -49,18 +58,45 @@ Mesh::Mesh(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-void Mesh::render()
+void Mesh::render(uint32_t lod)
 {
+    if (lods.empty()) return;
+    const MeshLod &level = lods[std::min<size_t>(lod, lods.size() - 1)];
+
     glBindVertexArray(m_vao);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
     // Draw Triangles
-    glDrawElements(GL_TRIANGLES, m_drawCount, GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES,
+      level.index_count,
+      GL_UNSIGNED_INT,
+      reinterpret_cast<const void *>(static_cast<size_t>(level.index_offset) * sizeof(uint32_t)));
 
     // unbind all again
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
 
+void Mesh::computeBoundingSphere()
+{
+    // sphere around the box center; LOD selection only needs a rough extent
+    bounding_sphere = glm::vec4(0.f);
+    if (vertices.empty()) return;
+
+    glm::vec3 min_pos = vertices[0].position;
+    glm::vec3 max_pos = min_pos;
+    for (const Vertex &vertex : vertices) {
+        min_pos = glm::min(min_pos, vertex.position);
+        max_pos = glm::max(max_pos, vertex.position);
+    }
+    const glm::vec3 center = (min_pos + max_pos) * 0.5f;
+    float radius = 0.f;
+    for (const Vertex &vertex : vertices) {
+        const glm::vec3 d = vertex.position - center;
+        radius = std::max(radius, std::sqrt(glm::dot(d, d)));
+    }
+    bounding_sphere = glm::vec4(center, radius);
+}
+
 Mesh::~Mesh()
 {
     glDeleteVertexArrays(1, &m_vao);
@@ -2,23 +2,28 @@
 #include <glad/glad.h>
 
 #include <glm/glm.hpp>
+#include <span>
 #include <vector>
 
 #include "hostDevice/GlobalValues.hpp"
+#include "scene/MeshLod.hpp"
 #include "scene/Vertex.hpp"
 
 // this a simple Mesh without mesh generation
 class Mesh
 {
   public:
-    Mesh(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+    Mesh(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, std::span<const MeshLod> lods = {});
 
     Mesh();
 
-    void render();
+    void render(uint32_t lod = 0);
 
     std::vector<Vertex> getVertices() const { return this->vertices; }
     std::vector<unsigned int> getIndices() const { return this->indices; }
+    const std::vector<MeshLod> &getLods() const { return this->lods; }
+    // xyz center, w radius in object space
+    glm::vec4 getBoundingSphere() const { return this->bounding_sphere; }
 
     ~Mesh();
 
@@ -43,4 +48,8 @@ class Mesh
     uint32_t m_drawCount;
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    glm::vec4 bounding_sphere;
+
+    void computeBoundingSphere();
 };
@@ -0,0 +1,237 @@
+#include "scene/MeshCache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+
+#include "spdlog/spdlog.h"
+#include "util/Hash.hpp"
+#include "util/MappedFile.hpp"
+
+static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex must be trivially copyable to be cached!");
+static_assert(std::is_trivially_copyable_v<MeshLod>, "MeshLod must be trivially copyable to be cached!");
+
+namespace {
+
+constexpr size_t section_alignment = 16;
+
+size_t align_section(size_t offset) { return (offset + section_alignment - 1) & ~(section_alignment - 1); }
+
+template<typename T>
+void read_section(const std::byte *base, size_t &offset, uint64_t count, std::vector<T> &destination)
+{
+    const size_t first = destination.size();
+    destination.resize(first + static_cast<size_t>(count));
+    std::memcpy(destination.data() + first, base + offset, sizeof(T) * count);
+    offset = align_section(offset + sizeof(T) * count);
+}
+
+template<typename T> void write_section(std::ofstream &stream, const T *data, size_t count)
+{
+    static const char padding[section_alignment] = {};
+    const size_t size = sizeof(T) * count;
+    stream.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+    stream.write(padding, static_cast<std::streamsize>(align_section(size) - size));
+}
+
+}// namespace
+
+MeshCache::MeshCache(const std::string &source_file, uint32_t loader_version)
+  : source_file(source_file), cache_file(source_file + ".kgcache"), base_dir(get_base_dir(source_file)),
+    loader_version(loader_version)
+{}
+
+bool MeshCache::load(std::vector<Vertex> &vertices,
+  std::vector<unsigned int> &indices,
+  std::vector<std::string> &texture_list,
+  std::vector<ObjMaterial> &materials,
+  std::vector<glm::vec4> &materialIndex,
+  std::vector<MeshLod> &lods)
+{
+    MappedFile mapping;
+    if (!mapping.open(cache_file)) return false;
+
+    const std::byte *base = mapping.data();
+    const size_t size = mapping.size();
+
+    Header header{};
+    if (size < sizeof(Header)) return false;
+    std::memcpy(&header, base, sizeof(Header));
+
+    uint64_t source_hash = 0;
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.format_version != format_version
+        || header.loader_version != loader_version || header.vertex_size != sizeof(Vertex)
+        || header.material_size != sizeof(CachedMaterial) || !compute_source_hash(source_hash)
+        || header.source_hash != source_hash) {
+        spdlog::info("Mesh cache {} is outdated and will be rebuilt.", cache_file);
+        return false;
+    }
+
+    size_t offset = align_section(sizeof(Header));
+    const size_t payload_size = align_section(sizeof(Vertex) * header.vertex_count)
+                                + align_section(sizeof(unsigned int) * header.index_count)
+                                + align_section(sizeof(glm::vec4) * header.material_index_count)
+                                + align_section(sizeof(CachedMaterial) * header.material_count)
+                                + align_section(sizeof(MeshLod) * header.lod_count);
+    if (offset + payload_size > size) {
+        spdlog::warn("Mesh cache {} is truncated!", cache_file);
+        return false;
+    }
+
+    // the texture names follow the sections; they are checked before any output is touched so a
+    // truncated cache leaves everything to the OBJ parser
+    std::vector<std::string> cached_textures;
+    size_t texture_offset = offset + payload_size;
+    for (uint64_t i = 0; i < header.texture_count; i++) {
+        uint32_t length = 0;
+        if (texture_offset + sizeof(length) > size) break;
+        std::memcpy(&length, base + texture_offset, sizeof(length));
+        texture_offset += sizeof(length);
+        if (texture_offset + length > size) break;
+
+        // texture names inside the model directory are stored relative to it
+        std::string name(reinterpret_cast<const char *>(base + texture_offset), length);
+        texture_offset += length;
+        if (name.starts_with("./")) name = base_dir + name.substr(1);
+        cached_textures.push_back(name);
+    }
+
+    if (cached_textures.size() != header.texture_count) {
+        spdlog::warn("Mesh cache {} is truncated!", cache_file);
+        return false;
+    }
+
+    std::vector<CachedMaterial> cached_materials;
+    read_section(base, offset, header.vertex_count, vertices);
+    read_section(base, offset, header.index_count, indices);
+    read_section(base, offset, header.material_index_count, materialIndex);
+    read_section(base, offset, header.material_count, cached_materials);
+    read_section(base, offset, header.lod_count, lods);
+
+    for (const CachedMaterial &cached : cached_materials) {
+        materials.emplace_back(glm::vec3(cached.ambient[0], cached.ambient[1], cached.ambient[2]),
+          glm::vec3(cached.diffuse[0], cached.diffuse[1], cached.diffuse[2]),
+          glm::vec3(cached.specular[0], cached.specular[1], cached.specular[2]),
+          glm::vec3(cached.transmittance[0], cached.transmittance[1], cached.transmittance[2]),
+          glm::vec3(cached.emission[0], cached.emission[1], cached.emission[2]),
+          cached.shininess,
+          cached.ior,
+          cached.dissolve,
+          cached.illum,
+          cached.textureID);
+    }
+
+    texture_list.insert(texture_list.end(), cached_textures.begin(), cached_textures.end());
+
+    return true;
+}
+
+void MeshCache::store(const std::vector<Vertex> &vertices,
+  const std::vector<unsigned int> &indices,
+  const std::vector<std::string> &texture_list,
+  const std::vector<ObjMaterial> &materials,
+  const std::vector<glm::vec4> &materialIndex,
+  const std::vector<MeshLod> &lods)
+{
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.format_version = format_version;
+    header.loader_version = loader_version;
+    header.vertex_size = sizeof(Vertex);
+    header.material_size = sizeof(CachedMaterial);
+    header.vertex_count = vertices.size();
+    header.index_count = indices.size();
+    header.material_index_count = materialIndex.size();
+    header.material_count = materials.size();
+    header.texture_count = texture_list.size();
+    header.lod_count = lods.size();
+
+    if (!compute_source_hash(header.source_hash)) return;
+
+    std::vector<CachedMaterial> cached_materials;
+    cached_materials.reserve(materials.size());
+    for (const ObjMaterial &material : materials) {
+        CachedMaterial cached{};
+        std::memcpy(cached.ambient, &material.ambient, sizeof(cached.ambient));
+        std::memcpy(cached.diffuse, &material.diffuse, sizeof(cached.diffuse));
+        std::memcpy(cached.specular, &material.specular, sizeof(cached.specular));
+        std::memcpy(cached.transmittance, &material.transmittance, sizeof(cached.transmittance));
+        std::memcpy(cached.emission, &material.emission, sizeof(cached.emission));
+        cached.shininess = material.shininess;
+        cached.ior = material.ior;
+        cached.dissolve = material.dissolve;
+        cached.illum = material.illum;
+        cached.textureID = material.textureID;
+        cached_materials.push_back(cached);
+    }
+
+    // write to a temporary file first so an interrupted run never leaves a
+    // half written cache behind
+    const std::string temporary_file = cache_file + ".tmp";
+    {
+        std::ofstream stream(temporary_file, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open()) {
+            spdlog::warn("Failed to write mesh cache {}!", cache_file);
+            return;
+        }
+
+        write_section(stream, &header, 1);
+        write_section(stream, vertices.data(), vertices.size());
+        write_section(stream, indices.data(), indices.size());
+        write_section(stream, materialIndex.data(), materialIndex.size());
+        write_section(stream, cached_materials.data(), cached_materials.size());
+        write_section(stream, lods.data(), lods.size());
+
+        for (const std::string &texture : texture_list) {
+            std::string name = texture;
+            if (name.starts_with(base_dir + "/")) name = "." + name.substr(base_dir.size());
+
+            uint32_t length = static_cast<uint32_t>(name.size());
+            stream.write(reinterpret_cast<const char *>(&length), sizeof(length));
+            stream.write(name.data(), static_cast<std::streamsize>(length));
+        }
+
+        if (!stream.good()) {
+            spdlog::warn("Failed to write mesh cache {}!", cache_file);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_file, cache_file, error);
+    if (error) { spdlog::warn("Failed to write mesh cache {}: {}", cache_file, error.message()); }
+}
+
+MeshCache::~MeshCache() {}
+
+bool MeshCache::compute_source_hash(uint64_t &hash)
+{
+    MappedFile source;
+    if (!source.open(source_file)) return false;
+
+    hash = hashBytes(source.data(), source.size(), loader_version);
+
+    // material libraries change the cached materials as well
+    std::string_view content(reinterpret_cast<const char *>(source.data()), source.size());
+    size_t position = content.find("mtllib");
+    while (position != std::string_view::npos) {
+        if (position == 0 || content[position - 1] == '\n') {
+            size_t line_end = content.find_first_of("\r\n", position);
+            std::istringstream library_names(std::string(content.substr(position + 6, line_end - position - 6)));
+
+            std::string library_name;
+            while (library_names >> library_name) {
+                MappedFile library;
+                if (library.open(base_dir + "/" + library_name)) {
+                    hash = combineHash64(hash, hashBytes(library.data(), library.size()));
+                }
+            }
+        }
+        position = content.find("mtllib", position + 6);
+    }
+
+    return true;
+}
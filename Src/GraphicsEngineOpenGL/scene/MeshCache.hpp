@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "scene/MeshLod.hpp"
+#include "scene/ObjMaterial.hpp"
+#include "scene/Vertex.hpp"
+
+// binary cache of a fully processed model, stored next to the source file;
+// a cache is only accepted if source hash, loader version and the memory
+// layout of the stored types all match
+class MeshCache
+{
+  public:
+    MeshCache(const std::string &source_file, uint32_t loader_version);
+
+    // appends the cached model to the given containers
+    bool load(std::vector<Vertex> &vertices,
+      std::vector<unsigned int> &indices,
+      std::vector<std::string> &texture_list,
+      std::vector<ObjMaterial> &materials,
+      std::vector<glm::vec4> &materialIndex,
+      std::vector<MeshLod> &lods);
+
+    void store(const std::vector<Vertex> &vertices,
+      const std::vector<unsigned int> &indices,
+      const std::vector<std::string> &texture_list,
+      const std::vector<ObjMaterial> &materials,
+      const std::vector<glm::vec4> &materialIndex,
+      const std::vector<MeshLod> &lods);
+
+    ~MeshCache();
+
+  private:
+    // ObjMaterial is not trivially copyable, so it is stored in this flat form
+    struct CachedMaterial
+    {
+        float ambient[3];
+        float diffuse[3];
+        float specular[3];
+        float transmittance[3];
+        float emission[3];
+        float shininess;
+        float ior;
+        float dissolve;
+        int32_t illum;
+        int32_t textureID;
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t format_version;
+        uint32_t loader_version;
+        uint64_t source_hash;
+        uint32_t vertex_size;
+        uint32_t material_size;
+        uint64_t vertex_count;
+        uint64_t index_count;
+        uint64_t material_index_count;
+        uint64_t material_count;
+        uint64_t texture_count;
+        uint64_t lod_count;
+    };
+
+    static constexpr char magic[8] = { 'K', 'G', 'G', 'L', 'M', 'S', 'H', '\0' };
+    static constexpr uint32_t format_version = 2;
+
+    std::string source_file;
+    std::string cache_file;
+    std::string base_dir;
+    uint32_t loader_version;
+
+    bool compute_source_hash(uint64_t &hash);
+
+    static std::string get_base_dir(const std::string &filepath)
+    {
+        if (filepath.find_last_of("/\\") != std::string::npos) return filepath.substr(0, filepath.find_last_of("/\\"));
+        return "";
+    }
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "scene/MeshLod.hpp"
+#include "scene/Vertex.hpp"
+
+struct MeshSimplifierSettings
+{
+    // triangle count of every level relative to the previous one
+    float reduction{ 0.5f };
+    // no levels below this many triangles
+    uint32_t min_triangle_count{ 64 };
+    // object space error a single collapse may introduce
+    float max_error{ std::numeric_limits<float>::max() };
+};
+
+// Quadric error metric simplification (Garland and Heckbert 1997) by half edge
+// collapses: vertices only ever move onto existing vertices, so every level
+// indexes the original vertex buffer and no new vertices are created.
+// Collapses operate on positions, i.e. attribute seams are not an obstacle.
+class MeshSimplifier
+{
+  public:
+    explicit MeshSimplifier(MeshSimplifierSettings settings = MeshSimplifierSettings{});
+
+    // simplifies until at most target_index_count indices remain or no collapse within max_error is left;
+    // triangles keep their relative order, kept_triangles receives their index in the input
+    std::vector<uint32_t> simplify(std::span<const Vertex> vertices,
+      std::span<const uint32_t> indices,
+      size_t target_index_count,
+      float *result_error = nullptr,
+      std::vector<uint32_t> *kept_triangles = nullptr) const;
+
+    // appends up to lod_count - 1 coarser levels to indices (and their per-triangle
+    // materials to materialIndex); the first returned level is the input itself
+    std::vector<MeshLod> buildLodChain(std::span<const Vertex> vertices,
+      std::vector<uint32_t> &indices,
+      std::vector<glm::vec4> &materialIndex,
+      uint32_t lod_count) const;
+
+  private:
+    MeshSimplifierSettings settings;
+};
@@ -5,9 +5,13 @@
 
 #include "scene/texture/RepeatMode.hpp"
 
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <unordered_map>
 
+#include "spdlog/spdlog.h"
+
 Model::Model() : aabb(std::make_shared<AABB>()) {}
 
 std::shared_ptr<AABB> Model::get_aabb() { return aabb; }
@@ -16,10 +20,35 @@ std::vector<ObjMaterial> Model::get_materials() const { return materials; }
 
 int Model::get_texture_count() const { return static_cast<uint32_t>(texture_list.size()); }
 
+const std::vector<MeshLod> &Model::get_lods() const { return mesh->getLods(); }
+
+glm::vec4 Model::get_bounding_sphere() const { return mesh->getBoundingSphere(); }
+
 void Model::load_model_in_ram(const std::string &model_path)
 {
+    if (std::filesystem::path(model_path).extension() == ".glb") {
+        gltf_loader = std::make_shared<GltfLoader>();
+        if (!gltf_loader->load(
+              model_path, vertices, indices, textures, embedded_textures, materials, materialIndex, lods)) {
+            spdlog::error("Failed to load model at: {}", model_path);
+        }
+        return;
+    }
+
     loader = ObjLoader();
-    loader.load(model_path, vertices, indices, textures, materials, materialIndex);
+    loader.load(model_path, vertices, indices, textures, materials, materialIndex, lods);
+}
+
+void Model::set_scene_offsets(uint32_t material_offset, uint32_t texture_offset)
+{
+    this->texture_offset = texture_offset;
+    for (ObjMaterial &material : materials) {
+        if (material.textureID >= 0) material.textureID += static_cast<int>(texture_offset);
+    }
+    // faces without a material keep their -1
+    for (glm::vec4 &material : materialIndex) {
+        if (material.x >= 0.f) material.x += static_cast<float>(material_offset);
+    }
 }
 
 // all OpenGL calls need to be on the same thread!
@@ -29,22 +58,55 @@ void Model::create_render_context()
     texture_list.resize(textures.size());
 
     for (uint32_t i = 0; i < static_cast<uint32_t>(textures.size()); i++) {
-        texture_list[i] = std::make_shared<Texture>(textures[i].c_str(), std::make_shared<RepeatMode>());
+        const bool embedded = i < embedded_textures.size() && !embedded_textures[i].empty();
+        // a baked .ktx2 next to the source image already has its mips and is block compressed
+        std::filesystem::path baked(textures[i]);
+        baked.replace_extension(".ktx2");
+        const std::string texture_file =
+          !embedded && std::filesystem::exists(baked) ? baked.string() : textures[i];
+        texture_list[i] = std::make_shared<Texture>(texture_file.c_str(), std::make_shared<RepeatMode>());
+        if (embedded) texture_list[i]->set_encoded_data(embedded_textures[i]);
 
         if (!texture_list[i]->load_SRGB_texture_without_alpha_channel()) {
             printf("Failed to load texture at: %s\n", textures[i].c_str());
             texture_list[i].reset();
         }
     }
-
-    mesh = std::make_shared<Mesh>(vertices, indices);
+    // the embedded images were the last thing read from the mapped file
+    embedded_textures.clear();
+    gltf_loader.reset();
+
+    mesh = std::make_shared<Mesh>(vertices, indices, lods);
+
+    // the material ids of every LOD start at a bindable offset, so the shaders
+    // keep indexing them with gl_PrimitiveID whichever level is drawn
+    GLint offset_alignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+    const size_t alignment_in_elements = std::max<size_t>(1, offset_alignment / sizeof(glm::vec4));
+
+    std::vector<glm::vec4> aligned_material_index;
+    aligned_material_index.reserve(materialIndex.size() + mesh->getLods().size() * alignment_in_elements);
+    material_offsets.clear();
+    for (const MeshLod &lod : mesh->getLods()) {
+        aligned_material_index.resize(
+          (aligned_material_index.size() + alignment_in_elements - 1) / alignment_in_elements * alignment_in_elements);
+        material_offsets.push_back(static_cast<GLintptr>(aligned_material_index.size() * sizeof(glm::vec4)));
+
+        const size_t first = lod.index_offset / 3;
+        const size_t last = std::min<size_t>(first + lod.index_count / 3, materialIndex.size());
+        if (first < last) {
+            aligned_material_index.insert(
+              aligned_material_index.end(), materialIndex.begin() + first, materialIndex.begin() + last);
+        }
+    }
+    if (aligned_material_index.empty()) aligned_material_index.emplace_back(0.f);
 
     // https://www.khronos.org/opengl/wiki/Shader_Storage_Buffer_Object
     glGenBuffers(1, &ssbo);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
     glBufferData(GL_SHADER_STORAGE_BUFFER,
-      materialIndex.size() * sizeof(glm::vec4),
-      materialIndex.data(),
+      aligned_material_index.size() * sizeof(glm::vec4),
+      aligned_material_index.data(),
       GL_STREAM_READ);// sizeof(data) only works for statically sized
                       // C/C++ arrays.
 }
@@ -53,7 +115,7 @@ void Model::bind_ressources()
 {
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BUFFER_MATERIAL_ID_BINDING, ssbo);
     for (int i = 0; i < static_cast<int>(texture_list.size()); i++) {
-        texture_list[i]->use_texture(i + MODEL_TEXTURES_SLOT);
+        texture_list[i]->use_texture(i + texture_offset + MODEL_TEXTURES_SLOT);
     }
 }
 
@@ -61,11 +123,28 @@ void Model::unbind_resources()
 {
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
     for (int i = 0; i < static_cast<int>(texture_list.size()); i++) {
-        texture_list[i]->unbind_texture(i + MODEL_TEXTURES_SLOT);
+        texture_list[i]->unbind_texture(i + texture_offset + MODEL_TEXTURES_SLOT);
     }
 }
 
-void Model::render() { mesh->render(); }
+void Model::render(uint32_t lod)
+{
+    const std::vector<MeshLod> &mesh_lods = mesh->getLods();
+    lod = std::min<uint32_t>(lod, static_cast<uint32_t>(mesh_lods.size()) - 1);
+
+    // every model of the scene has its own material ids, so they are bound per draw
+    if (lod > 0 && lod < material_offsets.size()) {
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER,
+          STORAGE_BUFFER_MATERIAL_ID_BINDING,
+          ssbo,
+          material_offsets[lod],
+          static_cast<GLsizeiptr>(mesh_lods[lod].index_count / 3 * sizeof(glm::vec4)));
+    } else {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BUFFER_MATERIAL_ID_BINDING, ssbo);
+    }
+
+    mesh->render(lod);
+}
 
 Model::~Model()
 {
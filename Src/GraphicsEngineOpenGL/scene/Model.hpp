@@ -1,10 +1,14 @@
 #pragma once
+#include <cstddef>
 #include <memory>
+#include <span>
 #include <vector>
 
 #include "ObjLoader.hpp"
+#include "scene/GltfLoader.hpp"
 #include "scene/AABB.hpp"
 #include "scene/Mesh.hpp"
+#include "scene/MeshLod.hpp"
 #include "scene/ObjMaterial.hpp"
 #include "scene/Vertex.hpp"
 #include "scene/texture/Texture.hpp"
@@ -16,6 +20,10 @@ class Model
 
     void load_model_in_ram(const std::string &model_path);
 
+    // the scene binds materials and textures of all its models back to back; shifts the
+    // material ids and texture ids of this model behind the ones before it. Call once after loading
+    void set_scene_offsets(uint32_t material_offset, uint32_t texture_offset);
+
     void create_render_context();
 
     void bind_ressources();
@@ -25,16 +33,22 @@ class Model
     std::shared_ptr<AABB> get_aabb();
     std::vector<ObjMaterial> get_materials() const;
     int get_texture_count() const;
+    const std::vector<MeshLod> &get_lods() const;
+    glm::vec4 get_bounding_sphere() const;
 
-    void render();
+    void render(uint32_t lod = 0);
 
     ~Model();
 
   private:
     // buffer for material id's
     GLuint ssbo;
+    // byte offset of every LOD's material ids inside ssbo, aligned for glBindBufferRange
+    std::vector<GLintptr> material_offsets;
 
     ObjLoader loader;
+    // keeps a .glb mapped until its embedded images are uploaded
+    std::shared_ptr<GltfLoader> gltf_loader;
 
     std::shared_ptr<AABB> aabb;
 
@@ -44,5 +58,10 @@ class Model
     std::vector<std::shared_ptr<Texture>> texture_list;
     std::vector<ObjMaterial> materials;
     std::vector<glm::vec4> materialIndex;
+    std::vector<MeshLod> lods;
     std::vector<std::string> textures;
+    // texture unit of the first texture relative to MODEL_TEXTURES_SLOT
+    uint32_t texture_offset{ 0 };
+    // parallel to textures; non empty views are images embedded in a .glb
+    std::vector<std::span<const std::byte>> embedded_textures;
 };
@@ -5,10 +5,14 @@
 #include "hostDevice/GlobalValues.hpp"
 #include "hostDevice/host_device_shared.hpp"
 #include "scene/Mesh.hpp"
+#include "scene/MeshCache.hpp"
+#include "scene/MeshSimplifier.hpp"
+#include "scene/VertexWelder.hpp"
 #include <filesystem>
 #include <iostream>
 #include <tiny_obj_loader.h>
-#include <unordered_map>
+
+#include "spdlog/spdlog.h"
 
 ObjLoader::ObjLoader() {}
 
@@ -17,8 +21,21 @@ void ObjLoader::load(std::string modelFile,
   std::vector<unsigned int> &indices,
   std::vector<std::string> &texture_list,
   std::vector<ObjMaterial> &materials,
-  std::vector<glm::vec4> &materialIndex)
+  std::vector<glm::vec4> &materialIndex,
+  std::vector<MeshLod> &lods)
 {
+    std::stringstream texture_base_dir;
+    std::filesystem::path cwd = std::filesystem::current_path();
+    texture_base_dir << cwd.string();
+    texture_base_dir << RELATIVE_RESOURCE_PATH << "Textures/plain.png";
+    texture_list.push_back(texture_base_dir.str());
+
+    // warm start: skip parsing entirely if the processed model is cached
+    MeshCache cache(modelFile, loader_version);
+    if (cache.load(vertices, indices, texture_list, materials, materialIndex, lods)) return;
+
+    const size_t first_model_texture = texture_list.size();
+
     tinyobj::ObjReaderConfig reader_config;
     tinyobj::ObjReader reader;
 
@@ -40,12 +57,6 @@ void ObjLoader::load(std::string modelFile,
     // texture at position 0 is plain texture to handle non existing materials
     int texture_id = 1;
 
-    std::stringstream texture_base_dir;
-    std::filesystem::path cwd = std::filesystem::current_path();
-    texture_base_dir << cwd.string();
-    texture_base_dir << RELATIVE_RESOURCE_PATH << "Textures/plain.png";
-    texture_list.push_back(texture_base_dir.str());
-
     // we now iterate over all materials to get diffuse textures
     for (size_t i = 0; i < tol_materials.size(); i++) {
         const tinyobj::material_t *mp = &tol_materials[i];
@@ -84,14 +95,15 @@ void ObjLoader::load(std::string modelFile,
     auto &attrib = reader.GetAttrib();
     auto &shapes = reader.GetShapes();
 
-    std::unordered_map<Vertex, uint32_t> vertices_map{};
+    size_t corner_count = 0;
+    for (const auto &shape : shapes) corner_count += shape.mesh.indices.size();
+
+    // expand all faces into one corner stream; the welder merges duplicates afterwards
+    std::vector<Vertex> corners;
+    corners.reserve(corner_count);
 
     // Loop over shapes
     for (size_t s = 0; s < shapes.size(); s++) {
-        // prepare for enlargement
-        vertices.reserve(shapes[s].mesh.indices.size() + vertices.size());
-        indices.reserve(shapes[s].mesh.indices.size() + indices.size());
-
         // Loop over faces(polygon)
         size_t index_offset = 0;
         for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
@@ -141,14 +153,7 @@ void ObjLoader::load(std::string modelFile,
                     tex_coords = glm::vec2(tx, ty);
                 }
 
-                Vertex vert{ pos, normals, color, tex_coords };
-
-                if (vertices_map.count(vert) == 0) {
-                    vertices_map[vert] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vert);
-                }
-
-                indices.push_back(vertices_map[vert]);
+                corners.emplace_back(pos, normals, color, tex_coords);
             }
 
             index_offset += fv;
@@ -159,6 +164,16 @@ void ObjLoader::load(std::string modelFile,
         }
     }
 
+    std::vector<Vertex> welded_vertices;
+    std::vector<uint32_t> remap;
+    VertexWelder welder;
+    welder.weld(corners, welded_vertices, remap);
+
+    const uint32_t first_vertex = static_cast<uint32_t>(vertices.size());
+    vertices.insert(vertices.end(), welded_vertices.begin(), welded_vertices.end());
+    indices.reserve(indices.size() + remap.size());
+    for (uint32_t index : remap) indices.push_back(first_vertex + index);
+
     // precompute normals if no provided
     if (attrib.normals.empty()) {
         for (size_t i = 0; i < indices.size(); i += 3) {
@@ -172,6 +187,17 @@ void ObjLoader::load(std::string modelFile,
             v2.normal = n;
         }
     }
+
+    // coarser levels index the same vertices and are appended behind LOD 0
+    MeshSimplifier simplifier;
+    lods = simplifier.buildLodChain(vertices, indices, materialIndex, lod_count);
+    for (size_t i = 1; i < lods.size(); i++) {
+        spdlog::info("LOD {} of {}: {} triangles, error {:.5f}", i, modelFile, lods[i].index_count / 3, lods[i].error);
+    }
+
+    // the plain texture depends on the working directory and is never cached
+    std::vector<std::string> model_textures(texture_list.begin() + first_model_texture, texture_list.end());
+    cache.store(vertices, indices, model_textures, materials, materialIndex, lods);
 }
 
 ObjLoader::~ObjLoader() {}
@@ -2,6 +2,7 @@
 #include <memory>
 #include <stdexcept>
 
+#include "scene/MeshLod.hpp"
 #include "scene/ObjMaterial.hpp"
 #include "scene/Vertex.hpp"
 
@@ -15,7 +16,15 @@ class ObjLoader
       std::vector<unsigned int> &indices,
       std::vector<std::string> &texture_list,
       std::vector<ObjMaterial> &materials,
-      std::vector<glm::vec4> &materialIndex);
+      std::vector<glm::vec4> &materialIndex,
+      std::vector<MeshLod> &lods);
+
+    // levels of detail generated per model, LOD 0 included. Coarser levels are opt-in: the geometry
+    // pass shaders have to look their materials up in the level's bound material id range
+    static constexpr uint32_t lod_count = 1;
+
+    // bump whenever the processed output changes; invalidates all mesh caches
+    static constexpr uint32_t loader_version = 4;
 
     ~ObjLoader();
 
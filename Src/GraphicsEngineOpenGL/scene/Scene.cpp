@@ -1,9 +1,14 @@
 #include "scene/Scene.hpp"
 
+#include "hostDevice/host_device_shared.hpp"
 #include "renderer/OpenGLRendererConfig.hpp"
+#include "scene/SceneFile.hpp"
+#include <cstdlib>
 #include <filesystem>
 #include <sstream>
 
+#include "spdlog/spdlog.h"
+
 Scene::Scene()
   :
 
@@ -71,36 +76,70 @@ std::vector<std::shared_ptr<PointLight>> Scene::get_point_lights() const { retur
 
 void Scene::load_models()
 {
-    glm::vec3 sponza_offset = glm::vec3(0.f, 0.0f, 0.0f);
-    GLfloat sponza_scale = 10.f;
-    Rotation sponza_rot;
-    sponza_rot.degrees = 0.0f;
-    sponza_rot.axis = glm::vec3(0.0f, 1.0f, 0.0f);
-
     glm::vec3 clouds_offset = glm::vec3(-3.f, 20.0f, -3.0f);
     glm::vec3 clouds_scale = glm::vec3(1.f, 1.f, 1.f);
     clouds->set_scale(clouds_scale);
     clouds->set_translation(clouds_offset);
 
-    std::stringstream modelFile;
+    std::stringstream sceneFile;
     std::filesystem::path cwd = std::filesystem::current_path();
-    modelFile << cwd.string();
-    modelFile << RELATIVE_RESOURCE_PATH << "Models/dinosaurs.obj";
-    /*"../Models/Pillum/PilumPainting_Export.obj",*/
-    /*"../Models/crytek-sponza/sponza_triag.obj",*/
-
-    std::shared_ptr<GameObject> sponza =
-      std::make_shared<GameObject>(modelFile.str(), sponza_offset, sponza_scale, sponza_rot);
-    progress += 1.f;
-
-    game_objects.push_back(sponza);
+    sceneFile << cwd.string();
+    sceneFile << RELATIVE_RESOURCE_PATH << "Scenes/dinosaurs.json";
+    // scenes can be switched without recompiling, e.g. for benchmarks
+    const char *scene_override = std::getenv("KATAGLYPHIS_SCENE");
+    const std::string scene_file_name = scene_override ? scene_override : sceneFile.str();
+
+    SceneFile scene_file;
+    if (!scene_file.load(scene_file_name)) exit(EXIT_FAILURE);
+
+    // materials and textures of all models are bound back to back
+    uint32_t material_count = 0;
+    uint32_t texture_count = 0;
+    const std::vector<SceneFileMesh> &scene_meshes = scene_file.getMeshes();
+    for (uint32_t m = 0; m < static_cast<uint32_t>(scene_meshes.size()); m++) {
+        const std::vector<glm::mat4> placements = scene_file.getPlacements(m);
+        if (placements.empty()) {
+            spdlog::warn("{} is never placed and not loaded", scene_meshes[m].name);
+            continue;
+        }
+
+        std::shared_ptr<Model> model = std::make_shared<Model>();
+        model->load_model_in_ram(scene_meshes[m].file);
+        model->set_scene_offsets(material_count, texture_count);
+        material_count += static_cast<uint32_t>(model->get_materials().size());
+        texture_count += static_cast<uint32_t>(model->get_texture_count());
+        models.push_back(model);
+
+        for (const glm::mat4 &placement : placements) {
+            game_objects.push_back(std::make_shared<GameObject>(model, placement));
+        }
+
+        mx_progress.lock();
+        progress = static_cast<GLfloat>(m + 1) / static_cast<GLfloat>(scene_meshes.size());
+        mx_progress.unlock();
+    }
+
+    if (material_count > static_cast<uint32_t>(MAX_MATERIALS)
+        || texture_count > static_cast<uint32_t>(MAX_TEXTURE_COUNT)) {
+        spdlog::warn(
+          "The scene has {} materials and {} textures, more than the shaders bind!", material_count, texture_count);
+    }
+    spdlog::info("Scene {}: {} models, {} instances", scene_file_name, models.size(), game_objects.size());
 
     mx_isLoaded.lock();
     loaded_scene = true;
     mx_isLoaded.unlock();
 }
 
-std::vector<ObjMaterial> Scene::get_materials() { return game_objects[0]->get_model()->get_materials(); }
+std::vector<ObjMaterial> Scene::get_materials()
+{
+    std::vector<ObjMaterial> materials;
+    for (std::shared_ptr<Model> model : models) {
+        const std::vector<ObjMaterial> model_materials = model->get_materials();
+        materials.insert(materials.end(), model_materials.begin(), model_materials.end());
+    }
+    return materials;
+}
 
 bool Scene::is_loaded()
 {
@@ -116,15 +155,26 @@ GLfloat Scene::get_progress()
 
 void Scene::setup_game_object_context()
 {
-    game_objects[0]->get_model()->create_render_context();
+    for (std::shared_ptr<Model> model : models) { model->create_render_context(); }
     context_setup = true;
 }
 
-void Scene::bind_textures_and_buffer() { game_objects[0]->get_model()->bind_ressources(); }
+void Scene::bind_textures_and_buffer()
+{
+    for (std::shared_ptr<Model> model : models) { model->bind_ressources(); }
+}
 
-void Scene::unbind_textures_and_buffer() { game_objects[0]->get_model()->unbind_resources(); }
+void Scene::unbind_textures_and_buffer()
+{
+    for (std::shared_ptr<Model> model : models) { model->unbind_resources(); }
+}
 
-int Scene::get_texture_count(int index) { return game_objects[0]->get_model()->get_texture_count(); }
+int Scene::get_texture_count(int index)
+{
+    int texture_count = 0;
+    for (std::shared_ptr<Model> model : models) { texture_count += model->get_texture_count(); }
+    return texture_count;
+}
 
 void Scene::set_context_setup(bool context_setup) { this->context_setup = context_setup; }
 
@@ -35,6 +35,7 @@ class Scene
     std::vector<std::shared_ptr<GameObject>> get_game_objects() const;
 
     void add_game_object(const std::string &model_path, glm::vec3 translation, GLfloat scale, Rotation rot);
+    // loads every mesh of the scene file once; each instance becomes a game object sharing it
     void load_models();
 
     bool is_loaded();
@@ -61,6 +62,8 @@ class Scene
     std::shared_ptr<ViewFrustumCulling> view_frustum_culling;
 
     std::vector<std::shared_ptr<GameObject>> game_objects;
+    // every model once, however many game objects instance it
+    std::vector<std::shared_ptr<Model>> models;
 
     GLfloat progress;
     bool loaded_scene;
@@ -0,0 +1,162 @@
+#include "scene/VertexWelder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include "util/Hash.hpp"
+
+namespace {
+
+constexpr uint32_t empty_slot = std::numeric_limits<uint32_t>::max();
+// below this many vertices a single shard is faster than spawning threads
+constexpr size_t min_vertices_per_shard = 1u << 15;
+
+using WeldKey = std::array<uint32_t, 11>;
+
+uint32_t floatKey(float value)
+{
+    // +0 and -0 compare equal, so they must hash equal as well
+    value += 0.0f;
+    return std::bit_cast<uint32_t>(value);
+}
+
+WeldKey makeKey(const Vertex &vertex, float position_epsilon)
+{
+    WeldKey key{};
+    if (position_epsilon > 0.0f) {
+        const float inverse_cell_size = 1.0f / position_epsilon;
+        key[0] = static_cast<uint32_t>(static_cast<int32_t>(std::floor(vertex.position.x * inverse_cell_size)));
+        key[1] = static_cast<uint32_t>(static_cast<int32_t>(std::floor(vertex.position.y * inverse_cell_size)));
+        key[2] = static_cast<uint32_t>(static_cast<int32_t>(std::floor(vertex.position.z * inverse_cell_size)));
+    } else {
+        key[0] = floatKey(vertex.position.x);
+        key[1] = floatKey(vertex.position.y);
+        key[2] = floatKey(vertex.position.z);
+    }
+    key[3] = floatKey(vertex.normal.x);
+    key[4] = floatKey(vertex.normal.y);
+    key[5] = floatKey(vertex.normal.z);
+    key[6] = floatKey(vertex.color.x);
+    key[7] = floatKey(vertex.color.y);
+    key[8] = floatKey(vertex.color.z);
+    key[9] = floatKey(vertex.texture_coords.x);
+    key[10] = floatKey(vertex.texture_coords.y);
+    return key;
+}
+
+template<typename Function> void parallelFor(size_t count, uint32_t thread_count, Function function)
+{
+    if (thread_count <= 1) {
+        function(size_t(0), count, 0u);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count);
+    const size_t per_thread = (count + thread_count - 1) / thread_count;
+    for (uint32_t t = 0; t < thread_count; t++) {
+        const size_t begin = std::min(count, per_thread * t);
+        const size_t end = std::min(count, begin + per_thread);
+        workers.emplace_back([=]() { function(begin, end, t); });
+    }
+    for (auto &worker : workers) worker.join();
+}
+
+}// namespace
+
+VertexWelder::VertexWelder(VertexWeldSettings settings) { this->settings = settings; }
+
+uint64_t VertexWelder::hashVertex(const Vertex &vertex, float position_epsilon)
+{
+    WeldKey key = makeKey(vertex, position_epsilon);
+    return hashBytes(key.data(), sizeof(WeldKey));
+}
+
+bool VertexWelder::equalVertices(const Vertex &a, const Vertex &b, float position_epsilon)
+{
+    return makeKey(a, position_epsilon) == makeKey(b, position_epsilon);
+}
+
+void VertexWelder::weld(std::span<const Vertex> input, std::vector<Vertex> &vertices, std::vector<uint32_t> &remap) const
+{
+    const size_t count = input.size();
+    const uint32_t shard_count = resolveShardCount(count);
+    const float position_epsilon = settings.position_epsilon;
+
+    // 1.) hash all vertices in parallel and count the shard sizes
+    std::vector<uint64_t> hashes(count);
+    std::vector<std::vector<size_t>> shard_sizes_per_thread(shard_count, std::vector<size_t>(shard_count, 0));
+    parallelFor(count, shard_count, [&](size_t begin, size_t end, uint32_t thread) {
+        std::vector<size_t> &shard_sizes = shard_sizes_per_thread[thread];
+        for (size_t i = begin; i < end; i++) {
+            hashes[i] = hashVertex(input[i], position_epsilon);
+            shard_sizes[(hashes[i] >> 32) % shard_count]++;
+        }
+    });
+
+    // 2.) weld every shard independently; representative[i] is the first
+    // input index that is equal to input[i]
+    std::vector<uint32_t> representative(count);
+    parallelFor(shard_count, shard_count, [&](size_t begin, size_t end, uint32_t) {
+        for (size_t shard = begin; shard < end; shard++) {
+            size_t shard_size = 0;
+            for (const auto &shard_sizes : shard_sizes_per_thread) shard_size += shard_sizes[shard];
+
+            // keep the load factor at or below 0.5
+            const size_t capacity = std::bit_ceil(std::max<size_t>(16, shard_size * 2));
+            const size_t mask = capacity - 1;
+            std::vector<uint32_t> table(capacity, empty_slot);
+
+            for (size_t i = 0; i < count; i++) {
+                const uint64_t hash = hashes[i];
+                if ((hash >> 32) % shard_count != shard) continue;
+
+                const WeldKey key = makeKey(input[i], position_epsilon);
+                size_t slot = hash & mask;
+                while (true) {
+                    const uint32_t candidate = table[slot];
+                    if (candidate == empty_slot) {
+                        table[slot] = static_cast<uint32_t>(i);
+                        representative[i] = static_cast<uint32_t>(i);
+                        break;
+                    }
+                    if (hashes[candidate] == hash && makeKey(input[candidate], position_epsilon) == key) {
+                        representative[i] = candidate;
+                        break;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+            }
+        }
+    });
+
+    // 3.) number the unique vertices in first-occurrence order; representatives
+    // always precede the vertices referencing them
+    vertices.clear();
+    vertices.reserve(count);
+    remap.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        if (representative[i] == i) {
+            remap[i] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(input[i]);
+        } else {
+            remap[i] = remap[representative[i]];
+        }
+    }
+}
+
+uint32_t VertexWelder::resolveShardCount(size_t vertex_count) const
+{
+    uint32_t shard_count = settings.shard_count;
+    if (shard_count == 0) {
+        shard_count = std::max(1u, std::thread::hardware_concurrency());
+        shard_count = static_cast<uint32_t>(
+          std::max<size_t>(1, std::min<size_t>(shard_count, vertex_count / min_vertices_per_shard)));
+    }
+    return shard_count;
+}
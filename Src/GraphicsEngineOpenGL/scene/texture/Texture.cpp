@@ -6,8 +6,40 @@
 #include "MirroredRepeatMode.hpp"
 #include "scene/texture/RepeatMode.hpp"
 
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 
+#include <ktx.h>
+
+namespace {
+
+struct Ktx2Target
+{
+    ktx_transcode_fmt_e transcode_format;
+    // 0 for the uncompressed fallback
+    GLenum compressed_format;
+};
+
+// best block format the context can sample, same preference as the Vulkan renderer
+Ktx2Target choose_ktx2_target(bool srgb, bool has_alpha)
+{
+    if (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_compression_bptc) {
+        return { KTX_TTF_BC7_RGBA, GLenum(srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM) };
+    }
+    if (GLAD_GL_KHR_texture_compression_astc_ldr) {
+        return { KTX_TTF_ASTC_4x4_RGBA,
+            GLenum(srgb ? GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR : GL_COMPRESSED_RGBA_ASTC_4x4_KHR) };
+    }
+    // BC1 only has 1 bit alpha; rather pay for RGBA8 than lose cutouts and blending
+    if (GLAD_GL_EXT_texture_compression_s3tc && !has_alpha && (!srgb || GLAD_GL_EXT_texture_sRGB)) {
+        return { KTX_TTF_BC1_RGB, GLenum(srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT) };
+    }
+    return { KTX_TTF_RGBA32, 0 };
+}
+
+}// namespace
+
 Texture::Texture()
   :
 
@@ -28,8 +60,10 @@ Texture::Texture(const char *file_loc, std::shared_ptr<TextureWrappingMode> wrap
 
 bool Texture::load_texture_without_alpha_channel()
 {
+    if (is_ktx2_file()) return load_ktx2_texture(false);
+
     stbi_set_flip_vertically_on_load(true);
-    unsigned char *texture_data = stbi_load(file_location.c_str(), &width, &height, &bit_depth, 0);
+    unsigned char *texture_data = load_pixels();
     if (!texture_data) {
         printf("Failed to find: %s\n", file_location.c_str());
         return false;
@@ -59,8 +93,10 @@ bool Texture::load_texture_without_alpha_channel()
 
 bool Texture::load_texture_with_alpha_channel()
 {
+    if (is_ktx2_file()) return load_ktx2_texture(false);
+
     stbi_set_flip_vertically_on_load(true);
-    unsigned char *texture_data = stbi_load(file_location.c_str(), &width, &height, &bit_depth, 0);
+    unsigned char *texture_data = load_pixels();
     if (!texture_data) {
         printf("Failed to find: %s\n", file_location.c_str());
         return false;
@@ -93,8 +129,10 @@ bool Texture::load_texture_with_alpha_channel()
 
 bool Texture::load_SRGB_texture_without_alpha_channel()
 {
+    if (is_ktx2_file()) return load_ktx2_texture(true);
+
     stbi_set_flip_vertically_on_load(true);
-    unsigned char *texture_data = stbi_load(file_location.c_str(), &width, &height, &bit_depth, 0);
+    unsigned char *texture_data = load_pixels();
     if (!texture_data) {
         printf("Failed to find: %s\n", file_location.c_str());
         return false;
@@ -124,8 +162,10 @@ bool Texture::load_SRGB_texture_without_alpha_channel()
 
 bool Texture::load_SRGB_texture_with_alpha_channel()
 {
+    if (is_ktx2_file()) return load_ktx2_texture(true);
+
     stbi_set_flip_vertically_on_load(true);
-    unsigned char *texture_data = stbi_load(file_location.c_str(), &width, &height, &bit_depth, 0);
+    unsigned char *texture_data = load_pixels();
     if (!texture_data) {
         printf("Failed to find: %s\n", file_location.c_str());
         return false;
@@ -156,6 +196,103 @@ bool Texture::load_SRGB_texture_with_alpha_channel()
     return true;
 }
 
+void Texture::set_encoded_data(std::span<const std::byte> encoded) { encoded_data = encoded; }
+
+unsigned char *Texture::load_pixels()
+{
+    if (encoded_data.empty()) return stbi_load(file_location.c_str(), &width, &height, &bit_depth, 0);
+    return stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(encoded_data.data()),
+      static_cast<int>(encoded_data.size()),
+      &width,
+      &height,
+      &bit_depth,
+      0);
+}
+
+bool Texture::is_ktx2_file() const { return std::filesystem::path(file_location).extension() == ".ktx2"; }
+
+bool Texture::load_ktx2_texture(bool srgb)
+{
+    ktxTexture2 *texture = nullptr;
+    KTX_error_code result =
+      ktxTexture2_CreateFromNamedFile(file_location.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture);
+    if (result != KTX_SUCCESS) {
+        printf("Failed to find: %s (%s)\n", file_location.c_str(), ktxErrorString(result));
+        return false;
+    }
+
+    // only Basis Universal (UASTC/ETC1S) payloads; those are what we bake
+    if (!ktxTexture2_NeedsTranscoding(texture)) {
+        printf("Not a Basis Universal ktx2 file: %s\n", file_location.c_str());
+        ktxTexture_Destroy(ktxTexture(texture));
+        return false;
+    }
+
+    // stb flips every image on load; block compressed data can't be flipped like
+    // that, so ktx2 files for this renderer have to be baked bottom up already
+    if (texture->orientation.y != KTX_ORIENT_Y_UP) {
+        printf("ktx2 texture is stored top down and will be upside down: %s\n", file_location.c_str());
+    }
+
+    const uint32_t components = ktxTexture2_GetNumComponents(texture);
+    const Ktx2Target target = choose_ktx2_target(srgb, components == 2 || components == 4);
+    result = ktxTexture2_TranscodeBasis(texture, target.transcode_format, 0);
+    if (result != KTX_SUCCESS) {
+        printf("Failed to transcode: %s (%s)\n", file_location.c_str(), ktxErrorString(result));
+        ktxTexture_Destroy(ktxTexture(texture));
+        return false;
+    }
+
+    width = static_cast<int>(texture->baseWidth);
+    height = static_cast<int>(texture->baseHeight);
+    bit_depth = 4;
+
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+
+    wrapping_mode->activate();
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture->numLevels) - 1);
+
+    // the file has the whole mip chain, no glGenerateMipmap
+    const ktx_uint8_t *data = ktxTexture_GetData(ktxTexture(texture));
+    for (uint32_t level = 0; level < texture->numLevels; level++) {
+        ktx_size_t offset = 0;
+        ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0, &offset);
+        const GLsizei level_width = static_cast<GLsizei>(std::max(1u, texture->baseWidth >> level));
+        const GLsizei level_height = static_cast<GLsizei>(std::max(1u, texture->baseHeight >> level));
+
+        if (target.compressed_format != 0) {
+            glCompressedTexImage2D(GL_TEXTURE_2D,
+              static_cast<GLint>(level),
+              target.compressed_format,
+              level_width,
+              level_height,
+              0,
+              static_cast<GLsizei>(ktxTexture_GetImageSize(ktxTexture(texture), level)),
+              data + offset);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D,
+              static_cast<GLint>(level),
+              srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8,
+              level_width,
+              level_height,
+              0,
+              GL_RGBA,
+              GL_UNSIGNED_BYTE,
+              data + offset);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    ktxTexture_Destroy(ktxTexture(texture));
+
+    return true;
+}
+
 std::string Texture::get_filename() const { return file_location; }
 
 void Texture::use_texture(unsigned int index)
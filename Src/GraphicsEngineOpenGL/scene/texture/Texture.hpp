@@ -4,7 +4,9 @@
 #include <stb_image.h>
 #include <string.h>
 
+#include <cstddef>
 #include <memory>
+#include <span>
 #include <string>
 
 #include "TextureWrappingMode.hpp"
@@ -16,6 +18,10 @@ class Texture
     Texture();
     Texture(const char *file_loc, std::shared_ptr<TextureWrappingMode> wrapping_mode);
 
+    // decode from an encoded image in memory (e.g. embedded in a .glb) instead of the file;
+    // the bytes have to stay valid until one of the load functions ran
+    void set_encoded_data(std::span<const std::byte> encoded);
+
     bool load_texture_without_alpha_channel();
     bool load_texture_with_alpha_channel();
 
@@ -33,10 +39,17 @@ class Texture
     ~Texture();
 
   private:
+    // .ktx2 files carry their own mip chain and are transcoded to a block format the driver supports
+    bool is_ktx2_file() const;
+    bool load_ktx2_texture(bool srgb);
+    // stbi_load of the file or of the encoded data
+    unsigned char *load_pixels();
+
     GLuint textureID;
     int width, height, bit_depth;
 
     std::shared_ptr<TextureWrappingMode> wrapping_mode;
 
     std::string file_location;
+    std::span<const std::byte> encoded_data;
 };
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// finalizer of MurmurHash3; spreads every input bit over the whole word
+inline uint64_t mixHash64(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+inline uint64_t combineHash64(uint64_t seed, uint64_t value)
+{
+    return mixHash64(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+// 64 bit hash over raw bytes; consumes 8 bytes per step which keeps hashing
+// of large files far below the time it takes to parse them
+inline uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0)
+{
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = seed ^ (size * 0x9e3779b97f4a7c15ULL);
+
+    size_t offset = 0;
+    for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + offset, sizeof(uint64_t));
+        hash = (hash ^ mixHash64(word)) * 0x9e3779b97f4a7c15ULL;
+        hash = (hash << 31) | (hash >> 33);
+    }
+
+    uint64_t tail = 0;
+    std::memcpy(&tail, bytes + offset, size - offset);
+    hash ^= mixHash64(tail);
+
+    return mixHash64(hash);
+}
@@ -0,0 +1,97 @@
+#include "util/MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {}
+
+bool MappedFile::open(const std::string &file_location)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(file_location.c_str(),
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+      nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    mapping_handle = mapping;
+    mapped_data = view;
+    mapped_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    int file_descriptor = ::open(file_location.c_str(), O_RDONLY);
+    if (file_descriptor < 0) return false;
+
+    struct stat file_stat
+    {
+    };
+    if (fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(file_descriptor);
+        return false;
+    }
+
+    void *view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    // the mapping keeps its own reference to the file
+    ::close(file_descriptor);
+    if (view == MAP_FAILED) return false;
+
+    madvise(view, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+
+    mapped_data = view;
+    mapped_size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mapped_data == nullptr) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mapped_data);
+    CloseHandle(static_cast<HANDLE>(mapping_handle));
+    CloseHandle(static_cast<HANDLE>(file_handle));
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+#else
+    munmap(mapped_data, mapped_size);
+#endif
+
+    mapped_data = nullptr;
+    mapped_size = 0;
+}
+
+MappedFile::~MappedFile() { close(); }
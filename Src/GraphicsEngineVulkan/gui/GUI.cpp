@@ -6,6 +6,7 @@
 
 #include "renderer/VulkanRendererConfig.hpp"
 
+#include <cstdio>
 #include <filesystem>
 
 #include <imgui.h>
@@ -109,6 +110,65 @@ void GUI::render()
 
     ImGui::Separator();
 
+    if (ImGui::CollapsingHeader("Texture streaming")) {
+        const TextureStreamingStats &streaming = guiRendererSharedVars.texture_streaming;
+        const float mib = 1.f / (1024.f * 1024.f);
+        ImGui::Text("Textures: %u, resident levels %u / %u",
+          streaming.texture_count,
+          streaming.resident_levels,
+          streaming.total_levels);
+        ImGui::Text("Resident %.1f MiB of %.1f MiB budget (view wants %.1f MiB)",
+          static_cast<float>(streaming.resident_bytes) * mib,
+          static_cast<float>(streaming.budget_bytes) * mib,
+          static_cast<float>(streaming.wanted_bytes) * mib);
+        ImGui::Text("Streaming %.2f MiB/s, %.1f MiB total, %u evictions",
+          static_cast<float>(streaming.streamed_bytes_per_second) * mib,
+          static_cast<float>(streaming.streamed_bytes) * mib,
+          streaming.evictions);
+    }
+
+    ImGui::Separator();
+
+    if (ImGui::CollapsingHeader("Memory")) {
+        const MemoryStats &memory = guiRendererSharedVars.memory;
+        const float mib = 1.f / (1024.f * 1024.f);
+        if (!memory.budget_from_driver) ImGui::Text("Budgets are estimated, VK_EXT_memory_budget is missing");
+        for (size_t i = 0; i < memory.heaps.size(); i++) {
+            const MemoryHeapStats &heap = memory.heaps[i];
+            const float usage = static_cast<float>(heap.usage) * mib;
+            const float budget = static_cast<float>(heap.budget) * mib;
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "%.1f / %.1f MiB", usage, budget);
+            ImGui::Text("Heap %zu (%s)", i, heap.device_local ? "device local" : "host");
+            ImGui::ProgressBar(budget > 0.f ? usage / budget : 0.f, ImVec2(-1.f, 0.f), overlay);
+        }
+
+        if (ImGui::BeginTable("memory_classes", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Category");
+            ImGui::TableSetupColumn("Allocations");
+            ImGui::TableSetupColumn("MiB");
+            ImGui::TableHeadersRow();
+            for (size_t i = 0; i < memory_class_count; i++) {
+                const MemoryClassStats &memory_class = memory.classes[i];
+                if (memory_class.allocation_count == 0) continue;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(getMemoryClassName(static_cast<MemoryClass>(i)));
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", memory_class.allocation_count);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", static_cast<float>(memory_class.bytes) * mib);
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::Button("Dump JSON")) { guiRendererSharedVars.dump_memory_stats_triggered = true; }
+        ImGui::SameLine();
+        if (ImGui::Button("Defragment textures")) { guiRendererSharedVars.defragment_memory_triggered = true; }
+    }
+
+    ImGui::Separator();
+
     if (ImGui::CollapsingHeader("KEY Bindings")) {
         ImGui::Text("WASD for moving Forward, backward and to the side\n QE for rotating ");
     }
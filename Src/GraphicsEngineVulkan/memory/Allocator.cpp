@@ -4,14 +4,42 @@
 
 using namespace Kataglyphis;
 
+namespace {
+
+size_t classIndex(MemoryClass memory_class) { return static_cast<size_t>(memory_class); }
+
+// block size of the pools of each class; 0 for classes without pools
+constexpr std::array<VkDeviceSize, memory_class_count> pool_block_sizes = {
+    0,// FROM_USAGE
+    64ull << 20,// GEOMETRY
+    4ull << 20,// UNIFORM
+    32ull << 20,// ACCELERATION_STRUCTURE
+    32ull << 20,// STAGING
+    128ull << 20,// TEXTURE
+    0,// RENDER_TARGET
+};
+
+// shader binding tables live in staging memory and have to start at shaderGroupBaseAlignment;
+// acceleration structures and build scratch at 256 bytes resp. minAccelerationStructureScratchOffsetAlignment
+constexpr VkDeviceSize address_alignment = 256;
+
+}// namespace
+
 Allocator::Allocator() {}
 
-Allocator::Allocator(const VkDevice &device, const VkPhysicalDevice &physicalDevice, const VkInstance &instance)
+Allocator::Allocator(const VkDevice &device,
+  const VkPhysicalDevice &physicalDevice,
+  const VkInstance &instance,
+  bool memory_budget)
 {
+    this->device = device;
+    this->memory_budget = memory_budget;
+
     // see here:
     // https://gpuopen-librariesandsdks.github.io/VulkanMemoryAllocator/html/quick_start.html
     VmaAllocatorCreateInfo allocatorCreateInfo = {};
     allocatorCreateInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+    if (memory_budget) allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
     allocatorCreateInfo.vulkanApiVersion = VK_API_VERSION_1_3;
     allocatorCreateInfo.physicalDevice = physicalDevice;
     allocatorCreateInfo.device = device;
@@ -20,6 +48,223 @@ Allocator::Allocator(const VkDevice &device, const VkPhysicalDevice &physicalDev
     ASSERT_VULKAN(vmaCreateAllocator(&allocatorCreateInfo, &vmaAllocator), "Failed to create vma allocator!")
 }
 
-void Allocator::cleanUp() { vmaDestroyAllocator(vmaAllocator); }
+VkResult Allocator::createBuffer(const VkBufferCreateInfo &buffer_info,
+  VkMemoryPropertyFlags memory_properties,
+  MemoryClass memory_class,
+  VkBuffer &buffer,
+  VmaAllocation &allocation,
+  VmaAllocationInfo &allocation_info)
+{
+    if (memory_class == MemoryClass::FROM_USAGE) memory_class = classify(buffer_info.usage, memory_properties);
+    VmaAllocationCreateInfo allocation_create_info = allocationInfo(memory_class, memory_properties);
+
+    // larger buffers would leave most of a block unused; VMA gives them memory of their own
+    if (buffer_info.size <= pool_block_sizes[classIndex(memory_class)] / 2) {
+        uint32_t memory_type_index = 0;
+        if (vmaFindMemoryTypeIndexForBufferInfo(vmaAllocator, &buffer_info, &allocation_create_info, &memory_type_index)
+            == VK_SUCCESS) {
+            allocation_create_info.pool = getPool(memory_class, memory_type_index);
+        }
+    }
+
+    VkResult result =
+      vmaCreateBuffer(vmaAllocator, &buffer_info, &allocation_create_info, &buffer, &allocation, &allocation_info);
+    if (result == VK_SUCCESS) track(memory_class, allocation);
+    return result;
+}
+
+VkResult Allocator::createImage(const VkImageCreateInfo &image_info,
+  VkMemoryPropertyFlags memory_properties,
+  VkImage &image,
+  VmaAllocation &allocation)
+{
+    const MemoryClass memory_class = classify(image_info);
+    VmaAllocationCreateInfo allocation_create_info = allocationInfo(memory_class, memory_properties);
+
+    // the size is only known once the image exists, so memory is allocated and bound separately
+    VkResult result = vkCreateImage(device, &image_info, nullptr, &image);
+    if (result != VK_SUCCESS) return result;
+
+    VkMemoryRequirements memory_requirements{};
+    vkGetImageMemoryRequirements(device, image, &memory_requirements);
+
+    if (memory_requirements.size <= pool_block_sizes[classIndex(memory_class)] / 2) {
+        uint32_t memory_type_index = 0;
+        if (vmaFindMemoryTypeIndexForImageInfo(vmaAllocator, &image_info, &allocation_create_info, &memory_type_index)
+            == VK_SUCCESS) {
+            allocation_create_info.pool = getPool(memory_class, memory_type_index);
+        }
+    }
+
+    result = vmaAllocateMemoryForImage(vmaAllocator, image, &allocation_create_info, &allocation, nullptr);
+    if (result != VK_SUCCESS) {
+        vkDestroyImage(device, image, nullptr);
+        return result;
+    }
+
+    result = vmaBindImageMemory(vmaAllocator, allocation, image);
+    if (result == VK_SUCCESS) track(memory_class, allocation);
+    return result;
+}
+
+void Allocator::destroyBuffer(VkBuffer buffer, VmaAllocation allocation)
+{
+    untrack(allocation);
+    vmaDestroyBuffer(vmaAllocator, buffer, allocation);
+}
+
+void Allocator::destroyImage(VkImage image, VmaAllocation allocation)
+{
+    untrack(allocation);
+    vmaDestroyImage(vmaAllocator, image, allocation);
+}
+
+MemoryClass Allocator::classify(VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties)
+{
+    if (memory_properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) return MemoryClass::STAGING;
+    if (usage & VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR) return MemoryClass::ACCELERATION_STRUCTURE;
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) return MemoryClass::UNIFORM;
+    return MemoryClass::GEOMETRY;
+}
+
+MemoryClass Allocator::classify(const VkImageCreateInfo &image_info)
+{
+    const VkImageUsageFlags render_target_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                                                  | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                                                  | VK_IMAGE_USAGE_STORAGE_BIT;
+    return (image_info.usage & render_target_usage) ? MemoryClass::RENDER_TARGET : MemoryClass::TEXTURE;
+}
+
+VmaDefragmentationStats Allocator::defragment(MemoryClass memory_class,
+  const std::function<void(std::span<VmaDefragmentationMove> moves)> &relocate)
+{
+    VmaDefragmentationStats stats{};
+
+    for (VmaPool pool : pools[classIndex(memory_class)]) {
+        if (pool == VK_NULL_HANDLE) continue;
+
+        VmaDefragmentationInfo defragmentation_info{};
+        defragmentation_info.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+        defragmentation_info.pool = pool;
+
+        VmaDefragmentationContext context;
+        VkResult result = vmaBeginDefragmentation(vmaAllocator, &defragmentation_info, &context);
+        ASSERT_VULKAN(result, "Failed to begin a defragmentation!")
+        if (result != VK_SUCCESS) continue;
+
+        // both ends of a pass return VK_SUCCESS once there is nothing left to move
+        while (true) {
+            VmaDefragmentationPassMoveInfo pass{};
+            if (vmaBeginDefragmentationPass(vmaAllocator, context, &pass) == VK_SUCCESS) break;
+            relocate(std::span<VmaDefragmentationMove>(pass.pMoves, pass.moveCount));
+            if (vmaEndDefragmentationPass(vmaAllocator, context, &pass) == VK_SUCCESS) break;
+        }
+
+        VmaDefragmentationStats pool_stats{};
+        vmaEndDefragmentation(vmaAllocator, context, &pool_stats);
+        stats.bytesMoved += pool_stats.bytesMoved;
+        stats.bytesFreed += pool_stats.bytesFreed;
+        stats.allocationsMoved += pool_stats.allocationsMoved;
+        stats.deviceMemoryBlocksFreed += pool_stats.deviceMemoryBlocksFreed;
+    }
+
+    return stats;
+}
+
+void Allocator::beginFrame() { vmaSetCurrentFrameIndex(vmaAllocator, ++frame_index); }
+
+MemoryStats Allocator::getStats() const
+{
+    MemoryStats stats;
+    stats.classes = class_stats;
+    stats.budget_from_driver = memory_budget;
+
+    const VkPhysicalDeviceMemoryProperties *memory_properties = nullptr;
+    vmaGetMemoryProperties(vmaAllocator, &memory_properties);
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+    vmaGetHeapBudgets(vmaAllocator, budgets.data());
+
+    stats.heaps.resize(memory_properties->memoryHeapCount);
+    for (uint32_t i = 0; i < memory_properties->memoryHeapCount; i++) {
+        MemoryHeapStats &heap = stats.heaps[i];
+        heap.device_local = memory_properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+        heap.usage = budgets[i].usage;
+        heap.budget = budgets[i].budget;
+        heap.block_bytes = budgets[i].statistics.blockBytes;
+        heap.allocation_bytes = budgets[i].statistics.allocationBytes;
+    }
+
+    return stats;
+}
+
+void Allocator::cleanUp()
+{
+    for (auto &class_pools : pools) {
+        for (VmaPool &pool : class_pools) {
+            if (pool != VK_NULL_HANDLE) vmaDestroyPool(vmaAllocator, pool);
+            pool = VK_NULL_HANDLE;
+        }
+    }
+    vmaDestroyAllocator(vmaAllocator);
+}
 
 Allocator::~Allocator() {}
+
+VmaPool Allocator::getPool(MemoryClass memory_class, uint32_t memory_type_index)
+{
+    VmaPool &pool = pools[classIndex(memory_class)][memory_type_index];
+    if (pool != VK_NULL_HANDLE) return pool;
+
+    VmaPoolCreateInfo pool_info{};
+    pool_info.memoryTypeIndex = memory_type_index;
+    pool_info.blockSize = pool_block_sizes[classIndex(memory_class)];
+    if (memory_class == MemoryClass::STAGING || memory_class == MemoryClass::ACCELERATION_STRUCTURE) {
+        pool_info.minAllocationAlignment = address_alignment;
+    }
+
+    VkResult result = vmaCreatePool(vmaAllocator, &pool_info, &pool);
+    ASSERT_VULKAN(result, "Failed to create a memory pool!")
+    // VMA's default pools take over then
+    if (result != VK_SUCCESS) return pool = VK_NULL_HANDLE;
+
+    vmaSetPoolName(vmaAllocator, pool, getMemoryClassName(memory_class));
+    return pool;
+}
+
+void Allocator::track(MemoryClass memory_class, VmaAllocation allocation)
+{
+    vmaSetAllocationUserData(vmaAllocator, allocation, reinterpret_cast<void *>(classIndex(memory_class)));
+
+    VmaAllocationInfo allocation_info{};
+    vmaGetAllocationInfo(vmaAllocator, allocation, &allocation_info);
+    MemoryClassStats &stats = class_stats[classIndex(memory_class)];
+    stats.allocation_count++;
+    stats.bytes += allocation_info.size;
+}
+
+void Allocator::untrack(VmaAllocation allocation)
+{
+    if (allocation == VK_NULL_HANDLE) return;
+
+    VmaAllocationInfo allocation_info{};
+    vmaGetAllocationInfo(vmaAllocator, allocation, &allocation_info);
+    MemoryClassStats &stats = class_stats[reinterpret_cast<size_t>(allocation_info.pUserData)];
+    stats.allocation_count--;
+    stats.bytes -= allocation_info.size;
+}
+
+VmaAllocationCreateInfo Allocator::allocationInfo(MemoryClass memory_class, VkMemoryPropertyFlags memory_properties)
+{
+    VmaAllocationCreateInfo allocation_create_info{};
+    allocation_create_info.usage = VMA_MEMORY_USAGE_AUTO;
+    allocation_create_info.requiredFlags = memory_properties;
+
+    if (memory_class == MemoryClass::STAGING) {
+        allocation_create_info.flags =
+          VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+    } else if (memory_class == MemoryClass::RENDER_TARGET) {
+        allocation_create_info.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    }
+
+    return allocation_create_info;
+}
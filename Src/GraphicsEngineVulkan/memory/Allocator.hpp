@@ -2,20 +2,76 @@
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.h>
 
+#include <array>
+#include <functional>
+#include <span>
 #include <stdexcept>
+
+#include "memory/MemoryStats.hpp"
+
 namespace Kataglyphis {
 
 class Allocator
 {
   public:
     Allocator();
-    Allocator(const VkDevice &device, const VkPhysicalDevice &physicalDevice, const VkInstance &instance);
+    // memory_budget: VK_EXT_memory_budget is enabled on device, budget and usage come from the driver then
+    Allocator(const VkDevice &device,
+      const VkPhysicalDevice &physicalDevice,
+      const VkInstance &instance,
+      bool memory_budget);
+
+    // memory_properties become the required flags of the memory type; STAGING memory comes back mapped
+    VkResult createBuffer(const VkBufferCreateInfo &buffer_info,
+      VkMemoryPropertyFlags memory_properties,
+      MemoryClass memory_class,
+      VkBuffer &buffer,
+      VmaAllocation &allocation,
+      VmaAllocationInfo &allocation_info);
+    VkResult createImage(const VkImageCreateInfo &image_info,
+      VkMemoryPropertyFlags memory_properties,
+      VkImage &image,
+      VmaAllocation &allocation);
+    void destroyBuffer(VkBuffer buffer, VmaAllocation allocation);
+    void destroyImage(VkImage image, VmaAllocation allocation);
+
+    static MemoryClass classify(VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties);
+    static MemoryClass classify(const VkImageCreateInfo &image_info);
+
+    // Compacts the pools of memory_class, e.g. after a long session of streaming. Each pass
+    // hands its moves to relocate, which has to bind a new resource to dstTmpAllocation and
+    // finish copying the old contents over before returning; moves it can't do are set to
+    // VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE. The device has to be idle.
+    VmaDefragmentationStats defragment(MemoryClass memory_class,
+      const std::function<void(std::span<VmaDefragmentationMove> moves)> &relocate);
+
+    // call once per frame; lets VMA refresh the budget it got from the driver
+    void beginFrame();
+    // live allocations per class and usage against budget per heap
+    MemoryStats getStats() const;
+
+    VmaAllocator getVmaAllocator() const { return vmaAllocator; };
 
     void cleanUp();
 
     ~Allocator();
 
   private:
-    VmaAllocator vmaAllocator;
+    VkDevice device{ VK_NULL_HANDLE };
+    VmaAllocator vmaAllocator{ VK_NULL_HANDLE };
+    bool memory_budget{ false };
+    uint32_t frame_index{ 0 };
+
+    // every allocation carries its class as user data, so it is taken off the right counter when freed;
+    // like the rest of the allocator only used from the render thread
+    std::array<MemoryClassStats, memory_class_count> class_stats{};
+    void track(MemoryClass memory_class, VmaAllocation allocation);
+    void untrack(VmaAllocation allocation);
+
+    // created on first use, one per class and memory type
+    std::array<std::array<VmaPool, VK_MAX_MEMORY_TYPES>, memory_class_count> pools{};
+
+    VmaPool getPool(MemoryClass memory_class, uint32_t memory_type_index);
+    VmaAllocationCreateInfo allocationInfo(MemoryClass memory_class, VkMemoryPropertyFlags memory_properties);
 };
-}// namespace Kataglyphis
\ No newline at end of file
+}// namespace Kataglyphis
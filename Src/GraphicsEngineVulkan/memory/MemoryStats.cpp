@@ -0,0 +1,55 @@
+#include "memory/MemoryStats.hpp"
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+
+using namespace Kataglyphis;
+
+uint64_t MemoryStats::getDeviceLocalHeadroom() const
+{
+    uint64_t headroom = 0;
+    for (const MemoryHeapStats &heap : heaps) {
+        if (heap.device_local && heap.budget > heap.usage) headroom += heap.budget - heap.usage;
+    }
+    return headroom;
+}
+
+std::string MemoryStats::toJson() const
+{
+    nlohmann::json json;
+    json["budget_from_driver"] = budget_from_driver;
+
+    nlohmann::json &json_classes = json["classes"];
+    json_classes = nlohmann::json::object();
+    // FROM_USAGE is resolved to one of the others before allocating
+    for (size_t i = static_cast<size_t>(MemoryClass::GEOMETRY); i < memory_class_count; i++) {
+        json_classes[getMemoryClassName(static_cast<MemoryClass>(i))] = {
+            { "allocation_count", classes[i].allocation_count }, { "bytes", classes[i].bytes }
+        };
+    }
+
+    nlohmann::json &json_heaps = json["heaps"];
+    json_heaps = nlohmann::json::array();
+    for (const MemoryHeapStats &heap : heaps) {
+        json_heaps.push_back({ { "device_local", heap.device_local },
+          { "usage", heap.usage },
+          { "budget", heap.budget },
+          { "block_bytes", heap.block_bytes },
+          { "allocation_bytes", heap.allocation_bytes } });
+    }
+
+    return json.dump(4);
+}
+
+bool MemoryStats::writeJson(const std::string &file_name) const
+{
+    std::ofstream file(file_name);
+    if (!file.is_open()) {
+        spdlog::error("Failed to open {} for the memory statistics!", file_name);
+        return false;
+    }
+    file << toJson() << '\n';
+    return true;
+}
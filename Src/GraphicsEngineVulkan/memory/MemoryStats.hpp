@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Kataglyphis {
+
+// Every buffer and image is sub-allocated from pools of its class. Keeping the
+// classes apart stops short lived resources (staging memory, streamed textures,
+// build scratch) from fragmenting the blocks of long lived ones.
+enum class MemoryClass {
+    // derive the class from usage and memory properties
+    FROM_USAGE,
+    // vertex, index, storage and indirect buffers
+    GEOMETRY,
+    UNIFORM,
+    // acceleration structure storage and build scratch
+    ACCELERATION_STRUCTURE,
+    // host visible and persistently mapped: staging memory, shader binding tables
+    STAGING,
+    // sampled images
+    TEXTURE,
+    // attachments and storage images; every one gets a dedicated allocation
+    RENDER_TARGET,
+    COUNT
+};
+
+constexpr size_t memory_class_count = static_cast<size_t>(MemoryClass::COUNT);
+
+inline const char *getMemoryClassName(MemoryClass memory_class)
+{
+    constexpr std::array<const char *, memory_class_count> names = {
+        "unclassified", "geometry", "uniform", "acceleration structure", "staging", "texture", "render target"
+    };
+    return memory_class < MemoryClass::COUNT ? names[static_cast<size_t>(memory_class)] : "invalid";
+}
+
+// live allocations of one memory class
+struct MemoryClassStats
+{
+    uint32_t allocation_count{ 0 };
+    uint64_t bytes{ 0 };
+};
+
+struct MemoryHeapStats
+{
+    bool device_local{ false };
+    // what the whole process uses of the heap and may use before the driver starts evicting;
+    // estimates from the heap size if VK_EXT_memory_budget isn't there
+    uint64_t usage{ 0 };
+    uint64_t budget{ 0 };
+    // device memory blocks of this allocator and the part of them handed out
+    uint64_t block_bytes{ 0 };
+    uint64_t allocation_bytes{ 0 };
+};
+
+// snapshot of the allocator, refreshed every frame and shown in the GUI
+struct MemoryStats
+{
+    std::array<MemoryClassStats, memory_class_count> classes{};
+    std::vector<MemoryHeapStats> heaps;
+    // false if budget and usage are only estimated
+    bool budget_from_driver{ false };
+
+    // budget left in the device local heaps
+    uint64_t getDeviceLocalHeadroom() const;
+
+    std::string toJson() const;
+    bool writeJson(const std::string &file_name) const;
+};
+
+}// namespace Kataglyphis
@@ -0,0 +1,333 @@
+#include "renderer/DepthPyramid.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <filesystem>
+#include <sstream>
+
+#include "renderer/pushConstants/PushConstantDepthPyramid.hpp"
+#include "util/File.hpp"
+#include "vulkan_base/ShaderHelper.hpp"
+
+#include "common/Utilities.hpp"
+#include "renderer/VulkanRendererConfig.hpp"
+
+Kataglyphis::VulkanRendererInternals::DepthPyramid::DepthPyramid() {}
+
+void Kataglyphis::VulkanRendererInternals::DepthPyramid::create(VulkanDevice *device,
+  VkCommandBuffer commandBuffer,
+  VkExtent2D depth_extent,
+  VkImage depth_image,
+  VkFormat depth_format)
+{
+    this->device = device;
+    this->depth_extent = depth_extent;
+    extent = pyramidExtent(depth_extent);
+    level_count = levelCount(extent);
+
+    pyramid.createImage(device,
+      extent.width,
+      extent.height,
+      level_count,
+      VK_FORMAT_R32_SFLOAT,
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    pyramid.createImageView(device, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, level_count);
+    // written and sampled in the same layout, so the build only needs memory barriers
+    pyramid.getVulkanImage().transitionImageLayout(
+      commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, level_count, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    VkImageViewCreateInfo view_create_info{};
+    view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_create_info.image = pyramid.getImage();
+    view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_create_info.format = VK_FORMAT_R32_SFLOAT;
+    view_create_info.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    level_views.resize(level_count);
+    for (uint32_t level = 0; level < level_count; level++) {
+        view_create_info.subresourceRange.baseMipLevel = level;
+        VkResult result =
+          vkCreateImageView(device->getLogicalDevice(), &view_create_info, nullptr, &level_views[level]);
+        ASSERT_VULKAN(result, "Failed to create a depth pyramid level view!")
+    }
+
+    // a sampled depth/stencil view may only contain one aspect
+    view_create_info.image = depth_image;
+    view_create_info.format = depth_format;
+    view_create_info.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+    VkResult result = vkCreateImageView(device->getLogicalDevice(), &view_create_info, nullptr, &depth_view);
+    ASSERT_VULKAN(result, "Failed to create the depth view of the depth pyramid!")
+
+    createSampler();
+    createDescriptorSets();
+    createPipeline();
+}
+
+void Kataglyphis::VulkanRendererInternals::DepthPyramid::shaderHotReload()
+{
+    vkDestroyPipeline(device->getLogicalDevice(), pipeline, nullptr);
+    vkDestroyPipelineLayout(device->getLogicalDevice(), pipeline_layout, nullptr);
+    createPipeline();
+}
+
+void Kataglyphis::VulkanRendererInternals::DepthPyramid::recordBuild(VkCommandBuffer &commandBuffer)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+    VkExtent2D source_size = depth_extent;
+    for (uint32_t level = 0; level < level_count; level++) {
+        // each level reads the one written before; the first barrier also orders the build after
+        // the occlusion tests of this frame
+        VkMemoryBarrier level_barrier{};
+        level_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        level_barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        level_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer,
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+          0,
+          1,
+          &level_barrier,
+          0,
+          nullptr,
+          0,
+          nullptr);
+
+        PushConstantDepthPyramid push_constant{};
+        push_constant.source_size = glm::uvec2(source_size.width, source_size.height);
+        push_constant.destination_size =
+          glm::uvec2(std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u));
+
+        vkCmdBindDescriptorSets(commandBuffer,
+          VK_PIPELINE_BIND_POINT_COMPUTE,
+          pipeline_layout,
+          0,
+          1,
+          &build_descriptor_sets[level],
+          0,
+          nullptr);
+        vkCmdPushConstants(commandBuffer,
+          pipeline_layout,
+          VK_SHADER_STAGE_COMPUTE_BIT,
+          0,
+          sizeof(PushConstantDepthPyramid),
+          &push_constant);
+
+        // matches local_size in depth_pyramid.comp
+        vkCmdDispatch(commandBuffer,
+          (push_constant.destination_size.x + 7) / 8,
+          (push_constant.destination_size.y + 7) / 8,
+          1);
+
+        source_size = { push_constant.destination_size.x, push_constant.destination_size.y };
+    }
+}
+
+VkExtent2D Kataglyphis::VulkanRendererInternals::DepthPyramid::pyramidExtent(VkExtent2D depth_extent)
+{
+    return { std::bit_floor(std::max(depth_extent.width, 1u)), std::bit_floor(std::max(depth_extent.height, 1u)) };
+}
+
+uint32_t Kataglyphis::VulkanRendererInternals::DepthPyramid::levelCount(VkExtent2D pyramid_extent)
+{
+    return static_cast<uint32_t>(std::bit_width(std::max(pyramid_extent.width, pyramid_extent.height)));
+}
+
+void Kataglyphis::VulkanRendererInternals::DepthPyramid::cleanUp()
+{
+    vkDestroyPipeline(device->getLogicalDevice(), pipeline, nullptr);
+    vkDestroyPipelineLayout(device->getLogicalDevice(), pipeline_layout, nullptr);
+
+    vkDestroyDescriptorPool(device->getLogicalDevice(), descriptor_pool, nullptr);
+    vkDestroyDescriptorSetLayout(device->getLogicalDevice(), build_descriptor_set_layout, nullptr);
+    vkDestroyDescriptorSetLayout(device->getLogicalDevice(), sampled_descriptor_set_layout, nullptr);
+    build_descriptor_sets.clear();
+
+    vkDestroySampler(device->getLogicalDevice(), sampler, nullptr);
+    vkDestroyImageView(device->getLogicalDevice(), depth_view, nullptr);
+    for (VkImageView view : level_views) { vkDestroyImageView(device->getLogicalDevice(), view, nullptr); }
+    level_views.clear();
+
+    pyramid.cleanUp();
+}
+
+Kataglyphis::VulkanRendererInternals::DepthPyramid::~DepthPyramid() {}
+
+void Kataglyphis::VulkanRendererInternals::DepthPyramid::createSampler()
+{
+    // the reduction already took the farthest depth; filtering would blend it with nearer texels
+    VkSamplerCreateInfo sampler_create_info{};
+    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_create_info.magFilter = VK_FILTER_NEAREST;
+    sampler_create_info.minFilter = VK_FILTER_NEAREST;
+    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+    sampler_create_info.unnormalizedCoordinates = VK_FALSE;
+    sampler_create_info.minLod = 0.0f;
+    sampler_create_info.maxLod = static_cast<float>(level_count);
+    sampler_create_info.anisotropyEnable = VK_FALSE;
+
+    VkResult result = vkCreateSampler(device->getLogicalDevice(), &sampler_create_info, nullptr, &sampler);
+    ASSERT_VULKAN(result, "Failed to create the depth pyramid sampler!")
+}
+
+void Kataglyphis::VulkanRendererInternals::DepthPyramid::createDescriptorSets()
+{
+    VkDescriptorSetLayoutBinding source_binding{};
+    source_binding.binding = 0;
+    source_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    source_binding.descriptorCount = 1;
+    source_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutBinding destination_binding{};
+    destination_binding.binding = 1;
+    destination_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    destination_binding.descriptorCount = 1;
+    destination_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    std::array<VkDescriptorSetLayoutBinding, 2> build_bindings = { source_binding, destination_binding };
+    VkDescriptorSetLayoutCreateInfo layout_create_info{};
+    layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_create_info.bindingCount = static_cast<uint32_t>(build_bindings.size());
+    layout_create_info.pBindings = build_bindings.data();
+    VkResult result = vkCreateDescriptorSetLayout(
+      device->getLogicalDevice(), &layout_create_info, nullptr, &build_descriptor_set_layout);
+    ASSERT_VULKAN(result, "Failed to create the depth pyramid build descriptor set layout!")
+
+    layout_create_info.bindingCount = 1;
+    layout_create_info.pBindings = &source_binding;
+    result = vkCreateDescriptorSetLayout(
+      device->getLogicalDevice(), &layout_create_info, nullptr, &sampled_descriptor_set_layout);
+    ASSERT_VULKAN(result, "Failed to create the depth pyramid descriptor set layout!")
+
+    std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_sizes[0].descriptorCount = level_count + 1;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    pool_sizes[1].descriptorCount = level_count;
+
+    VkDescriptorPoolCreateInfo pool_create_info{};
+    pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_create_info.maxSets = level_count + 1;
+    pool_create_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_create_info.pPoolSizes = pool_sizes.data();
+    result = vkCreateDescriptorPool(device->getLogicalDevice(), &pool_create_info, nullptr, &descriptor_pool);
+    ASSERT_VULKAN(result, "Failed to create the depth pyramid descriptor pool!")
+
+    std::vector<VkDescriptorSetLayout> build_layouts(level_count, build_descriptor_set_layout);
+    build_descriptor_sets.resize(level_count);
+    VkDescriptorSetAllocateInfo set_alloc_info{};
+    set_alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_alloc_info.descriptorPool = descriptor_pool;
+    set_alloc_info.descriptorSetCount = level_count;
+    set_alloc_info.pSetLayouts = build_layouts.data();
+    result = vkAllocateDescriptorSets(device->getLogicalDevice(), &set_alloc_info, build_descriptor_sets.data());
+    ASSERT_VULKAN(result, "Failed to allocate the depth pyramid build descriptor sets!")
+
+    set_alloc_info.descriptorSetCount = 1;
+    set_alloc_info.pSetLayouts = &sampled_descriptor_set_layout;
+    result = vkAllocateDescriptorSets(device->getLogicalDevice(), &set_alloc_info, &sampled_descriptor_set);
+    ASSERT_VULKAN(result, "Failed to allocate the depth pyramid descriptor set!")
+
+    // level 0 reduces the depth buffer, every further level the one before
+    std::vector<VkDescriptorImageInfo> source_infos(level_count);
+    std::vector<VkDescriptorImageInfo> destination_infos(level_count);
+    std::vector<VkWriteDescriptorSet> writes;
+    writes.reserve(2 * level_count + 1);
+    for (uint32_t level = 0; level < level_count; level++) {
+        source_infos[level].sampler = sampler;
+        source_infos[level].imageView = level == 0 ? depth_view : level_views[level - 1];
+        source_infos[level].imageLayout =
+          level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+        destination_infos[level].imageView = level_views[level];
+        destination_infos[level].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = build_descriptor_sets[level];
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &source_infos[level];
+        writes.push_back(write);
+
+        write.dstBinding = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        write.pImageInfo = &destination_infos[level];
+        writes.push_back(write);
+    }
+
+    VkDescriptorImageInfo pyramid_info{};
+    pyramid_info.sampler = sampler;
+    pyramid_info.imageView = pyramid.getImageView();
+    pyramid_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    VkWriteDescriptorSet pyramid_write{};
+    pyramid_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    pyramid_write.dstSet = sampled_descriptor_set;
+    pyramid_write.dstBinding = 0;
+    pyramid_write.descriptorCount = 1;
+    pyramid_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pyramid_write.pImageInfo = &pyramid_info;
+    writes.push_back(pyramid_write);
+
+    vkUpdateDescriptorSets(device->getLogicalDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void Kataglyphis::VulkanRendererInternals::DepthPyramid::createPipeline()
+{
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(PushConstantDepthPyramid);
+
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &build_descriptor_set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+    ASSERT_VULKAN(
+      vkCreatePipelineLayout(device->getLogicalDevice(), &pipeline_layout_create_info, nullptr, &pipeline_layout),
+      "Failed to create depth pyramid pipeline layout!");
+
+    std::stringstream rasterizer_shader_dir;
+    std::filesystem::path cwd = std::filesystem::current_path();
+    rasterizer_shader_dir << cwd.string();
+    rasterizer_shader_dir << RELATIVE_RESOURCE_PATH;
+    rasterizer_shader_dir << "Shaders/rasterizer/";
+
+    ShaderHelper shaderHelper;
+    shaderHelper.compileShader(rasterizer_shader_dir.str(), "depth_pyramid.comp");
+
+    File pyramidFile(shaderHelper.getShaderSpvDir(rasterizer_shader_dir.str(), "depth_pyramid.comp"));
+    std::vector<char> pyramid_shader_code = pyramidFile.readCharSequence();
+    VkShaderModule pyramid_shader_module = shaderHelper.createShaderModule(device, pyramid_shader_code);
+
+    VkPipelineShaderStageCreateInfo pyramid_shader_create_info{};
+    pyramid_shader_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pyramid_shader_create_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pyramid_shader_create_info.module = pyramid_shader_module;
+    pyramid_shader_create_info.pName = "main";
+
+    VkComputePipelineCreateInfo compute_pipeline_create_info{};
+    compute_pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    compute_pipeline_create_info.stage = pyramid_shader_create_info;
+    compute_pipeline_create_info.layout = pipeline_layout;
+    compute_pipeline_create_info.flags = 0;
+
+    ASSERT_VULKAN(
+      vkCreateComputePipelines(
+        device->getLogicalDevice(), VK_NULL_HANDLE, 1, &compute_pipeline_create_info, nullptr, &pipeline),
+      "Failed to create depth pyramid pipeline!");
+
+    vkDestroyShaderModule(device->getLogicalDevice(), pyramid_shader_module, nullptr);
+}
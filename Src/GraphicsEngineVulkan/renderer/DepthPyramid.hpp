@@ -0,0 +1,72 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "scene/Texture.hpp"
+#include "vulkan_base/VulkanDevice.hpp"
+
+namespace Kataglyphis::VulkanRendererInternals {
+// Hierarchical depth of a rasterized frame for occlusion culling. Level 0 holds the farthest depth
+// of the depth buffer shrunk to a power of two, every further level the farthest depth of the 2x2
+// texels below it; bounds whose nearest depth lies behind it are hidden.
+class DepthPyramid
+{
+  public:
+    DepthPyramid();
+
+    // the pyramid is left in VK_IMAGE_LAYOUT_GENERAL by commandBuffer
+    void create(VulkanDevice *device,
+      VkCommandBuffer commandBuffer,
+      VkExtent2D depth_extent,
+      VkImage depth_image,
+      VkFormat depth_format);
+
+    void shaderHotReload();
+
+    // the depth buffer has to be in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL and its
+    // writes visible to compute shaders
+    void recordBuild(VkCommandBuffer &commandBuffer);
+
+    // the whole pyramid as sampler2D, for the culling passes
+    VkDescriptorSetLayout getSampledDescriptorSetLayout() { return sampled_descriptor_set_layout; };
+    VkDescriptorSet getSampledDescriptorSet() { return sampled_descriptor_set; };
+    VkExtent2D getExtent() { return extent; };
+    uint32_t getLevelCount() { return level_count; };
+
+    // largest power of two per axis not above the depth buffer, so every further level halves exactly
+    static VkExtent2D pyramidExtent(VkExtent2D depth_extent);
+    static uint32_t levelCount(VkExtent2D pyramid_extent);
+
+    void cleanUp();
+
+    ~DepthPyramid();
+
+  private:
+    VulkanDevice *device{ VK_NULL_HANDLE };
+
+    VkExtent2D depth_extent{ 0, 0 };
+    VkExtent2D extent{ 0, 0 };
+    uint32_t level_count{ 0 };
+
+    Texture pyramid;
+    // one view per level to write it, the depth aspect of the depth buffer to read level 0 from
+    std::vector<VkImageView> level_views;
+    VkImageView depth_view{ VK_NULL_HANDLE };
+    VkSampler sampler{ VK_NULL_HANDLE };
+
+    VkDescriptorPool descriptor_pool{ VK_NULL_HANDLE };
+    // per level: the finer level (or the depth buffer) as source and the level as destination
+    VkDescriptorSetLayout build_descriptor_set_layout{ VK_NULL_HANDLE };
+    std::vector<VkDescriptorSet> build_descriptor_sets;
+    VkDescriptorSetLayout sampled_descriptor_set_layout{ VK_NULL_HANDLE };
+    VkDescriptorSet sampled_descriptor_set{ VK_NULL_HANDLE };
+
+    VkPipeline pipeline{ VK_NULL_HANDLE };
+    VkPipelineLayout pipeline_layout{ VK_NULL_HANDLE };
+
+    void createSampler();
+    void createDescriptorSets();
+    void createPipeline();
+};
+}// namespace Kataglyphis::VulkanRendererInternals
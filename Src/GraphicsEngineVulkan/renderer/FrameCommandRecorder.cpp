@@ -0,0 +1,120 @@
+#include "renderer/FrameCommandRecorder.hpp"
+
+#include <algorithm>
+
+#include "common/Utilities.hpp"
+
+Kataglyphis::VulkanRendererInternals::FrameCommandRecorder::FrameCommandRecorder() {}
+
+void Kataglyphis::VulkanRendererInternals::FrameCommandRecorder::create(VulkanDevice *device,
+  uint32_t frame_count,
+  bool reusable,
+  uint32_t thread_count)
+{
+    this->device = device;
+    this->thread_count = thread_count > 0 ? thread_count : JobPool::hardwareThreads();
+    usage_flags = reusable ? 0 : VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    // buffers are never reset one by one, only their whole pool per frame
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = reusable ? 0 : VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = device->getQueueFamilies().graphics_family;
+
+    frames.resize(frame_count);
+    for (FramePools &frame : frames) {
+        frame.pools.resize(this->thread_count, VK_NULL_HANDLE);
+        for (VkCommandPool &pool : frame.pools) {
+            VkResult result = vkCreateCommandPool(device->getLogicalDevice(), &pool_info, nullptr, &pool);
+            ASSERT_VULKAN(result, "Failed to create command pool!")
+        }
+        frame.secondaries.resize(this->thread_count);
+    }
+}
+
+void Kataglyphis::VulkanRendererInternals::FrameCommandRecorder::resetFrame(uint32_t frame)
+{
+    FramePools &frame_pools = frames[frame];
+    for (uint32_t thread = 0; thread < thread_count; thread++) {
+        VkResult result = vkResetCommandPool(device->getLogicalDevice(), frame_pools.pools[thread], 0);
+        ASSERT_VULKAN(result, "Failed to reset command pool!")
+        frame_pools.secondaries[thread].used = 0;
+    }
+    frame_pools.primaries.used = 0;
+}
+
+VkCommandBuffer Kataglyphis::VulkanRendererInternals::FrameCommandRecorder::beginPrimary(uint32_t frame)
+{
+    FramePools &frame_pools = frames[frame];
+    VkCommandBuffer command_buffer =
+      nextCommandBuffer(frame_pools.pools[0], VK_COMMAND_BUFFER_LEVEL_PRIMARY, frame_pools.primaries);
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = usage_flags;
+    VkResult result = vkBeginCommandBuffer(command_buffer, &begin_info);
+    ASSERT_VULKAN(result, "Failed to start recording a command buffer!")
+
+    return command_buffer;
+}
+
+const std::vector<VkCommandBuffer> &Kataglyphis::VulkanRendererInternals::FrameCommandRecorder::recordSecondary(
+  uint32_t frame,
+  uint32_t job_count,
+  const VkCommandBufferInheritanceInfo &inheritance,
+  const std::function<void(uint32_t, VkCommandBuffer)> &record)
+{
+    FramePools &frame_pools = frames[frame];
+    recorded.assign(std::min(job_count, thread_count), VK_NULL_HANDLE);
+
+    // job i records from pool i only, whichever thread of the job pool happens to run it
+    jobPool.run(static_cast<uint32_t>(recorded.size()), [&](uint32_t job) {
+        VkCommandBuffer command_buffer =
+          nextCommandBuffer(frame_pools.pools[job], VK_COMMAND_BUFFER_LEVEL_SECONDARY, frame_pools.secondaries[job]);
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = usage_flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        begin_info.pInheritanceInfo = &inheritance;
+        VkResult result = vkBeginCommandBuffer(command_buffer, &begin_info);
+        ASSERT_VULKAN(result, "Failed to start recording a command buffer!")
+
+        record(job, command_buffer);
+
+        result = vkEndCommandBuffer(command_buffer);
+        ASSERT_VULKAN(result, "Failed to stop recording a command buffer!")
+        recorded[job] = command_buffer;
+    });
+
+    return recorded;
+}
+
+void Kataglyphis::VulkanRendererInternals::FrameCommandRecorder::cleanUp()
+{
+    // destroying a pool frees all of its command buffers
+    for (FramePools &frame : frames) {
+        for (VkCommandPool pool : frame.pools) { vkDestroyCommandPool(device->getLogicalDevice(), pool, nullptr); }
+    }
+    frames.clear();
+    recorded.clear();
+}
+
+Kataglyphis::VulkanRendererInternals::FrameCommandRecorder::~FrameCommandRecorder() {}
+
+VkCommandBuffer Kataglyphis::VulkanRendererInternals::FrameCommandRecorder::nextCommandBuffer(VkCommandPool pool,
+  VkCommandBufferLevel level,
+  PooledCommandBuffers &pooled)
+{
+    if (pooled.used == pooled.command_buffers.size()) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.commandPool = pool;
+        alloc_info.level = level;
+        alloc_info.commandBufferCount = 1;
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        VkResult result = vkAllocateCommandBuffers(device->getLogicalDevice(), &alloc_info, &command_buffer);
+        ASSERT_VULKAN(result, "Failed to allocate command buffers!")
+        pooled.command_buffers.push_back(command_buffer);
+    }
+    return pooled.command_buffers[pooled.used++];
+}
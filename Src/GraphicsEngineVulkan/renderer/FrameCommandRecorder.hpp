@@ -0,0 +1,69 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <vector>
+
+#include "util/JobPool.hpp"
+#include "vulkan_base/VulkanDevice.hpp"
+
+namespace Kataglyphis::VulkanRendererInternals {
+// Command pools per swapchain image and recording thread. The primary command buffers of an
+// image and every secondary one recorded for it come from the pools of that image, so they are
+// recycled together with one vkResetCommandPool per pool, and no two threads ever record from
+// the same pool.
+class FrameCommandRecorder
+{
+  public:
+    FrameCommandRecorder();
+
+    // thread_count = 0 picks the core count; reusable command buffers may be submitted again
+    // until the next reset of their frame instead of only once
+    void create(VulkanDevice *device, uint32_t frame_count, bool reusable, uint32_t thread_count = 0);
+
+    uint32_t getThreadCount() { return thread_count; };
+
+    // recycles all command buffers of the frame; none of them may be pending any more
+    void resetFrame(uint32_t frame);
+    // begins the next primary command buffer of the frame
+    VkCommandBuffer beginPrimary(uint32_t frame);
+
+    // records job_count <= getThreadCount() secondary command buffers continuing the subpass given
+    // by inheritance. record(job, command_buffer) runs for all jobs in parallel, each on a begun
+    // buffer of its own pool; the ended buffers are returned in job order for vkCmdExecuteCommands
+    const std::vector<VkCommandBuffer> &recordSecondary(uint32_t frame,
+      uint32_t job_count,
+      const VkCommandBufferInheritanceInfo &inheritance,
+      const std::function<void(uint32_t, VkCommandBuffer)> &record);
+
+    void cleanUp();
+
+    ~FrameCommandRecorder();
+
+  private:
+    VulkanDevice *device{ VK_NULL_HANDLE };
+    uint32_t thread_count{ 0 };
+    VkCommandBufferUsageFlags usage_flags{ 0 };
+
+    // command buffers of one level allocated from a pool on demand and reused after every reset
+    struct PooledCommandBuffers
+    {
+        std::vector<VkCommandBuffer> command_buffers;
+        uint32_t used{ 0 };
+    };
+
+    struct FramePools
+    {
+        // one per thread, the first one holds the primary command buffers as well
+        std::vector<VkCommandPool> pools;
+        PooledCommandBuffers primaries;
+        std::vector<PooledCommandBuffers> secondaries;
+    };
+    std::vector<FramePools> frames;
+    std::vector<VkCommandBuffer> recorded;
+
+    JobPool jobPool;
+
+    VkCommandBuffer nextCommandBuffer(VkCommandPool pool, VkCommandBufferLevel level, PooledCommandBuffers &pooled);
+};
+}// namespace Kataglyphis::VulkanRendererInternals
@@ -1,3 +1,7 @@
+#pragma once
+#include "memory/MemoryStats.hpp"
+#include "scene/TextureStreamingStats.hpp"
+
 namespace Kataglyphis::VulkanRendererInternals::FrontendShared {
 struct GUIRendererSharedVars
 {
@@ -5,6 +9,12 @@ struct GUIRendererSharedVars
     bool pathTracing = false;
 
     bool shader_hot_reload_triggered = false;
+    bool defragment_memory_triggered = false;
+    bool dump_memory_stats_triggered = false;
+
+    // filled by the renderer every frame
+    Kataglyphis::TextureStreamingStats texture_streaming;
+    Kataglyphis::MemoryStats memory;
 
     // path tracing vars
 };
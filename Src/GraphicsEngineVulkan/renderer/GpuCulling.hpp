@@ -0,0 +1,64 @@
+// this little "hack" is needed for using it on the
+// CPU side as well for the GPU side :)
+// inspired by the NVDIDIA tutorial:
+// https://nvpro-samples.github.io/vk_raytracing_tutorial_KHR/
+
+#ifdef __cplusplus
+#pragma once
+#include <glm/glm.hpp>
+// GLSL Type
+using vec2 = glm::vec2;
+using vec3 = glm::vec3;
+using vec4 = glm::vec4;
+using mat4 = glm::mat4;
+using uint = unsigned int;
+namespace Kataglyphis::VulkanRendererInternals {
+#endif
+
+// marks a draw candidate that draws itself instead of deciding on the meshlets of its instance
+#define DRAW_CANDIDATE_NO_VISIBILITY 0xFFFFFFFFu
+
+// One indexed draw the object culling pass may emit: a submesh of a full resolution mesh or a
+// whole coarser level. It is drawn if the level of detail picked for its instance is its own
+// and its bounds survive the frustum and depth pyramid tests. Candidates of meshes culled per
+// meshlet draw nothing themselves but store whether the meshlets of the instance are wanted.
+struct DrawCandidate
+{
+    vec4 mesh_bounding_sphere;// object space of the whole mesh; the level of detail is picked with it
+    vec4 bounds_min;// xyz: object space bounds of the drawn triangles, w: error of the candidate's level
+    vec4 bounds_max;// w: error of the next coarser level, negative if there is none
+    uint group;// draw group: transform, draw count and its region of the draw commands
+    uint first_command;// first draw command of the group
+    uint index_count;
+    uint first_index;// in the geometry arena
+    int vertex_offset;
+    uint first_triangle;// in the mesh, for the per-triangle material lookup
+    uint visibility;// slot of the instance in the meshlet visibility flags, or DRAW_CANDIDATE_NO_VISIBILITY
+    uint padding;
+};
+
+// everything the culling passes need to know about the view, rewritten every frame
+struct CullingView
+{
+    mat4 view_projection;// frustum test
+    mat4 occlusion_view_projection;// view the depth pyramid was rendered from (the previous frame)
+    vec4 camera_position;// world space
+    vec2 pyramid_size;// texels of pyramid level 0
+    float lod_scale;// see selectLod()
+    float lod_threshold_pixels;
+    uint pyramid_levels;
+    uint occlusion_enabled;// 0 as long as the pyramid holds no frame yet
+    uint padding0;
+    uint padding1;
+};
+
+// view of one draw group in its object space for the meshlet culling pass, rewritten every frame
+struct MeshletCullingView
+{
+    mat4 model_view_projection;// frustum planes are extracted in object space
+    vec4 camera_position;// object space, for the normal cone test
+};
+
+#ifdef __cplusplus
+}// namespace Kataglyphis::VulkanRendererInternals
+#endif
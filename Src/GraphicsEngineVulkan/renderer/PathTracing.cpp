@@ -146,6 +146,10 @@ void Kataglyphis::VulkanRendererInternals::PathTracing::recordCommands(VkCommand
 
     vkCmdWriteTimestamp(
       commandBuffer, VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, queryPool, query++);
+}
+
+void Kataglyphis::VulkanRendererInternals::PathTracing::readTimings()
+{
     VkResult result = vkGetQueryPoolResults(device->getLogicalDevice(),
       queryPool,
       0,
@@ -21,6 +21,9 @@ class PathTracing
       VulkanImage &vulkanImage,
       VulkanSwapChain *vulkanSwapChain,
       const std::vector<VkDescriptorSet> &descriptorSets);
+    // fetches the timestamps of the last finished dispatch; the recorded commands may be reused,
+    // so this runs every frame on its own
+    void readTimings();
 
     void cleanUp();
 
@@ -1,10 +1,13 @@
 #include "Rasterizer.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <filesystem>
 #include <vector>
 
 #include "common/FormatHelper.hpp"
+#include "scene/CompactVertex.hpp"
 #include "scene/Vertex.hpp"
 #include "util/File.hpp"
 #include "vulkan_base/ShaderHelper.hpp"
@@ -22,11 +25,18 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::init(VulkanDevice *device
     this->device = device;
     this->vulkanSwapChain = vulkanSwapChain;
 
+    // decides about the depth buffer as well, it is sampled for the depth pyramid
+    gpuCullingSupported = device->supportsDrawIndirectCount();
+    // the new depth buffer holds no frame yet
+    depthPyramidValid = false;
+
     createTextures(commandPool);
     createRenderPass();
     createPushConstantRange();
     createGraphicsPipeline(descriptorSetLayouts);
     createFramebuffer();
+
+    if (gpuCullingSupported) { createCullingPipelines(); }
 }
 
 void Kataglyphis::VulkanRendererInternals::Rasterizer::shaderHotReload(
@@ -34,6 +44,15 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::shaderHotReload(
 {
     vkDestroyPipeline(device->getLogicalDevice(), graphics_pipeline, nullptr);
     createGraphicsPipeline(descriptor_set_layouts);
+
+    if (gpuCullingSupported) {
+        vkDestroyPipeline(device->getLogicalDevice(), object_culling_pipeline, nullptr);
+        vkDestroyPipelineLayout(device->getLogicalDevice(), object_culling_pipeline_layout, nullptr);
+        vkDestroyPipeline(device->getLogicalDevice(), meshlet_culling_pipeline, nullptr);
+        vkDestroyPipelineLayout(device->getLogicalDevice(), meshlet_culling_pipeline_layout, nullptr);
+        createCullingPipelines();
+        depthPyramid.shaderHotReload();
+    }
 }
 
 Kataglyphis::Texture &Kataglyphis::VulkanRendererInternals::Rasterizer::getOffscreenTexture(uint32_t index)
@@ -46,10 +65,221 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::setPushConstant(PushConst
     this->pushConstant = pushConstant;
 }
 
+void Kataglyphis::VulkanRendererInternals::Rasterizer::createDrawBuffers(Scene *scene)
+{
+    drawGroups.clear();
+    visibilitySlots.clear();
+    visibilitySlotCount = 0;
+
+    // every instance offers its full resolution submeshes and each coarser level as draws; the
+    // object culling pass keeps those of the level picked for the instance that are in view
+    std::vector<DrawCandidate> candidates;
+    uint32_t culled_command_count = 0;
+    for (uint32_t i = 0; i < scene->getInstanceCount(); i++) {
+        const SceneInstance &instance = scene->getInstance(i);
+        const uint32_t m = instance.model;
+        const uint32_t k = instance.mesh;
+        const VertexQuantization quantization = scene->getVertexQuantization(m, k);
+        if (drawGroups.empty() || drawGroups.back().model != m || drawGroups.back().transform != instance.transform
+            || drawGroups.back().quantization.position_offset != quantization.position_offset
+            || drawGroups.back().quantization.position_scale != quantization.position_scale) {
+            DrawGroup group{};
+            group.model = m;
+            group.first_instance = i;
+            group.transform = instance.transform;
+            group.quantization = quantization;
+            group.first_culled_command = culled_command_count;
+            drawGroups.push_back(group);
+        }
+
+        DrawGroup &group = drawGroups.back();
+        group.instance_count++;
+        if (!gpuCullingSupported) continue;
+
+        const GeometryRange &range = scene->getGeometryRange(m, k);
+        const std::vector<MeshLod> &lods = scene->getMeshLods(m, k);
+        const std::vector<Submesh> &submeshes = scene->getSubmeshes(m, k);
+        const uint32_t meshlet_count = scene->getMeshletCount(m, k);
+        const glm::vec4 sphere = scene->getMeshBoundingSphere(m, k);
+
+        // coarser levels are simplified over the whole mesh and tested with its bounds
+        glm::vec3 mesh_min;
+        glm::vec3 mesh_max;
+        scene->getMeshBounds(m, k, mesh_min, mesh_max);
+
+        const uint32_t lod_count = std::max(static_cast<uint32_t>(lods.size()), 1u);
+        auto add_candidate = [&](uint32_t lod,
+                               const glm::vec3 &bounds_min,
+                               const glm::vec3 &bounds_max,
+                               uint32_t index_offset,
+                               uint32_t index_count,
+                               uint32_t visibility) {
+            DrawCandidate candidate{};
+            candidate.mesh_bounding_sphere = sphere;
+            // level 0 is always good enough, see selectLod()
+            candidate.bounds_min = glm::vec4(bounds_min, lod == 0 ? 0.f : lods[lod].error);
+            candidate.bounds_max = glm::vec4(bounds_max, lod + 1 < lod_count ? lods[lod + 1].error : -1.f);
+            candidate.group = static_cast<uint32_t>(drawGroups.size() - 1);
+            candidate.first_command = group.first_culled_command;
+            candidate.index_count = index_count;
+            candidate.first_index = range.first_index + index_offset;
+            candidate.vertex_offset = static_cast<int32_t>(range.first_vertex);
+            // the first instance carries the first triangle in the mesh for the per-triangle material lookup
+            candidate.first_triangle = index_offset / 3;
+            candidate.visibility = visibility;
+            candidates.push_back(candidate);
+            if (visibility == DRAW_CANDIDATE_NO_VISIBILITY) group.culled_command_count++;
+        };
+
+        if (meshlet_count > 0) {
+            // the meshlet pass draws level 0 and only needs to know whether it is wanted
+            visibilitySlots.push_back(visibilitySlotCount);
+            add_candidate(0, mesh_min, mesh_max, 0, 0, visibilitySlotCount++);
+            group.culled_command_count += meshlet_count;
+        } else {
+            visibilitySlots.push_back(UINT32_MAX);
+            for (const Submesh &submesh : submeshes) {
+                add_candidate(0,
+                  submesh.aabb_min,
+                  submesh.aabb_max,
+                  submesh.index_offset,
+                  submesh.index_count,
+                  DRAW_CANDIDATE_NO_VISIBILITY);
+            }
+        }
+        for (uint32_t lod = 1; lod < lod_count; lod++) {
+            add_candidate(lod,
+              mesh_min,
+              mesh_max,
+              lods[lod].index_offset,
+              lods[lod].index_count,
+              DRAW_CANDIDATE_NO_VISIBILITY);
+        }
+        culled_command_count = group.first_culled_command + group.culled_command_count;
+    }
+
+    drawCandidateCount = static_cast<uint32_t>(candidates.size());
+    if (!gpuCullingSupported || drawCandidateCount == 0) return;
+
+    drawCandidateBuffer.create(device,
+      static_cast<VkDeviceSize>(drawCandidateCount) * sizeof(DrawCandidate),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    std::memcpy(drawCandidateBuffer.getMappedData(), candidates.data(), candidates.size() * sizeof(DrawCandidate));
+
+    const uint32_t image_count = vulkanSwapChain->getNumberSwapChainImages();
+    cullingViewBuffers.resize(image_count);
+    visibilityBuffers.resize(image_count);
+    drawCommandBuffers.resize(image_count);
+    drawCountBuffers.resize(image_count);
+    for (uint32_t i = 0; i < image_count; i++) {
+        cullingViewBuffers[i].create(device,
+          sizeof(CullingView) + drawGroups.size() * (sizeof(glm::mat4) + sizeof(MeshletCullingView)),
+          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        visibilityBuffers[i].create(device,
+          static_cast<VkDeviceSize>(std::max(visibilitySlotCount, 1u)) * sizeof(uint32_t),
+          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        drawCommandBuffers[i].create(device,
+          static_cast<VkDeviceSize>(std::max(culled_command_count, 1u)) * sizeof(VkDrawIndexedIndirectCommand),
+          VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        drawCountBuffers[i].create(device,
+          static_cast<VkDeviceSize>(drawGroups.size()) * sizeof(uint32_t),
+          VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+            | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+}
+
+void Kataglyphis::VulkanRendererInternals::Rasterizer::cleanUpDrawBuffers()
+{
+    drawCandidateBuffer.cleanUp();
+    for (VulkanBuffer &buffer : cullingViewBuffers) { buffer.cleanUp(); }
+    for (VulkanBuffer &buffer : visibilityBuffers) { buffer.cleanUp(); }
+    for (VulkanBuffer &buffer : drawCommandBuffers) { buffer.cleanUp(); }
+    for (VulkanBuffer &buffer : drawCountBuffers) { buffer.cleanUp(); }
+    cullingViewBuffers.clear();
+    visibilityBuffers.clear();
+    drawCommandBuffers.clear();
+    drawCountBuffers.clear();
+    drawGroups.clear();
+    visibilitySlots.clear();
+    drawCandidateCount = 0;
+}
+
+void Kataglyphis::VulkanRendererInternals::Rasterizer::setView(const glm::mat4 &view_projection,
+  const glm::vec3 &camera_position,
+  float lod_scale)
+{
+    viewProjection = view_projection;
+    cameraPosition = camera_position;
+    lodScale = lod_scale;
+}
+
+void Kataglyphis::VulkanRendererInternals::Rasterizer::updateFrame(uint32_t image_index, Scene *scene)
+{
+    if (commandsDependOnView()) return;
+
+    // view and transforms of this frame; host coherent, so they are visible once submitted
+    CullingView view{};
+    view.view_projection = viewProjection;
+    view.occlusion_view_projection = pyramidViewProjection;
+    view.camera_position = glm::vec4(cameraPosition, 1.f);
+    const VkExtent2D pyramid_extent = depthPyramid.getExtent();
+    view.pyramid_size = glm::vec2(pyramid_extent.width, pyramid_extent.height);
+    view.lod_scale = lodScale;
+    view.lod_threshold_pixels = lodErrorThresholdPixels;
+    view.pyramid_levels = depthPyramid.getLevelCount();
+    view.occlusion_enabled = depthPyramidValid ? 1 : 0;
+
+    std::vector<glm::mat4> transforms(drawGroups.size());
+    std::vector<MeshletCullingView> meshlet_views(drawGroups.size());
+    for (size_t g = 0; g < drawGroups.size(); g++) {
+        // cull with exactly the transform the draw uses
+        transforms[g] = scene->getInstanceTransform(drawGroups[g].first_instance);
+        meshlet_views[g].model_view_projection = viewProjection * transforms[g];
+        meshlet_views[g].camera_position = glm::inverse(transforms[g]) * glm::vec4(cameraPosition, 1.f);
+    }
+
+    auto *view_data = static_cast<std::byte *>(cullingViewBuffers[image_index].getMappedData());
+    std::memcpy(view_data, &view, sizeof(CullingView));
+    view_data += sizeof(CullingView);
+    std::memcpy(view_data, transforms.data(), transforms.size() * sizeof(glm::mat4));
+    view_data += transforms.size() * sizeof(glm::mat4);
+    std::memcpy(view_data, meshlet_views.data(), meshlet_views.size() * sizeof(MeshletCullingView));
+
+    // the frame ends with a pyramid build, the next one tests against it with the view it was rendered from
+    depthPyramidValid = true;
+    pyramidViewProjection = viewProjection;
+}
+
+uint32_t Kataglyphis::VulkanRendererInternals::Rasterizer::selectInstanceLod(Scene *scene, uint32_t instance_index)
+{
+    // same transform as the draw
+    const glm::mat4 model = scene->getInstanceTransform(instance_index);
+    const float scale = std::max(
+      { glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+
+    const SceneInstance &instance = scene->getInstance(instance_index);
+    const glm::vec4 sphere = scene->getMeshBoundingSphere(instance.model, instance.mesh);
+    const glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.f));
+    const float distance = std::max(glm::length(center - cameraPosition) - sphere.w * scale, 0.f);
+
+    // the errors are in object space, so compare against the distance in object units
+    return selectLod(scene->getMeshLods(instance.model, instance.mesh),
+      distance / std::max(scale, 1e-6f),
+      lodScale,
+      lodErrorThresholdPixels);
+}
+
 void Kataglyphis::VulkanRendererInternals::Rasterizer::recordCommands(VkCommandBuffer &commandBuffer,
   uint32_t image_index,
   Scene *scene,
-  const std::vector<VkDescriptorSet> &descriptorSets)
+  const std::vector<VkDescriptorSet> &descriptorSets,
+  FrameCommandRecorder &commandRecorder)
 {
     // information about how to begin a render pass (only needed for graphical
     // applications)
@@ -70,53 +300,297 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::recordCommands(VkCommandB
     render_pass_begin_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
     render_pass_begin_info.framebuffer = framebuffer[image_index];
 
-    // begin render pass
-    vkCmdBeginRenderPass(commandBuffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    // culling runs in compute and therefore has to be recorded outside of the render pass;
+    // without it the instances are culled and their levels of detail picked on the CPU
+    const bool gpu_culling = !commandsDependOnView();
+    if (gpu_culling) {
+        recordCulling(commandBuffer, image_index, scene);
+    } else {
+        frustumCuller.cull(scene->getInstanceBounds(), viewProjection, visibleInstances);
+    }
+
+    // one indirect draw per group after GPU culling, otherwise at least one draw per visible instance
+    const size_t draw_count = gpu_culling ? drawGroups.size() : visibleInstances.size();
+    const uint32_t recording_jobs = static_cast<uint32_t>(std::min<size_t>(
+      commandRecorder.getThreadCount(), draw_count / std::max(minDrawsPerRecordingJob, 1u)));
+
+    if (recording_jobs <= 1) {
+        vkCmdBeginRenderPass(commandBuffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        recordDraws(commandBuffer, image_index, scene, descriptorSets, gpu_culling, 0, draw_count);
+    } else {
+        // secondary command buffers inherit no state, so every job binds everything again
+        VkCommandBufferInheritanceInfo inheritance_info{};
+        inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance_info.renderPass = render_pass;
+        inheritance_info.subpass = 0;
+        inheritance_info.framebuffer = framebuffer[image_index];
+
+        // consecutive slices keep the draws in the order of a single threaded recording
+        const std::vector<VkCommandBuffer> &draw_command_buffers = commandRecorder.recordSecondary(image_index,
+          recording_jobs,
+          inheritance_info,
+          [&](uint32_t job, VkCommandBuffer draw_command_buffer) {
+              recordDraws(draw_command_buffer,
+                image_index,
+                scene,
+                descriptorSets,
+                gpu_culling,
+                draw_count * job / recording_jobs,
+                draw_count * (job + 1) / recording_jobs);
+          });
+
+        vkCmdBeginRenderPass(commandBuffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        vkCmdExecuteCommands(
+          commandBuffer, static_cast<uint32_t>(draw_command_buffers.size()), draw_command_buffers.data());
+    }
 
+    // end render pass
+    vkCmdEndRenderPass(commandBuffer);
+
+    // occluders for the next frame, see updateFrame()
+    if (gpu_culling) { depthPyramid.recordBuild(commandBuffer); }
+}
+
+void Kataglyphis::VulkanRendererInternals::Rasterizer::recordDraws(VkCommandBuffer commandBuffer,
+  uint32_t image_index,
+  Scene *scene,
+  const std::vector<VkDescriptorSet> &descriptorSets,
+  bool gpu_culling,
+  size_t begin,
+  size_t end)
+{
     // bind pipeline to be used in render pass
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
 
-    for (uint32_t m = 0; m < static_cast<uint32_t>(scene->getModelCount()); m++) {
+    // bind descriptor sets
+    vkCmdBindDescriptorSets(commandBuffer,
+      VK_PIPELINE_BIND_POINT_GRAPHICS,
+      pipeline_layout,
+      0,
+      static_cast<uint32_t>(descriptorSets.size()),
+      descriptorSets.data(),
+      0,
+      nullptr);
+
+    // every mesh is addressed by its vertexOffset/firstIndex in the arena; one binding for all of them
+    scene->getGeometryArena().bind(commandBuffer);
+
+    // may run on several threads at once, so the push constants are a copy per call
+    PushConstantRasterizer group_push_constant = pushConstant;
+    auto pushGroupConstants = [&](const DrawGroup &group) {
         // for GCC doen't allow references on rvalues go like that ...
-        pushConstant.model = scene->getModelMatrix(0);
+        group_push_constant.model = scene->getInstanceTransform(group.first_instance);
+        group_push_constant.position_offset = group.quantization.position_offset;
+        group_push_constant.position_scale = group.quantization.position_scale;
         // just "Push" constants to given shader stage directly (no buffer)
         vkCmdPushConstants(commandBuffer,
           pipeline_layout,
           VK_SHADER_STAGE_VERTEX_BIT,// stage to push constants to
           0,// offset to push constants to update
           sizeof(PushConstantRasterizer),// size of data being pushed
-          &pushConstant);// using model of current mesh (can be array)
-
-        for (unsigned int k = 0; k < scene->getMeshCount(m); k++) {
-            // list of vertex buffers we want to draw
-            VkBuffer vertex_buffers[] = { scene->getVertexBuffer(m, k) };// buffers to bind
-            VkDeviceSize offsets[] = { 0 };
-            vkCmdBindVertexBuffers(commandBuffer,
-              0,
-              1,
-              vertex_buffers,
-              offsets);// command to bind vertex buffer before drawing with them
-
-            // bind mesh index buffer with 0 offset and using the uint32 type
-            vkCmdBindIndexBuffer(commandBuffer, scene->getIndexBuffer(m, k), 0, VK_INDEX_TYPE_UINT32);
-
-            // bind descriptor sets
-            vkCmdBindDescriptorSets(commandBuffer,
-              VK_PIPELINE_BIND_POINT_GRAPHICS,
-              pipeline_layout,
-              0,
-              static_cast<uint32_t>(descriptorSets.size()),
-              descriptorSets.data(),
-              0,
-              nullptr);
-
-            // execute pipeline
-            vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(scene->getIndexCount(m, k)), 1, 0, 0, 0);
+          &group_push_constant);
+    };
+
+    // [begin, end) are draw groups; everything of a group that survived culling
+    if (gpu_culling) {
+        for (size_t g = begin; g < end; g++) {
+            const DrawGroup &group = drawGroups[g];
+            if (group.culled_command_count == 0) continue;
+            pushGroupConstants(group);
+            pvkCmdDrawIndexedIndirectCountKHR(commandBuffer,
+              drawCommandBuffers[image_index].getBuffer(),
+              group.first_culled_command * sizeof(VkDrawIndexedIndirectCommand),
+              drawCountBuffers[image_index].getBuffer(),
+              g * sizeof(uint32_t),
+              group.culled_command_count,
+              sizeof(VkDrawIndexedIndirectCommand));
         }
+        return;
     }
 
-    // end render pass
-    vkCmdEndRenderPass(commandBuffer);
+    // [begin, end) are visible instances; they are sorted, so each group takes the next run of them
+    if (begin == end) return;
+    auto first_group = std::upper_bound(drawGroups.cbegin(),
+      drawGroups.cend(),
+      visibleInstances[begin],
+      [](uint32_t instance, const DrawGroup &group) { return instance < group.first_instance; });
+    if (first_group != drawGroups.cbegin()) first_group--;
+
+    size_t v = begin;
+    for (auto group = first_group; group != drawGroups.cend() && v < end; group++) {
+        const uint32_t group_end = group->first_instance + group->instance_count;
+        while (v < end && visibleInstances[v] < group->first_instance) { v++; }
+        if (v == end || visibleInstances[v] >= group_end) continue;
+
+        pushGroupConstants(*group);
+
+        // full resolution meshes draw their submeshes (a single one unless they were split, see
+        // sceneConfig::getSplitSubmeshes()), coarser levels are drawn whole. gl_PrimitiveID
+        // restarts at 0 for every draw, so the first instance carries the draw's first triangle in
+        // the mesh; the scene shaders look materials up with MESH_TRIANGLE_ID of the flat
+        // forwarded gl_InstanceIndex
+        for (; v < end && visibleInstances[v] < group_end; v++) {
+            const uint32_t i = visibleInstances[v];
+            const uint32_t k = scene->getInstance(i).mesh;
+            const uint32_t lod = selectInstanceLod(scene, i);
+            const GeometryRange &range = scene->getGeometryRange(group->model, k);
+            if (lod == 0) {
+                for (const Submesh &submesh : scene->getSubmeshes(group->model, k)) {
+                    vkCmdDrawIndexed(commandBuffer,
+                      submesh.index_count,
+                      1,
+                      range.first_index + submesh.index_offset,
+                      static_cast<int32_t>(range.first_vertex),
+                      submesh.index_offset / 3);
+                }
+            } else {
+                const MeshLod &mesh_lod = scene->getMeshLods(group->model, k)[lod];
+                vkCmdDrawIndexed(commandBuffer,
+                  mesh_lod.index_count,
+                  1,
+                  range.first_index + mesh_lod.index_offset,
+                  static_cast<int32_t>(range.first_vertex),
+                  mesh_lod.index_offset / 3);
+            }
+        }
+    }
+}
+
+void Kataglyphis::VulkanRendererInternals::Rasterizer::recordCulling(VkCommandBuffer &commandBuffer,
+  uint32_t image_index,
+  Scene *scene)
+{
+    auto buffer_address = [this](VulkanBuffer &buffer) {
+        VkBufferDeviceAddressInfo address_info{};
+        address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        address_info.buffer = buffer.getBuffer();
+        return vkGetBufferDeviceAddress(device->getLogicalDevice(), &address_info);
+    };
+
+    VkBuffer draw_count_buffer = drawCountBuffers[image_index].getBuffer();
+    vkCmdFillBuffer(commandBuffer, draw_count_buffer, 0, VK_WHOLE_SIZE, 0);
+
+    // also orders the object culling pass after the depth pyramid build of the previous frame
+    VkMemoryBarrier reset_barrier{};
+    reset_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    reset_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    reset_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      1,
+      &reset_barrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
+
+    // the view is written by updateFrame(); the commands only refer to its buffer
+    const VkDeviceAddress view_address = buffer_address(cullingViewBuffers[image_index]);
+    const VkDeviceAddress meshlet_view_address =
+      view_address + sizeof(CullingView) + drawGroups.size() * sizeof(glm::mat4);
+    const VkDeviceAddress visibility_address = buffer_address(visibilityBuffers[image_index]);
+    const VkDeviceAddress draw_command_address = buffer_address(drawCommandBuffers[image_index]);
+    const VkDeviceAddress draw_count_address = buffer_address(drawCountBuffers[image_index]);
+
+    // -- object culling: one invocation per draw candidate of the scene
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, object_culling_pipeline);
+    VkDescriptorSet pyramid_descriptor_set = depthPyramid.getSampledDescriptorSet();
+    vkCmdBindDescriptorSets(commandBuffer,
+      VK_PIPELINE_BIND_POINT_COMPUTE,
+      object_culling_pipeline_layout,
+      0,
+      1,
+      &pyramid_descriptor_set,
+      0,
+      nullptr);
+
+    PushConstantObjectCulling object_culling{};
+    object_culling.candidate_address = buffer_address(drawCandidateBuffer);
+    object_culling.view_address = view_address;
+    object_culling.transform_address = view_address + sizeof(CullingView);
+    object_culling.draw_command_address = draw_command_address;
+    object_culling.draw_count_address = draw_count_address;
+    object_culling.visibility_address = visibility_address;
+    object_culling.candidate_count = drawCandidateCount;
+    vkCmdPushConstants(commandBuffer,
+      object_culling_pipeline_layout,
+      VK_SHADER_STAGE_COMPUTE_BIT,
+      0,
+      sizeof(PushConstantObjectCulling),
+      &object_culling);
+
+    // matches local_size_x in object_cull.comp
+    vkCmdDispatch(commandBuffer, (drawCandidateCount + 63) / 64, 1, 1);
+
+    // -- meshlet culling: the visibility flags and the draw counts of the pass above are read on
+    VkMemoryBarrier object_barrier{};
+    object_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    object_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    object_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      1,
+      &object_barrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
+
+    if (visibilitySlotCount > 0) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, meshlet_culling_pipeline);
+
+        for (uint32_t g = 0; g < static_cast<uint32_t>(drawGroups.size()); g++) {
+            const DrawGroup &group = drawGroups[g];
+
+            PushConstantMeshletCulling culling{};
+            culling.group_view_address = meshlet_view_address + g * sizeof(MeshletCullingView);
+            // all meshes of the group append to the same draws
+            culling.draw_command_address =
+              draw_command_address + group.first_culled_command * sizeof(VkDrawIndexedIndirectCommand);
+            culling.draw_count_address = draw_count_address + g * sizeof(uint32_t);
+
+            for (uint32_t i = group.first_instance; i < group.first_instance + group.instance_count; i++) {
+                if (visibilitySlots[i] == UINT32_MAX) continue;
+
+                const uint32_t k = scene->getInstance(i).mesh;
+                const GeometryRange &range = scene->getGeometryRange(group.model, k);
+                culling.meshlet_count = scene->getMeshletCount(group.model, k);
+                culling.meshlet_address = scene->getMeshletBufferAddress(group.model, k);
+                culling.first_index = range.first_index;
+                culling.vertex_offset = static_cast<int32_t>(range.first_vertex);
+                culling.visibility_address = visibility_address + visibilitySlots[i] * sizeof(uint32_t);
+
+                vkCmdPushConstants(commandBuffer,
+                  meshlet_culling_pipeline_layout,
+                  VK_SHADER_STAGE_COMPUTE_BIT,
+                  0,
+                  sizeof(PushConstantMeshletCulling),
+                  &culling);
+
+                // matches local_size_x in meshlet_cull.comp
+                vkCmdDispatch(commandBuffer, (culling.meshlet_count + 63) / 64, 1, 1);
+            }
+        }
+    }
+
+    VkMemoryBarrier cull_barrier{};
+    cull_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    cull_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    cull_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+      0,
+      1,
+      &cull_barrier,
+      0,
+      nullptr,
+      0,
+      nullptr);
 }
 
 void Kataglyphis::VulkanRendererInternals::Rasterizer::cleanUp()
@@ -130,6 +604,14 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::cleanUp()
     vkDestroyPipeline(device->getLogicalDevice(), graphics_pipeline, nullptr);
     vkDestroyPipelineLayout(device->getLogicalDevice(), pipeline_layout, nullptr);
     vkDestroyRenderPass(device->getLogicalDevice(), render_pass, nullptr);
+
+    if (gpuCullingSupported) {
+        vkDestroyPipeline(device->getLogicalDevice(), object_culling_pipeline, nullptr);
+        vkDestroyPipelineLayout(device->getLogicalDevice(), object_culling_pipeline_layout, nullptr);
+        vkDestroyPipeline(device->getLogicalDevice(), meshlet_culling_pipeline, nullptr);
+        vkDestroyPipelineLayout(device->getLogicalDevice(), meshlet_culling_pipeline_layout, nullptr);
+        depthPyramid.cleanUp();
+    }
 }
 
 Kataglyphis::VulkanRendererInternals::Rasterizer::~Rasterizer() {}
@@ -158,18 +640,17 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::createRenderPass()
 
     // depth attachment of render pass
     VkAttachmentDescription depth_attachment{};
-    depth_attachment.format = choose_supported_format(device->getPhysicalDevice(),
-      { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
-      VK_IMAGE_TILING_OPTIMAL,
-      VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+    depth_attachment.format = chooseDepthFormat();
 
     depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
     depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    // the depth pyramid is built from the depth after the render pass
+    depth_attachment.storeOp = gpuCullingSupported ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depth_attachment.finalLayout = gpuCullingSupported ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                                                       : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     // attachment reference uses an attachment index that refers to index in the
     // attachment list passed to renderPassCreateInfo
@@ -191,7 +672,7 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::createRenderPass()
     subpass.pDepthStencilAttachment = &depth_attachment_reference;
 
     // need to determine when layout transitions occur using subpass dependencies
-    std::array<VkSubpassDependency, 1> subpass_dependencies;
+    std::array<VkSubpassDependency, 2> subpass_dependencies;
 
     // conversion from VK_IMAGE_LAYOUT_UNDEFINED to
     // VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL transition must happen after ....
@@ -206,6 +687,21 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::createRenderPass()
     subpass_dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
     subpass_dependencies[0].dependencyFlags = 0;// VK_DEPENDENCY_BY_REGION_BIT;
 
+    // the depth pyramid build of the previous frame has to finish reading the depth buffer before
+    // it is cleared again
+    subpass_dependencies[0].srcStageMask |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    subpass_dependencies[0].dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    subpass_dependencies[0].dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    // ... and may only read it once it is written
+    subpass_dependencies[1].srcSubpass = 0;
+    subpass_dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    subpass_dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    subpass_dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    subpass_dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    subpass_dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    subpass_dependencies[1].dependencyFlags = 0;
+
     std::array<VkAttachmentDescription, 2> render_pass_attachments = { color_attachment, depth_attachment };
 
     // create info for render pass
@@ -285,10 +781,7 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::createTextures(VkCommandP
         offscreenTextures[index] = texture;
     }
 
-    VkFormat depth_format = choose_supported_format(device->getPhysicalDevice(),
-      { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
-      VK_IMAGE_TILING_OPTIMAL,
-      VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+    VkFormat depth_format = chooseDepthFormat();
 
     // create depth buffer image
     // MIP LEVELS: for depth texture we only want 1 level :)
@@ -299,7 +792,7 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::createTextures(VkCommandP
       1,
       depth_format,
       VK_IMAGE_TILING_OPTIMAL,
-      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | (gpuCullingSupported ? VK_IMAGE_USAGE_SAMPLED_BIT : 0),
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     // depth buffer image view
@@ -316,6 +809,10 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::createTextures(VkCommandP
       VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT,
       1);
 
+    if (gpuCullingSupported) {
+        depthPyramid.create(device, cmdBuffer, swap_chain_extent, depthBufferImage.getImage(), depth_format);
+    }
+
     commandBufferManager.endAndSubmitCommandBuffer(
       device->getLogicalDevice(), commandPool, device->getGraphicsQueue(), cmdBuffer);
 }
@@ -329,8 +826,13 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::createGraphicsPipeline(
     rasterizer_shader_dir << RELATIVE_RESOURCE_PATH;
     rasterizer_shader_dir << "Shaders/rasterizer/";
 
+    // the vertex shader reads the attribute layout selected here
+    const bool compact_vertices = sceneConfig::getCompactVertices();
+    std::vector<std::string> vertex_defines;
+    if (compact_vertices) vertex_defines.push_back("COMPACT_VERTICES");
+
     ShaderHelper shaderHelper;
-    shaderHelper.compileShader(rasterizer_shader_dir.str(), "shader.vert");
+    shaderHelper.compileShader(rasterizer_shader_dir.str(), "shader.vert", vertex_defines);
     shaderHelper.compileShader(rasterizer_shader_dir.str(), "shader.frag");
 
     File vertexFile(shaderHelper.getShaderSpvDir(rasterizer_shader_dir.str(), "shader.vert"));
@@ -364,12 +866,13 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::createGraphicsPipeline(
     // texture coords, normals, etc) is as a whole
     VkVertexInputBindingDescription binding_description{};
     binding_description.binding = 0;
-    binding_description.stride = sizeof(Vertex);
+    binding_description.stride = compact_vertices ? sizeof(CompactVertex) : sizeof(Vertex);
     binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;// how to move between data after each
                                                                 // vertex.
 
     // how the data for an attribute is defined within a vertex
-    std::array<VkVertexInputAttributeDescription, 4> attribute_describtions = vertex::getVertexInputAttributeDesc();
+    std::array<VkVertexInputAttributeDescription, 4> attribute_describtions =
+      compact_vertices ? vertex::getCompactVertexInputAttributeDesc() : vertex::getVertexInputAttributeDesc();
 
     // CREATE PIPELINE
     // 1.) Vertex input
@@ -503,3 +1006,87 @@ void Kataglyphis::VulkanRendererInternals::Rasterizer::createGraphicsPipeline(
     vkDestroyShaderModule(device->getLogicalDevice(), vertex_shader_module, nullptr);
     vkDestroyShaderModule(device->getLogicalDevice(), fragment_shader_module, nullptr);
 }
+
+VkFormat Kataglyphis::VulkanRendererInternals::Rasterizer::chooseDepthFormat()
+{
+    // the depth pyramid samples the depth buffer
+    VkFormatFeatureFlags features = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if (gpuCullingSupported) features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+    return choose_supported_format(device->getPhysicalDevice(),
+      { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
+      VK_IMAGE_TILING_OPTIMAL,
+      features);
+}
+
+void Kataglyphis::VulkanRendererInternals::Rasterizer::createCullingPipelines()
+{
+    pvkCmdDrawIndexedIndirectCountKHR = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(
+      device->getLogicalDevice(), "vkCmdDrawIndexedIndirectCountKHR");
+
+    // buffers are reached through buffer device addresses; only the depth pyramid is bound
+    createComputePipeline("object_cull.comp",
+      sizeof(PushConstantObjectCulling),
+      { depthPyramid.getSampledDescriptorSetLayout() },
+      object_culling_pipeline_layout,
+      object_culling_pipeline);
+    createComputePipeline("meshlet_cull.comp",
+      sizeof(PushConstantMeshletCulling),
+      {},
+      meshlet_culling_pipeline_layout,
+      meshlet_culling_pipeline);
+}
+
+void Kataglyphis::VulkanRendererInternals::Rasterizer::createComputePipeline(const std::string &shader_name,
+  uint32_t push_constant_size,
+  const std::vector<VkDescriptorSetLayout> &descriptor_set_layouts,
+  VkPipelineLayout &layout,
+  VkPipeline &pipeline)
+{
+    VkPushConstantRange culling_push_constant_range{};
+    culling_push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    culling_push_constant_range.offset = 0;
+    culling_push_constant_range.size = push_constant_size;
+
+    VkPipelineLayoutCreateInfo compute_pipeline_layout_create_info{};
+    compute_pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    compute_pipeline_layout_create_info.setLayoutCount = static_cast<uint32_t>(descriptor_set_layouts.size());
+    compute_pipeline_layout_create_info.pSetLayouts = descriptor_set_layouts.data();
+    compute_pipeline_layout_create_info.pushConstantRangeCount = 1;
+    compute_pipeline_layout_create_info.pPushConstantRanges = &culling_push_constant_range;
+
+    ASSERT_VULKAN(
+      vkCreatePipelineLayout(device->getLogicalDevice(), &compute_pipeline_layout_create_info, nullptr, &layout),
+      "Failed to create culling pipeline layout!");
+
+    std::stringstream rasterizer_shader_dir;
+    std::filesystem::path cwd = std::filesystem::current_path();
+    rasterizer_shader_dir << cwd.string();
+    rasterizer_shader_dir << RELATIVE_RESOURCE_PATH;
+    rasterizer_shader_dir << "Shaders/rasterizer/";
+
+    ShaderHelper shaderHelper;
+    shaderHelper.compileShader(rasterizer_shader_dir.str(), shader_name);
+
+    File cullingFile(shaderHelper.getShaderSpvDir(rasterizer_shader_dir.str(), shader_name));
+    std::vector<char> culling_shader_code = cullingFile.readCharSequence();
+    VkShaderModule culling_shader_module = shaderHelper.createShaderModule(device, culling_shader_code);
+
+    VkPipelineShaderStageCreateInfo culling_shader_create_info{};
+    culling_shader_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    culling_shader_create_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    culling_shader_create_info.module = culling_shader_module;
+    culling_shader_create_info.pName = "main";
+
+    VkComputePipelineCreateInfo compute_pipeline_create_info{};
+    compute_pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    compute_pipeline_create_info.stage = culling_shader_create_info;
+    compute_pipeline_create_info.layout = layout;
+    compute_pipeline_create_info.flags = 0;
+
+    ASSERT_VULKAN(vkCreateComputePipelines(
+                    device->getLogicalDevice(), VK_NULL_HANDLE, 1, &compute_pipeline_create_info, nullptr, &pipeline),
+      "Failed to create culling pipeline!");
+
+    vkDestroyShaderModule(device->getLogicalDevice(), culling_shader_module, nullptr);
+}
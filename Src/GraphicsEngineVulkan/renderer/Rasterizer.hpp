@@ -1,9 +1,16 @@
 #pragma once
 #include <vulkan/vulkan.h>
 
+#include "renderer/DepthPyramid.hpp"
+#include "renderer/FrameCommandRecorder.hpp"
+#include "renderer/GpuCulling.hpp"
+#include "renderer/pushConstants/PushConstantMeshletCulling.hpp"
+#include "renderer/pushConstants/PushConstantObjectCulling.hpp"
 #include "renderer/pushConstants/PushConstantRasterizer.hpp"
+#include "scene/FrustumCuller.hpp"
 #include "scene/Scene.hpp"
 #include "scene/Texture.hpp"
+#include "vulkan_base/VulkanBuffer.hpp"
 #include "vulkan_base/VulkanDevice.hpp"
 #include "vulkan_base/VulkanSwapChain.hpp"
 
@@ -24,10 +31,25 @@ class Rasterizer
 
     void setPushConstant(PushConstantRasterizer pushConstant);
 
+    // draw groups, draw candidates and indirect buffers depend on the loaded scene only
+    // and therefore outlive cleanUp()/init() on swapchain recreation
+    void createDrawBuffers(Scene *scene);
+    void cleanUpDrawBuffers();
+    // lod_scale = viewport_height / (2 * tan(fov_y / 2)), see selectLod()
+    void setView(const glm::mat4 &view_projection, const glm::vec3 &camera_position, float lod_scale);
+    // writes the view of the image for GPU culling and keeps track of the depth pyramid; due for
+    // every rasterized frame, also when the commands of the image were recorded in an earlier one
+    void updateFrame(uint32_t image_index, Scene *scene);
+    // GPU culling reads the view from buffers only, so its commands can be submitted again as long
+    // as the scene stays the same; the plain draws are culled while recording
+    bool commandsDependOnView() { return !gpuCullingSupported || drawCommandBuffers.empty(); };
+
+    // large draw lists are recorded in parallel into secondary command buffers of commandRecorder
     void recordCommands(VkCommandBuffer &commandBuffer,
       uint32_t image_index,
       Scene *scene,
-      const std::vector<VkDescriptorSet> &descriptorSets);
+      const std::vector<VkDescriptorSet> &descriptorSets,
+      FrameCommandRecorder &commandRecorder);
 
     void cleanUp();
 
@@ -50,6 +72,87 @@ class Rasterizer
     VkPipelineLayout pipeline_layout{ VK_NULL_HANDLE };
     VkRenderPass render_pass{ VK_NULL_HANDLE };
 
+    // -- draw groups: consecutive scene instances sharing their push constants (model, node
+    // transform, quantization); all of them are drawn from the bound geometry arena with a single
+    // indirect draw
+    struct DrawGroup
+    {
+        uint32_t model{ 0 };
+        uint32_t first_instance{ 0 };
+        uint32_t instance_count{ 0 };
+        glm::mat4 transform{ 1.f };
+        VertexQuantization quantization;
+        // region of the group in the culled draw commands, one command per meshlet and draw candidate
+        uint32_t first_culled_command{ 0 };
+        uint32_t culled_command_count{ 0 };
+    };
+    std::vector<DrawGroup> drawGroups;
+
+    // -- GPU culling: the object culling pass picks the level of detail of every instance and tests
+    // submeshes and coarser levels against the frustum and the depth pyramid of the previous frame;
+    // meshes with meshlets are culled once more per cluster. Both append to the draws of their group,
+    // so recording costs the same for any number of visible objects.
+    bool gpuCullingSupported{ false };
+    VkPipeline object_culling_pipeline{ VK_NULL_HANDLE };
+    VkPipelineLayout object_culling_pipeline_layout{ VK_NULL_HANDLE };
+    VkPipeline meshlet_culling_pipeline{ VK_NULL_HANDLE };
+    VkPipelineLayout meshlet_culling_pipeline_layout{ VK_NULL_HANDLE };
+    PFN_vkCmdDrawIndexedIndirectCountKHR pvkCmdDrawIndexedIndirectCountKHR{ nullptr };
+    // static for the loaded scene, see createDrawBuffers()
+    uint32_t drawCandidateCount{ 0 };
+    VulkanBuffer drawCandidateBuffer;
+    // slot of every instance in the meshlet visibility flags, UINT32_MAX if it is not culled per meshlet
+    std::vector<uint32_t> visibilitySlots;
+    uint32_t visibilitySlotCount{ 0 };
+    // per swapchain image, so frames in flight never share them: the CullingView followed by one
+    // transform per draw group and one MeshletCullingView per draw group, the visibility flags, the
+    // draw commands and one count per draw group
+    std::vector<VulkanBuffer> cullingViewBuffers;
+    std::vector<VulkanBuffer> visibilityBuffers;
+    std::vector<VulkanBuffer> drawCommandBuffers;
+    std::vector<VulkanBuffer> drawCountBuffers;
+    glm::mat4 viewProjection{ 1.f };
+    glm::vec3 cameraPosition{ 0.f };
+
+    // -- occlusion: built from the depth buffer after every frame and tested in the next one
+    DepthPyramid depthPyramid;
+    bool depthPyramidValid{ false };
+    glm::mat4 pyramidViewProjection{ 1.f };
+
+    // -- level of detail: the coarsest level whose error stays below this many pixels is drawn
+    float lodScale{ 1.f };
+    float lodErrorThresholdPixels{ 1.f };
+    // CPU selection for the plain draws without GPU culling
+    uint32_t selectInstanceLod(Scene *scene, uint32_t instance_index);
+
+    // -- CPU culling for the plain draws: the instances whose world bounds touch the frustum
+    FrustumCuller frustumCuller;
+    std::vector<uint32_t> visibleInstances;
+
+    // -- draw recording: below this many draws per job splitting the render pass into secondary
+    // command buffers costs more than recording it on one thread
+    uint32_t minDrawsPerRecordingJob{ 512 };
+    // records the draws [begin, end) of the render pass, which are draw groups with GPU culling and
+    // visible instances without; binds all state itself and only reads shared members. Every draw
+    // passes its first triangle in the mesh as firstInstance, which the scene shaders must add to
+    // gl_PrimitiveID for the material lookup (MESH_TRIANGLE_ID)
+    void recordDraws(VkCommandBuffer commandBuffer,
+      uint32_t image_index,
+      Scene *scene,
+      const std::vector<VkDescriptorSet> &descriptorSets,
+      bool gpu_culling,
+      size_t begin,
+      size_t end);
+
+    void createCullingPipelines();
+    void createComputePipeline(const std::string &shader_name,
+      uint32_t push_constant_size,
+      const std::vector<VkDescriptorSetLayout> &descriptor_set_layouts,
+      VkPipelineLayout &layout,
+      VkPipeline &pipeline);
+    void recordCulling(VkCommandBuffer &commandBuffer, uint32_t image_index, Scene *scene);
+
+    VkFormat chooseDepthFormat();
     void createTextures(VkCommandPool &commandPool);
     void createGraphicsPipeline(const std::vector<VkDescriptorSetLayout> &descriptorSetLayouts);
     void createRenderPass();
@@ -321,21 +321,10 @@ void Kataglyphis::VulkanRendererInternals::Raytracing::createSBT()
 
     hitShaderBindingTableBuffer.create(device, handle_size, bufferUsageFlags, memoryUsageFlags);
 
-    void *mapped_raygen = nullptr;
-    vkMapMemory(device->getLogicalDevice(),
-      raygenShaderBindingTableBuffer.getBufferMemory(),
-      0,
-      VK_WHOLE_SIZE,
-      0,
-      &mapped_raygen);
-
-    void *mapped_miss = nullptr;
-    vkMapMemory(
-      device->getLogicalDevice(), missShaderBindingTableBuffer.getBufferMemory(), 0, VK_WHOLE_SIZE, 0, &mapped_miss);
-
-    void *mapped_rchit = nullptr;
-    vkMapMemory(
-      device->getLogicalDevice(), hitShaderBindingTableBuffer.getBufferMemory(), 0, VK_WHOLE_SIZE, 0, &mapped_rchit);
+    // host visible buffers are persistently mapped
+    void *mapped_raygen = raygenShaderBindingTableBuffer.getMappedData();
+    void *mapped_miss = missShaderBindingTableBuffer.getMappedData();
+    void *mapped_rchit = hitShaderBindingTableBuffer.getMappedData();
 
     memcpy(mapped_raygen, handles.data(), handle_size);
     memcpy(mapped_miss, handles.data() + handle_size_aligned, handle_size * 2);
@@ -65,8 +65,6 @@ Kataglyphis::VulkanRenderer::VulkanRenderer(Kataglyphis::Frontend::Window *windo
 
     device = std::make_unique<VulkanDevice>(&instance, &surface);
 
-    allocator = Allocator(device->getLogicalDevice(), device->getPhysicalDevice(), instance.getVulkanInstance());
-
     create_command_pool();
 
     vulkanSwapChain.initVulkanContext(device.get(), window, surface);
@@ -96,11 +94,12 @@ Kataglyphis::VulkanRenderer::VulkanRenderer(Kataglyphis::Frontend::Window *windo
         pathTracing.init(device.get(), layouts);
     }
 
-    scene->loadModel(device.get(), graphics_command_pool);
+    scene->loadModel(device.get(), graphics_command_pool, transfer_command_pool);
     updateTexturesInSharedRenderDescriptorSet();
+    rasterizer.createDrawBuffers(scene);
 
     if (device->supportsHardwareAcceleratedRRT()) {
-        asManager.createASForScene(device.get(), graphics_command_pool, scene);
+        asManager.createASForScene(device.get(), graphics_command_pool, transfer_command_pool, scene);
     }
 
     create_object_description_buffer();
@@ -124,6 +123,11 @@ void Kataglyphis::VulkanRenderer::updateUniforms(Scene *scene, Camera *camera, K
       (float)window->get_width() / (float)window->get_height(),
       camera->get_near_plane(),
       camera->get_far_plane());
+    const float lod_scale =
+      static_cast<float>(window->get_height()) / (2.f * std::tan(glm::radians(camera->get_fov()) * 0.5f));
+    rasterizer.setView(globalUBO.projection * globalUBO.view, camera->get_camera_position(), lod_scale);
+    streaming_camera_position = camera->get_camera_position();
+    streaming_lod_scale = lod_scale;
 
     sceneUBO.view_dir = glm::vec4(camera->get_camera_direction(), 1.0f);
 
@@ -144,6 +148,19 @@ void Kataglyphis::VulkanRenderer::updateStateDueToUserInput(Kataglyphis::Fronten
         shaderHotReload();
         guiRendererSharedVars.shader_hot_reload_triggered = false;
     }
+
+    if (guiRendererSharedVars.defragment_memory_triggered) {
+        defragmentMemory();
+        guiRendererSharedVars.defragment_memory_triggered = false;
+    }
+
+    if (guiRendererSharedVars.dump_memory_stats_triggered) {
+        const std::string file_name = "memory_stats.json";
+        if (guiRendererSharedVars.memory.writeJson(file_name)) {
+            spdlog::info("Wrote memory statistics to {}", file_name);
+        }
+        guiRendererSharedVars.dump_memory_stats_triggered = false;
+    }
 }
 
 void Kataglyphis::VulkanRenderer::finishAllRenderCommands() { vkDeviceWaitIdle(device->getLogicalDevice()); }
@@ -162,6 +179,19 @@ void Kataglyphis::VulkanRenderer::shaderHotReload()
     std::vector<VkDescriptorSetLayout> layouts = { sharedRenderDescriptorSetLayout, raytracingDescriptorSetLayout };
     raytracingStage.shaderHotReload(layouts);
     pathTracing.shaderHotReload(layouts);
+
+    // the kept commands still bind the destroyed pipelines
+    invalidateSceneCommands();
+}
+
+void Kataglyphis::VulkanRenderer::defragmentMemory()
+{
+    // moved images are copied on the graphics queue and their old memory is released right away
+    vkDeviceWaitIdle(device->getLogicalDevice());
+
+    if (scene->defragmentTextureMemory(device.get(), graphics_command_pool)) {
+        updateTexturesInSharedRenderDescriptorSet();
+    }
 }
 
 void Kataglyphis::VulkanRenderer::drawFrame()
@@ -203,23 +233,53 @@ void Kataglyphis::VulkanRenderer::drawFrame()
     // mark the image as now being in use by this frame
     images_in_flight_fences[image_index] = in_flight_fences[current_frame];
 
-    VkCommandBufferBeginInfo buffer_begin_info{};
-    buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    // start recording commands to command buffer
-    result = vkBeginCommandBuffer(command_buffers[image_index], &buffer_begin_info);
-    ASSERT_VULKAN(result, "Failed to start recording a command buffer!")
-
-    update_uniform_buffers(image_index);
+    updateMemoryStats();
+    updateTextureStreaming(image_index);
 
     Kataglyphis::VulkanRendererInternals::FrontendShared::GUIRendererSharedVars &guiRendererSharedVars =
       gui->getGuiRendererSharedVars();
-    if (guiRendererSharedVars.raytracing) update_raytracing_descriptor_set(image_index);
+    const RenderStage render_stage = guiRendererSharedVars.raytracing    ? RenderStage::RAYTRACING
+                                     : guiRendererSharedVars.pathTracing ? RenderStage::PATH_TRACING
+                                                                         : RenderStage::RASTERIZER;
+    if (render_stage != recorded_render_stage || scene->getRevision() != recorded_scene_revision) {
+        invalidateSceneCommands();
+        recorded_render_stage = render_stage;
+        recorded_scene_revision = scene->getRevision();
+    }
+
+    // start recording commands to command buffer; the image fence above retired everything
+    // recorded for this image before, so all of its per frame pools are reset at once
+    commandRecorder.resetFrame(image_index);
+    VkCommandBuffer frame_begin_commands = commandRecorder.beginPrimary(image_index);
+
+    // textures streamed in on the transfer queue belong to this queue from here on
+    scene->getTextureStreamer().recordAcquires(frame_begin_commands);
 
-    record_commands(image_index);
+    update_uniform_buffers(frame_begin_commands, image_index);
 
-    // stop recording to command buffer
-    result = vkEndCommandBuffer(command_buffers[image_index]);
+    result = vkEndCommandBuffer(frame_begin_commands);
+    ASSERT_VULKAN(result, "Failed to stop recording a command buffer!")
+
+    // the render stage takes its view from buffers written here, so its commands are only
+    // recorded again once something they refer to changed
+    if (render_stage == RenderStage::RASTERIZER) rasterizer.updateFrame(image_index, scene);
+    if (render_stage == RenderStage::PATH_TRACING) pathTracing.readTimings();
+    if (scene_commands_outdated[image_index]
+        || (render_stage == RenderStage::RASTERIZER && rasterizer.commandsDependOnView())) {
+        if (render_stage == RenderStage::RAYTRACING) update_raytracing_descriptor_set(image_index);
+
+        sceneCommandRecorder.resetFrame(image_index);
+        scene_command_buffers[image_index] = sceneCommandRecorder.beginPrimary(image_index);
+        record_scene_commands(scene_command_buffers[image_index], image_index, render_stage);
+        result = vkEndCommandBuffer(scene_command_buffers[image_index]);
+        ASSERT_VULKAN(result, "Failed to stop recording a command buffer!")
+        scene_commands_outdated[image_index] = false;
+    }
+
+    // post and GUI change every frame
+    VkCommandBuffer frame_end_commands = commandRecorder.beginPrimary(image_index);
+    record_post_commands(frame_end_commands, image_index);
+    result = vkEndCommandBuffer(frame_end_commands);
     ASSERT_VULKAN(result, "Failed to stop recording a command buffer!")
 
     // 2. Submit command buffer to queue for execution, making sure it waits for
@@ -241,8 +301,12 @@ void Kataglyphis::VulkanRenderer::drawFrame()
 
     submit_info.pWaitDstStageMask = &wait_stages;// stages to check semaphores at
 
-    submit_info.commandBufferCount = 1;// number of command buffers to submit
-    submit_info.pCommandBuffers = &command_buffers[image_index];// command buffer to submit
+    const std::array<VkCommandBuffer, 3> frame_command_buffers = { frame_begin_commands,
+        scene_command_buffers[image_index],
+        frame_end_commands };
+    submit_info.commandBufferCount =
+      static_cast<uint32_t>(frame_command_buffers.size());// number of command buffers to submit
+    submit_info.pCommandBuffers = frame_command_buffers.data();// command buffers to submit, executed in order
     submit_info.signalSemaphoreCount = 1;// number of semaphores to signal
     submit_info.pSignalSemaphores = &render_finished[current_frame];// semaphores to signal when command
                                                                     // buffer finishes
@@ -417,7 +481,7 @@ void Kataglyphis::VulkanRenderer::create_object_description_buffer()
       graphics_command_pool,
       objectDescriptionBuffer,
       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
       objectDescriptions);
 
     // update the object description set
@@ -586,17 +650,17 @@ void Kataglyphis::VulkanRenderer::createSharedRenderDescriptorSetLayouts()
                                                    | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
 
     // CREATE TEXTURE SAMPLER DESCRIPTOR SET LAYOUT
-    // texture binding info
+    // texture binding info; the texture ids of all materials index these tables
     descriptor_set_layout_bindings[3].binding = SAMPLER_BINDING;
     descriptor_set_layout_bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-    descriptor_set_layout_bindings[3].descriptorCount = MAX_TEXTURE_COUNT;
+    descriptor_set_layout_bindings[3].descriptorCount = device->getTextureTableSize();
     descriptor_set_layout_bindings[3].stageFlags =
       VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
     descriptor_set_layout_bindings[3].pImmutableSamplers = nullptr;
 
     descriptor_set_layout_bindings[4].binding = TEXTURES_BINDING;
     descriptor_set_layout_bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-    descriptor_set_layout_bindings[4].descriptorCount = MAX_TEXTURE_COUNT;
+    descriptor_set_layout_bindings[4].descriptorCount = device->getTextureTableSize();
     descriptor_set_layout_bindings[4].stageFlags =
       VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT;
     descriptor_set_layout_bindings[4].pImmutableSamplers = nullptr;
@@ -607,6 +671,23 @@ void Kataglyphis::VulkanRenderer::createSharedRenderDescriptorSetLayouts()
     layout_create_info.bindingCount = static_cast<uint32_t>(descriptor_set_layout_bindings.size());
     layout_create_info.pBindings = descriptor_set_layout_bindings.data();
 
+    // bindless: slots no material uses may stay empty and the tables are written while the set is
+    // bound in kept commands. A variable count is only allowed on the highest binding, the samplers
+    std::array<VkDescriptorBindingFlags, 5> binding_flags{};
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+    if (device->supportsBindlessTextures()) {
+        const VkDescriptorBindingFlags texture_table_flags =
+          VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+        binding_flags[3] = texture_table_flags | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+        binding_flags[4] = texture_table_flags;
+
+        binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        binding_flags_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+        binding_flags_info.pBindingFlags = binding_flags.data();
+        layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        layout_create_info.pNext = &binding_flags_info;
+    }
+
     // create descriptor set layout
     VkResult result = vkCreateDescriptorSetLayout(
       device->getLogicalDevice(), &layout_create_info, nullptr, &sharedRenderDescriptorSetLayout);
@@ -645,29 +726,48 @@ void Kataglyphis::VulkanRenderer::create_command_pool()
         VkResult result = vkCreateCommandPool(device->getLogicalDevice(), &pool_info, nullptr, &compute_command_pool);
         ASSERT_VULKAN(result, "Failed to create command pool!")
     }
+
+    {
+        // upload batches are one shot command buffers, freed once their fence signalled
+        VkCommandPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        pool_info.queueFamilyIndex = queue_family_indices.transfer_family;
+
+        VkResult result = vkCreateCommandPool(device->getLogicalDevice(), &pool_info, nullptr, &transfer_command_pool);
+        ASSERT_VULKAN(result, "Failed to create command pool!")
+    }
 }
 
 void Kataglyphis::VulkanRenderer::cleanUpCommandPools()
 {
     vkDestroyCommandPool(device->getLogicalDevice(), graphics_command_pool, nullptr);
     vkDestroyCommandPool(device->getLogicalDevice(), compute_command_pool, nullptr);
+    vkDestroyCommandPool(device->getLogicalDevice(), transfer_command_pool, nullptr);
 }
 
 void Kataglyphis::VulkanRenderer::create_command_buffers()
 {
-    // resize command buffer count to have one for each framebuffer
-    command_buffers.resize(vulkanSwapChain.getNumberSwapChainImages());
-
-    VkCommandBufferAllocateInfo command_buffer_alloc_info{};
-    command_buffer_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    command_buffer_alloc_info.commandPool = graphics_command_pool;
-    command_buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    // per frame commands are recorded on the calling thread only; the render stage may fill its
+    // render pass on all cores and is kept until invalidated
+    const uint32_t image_count = vulkanSwapChain.getNumberSwapChainImages();
+    commandRecorder.create(device.get(), image_count, false, 1);
+    sceneCommandRecorder.create(device.get(), image_count, true);
+    scene_command_buffers.assign(image_count, VK_NULL_HANDLE);
+    scene_commands_outdated.assign(image_count, true);
+}
 
-    command_buffer_alloc_info.commandBufferCount = static_cast<uint32_t>(command_buffers.size());
+void Kataglyphis::VulkanRenderer::cleanUpCommandBuffers()
+{
+    commandRecorder.cleanUp();
+    sceneCommandRecorder.cleanUp();
+    scene_command_buffers.clear();
+    scene_commands_outdated.clear();
+}
 
-    VkResult result =
-      vkAllocateCommandBuffers(device->getLogicalDevice(), &command_buffer_alloc_info, command_buffers.data());
-    ASSERT_VULKAN(result, "Failed to allocate command buffers!")
+void Kataglyphis::VulkanRenderer::invalidateSceneCommands()
+{
+    scene_commands_outdated.assign(scene_commands_outdated.size(), true);
 }
 
 void Kataglyphis::VulkanRenderer::createSynchronization()
@@ -750,13 +850,16 @@ void Kataglyphis::VulkanRenderer::createDescriptorPoolSharedRenderStages()
       static_cast<uint32_t>(sizeof(ObjectDescription) * Kataglyphis::MAX_OBJECTS);
 
     // TEXTURE SAMPLER POOL
+    // a full texture table for every set
+    const uint32_t texture_descriptor_count =
+      device->getTextureTableSize() * vulkanSwapChain.getNumberSwapChainImages();
     VkDescriptorPoolSize sampler_pool_size{};
     sampler_pool_size.type = VK_DESCRIPTOR_TYPE_SAMPLER;
-    sampler_pool_size.descriptorCount = MAX_TEXTURE_COUNT;
+    sampler_pool_size.descriptorCount = texture_descriptor_count;
 
     VkDescriptorPoolSize sampled_image_pool_size{};
     sampled_image_pool_size.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-    sampled_image_pool_size.descriptorCount = MAX_TEXTURE_COUNT;
+    sampled_image_pool_size.descriptorCount = texture_descriptor_count;
 
     // list of pool sizes
     std::vector<VkDescriptorPoolSize> descriptor_pool_sizes = {
@@ -770,6 +873,10 @@ void Kataglyphis::VulkanRenderer::createDescriptorPoolSharedRenderStages()
     pool_create_info.poolSizeCount =
       static_cast<uint32_t>(descriptor_pool_sizes.size());// amount of pool sizes being passed
     pool_create_info.pPoolSizes = descriptor_pool_sizes.data();// pool sizes to create pool with
+    // the texture tables of the sets are written while bound
+    if (device->supportsBindlessTextures()) {
+        pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    }
 
     // create descriptor pool
     VkResult result =
@@ -792,10 +899,22 @@ void Kataglyphis::VulkanRenderer::createSharedRenderDescriptorSet()
     set_alloc_info.descriptorSetCount = vulkanSwapChain.getNumberSwapChainImages();// number of sets to allocate
     set_alloc_info.pSetLayouts = set_layouts.data();// layouts to use to allocate sets (1:1 relationship)
 
+    // the layout only states the upper bound of the variable count binding
+    std::vector<uint32_t> texture_table_sizes(
+      vulkanSwapChain.getNumberSwapChainImages(), device->getTextureTableSize());
+    VkDescriptorSetVariableDescriptorCountAllocateInfo variable_count_info{};
+    if (device->supportsBindlessTextures()) {
+        variable_count_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+        variable_count_info.descriptorSetCount = static_cast<uint32_t>(texture_table_sizes.size());
+        variable_count_info.pDescriptorCounts = texture_table_sizes.data();
+        set_alloc_info.pNext = &variable_count_info;
+    }
+
     // allocate descriptor sets (multiple)
     VkResult result =
       vkAllocateDescriptorSets(device->getLogicalDevice(), &set_alloc_info, sharedRenderDescriptorSet.data());
     ASSERT_VULKAN(result, "Failed to create descriptor sets!")
+    written_texture_descriptors.assign(vulkanSwapChain.getNumberSwapChainImages(), {});
 
     // update all of descriptor set buffer bindings
     for (size_t i = 0; i < vulkanSwapChain.getNumberSwapChainImages(); i++) {
@@ -846,58 +965,133 @@ void Kataglyphis::VulkanRenderer::createSharedRenderDescriptorSet()
 
 void Kataglyphis::VulkanRenderer::updateTexturesInSharedRenderDescriptorSet()
 {
-    std::vector<Texture> &modelTextures = scene->getTextures(0);
-    std::vector<VkDescriptorImageInfo> image_info_textures;
-    image_info_textures.resize(scene->getTextureCount(0));
-    for (uint32_t i = 0; i < scene->getTextureCount(0); i++) {
-        image_info_textures[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        image_info_textures[i].imageView = modelTextures[i].getImageView();
-        image_info_textures[i].sampler = nullptr;
+    // images may have been destroyed and created again under the same handle, so every slot is written
+    written_texture_descriptors.assign(vulkanSwapChain.getNumberSwapChainImages(), {});
+    for (uint32_t i = 0; i < vulkanSwapChain.getNumberSwapChainImages(); i++) {
+        updateTexturesInSharedRenderDescriptorSet(i);
     }
+    texture_descriptors_outdated.assign(vulkanSwapChain.getNumberSwapChainImages(), false);
+}
+
+void Kataglyphis::VulkanRenderer::updateTexturesInSharedRenderDescriptorSet(uint32_t image_index)
+{
+    // one descriptor per texture cache slot, as the material texture ids are slots
+    TextureCache &texture_cache = scene->getTextureCache();
+    uint32_t slot_count = std::min(texture_cache.getSlotCount(), device->getTextureTableSize());
 
-    std::vector<VkSampler> &modelTextureSampler = scene->getTextureSampler(0);
+    std::vector<VkDescriptorImageInfo> image_info_textures;
     std::vector<VkDescriptorImageInfo> image_info_texture_sampler;
-    image_info_texture_sampler.resize(scene->getTextureCount(0));
-    for (uint32_t i = 0; i < scene->getTextureCount(0); i++) {
-        image_info_texture_sampler[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        image_info_texture_sampler[i].imageView = nullptr;
-        image_info_texture_sampler[i].sampler = modelTextureSampler[i];
-    }
+    std::vector<VkWriteDescriptorSet> write_descriptor_sets;
+    // the writes point into both lists
+    image_info_textures.reserve(slot_count);
+    image_info_texture_sampler.reserve(slot_count);
 
-    for (uint32_t i = 0; i < vulkanSwapChain.getNumberSwapChainImages(); i++) {
-        // descriptor write info
+    auto writeSlots = [&](uint32_t first_slot, uint32_t count) {
         VkWriteDescriptorSet descriptor_write{};
         descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptor_write.dstSet = sharedRenderDescriptorSet[i];
+        descriptor_write.dstSet = sharedRenderDescriptorSet[image_index];
         descriptor_write.dstBinding = TEXTURES_BINDING;
-        descriptor_write.dstArrayElement = 0;
+        descriptor_write.dstArrayElement = first_slot;
         descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-        descriptor_write.descriptorCount = static_cast<uint32_t>(image_info_textures.size());
-        descriptor_write.pImageInfo = image_info_textures.data();
-
-        /*VkDescriptorImageInfo sampler_info;
-                    sampler_info.imageView = nullptr;
-                    sampler_info.sampler = texture_sampler;*/
+        descriptor_write.descriptorCount = count;
+        descriptor_write.pImageInfo = image_info_textures.data() + image_info_textures.size() - count;
+        write_descriptor_sets.push_back(descriptor_write);
 
-        // descriptor write info
-        VkWriteDescriptorSet descriptor_write_sampler{};
-        descriptor_write_sampler.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptor_write_sampler.dstSet = sharedRenderDescriptorSet[i];
+        VkWriteDescriptorSet descriptor_write_sampler = descriptor_write;
         descriptor_write_sampler.dstBinding = SAMPLER_BINDING;
-        descriptor_write_sampler.dstArrayElement = 0;
         descriptor_write_sampler.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-        descriptor_write_sampler.descriptorCount = static_cast<uint32_t>(image_info_texture_sampler.size());
-        descriptor_write_sampler.pImageInfo = image_info_texture_sampler.data();
+        descriptor_write_sampler.pImageInfo =
+          image_info_texture_sampler.data() + image_info_texture_sampler.size() - count;
+        write_descriptor_sets.push_back(descriptor_write_sampler);
+    };
+    auto addSlot = [&](uint32_t texture_slot) {
+        VkDescriptorImageInfo image_info_texture{};
+        image_info_texture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        image_info_texture.imageView = texture_cache.getTexture(texture_slot).getImageView();
+        image_info_texture.sampler = nullptr;
+        image_info_textures.push_back(image_info_texture);
+
+        VkDescriptorImageInfo image_info_sampler{};
+        image_info_sampler.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        image_info_sampler.imageView = nullptr;
+        image_info_sampler.sampler = texture_cache.getSampler(texture_slot);
+        image_info_texture_sampler.push_back(image_info_sampler);
+    };
+
+    if (device->supportsBindlessTextures()) {
+        // the table is partially bound and updated after bind: only slots whose image or sampler
+        // changed are written, one write per run of them, and the commands kept for the image stay
+        // valid. Freed slots keep a stale descriptor no material reads any more
+        std::vector<VkDescriptorImageInfo> &written = written_texture_descriptors[image_index];
+        written.resize(std::max(static_cast<uint32_t>(written.size()), slot_count));
+        uint32_t run_begin = 0;
+        uint32_t run_length = 0;
+        for (uint32_t slot = 0; slot <= slot_count; slot++) {
+            bool changed = false;
+            if (slot < slot_count && texture_cache.isLive(slot)) {
+                const VkImageView image_view = texture_cache.getTexture(slot).getImageView();
+                const VkSampler sampler = texture_cache.getSampler(slot);
+                changed = written[slot].imageView != image_view || written[slot].sampler != sampler;
+                written[slot].imageView = image_view;
+                written[slot].sampler = sampler;
+            }
+            if (changed) {
+                if (run_length == 0) run_begin = slot;
+                addSlot(slot);
+                run_length++;
+            } else if (run_length > 0) {
+                writeSlots(run_begin, run_length);
+                run_length = 0;
+            }
+        }
+    } else {
+        // rewriting a bound set invalidates the commands kept for the image
+        scene_commands_outdated[image_index] = true;
 
-        std::vector<VkWriteDescriptorSet> write_descriptor_sets = { descriptor_write, descriptor_write_sampler };
+        uint32_t live_slot = 0;
+        while (live_slot < slot_count && !texture_cache.isLive(live_slot)) live_slot++;
+        if (live_slot == slot_count) slot_count = 0;
 
-        // update new descriptor set
-        vkUpdateDescriptorSets(device->getLogicalDevice(),
-          static_cast<uint32_t>(write_descriptor_sets.size()),
-          write_descriptor_sets.data(),
-          0,
-          nullptr);
+        // no material points at a freed slot, but its descriptor still has to be valid
+        for (uint32_t slot = 0; slot < slot_count; slot++) { addSlot(texture_cache.isLive(slot) ? slot : live_slot); }
+        if (slot_count > 0) writeSlots(0, slot_count);
+    }
+
+    if (write_descriptor_sets.empty()) return;
+
+    // update new descriptor set
+    vkUpdateDescriptorSets(device->getLogicalDevice(),
+      static_cast<uint32_t>(write_descriptor_sets.size()),
+      write_descriptor_sets.data(),
+      0,
+      nullptr);
+}
+
+void Kataglyphis::VulkanRenderer::updateTextureStreaming(uint32_t image_index)
+{
+    TextureStreamer &texture_streamer = scene->getTextureStreamer();
+    if (texture_streamer.update(streaming_camera_position, streaming_lod_scale)) {
+        texture_descriptors_outdated.assign(vulkanSwapChain.getNumberSwapChainImages(), true);
+    }
+
+    // the fences of image_index were waited on, nothing in flight reads its set any more
+    if (texture_descriptors_outdated[image_index]) {
+        updateTexturesInSharedRenderDescriptorSet(image_index);
+        texture_descriptors_outdated[image_index] = false;
     }
+
+    gui->getGuiRendererSharedVars().texture_streaming = texture_streamer.getStats();
+}
+
+void Kataglyphis::VulkanRenderer::updateMemoryStats()
+{
+    Allocator &allocator = device->getAllocator();
+    allocator.beginFrame();
+
+    MemoryStats &memory_stats = gui->getGuiRendererSharedVars().memory;
+    memory_stats = allocator.getStats();
+    // streaming backs off before the driver would start evicting
+    scene->getTextureStreamer().setMemoryHeadroom(memory_stats.getDeviceLocalHeadroom());
 }
 
 void Kataglyphis::VulkanRenderer::cleanUpUBOs()
@@ -907,7 +1101,7 @@ void Kataglyphis::VulkanRenderer::cleanUpUBOs()
     for (VulkanBuffer vulkanBuffer : sceneUBOBuffer) { vulkanBuffer.cleanUp(); }
 }
 
-void Kataglyphis::VulkanRenderer::update_uniform_buffers(uint32_t image_index)
+void Kataglyphis::VulkanRenderer::update_uniform_buffers(VkCommandBuffer command_buffer, uint32_t image_index)
 {
     auto usage_stage_flags = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR
                              | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
@@ -934,7 +1128,7 @@ void Kataglyphis::VulkanRenderer::update_uniform_buffers(uint32_t image_index)
     before_barrier_directions.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     before_barrier_directions.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 
-    vkCmdPipelineBarrier(command_buffers[image_index],
+    vkCmdPipelineBarrier(command_buffer,
       usage_stage_flags,
       VK_PIPELINE_STAGE_TRANSFER_BIT,
       0,
@@ -944,7 +1138,7 @@ void Kataglyphis::VulkanRenderer::update_uniform_buffers(uint32_t image_index)
       &before_barrier_uvp,
       0,
       nullptr);
-    vkCmdPipelineBarrier(command_buffers[image_index],
+    vkCmdPipelineBarrier(command_buffer,
       usage_stage_flags,
       VK_PIPELINE_STAGE_TRANSFER_BIT,
       0,
@@ -955,12 +1149,12 @@ void Kataglyphis::VulkanRenderer::update_uniform_buffers(uint32_t image_index)
       0,
       nullptr);
 
-    vkCmdUpdateBuffer(command_buffers[image_index],
+    vkCmdUpdateBuffer(command_buffer,
       globalUBOBuffer[image_index].getBuffer(),
       0,
       sizeof(VulkanRendererInternals::GlobalUBO),
       &globalUBO);
-    vkCmdUpdateBuffer(command_buffers[image_index],
+    vkCmdUpdateBuffer(command_buffer,
       sceneUBOBuffer[image_index].getBuffer(),
       0,
       sizeof(VulkanRendererInternals::SceneUBO),
@@ -988,7 +1182,7 @@ void Kataglyphis::VulkanRenderer::update_uniform_buffers(uint32_t image_index)
     after_barrier_directions.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     after_barrier_directions.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 
-    vkCmdPipelineBarrier(command_buffers[image_index],
+    vkCmdPipelineBarrier(command_buffer,
       VK_PIPELINE_STAGE_TRANSFER_BIT,
       usage_stage_flags,
       0,
@@ -998,7 +1192,7 @@ void Kataglyphis::VulkanRenderer::update_uniform_buffers(uint32_t image_index)
       &after_barrier_uvp,
       0,
       nullptr);
-    vkCmdPipelineBarrier(command_buffers[image_index],
+    vkCmdPipelineBarrier(command_buffer,
       VK_PIPELINE_STAGE_TRANSFER_BIT,
       usage_stage_flags,
       0,
@@ -1054,40 +1248,46 @@ void Kataglyphis::VulkanRenderer::update_raytracing_descriptor_set(uint32_t imag
       nullptr);
 }
 
-void Kataglyphis::VulkanRenderer::record_commands(uint32_t image_index)
+void Kataglyphis::VulkanRenderer::record_scene_commands(VkCommandBuffer command_buffer,
+  uint32_t image_index,
+  RenderStage render_stage)
 {
     Texture &renderResult = rasterizer.getOffscreenTexture(image_index);
     VulkanImage &vulkanImage = renderResult.getVulkanImage();
 
-    Kataglyphis::VulkanRendererInternals::FrontendShared::GUIRendererSharedVars &guiRendererSharedVars =
-      gui->getGuiRendererSharedVars();
-    if (guiRendererSharedVars.raytracing) {
+    if (render_stage == RenderStage::RAYTRACING) {
         std::vector<VkDescriptorSet> sets = { sharedRenderDescriptorSet[image_index],
             raytracingDescriptorSet[image_index] };
-        raytracingStage.recordCommands(command_buffers[image_index], &vulkanSwapChain, sets);
+        raytracingStage.recordCommands(command_buffer, &vulkanSwapChain, sets);
 
-    } else if (guiRendererSharedVars.pathTracing) {
+    } else if (render_stage == RenderStage::PATH_TRACING) {
         std::vector<VkDescriptorSet> sets = { sharedRenderDescriptorSet[image_index],
             raytracingDescriptorSet[image_index] };
 
-        pathTracing.recordCommands(command_buffers[image_index], image_index, vulkanImage, &vulkanSwapChain, sets);
+        pathTracing.recordCommands(command_buffer, image_index, vulkanImage, &vulkanSwapChain, sets);
 
     } else {
         std::vector<VkDescriptorSet> descriptorSets = { sharedRenderDescriptorSet[image_index] };
 
-        rasterizer.recordCommands(command_buffers[image_index], image_index, scene, descriptorSets);
+        rasterizer.recordCommands(command_buffer, image_index, scene, descriptorSets, sceneCommandRecorder);
     }
+}
 
-    vulkanImage.transitionImageLayout(command_buffers[image_index],
+void Kataglyphis::VulkanRenderer::record_post_commands(VkCommandBuffer command_buffer, uint32_t image_index)
+{
+    Texture &renderResult = rasterizer.getOffscreenTexture(image_index);
+    VulkanImage &vulkanImage = renderResult.getVulkanImage();
+
+    vulkanImage.transitionImageLayout(command_buffer,
       VK_IMAGE_LAYOUT_GENERAL,
       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
       1,
       VK_IMAGE_ASPECT_COLOR_BIT);
 
     std::vector<VkDescriptorSet> descriptorSets = { post_descriptor_set[image_index] };
-    postStage.recordCommands(command_buffers[image_index], image_index, descriptorSets);
+    postStage.recordCommands(command_buffer, image_index, descriptorSets);
 
-    vulkanImage.transitionImageLayout(command_buffers[image_index],
+    vulkanImage.transitionImageLayout(command_buffer,
       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
       VK_IMAGE_LAYOUT_GENERAL,
       1,
@@ -1102,6 +1302,9 @@ bool Kataglyphis::VulkanRenderer::checkChangedFramebufferSize()
 
         vulkanSwapChain.cleanUp();
         vulkanSwapChain.initVulkanContext(device.get(), window, surface);
+        // the new swapchain may come with a different number of images; all commands are recorded anew
+        cleanUpCommandBuffers();
+        create_command_buffers();
 
         std::vector<VkDescriptorSetLayout> descriptor_set_layouts = { sharedRenderDescriptorSetLayout };
         rasterizer.cleanUp();
@@ -1133,6 +1336,7 @@ void Kataglyphis::VulkanRenderer::cleanUp()
     cleanUpUBOs();
 
     rasterizer.cleanUp();
+    rasterizer.cleanUpDrawBuffers();
     raytracingStage.cleanUp();
     postStage.cleanUp();
     pathTracing.cleanUp();
@@ -1147,10 +1351,7 @@ void Kataglyphis::VulkanRenderer::cleanUp()
     vkDestroyDescriptorPool(device->getLogicalDevice(), descriptorPoolSharedRenderStages, nullptr);
     vkDestroyDescriptorPool(device->getLogicalDevice(), raytracingDescriptorPool, nullptr);
 
-    vkFreeCommandBuffers(device->getLogicalDevice(),
-      graphics_command_pool,
-      static_cast<uint32_t>(command_buffers.size()),
-      command_buffers.data());
+    cleanUpCommandBuffers();
 
     cleanUpCommandPools();
 
@@ -1158,7 +1359,6 @@ void Kataglyphis::VulkanRenderer::cleanUp()
 
     vulkanSwapChain.cleanUp();
     vkDestroySurfaceKHR(instance.getVulkanInstance(), surface, nullptr);
-    allocator.cleanUp();
     device->cleanUp();
     debug::freeDebugCallback(instance.getVulkanInstance());
     instance.cleanUp();
@@ -4,8 +4,8 @@
 #include "PathTracing.hpp"
 #include "PostStage.hpp"
 #include "gui/GUI.hpp"
-#include "memory/Allocator.hpp"
 #include "renderer/CommandBufferManager.hpp"
+#include "renderer/FrameCommandRecorder.hpp"
 #include "renderer/accelerationStructures/ASManager.hpp"
 
 #include "Rasterizer.hpp"
@@ -45,6 +45,7 @@ class VulkanRenderer
 
   private:
     void shaderHotReload();
+    void defragmentMemory();
 
     // helper class for managing our buffers
     VulkanBufferManager vulkanBufferManager;
@@ -66,11 +67,15 @@ class VulkanRenderer
     Kataglyphis::Frontend::GUI *gui;
 
     // -- pools
-    void record_commands(uint32_t image_index);
+    // the stage drawing the scene into the offscreen image; its commands are kept per image
+    enum class RenderStage { RASTERIZER, RAYTRACING, PATH_TRACING };
+    void record_scene_commands(VkCommandBuffer command_buffer, uint32_t image_index, RenderStage render_stage);
+    void record_post_commands(VkCommandBuffer command_buffer, uint32_t image_index);
     void create_command_pool();
     void cleanUpCommandPools();
     VkCommandPool graphics_command_pool;
     VkCommandPool compute_command_pool;
+    VkCommandPool transfer_command_pool;
 
     // uniform buffers
     VulkanRendererInternals::GlobalUBO globalUBO;
@@ -78,22 +83,30 @@ class VulkanRenderer
     VulkanRendererInternals::SceneUBO sceneUBO;
     std::vector<VulkanBuffer> sceneUBOBuffer;
     void create_uniform_buffers();
-    void update_uniform_buffers(uint32_t image_index);
+    void update_uniform_buffers(VkCommandBuffer command_buffer, uint32_t image_index);
     void cleanUpUBOs();
 
-    std::vector<VkCommandBuffer> command_buffers;
+    // a frame submits three command buffers: uniform updates and texture acquires, the render stage
+    // and post with the GUI. The first and last are recorded every frame; the render stage only reads
+    // the view from buffers and is kept per image until an invalidation: a switch of the stage, a
+    // resize, a scene revision, a shader reload or, without bindless textures, rewritten descriptors
+    // of the image
+    Kataglyphis::VulkanRendererInternals::FrameCommandRecorder commandRecorder;
+    Kataglyphis::VulkanRendererInternals::FrameCommandRecorder sceneCommandRecorder;
+    std::vector<VkCommandBuffer> scene_command_buffers;
+    std::vector<bool> scene_commands_outdated;
+    RenderStage recorded_render_stage{ RenderStage::RASTERIZER };
+    uint64_t recorded_scene_revision{ 0 };
     Kataglyphis::VulkanRendererInternals::CommandBufferManager commandBufferManager;
     void create_command_buffers();
+    void cleanUpCommandBuffers();
+    void invalidateSceneCommands();
 
     Kataglyphis::VulkanRendererInternals::Raytracing raytracingStage;
     Kataglyphis::VulkanRendererInternals::Rasterizer rasterizer;
     Kataglyphis::VulkanRendererInternals::PathTracing pathTracing;
     Kataglyphis::VulkanRendererInternals::PostStage postStage;
 
-    // new era of memory management for my project
-    // for now on integrate vma
-    Allocator allocator;
-
     // -- synchronization
     uint32_t current_frame{ 0 };
     std::vector<VkSemaphore> image_available;
@@ -114,6 +127,15 @@ class VulkanRenderer
     std::vector<VkDescriptorSet> sharedRenderDescriptorSet;
     void createSharedRenderDescriptorSet();
     void updateTexturesInSharedRenderDescriptorSet();
+    void updateTexturesInSharedRenderDescriptorSet(uint32_t image_index);
+    // streamed textures swap their images; each set is rewritten once its image is free again
+    std::vector<bool> texture_descriptors_outdated;
+    // bindless: what each texture table slot of each set was last written with
+    std::vector<std::vector<VkDescriptorImageInfo>> written_texture_descriptors;
+    glm::vec3 streaming_camera_position{ 0.f };
+    float streaming_lod_scale{ 1.f };
+    void updateTextureStreaming(uint32_t image_index);
+    void updateMemoryStats();
 
     VkDescriptorPool post_descriptor_pool{ VK_NULL_HANDLE };
     VkDescriptorSetLayout post_descriptor_set_layout{ VK_NULL_HANDLE };
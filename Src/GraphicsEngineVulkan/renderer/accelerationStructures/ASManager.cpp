@@ -4,11 +4,12 @@ Kataglyphis::VulkanRendererInternals::ASManager::ASManager() {}
 
 void Kataglyphis::VulkanRendererInternals::ASManager::createASForScene(VulkanDevice *device,
   VkCommandPool commandPool,
+  VkCommandPool transferCommandPool,
   Scene *scene)
 {
     this->vulkanDevice = device;
     createBLAS(device, commandPool, scene);
-    createTLAS(device, commandPool, scene);
+    createTLAS(device, commandPool, transferCommandPool, scene);
 }
 
 void Kataglyphis::VulkanRendererInternals::ASManager::createBLAS(VulkanDevice *device,
@@ -24,38 +25,44 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createBLAS(VulkanDevice *d
     PFN_vkGetBufferDeviceAddressKHR pvkGetBufferDeviceAddressKHR =
       (PFN_vkGetBufferDeviceAddressKHR)vkGetDeviceProcAddr(device->getLogicalDevice(), "vkGetBufferDeviceAddress");
 
-    std::vector<BlasInput> blas_input(scene->getModelCount());
+    // one BLAS per mesh in object description order; instances of a mesh share it
+    std::vector<BlasInput> blas_input;
+    blas_input.reserve(scene->getNumberObjectDescriptions());
 
     for (uint32_t model_index = 0; model_index < static_cast<uint32_t>(scene->getModelCount()); model_index++) {
         std::shared_ptr<Model> mesh_model = scene->get_model_list()[model_index];
-        // blas_input.emplace_back();
-        blas_input[model_index].as_geometry.reserve(mesh_model->getMeshCount());
-        blas_input[model_index].as_build_offset_info.reserve(mesh_model->getMeshCount());
 
         for (size_t mesh_index = 0; mesh_index < mesh_model->getMeshCount(); mesh_index++) {
-            VkAccelerationStructureGeometryKHR acceleration_structure_geometry{};
-            VkAccelerationStructureBuildRangeInfoKHR acceleration_structure_build_range_info{};
-
-            objectToVkGeometryKHR(device,
-              mesh_model->getMesh(mesh_index),
-              acceleration_structure_geometry,
-              acceleration_structure_build_range_info);
-            // this only specifies the acceleration structure
-            // we are building it in the end for the whole model with the build
-            // command
-
-            blas_input[model_index].as_geometry.push_back(acceleration_structure_geometry);
-            blas_input[model_index].as_build_offset_info.push_back(acceleration_structure_build_range_info);
+            Mesh *mesh = mesh_model->getMesh(mesh_index);
+            BlasInput &mesh_blas_input = blas_input.emplace_back();
+            mesh_blas_input.as_geometry.reserve(mesh->getSubmeshes().size());
+            mesh_blas_input.as_build_offset_info.reserve(mesh->getSubmeshes().size());
+
+            // the geometry index of a hit is the submesh index (see ObjectDescription::submesh_address);
+            // unsplit meshes are a single submesh and so a single geometry
+            for (const Submesh &submesh : mesh->getSubmeshes()) {
+                VkAccelerationStructureGeometryKHR acceleration_structure_geometry{};
+                VkAccelerationStructureBuildRangeInfoKHR acceleration_structure_build_range_info{};
+
+                objectToVkGeometryKHR(
+                  device, mesh, submesh, acceleration_structure_geometry, acceleration_structure_build_range_info);
+                // this only specifies the acceleration structure
+                // we are building it in the end for the whole mesh with the build
+                // command
+
+                mesh_blas_input.as_geometry.push_back(acceleration_structure_geometry);
+                mesh_blas_input.as_build_offset_info.push_back(acceleration_structure_build_range_info);
+            }
         }
     }
 
     std::vector<BuildAccelerationStructure> build_as_structures;
-    build_as_structures.resize(scene->getModelCount());
+    build_as_structures.resize(blas_input.size());
 
     VkDeviceSize max_scratch_size = 0;
     VkDeviceSize total_size_all_BLAS = 0;
 
-    for (unsigned int i = 0; i < scene->getModelCount(); i++) {
+    for (size_t i = 0; i < blas_input.size(); i++) {
         VkDeviceSize current_scretch_size = 0;
         VkDeviceSize current_size = 0;
 
@@ -71,7 +78,8 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createBLAS(VulkanDevice *d
     scratchBuffer.create(device,
       max_scratch_size,
       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-      VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      MemoryClass::ACCELERATION_STRUCTURE);
 
     VkBufferDeviceAddressInfo scratch_buffer_device_address_info{};
     scratch_buffer_device_address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
@@ -85,7 +93,7 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createBLAS(VulkanDevice *d
 
     VkCommandBuffer command_buffer = commandBufferManager.beginCommandBuffer(device->getLogicalDevice(), commandPool);
 
-    for (size_t i = 0; i < scene->getModelCount(); i++) {
+    for (size_t i = 0; i < build_as_structures.size(); i++) {
         createSingleBlas(device, command_buffer, build_as_structures[i], scratch_buffer_address);
 
         VkMemoryBarrier barrier;
@@ -116,6 +124,7 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createBLAS(VulkanDevice *d
 
 void Kataglyphis::VulkanRendererInternals::ASManager::createTLAS(VulkanDevice *device,
   VkCommandPool commandPool,
+  VkCommandPool transferCommandPool,
   Scene *scene)
 {
     // LOAD ALL NECESSARY FUNCTIONS STRAIGHT IN THE BEGINNING
@@ -143,26 +152,27 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createTLAS(VulkanDevice *d
         device->getLogicalDevice(), "vkGetAccelerationStructureDeviceAddressKHR");
 
     std::vector<VkAccelerationStructureInstanceKHR> tlas_instances;
-    tlas_instances.reserve(scene->getModelCount());
+    tlas_instances.reserve(scene->getInstanceCount());
 
-    for (size_t model_index = 0; model_index < scene->getModelCount(); model_index++) {
+    for (uint32_t instance_index = 0; instance_index < scene->getInstanceCount(); instance_index++) {
+        const SceneInstance &instance = scene->getInstance(instance_index);
         // glm uses column major matrices so transpose it for Vulkan want row major
         // here
-        glm::mat4 transpose_transform = glm::transpose(scene->getModelMatrix(static_cast<int>(model_index)));
+        glm::mat4 transpose_transform = glm::transpose(scene->getInstanceTransform(instance_index));
         VkTransformMatrixKHR out_matrix;
         memcpy(&out_matrix, &transpose_transform, sizeof(VkTransformMatrixKHR));
 
         VkAccelerationStructureDeviceAddressInfoKHR acceleration_structure_device_address_info{};
         acceleration_structure_device_address_info.sType =
           VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
-        acceleration_structure_device_address_info.accelerationStructure = blas[model_index].vulkanAS;
+        acceleration_structure_device_address_info.accelerationStructure = blas[instance.object_description].vulkanAS;
 
         VkDeviceAddress acceleration_structure_device_address = pvkGetAccelerationStructureDeviceAddressKHR(
           device->getLogicalDevice(), &acceleration_structure_device_address_info);
 
         VkAccelerationStructureInstanceKHR geometry_instance{};
         geometry_instance.transform = out_matrix;
-        geometry_instance.instanceCustomIndex = model_index;// gl_InstanceCustomIndexEXT
+        geometry_instance.instanceCustomIndex = instance.object_description;// gl_InstanceCustomIndexEXT
         geometry_instance.mask = 0xFF;
         geometry_instance.instanceShaderBindingTableRecordOffset = 0;
         geometry_instance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
@@ -172,17 +182,24 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createTLAS(VulkanDevice *d
         tlas_instances.emplace_back(geometry_instance);
     }
 
-    VkCommandBuffer command_buffer = commandBufferManager.beginCommandBuffer(device->getLogicalDevice(), commandPool);
-
     VulkanBuffer geometryInstanceBuffer;
 
-    vulkanBufferManager.createBufferAndUploadVectorOnDevice(device,
-      commandPool,
+    const VkDeviceSize instances_size = sizeof(VkAccelerationStructureInstanceKHR) * tlas_instances.size();
+    VulkanUploader uploader;
+    uploader.create(device, transferCommandPool, commandPool, instances_size);
+    vulkanBufferManager.createBufferAndUploadDataOnDevice(device,
+      uploader,
       geometryInstanceBuffer,
       VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR
         | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-      VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-      tlas_instances);
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      tlas_instances.data(),
+      instances_size);
+    // also hands the buffer over to the graphics queue the build is submitted to
+    uploader.finish();
+    uploader.cleanUp();
+
+    VkCommandBuffer command_buffer = commandBufferManager.beginCommandBuffer(device->getLogicalDevice(), commandPool);
 
     VkBufferDeviceAddressInfo geometry_instance_buffer_device_address_info{};
     geometry_instance_buffer_device_address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
@@ -252,7 +269,7 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createTLAS(VulkanDevice *d
       acceleration_structure_build_sizes_info.accelerationStructureSize,
       VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
         | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     VkAccelerationStructureCreateInfoKHR acceleration_structure_create_info{};
     acceleration_structure_create_info.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
@@ -272,7 +289,8 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createTLAS(VulkanDevice *d
     scratchBuffer.create(device,
       acceleration_structure_build_sizes_info.buildScratchSize,
       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT);
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      MemoryClass::ACCELERATION_STRUCTURE);
 
     VkBufferDeviceAddressInfo scratch_buffer_device_address_info{};
     scratch_buffer_device_address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
@@ -287,7 +305,7 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createTLAS(VulkanDevice *d
     acceleration_structure_build_geometry_info.dstAccelerationStructure = tlAS;
 
     VkAccelerationStructureBuildRangeInfoKHR acceleration_structure_build_range_info{};
-    acceleration_structure_build_range_info.primitiveCount = scene->getModelCount();
+    acceleration_structure_build_range_info.primitiveCount = count_instance;
     acceleration_structure_build_range_info.primitiveOffset = 0;
     acceleration_structure_build_range_info.firstVertex = 0;
     acceleration_structure_build_range_info.transformOffset = 0;
@@ -345,7 +363,7 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createSingleBlas(VulkanDev
       build_as_structure.size_info.accelerationStructureSize,
       VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
         | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-      VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     acceleration_structure_create_info.buffer = blasVulkanBuffer.getBuffer();
     VkAccelerationStructureKHR &blas_as = build_as_structure.single_blas.vulkanAS;
@@ -397,34 +415,13 @@ void Kataglyphis::VulkanRendererInternals::ASManager::createAccelerationStructur
 
 void Kataglyphis::VulkanRendererInternals::ASManager::objectToVkGeometryKHR(VulkanDevice *device,
   Mesh *mesh,
+  const Submesh &submesh,
   VkAccelerationStructureGeometryKHR &acceleration_structure_geometry,
   VkAccelerationStructureBuildRangeInfoKHR &acceleration_structure_build_range_info)
 {
-    // LOAD ALL NECESSARY FUNCTIONS STRAIGHT IN THE BEGINNING
-    // all functionality from extensions has to be loaded in the beginning
-    // we need a reference to the device location of our geometry laying on the
-    // graphics card we already uploaded objects and created vertex and index
-    // buffers respectively
-    PFN_vkGetBufferDeviceAddressKHR pvkGetBufferDeviceAddressKHR =
-      (PFN_vkGetBufferDeviceAddressKHR)vkGetDeviceProcAddr(device->getLogicalDevice(), "vkGetBufferDeviceAddress");
-
-    // all starts with the address of our vertex and index data we already
-    // uploaded in buffers earlier when loading the meshes/models
-    VkBufferDeviceAddressInfo vertex_buffer_device_address_info{};
-    vertex_buffer_device_address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
-    vertex_buffer_device_address_info.buffer = mesh->getVertexBuffer();
-    vertex_buffer_device_address_info.pNext = nullptr;
-
-    VkBufferDeviceAddressInfo index_buffer_device_address_info{};
-    index_buffer_device_address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
-    index_buffer_device_address_info.buffer = mesh->getIndexBuffer();
-    index_buffer_device_address_info.pNext = nullptr;
-
-    // receiving address to move on
-    VkDeviceAddress vertex_buffer_address =
-      pvkGetBufferDeviceAddressKHR(device->getLogicalDevice(), &vertex_buffer_device_address_info);
-    VkDeviceAddress index_buffer_address =
-      pvkGetBufferDeviceAddressKHR(device->getLogicalDevice(), &index_buffer_device_address_info);
+    // the geometry lives in the scene's geometry arena; the mesh knows the addresses of its range
+    VkDeviceAddress vertex_buffer_address = mesh->getVertexAddress();
+    VkDeviceAddress index_buffer_address = mesh->getIndexAddress();
 
     // convert to const address for further processing
     VkDeviceOrHostAddressConstKHR vertex_device_or_host_address_const{};
@@ -436,9 +433,11 @@ void Kataglyphis::VulkanRendererInternals::ASManager::objectToVkGeometryKHR(Vulk
     VkAccelerationStructureGeometryTrianglesDataKHR acceleration_structure_triangles_data{};
     acceleration_structure_triangles_data.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
     acceleration_structure_triangles_data.pNext = nullptr;
-    acceleration_structure_triangles_data.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
+    acceleration_structure_triangles_data.vertexFormat = mesh->getPositionFormat();
     acceleration_structure_triangles_data.vertexData = vertex_device_or_host_address_const;
-    acceleration_structure_triangles_data.vertexStride = sizeof(Vertex);
+    acceleration_structure_triangles_data.vertexStride = mesh->getVertexStride();
+    // compact positions are decoded to object space by the build itself
+    acceleration_structure_triangles_data.transformData.deviceAddress = mesh->getPositionTransformAddress();
     acceleration_structure_triangles_data.maxVertex = mesh->getVertexCount();
     acceleration_structure_triangles_data.indexType = VK_INDEX_TYPE_UINT32;
     acceleration_structure_triangles_data.indexData = index_device_or_host_address_const;
@@ -455,11 +454,9 @@ void Kataglyphis::VulkanRendererInternals::ASManager::objectToVkGeometryKHR(Vulk
     acceleration_structure_geometry.flags = VK_GEOMETRY_OPAQUE_BIT_KHR;
 
     // we have triangles so divide the number of vertices with 3!!
-    // for our simple case a no brainer
-    // take entire data to build BLAS
-    // number of indices is truly the stick point here
-    acceleration_structure_build_range_info.primitiveCount = mesh->getIndexCount() / 3;
-    acceleration_structure_build_range_info.primitiveOffset = 0;
+    // the submesh is a range of the mesh's index data; primitiveOffset is in bytes
+    acceleration_structure_build_range_info.primitiveCount = submesh.index_count / 3;
+    acceleration_structure_build_range_info.primitiveOffset = submesh.index_offset * sizeof(uint32_t);
     acceleration_structure_build_range_info.firstVertex = 0;
     acceleration_structure_build_range_info.transformOffset = 0;
 }
@@ -29,11 +29,15 @@ class ASManager
 
     VkAccelerationStructureKHR &getTLAS() { return tlas.vulkanAS; };
 
-    void createASForScene(VulkanDevice *device, VkCommandPool commandPool, Scene *scene);
+    void createASForScene(VulkanDevice *device,
+      VkCommandPool commandPool,
+      VkCommandPool transferCommandPool,
+      Scene *scene);
 
     void createBLAS(VulkanDevice *device, VkCommandPool commandPool, Scene *scene);
 
-    void createTLAS(VulkanDevice *device, VkCommandPool commandPool, Scene *scene);
+    // the instance buffer is uploaded on the transfer queue, the build runs on the graphics queue
+    void createTLAS(VulkanDevice *device, VkCommandPool commandPool, VkCommandPool transferCommandPool, Scene *scene);
 
     void cleanUp();
 
@@ -58,8 +62,10 @@ class ASManager
       VkDeviceSize &current_scretch_size,
       VkDeviceSize &current_size);
 
+    // one geometry for the triangles of a submesh
     void objectToVkGeometryKHR(VulkanDevice *device,
       Mesh *mesh,
+      const Submesh &submesh,
       VkAccelerationStructureGeometryKHR &acceleration_structure_geometry,
       VkAccelerationStructureBuildRangeInfoKHR &acceleration_structure_build_range_info);
 };
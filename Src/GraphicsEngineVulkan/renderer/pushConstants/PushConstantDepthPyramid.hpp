@@ -0,0 +1,23 @@
+// this little "hack" is needed for using it on the
+// CPU side as well for the GPU side :)
+// inspired by the NVDIDIA tutorial:
+// https://nvpro-samples.github.io/vk_raytracing_tutorial_KHR/
+
+#ifdef __cplusplus
+#pragma once
+#include <glm/glm.hpp>
+// GLSL Type
+using uvec2 = glm::uvec2;
+namespace Kataglyphis::VulkanRendererInternals {
+#endif
+
+// Push constant structure for one level of the depth pyramid reduction
+struct PushConstantDepthPyramid
+{
+    uvec2 source_size;// texels of the depth buffer or the finer level
+    uvec2 destination_size;
+};
+
+#ifdef __cplusplus
+}// namespace Kataglyphis::VulkanRendererInternals
+#endif
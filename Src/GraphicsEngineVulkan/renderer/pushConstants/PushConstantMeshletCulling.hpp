@@ -0,0 +1,38 @@
+// this little "hack" is needed for using it on the
+// CPU side as well for the GPU side :)
+// inspired by the NVDIDIA tutorial:
+// https://nvpro-samples.github.io/vk_raytracing_tutorial_KHR/
+
+#ifdef __cplusplus
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+// GLSL Type
+using vec2 = glm::vec2;
+using vec3 = glm::vec3;
+using vec4 = glm::vec4;
+using mat4 = glm::mat4;
+using uint = unsigned int;
+namespace Kataglyphis::VulkanRendererInternals {
+#endif
+
+// Push constant structure for the meshlet culling compute pass; the view lives in
+// a buffer, so the recorded dispatches stay valid while the camera moves
+struct PushConstantMeshletCulling
+{
+    uint64_t group_view_address;// MeshletCullingView of the draw group
+    uint64_t meshlet_address;// Meshlet[meshlet_count]
+    uint64_t draw_command_address;// VkDrawIndexedIndirectCommand output
+    uint64_t draw_count_address;// uint counter, reset before the dispatch
+    uint meshlet_count;
+    // range of the mesh in the geometry arena; meshlets index relative to it
+    uint first_index;
+    int vertex_offset;
+    uint padding;
+    uint64_t visibility_address;// uint flag of the instance, written by the object culling pass
+};
+
+#ifdef __cplusplus
+}// namespace Kataglyphis::VulkanRendererInternals
+#endif
@@ -0,0 +1,34 @@
+// this little "hack" is needed for using it on the
+// CPU side as well for the GPU side :)
+// inspired by the NVDIDIA tutorial:
+// https://nvpro-samples.github.io/vk_raytracing_tutorial_KHR/
+
+#ifdef __cplusplus
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+// GLSL Type
+using vec2 = glm::vec2;
+using vec3 = glm::vec3;
+using vec4 = glm::vec4;
+using mat4 = glm::mat4;
+using uint = unsigned int;
+namespace Kataglyphis::VulkanRendererInternals {
+#endif
+
+// Push constant structure for the object culling compute pass
+struct PushConstantObjectCulling
+{
+    uint64_t candidate_address;// DrawCandidate[candidate_count]
+    uint64_t view_address;// CullingView
+    uint64_t transform_address;// world transform per draw group
+    uint64_t draw_command_address;// VkDrawIndexedIndirectCommand output
+    uint64_t draw_count_address;// one uint counter per draw group, reset before the dispatch
+    uint64_t visibility_address;// one uint per instance culled per meshlet
+    uint candidate_count;
+};
+
+#ifdef __cplusplus
+}// namespace Kataglyphis::VulkanRendererInternals
+#endif
@@ -19,6 +19,9 @@ namespace Kataglyphis::VulkanRendererInternals {
 struct PushConstantRasterizer
 {
     mat4 model;// matrix of the instance
+    // decode of compact vertex positions (identity for full float vertices)
+    vec4 position_offset;
+    vec4 position_scale;
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,124 @@
+#include "scene/CompactVertex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/packing.hpp>
+
+namespace {
+
+int16_t quantizeSnorm16(float value)
+{
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+}
+
+float dequantizeSnorm16(int16_t value) { return std::max(static_cast<float>(value) / 32767.f, -1.f); }
+
+glm::vec2 encodeOctahedral(glm::vec3 n)
+{
+    const float l1_norm = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1_norm <= 0.f) return glm::vec2(0.f);
+    n /= l1_norm;
+
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.f) {
+        e = glm::vec2((1.f - std::abs(n.y)) * (n.x >= 0.f ? 1.f : -1.f),
+          (1.f - std::abs(n.x)) * (n.y >= 0.f ? 1.f : -1.f));
+    }
+    return e;
+}
+
+glm::vec3 decodeOctahedral(glm::vec2 e)
+{
+    glm::vec3 n(e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y));
+    if (n.z < 0.f) {
+        const float x = n.x;
+        n.x = (1.f - std::abs(n.y)) * (x >= 0.f ? 1.f : -1.f);
+        n.y = (1.f - std::abs(x)) * (n.y >= 0.f ? 1.f : -1.f);
+    }
+    return glm::normalize(n);
+}
+
+uint16_t encodeRGB565(glm::vec3 color)
+{
+    color = glm::clamp(color, glm::vec3(0.f), glm::vec3(1.f));
+    const uint32_t r = static_cast<uint32_t>(std::lround(color.x * 31.f));
+    const uint32_t g = static_cast<uint32_t>(std::lround(color.y * 63.f));
+    const uint32_t b = static_cast<uint32_t>(std::lround(color.z * 31.f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+glm::vec3 decodeRGB565(uint16_t bits)
+{
+    return glm::vec3(
+      static_cast<float>((bits >> 11) & 31u) / 31.f, static_cast<float>((bits >> 5) & 63u) / 63.f, (bits & 31u) / 31.f);
+}
+
+}// namespace
+
+namespace vertex {
+
+bool hasVertexColors(std::span<const Vertex> vertices)
+{
+    // the loaders write -1 if the model has no vertex colors
+    return std::any_of(vertices.begin(), vertices.end(), [](const Vertex &vertex) {
+        return vertex.color.x >= 0.f || vertex.color.y >= 0.f || vertex.color.z >= 0.f;
+    });
+}
+
+VertexQuantization compressVertices(std::span<const Vertex> vertices, std::vector<CompactVertex> &compact_vertices)
+{
+    glm::vec3 min_pos(0.f);
+    glm::vec3 max_pos(0.f);
+    if (!vertices.empty()) {
+        min_pos = vertices[0].pos;
+        max_pos = vertices[0].pos;
+    }
+    for (const Vertex &vertex : vertices) {
+        min_pos = glm::min(min_pos, vertex.pos);
+        max_pos = glm::max(max_pos, vertex.pos);
+    }
+
+    // snorm spans [-1, 1], i.e. the half extent around the box center; flat axes keep a scale of 1
+    const glm::vec3 center = (min_pos + max_pos) * 0.5f;
+    glm::vec3 half_extent = (max_pos - min_pos) * 0.5f;
+    for (int axis = 0; axis < 3; axis++) {
+        if (half_extent[axis] <= 0.f) half_extent[axis] = 1.f;
+    }
+
+    const bool has_color = hasVertexColors(vertices);
+
+    compact_vertices.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const Vertex &vertex = vertices[i];
+        const glm::vec3 relative = (vertex.pos - center) / half_extent;
+
+        CompactVertex &compact = compact_vertices[i];
+        compact.position[0] = quantizeSnorm16(relative.x);
+        compact.position[1] = quantizeSnorm16(relative.y);
+        compact.position[2] = quantizeSnorm16(relative.z);
+        compact.position[3] = has_color ? static_cast<int16_t>(encodeRGB565(vertex.color)) : 0;
+        compact.normal = glm::packSnorm2x16(encodeOctahedral(vertex.normal));
+        compact.texture_coords = glm::packHalf2x16(vertex.texture_coords);
+    }
+
+    VertexQuantization quantization{};
+    quantization.position_offset = glm::vec4(center, 0.f);
+    quantization.position_scale = glm::vec4(half_extent, has_color ? 1.f : 0.f);
+    return quantization;
+}
+
+Vertex decompressVertex(const CompactVertex &compact_vertex, const VertexQuantization &quantization, bool has_color)
+{
+    const glm::vec3 snorm(dequantizeSnorm16(compact_vertex.position[0]),
+      dequantizeSnorm16(compact_vertex.position[1]),
+      dequantizeSnorm16(compact_vertex.position[2]));
+    const glm::vec3 pos = glm::vec3(quantization.position_offset) + glm::vec3(quantization.position_scale) * snorm;
+    const glm::vec3 normal = decodeOctahedral(glm::unpackSnorm2x16(compact_vertex.normal));
+    const glm::vec3 color =
+      has_color ? decodeRGB565(static_cast<uint16_t>(compact_vertex.position[3])) : glm::vec3(-1.f);
+
+    return Vertex(pos, normal, color, glm::unpackHalf2x16(compact_vertex.texture_coords));
+}
+
+}// namespace vertex
@@ -0,0 +1,16 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "hostDevice/compact_vertex.hpp"
+#include "scene/Vertex.hpp"
+
+// the layout and its GLSL decode are shared with the shaders (hostDevice/compact_vertex.hpp)
+namespace vertex {
+
+// encodes vertices into the compact layout; the returned quantization decodes their positions
+VertexQuantization compressVertices(std::span<const Vertex> vertices, std::vector<CompactVertex> &compact_vertices);
+Vertex decompressVertex(const CompactVertex &compact_vertex, const VertexQuantization &quantization, bool has_color);
+bool hasVertexColors(std::span<const Vertex> vertices);
+
+}// namespace vertex
@@ -0,0 +1,204 @@
+#include "scene/FrustumCuller.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace Kataglyphis;
+
+namespace {
+
+// the box component each plane reads: the corner farthest along the plane normal
+struct PlaneCorner
+{
+    const float *x;
+    const float *y;
+    const float *z;
+};
+
+std::array<PlaneCorner, 6> planeCorners(const std::array<glm::vec4, 6> &planes, const InstanceBounds &bounds)
+{
+    std::array<PlaneCorner, 6> corners{};
+    for (size_t p = 0; p < planes.size(); p++) {
+        corners[p].x = planes[p].x >= 0.f ? bounds.max_x.data() : bounds.min_x.data();
+        corners[p].y = planes[p].y >= 0.f ? bounds.max_y.data() : bounds.min_y.data();
+        corners[p].z = planes[p].z >= 0.f ? bounds.max_z.data() : bounds.min_z.data();
+    }
+    return corners;
+}
+
+}// namespace
+
+void InstanceBounds::resize(size_t count)
+{
+    min_x.resize(count);
+    min_y.resize(count);
+    min_z.resize(count);
+    max_x.resize(count);
+    max_y.resize(count);
+    max_z.resize(count);
+}
+
+void InstanceBounds::set(size_t index, const glm::vec3 &box_min, const glm::vec3 &box_max)
+{
+    min_x[index] = box_min.x;
+    min_y[index] = box_min.y;
+    min_z[index] = box_min.z;
+    max_x[index] = box_max.x;
+    max_y[index] = box_max.y;
+    max_z[index] = box_max.z;
+}
+
+void InstanceBounds::setTransformed(size_t index,
+  const glm::vec3 &box_min,
+  const glm::vec3 &box_max,
+  const glm::mat4 &transform)
+{
+    // the world extent along an axis sums the absolute contributions of all three object axes
+    const glm::vec3 center = glm::vec3(transform * glm::vec4((box_min + box_max) * 0.5f, 1.f));
+    const glm::vec3 half_extent = (box_max - box_min) * 0.5f;
+    const glm::vec3 world_half_extent = glm::abs(glm::vec3(transform[0])) * half_extent.x
+                                        + glm::abs(glm::vec3(transform[1])) * half_extent.y
+                                        + glm::abs(glm::vec3(transform[2])) * half_extent.z;
+    set(index, center - world_half_extent, center + world_half_extent);
+}
+
+FrustumCuller::FrustumCuller(FrustumCullSettings settings) : settings(settings) {}
+
+void FrustumCuller::cull(const InstanceBounds &bounds, const glm::mat4 &view_projection, std::vector<uint32_t> &visible)
+{
+    visible.clear();
+    const std::array<glm::vec4, 6> planes = frustumPlanes(view_projection);
+    const size_t box_count = bounds.size();
+    const uint32_t jobs = resolveJobCount(box_count);
+    if (jobs <= 1) {
+        cullRange(planes, bounds, 0, box_count, visible);
+        return;
+    }
+
+    // whole SIMD blocks per job, only the last one has a scalar tail
+    const size_t job_size = ((box_count + jobs - 1) / jobs + 7) & ~size_t(7);
+    job_visible.resize(jobs);
+    jobPool.run(jobs, [&](uint32_t job) {
+        std::vector<uint32_t> &job_output = job == 0 ? visible : job_visible[job];
+        job_output.clear();
+        const size_t begin = std::min(box_count, job * job_size);
+        cullRange(planes, bounds, begin, std::min(box_count, begin + job_size), job_output);
+    });
+
+    // jobs cover ascending ranges, so concatenating keeps the order
+    for (uint32_t job = 1; job < jobs; job++) {
+        visible.insert(visible.end(), job_visible[job].begin(), job_visible[job].end());
+    }
+}
+
+std::array<glm::vec4, 6> FrustumCuller::frustumPlanes(const glm::mat4 &view_projection)
+{
+    // Gribb/Hartmann: the clip space conditions -w <= x <= w, -w <= y <= w and 0 <= z <= w
+    // written as planes over the rows of the matrix
+    auto row = [&](int r) {
+        return glm::vec4(view_projection[0][r], view_projection[1][r], view_projection[2][r], view_projection[3][r]);
+    };
+    return { row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(2), row(3) - row(2) };
+}
+
+bool FrustumCuller::boxInFrustum(const std::array<glm::vec4, 6> &planes,
+  const glm::vec3 &box_min,
+  const glm::vec3 &box_max)
+{
+    for (const glm::vec4 &plane : planes) {
+        const glm::vec3 corner(plane.x >= 0.f ? box_max.x : box_min.x,
+          plane.y >= 0.f ? box_max.y : box_min.y,
+          plane.z >= 0.f ? box_max.z : box_min.z);
+        // same order of additions as the vectorised test, so both agree on boxes touching a plane
+        if ((plane.x * corner.x + plane.y * corner.y) + (plane.z * corner.z + plane.w) < 0.f) return false;
+    }
+    return true;
+}
+
+void FrustumCuller::cullRange(const std::array<glm::vec4, 6> &planes,
+  const InstanceBounds &bounds,
+  size_t begin,
+  size_t end,
+  std::vector<uint32_t> &visible)
+{
+    const std::array<PlaneCorner, 6> corners = planeCorners(planes, bounds);
+    size_t i = begin;
+
+#if defined(__AVX2__)
+    for (; i + 8 <= end; i += 8) {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (size_t p = 0; p < planes.size(); p++) {
+            const __m256 x = _mm256_mul_ps(_mm256_set1_ps(planes[p].x), _mm256_loadu_ps(corners[p].x + i));
+            const __m256 y = _mm256_mul_ps(_mm256_set1_ps(planes[p].y), _mm256_loadu_ps(corners[p].y + i));
+            const __m256 z = _mm256_mul_ps(_mm256_set1_ps(planes[p].z), _mm256_loadu_ps(corners[p].z + i));
+            const __m256 distance = _mm256_add_ps(_mm256_add_ps(x, y), _mm256_add_ps(z, _mm256_set1_ps(planes[p].w)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+            if (_mm256_movemask_ps(inside) == 0) break;
+        }
+        for (uint32_t lanes = static_cast<uint32_t>(_mm256_movemask_ps(inside)); lanes != 0; lanes &= lanes - 1) {
+            visible.push_back(static_cast<uint32_t>(i) + std::countr_zero(lanes));
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    for (; i + 4 <= end; i += 4) {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (size_t p = 0; p < planes.size(); p++) {
+            const __m128 x = _mm_mul_ps(_mm_set1_ps(planes[p].x), _mm_loadu_ps(corners[p].x + i));
+            const __m128 y = _mm_mul_ps(_mm_set1_ps(planes[p].y), _mm_loadu_ps(corners[p].y + i));
+            const __m128 z = _mm_mul_ps(_mm_set1_ps(planes[p].z), _mm_loadu_ps(corners[p].z + i));
+            const __m128 distance = _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, _mm_set1_ps(planes[p].w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+            if (_mm_movemask_ps(inside) == 0) break;
+        }
+        for (uint32_t lanes = static_cast<uint32_t>(_mm_movemask_ps(inside)); lanes != 0; lanes &= lanes - 1) {
+            visible.push_back(static_cast<uint32_t>(i) + std::countr_zero(lanes));
+        }
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= end; i += 4) {
+        uint32x4_t inside = vdupq_n_u32(0xFFFFFFFFu);
+        for (size_t p = 0; p < planes.size(); p++) {
+            const float32x4_t x = vmulq_n_f32(vld1q_f32(corners[p].x + i), planes[p].x);
+            const float32x4_t y = vmulq_n_f32(vld1q_f32(corners[p].y + i), planes[p].y);
+            const float32x4_t z = vmulq_n_f32(vld1q_f32(corners[p].z + i), planes[p].z);
+            const float32x4_t distance = vaddq_f32(vaddq_f32(x, y), vaddq_f32(z, vdupq_n_f32(planes[p].w)));
+            inside = vandq_u32(inside, vcgeq_f32(distance, vdupq_n_f32(0.f)));
+            const uint32x2_t any = vorr_u32(vget_low_u32(inside), vget_high_u32(inside));
+            if ((vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) == 0) break;
+        }
+        if (vgetq_lane_u32(inside, 0)) visible.push_back(static_cast<uint32_t>(i));
+        if (vgetq_lane_u32(inside, 1)) visible.push_back(static_cast<uint32_t>(i + 1));
+        if (vgetq_lane_u32(inside, 2)) visible.push_back(static_cast<uint32_t>(i + 2));
+        if (vgetq_lane_u32(inside, 3)) visible.push_back(static_cast<uint32_t>(i + 3));
+    }
+#endif
+
+    for (; i < end; i++) {
+        bool inside = true;
+        for (size_t p = 0; p < planes.size() && inside; p++) {
+            const float x = planes[p].x * corners[p].x[i];
+            const float y = planes[p].y * corners[p].y[i];
+            const float z = planes[p].z * corners[p].z[i];
+            inside = (x + y) + (z + planes[p].w) >= 0.f;
+        }
+        if (inside) visible.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+FrustumCuller::~FrustumCuller() {}
+
+uint32_t FrustumCuller::resolveJobCount(size_t box_count) const
+{
+    const uint32_t max_jobs = settings.job_count > 0 ? settings.job_count : JobPool::hardwareThreads();
+    const size_t useful_jobs = box_count / std::max<size_t>(settings.min_boxes_per_job, 1);
+    return static_cast<uint32_t>(std::clamp<size_t>(useful_jobs, 1, max_jobs));
+}
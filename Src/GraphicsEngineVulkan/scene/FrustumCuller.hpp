@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "util/JobPool.hpp"
+
+namespace Kataglyphis {
+
+// world space axis aligned boxes as one array per component, so a SIMD
+// test loads the same component of 4 (SSE, NEON) or 8 (AVX2) boxes at once
+struct InstanceBounds
+{
+    std::vector<float> min_x;
+    std::vector<float> min_y;
+    std::vector<float> min_z;
+    std::vector<float> max_x;
+    std::vector<float> max_y;
+    std::vector<float> max_z;
+
+    size_t size() const { return min_x.size(); };
+    void resize(size_t count);
+    void set(size_t index, const glm::vec3 &box_min, const glm::vec3 &box_max);
+    // bounds of an object space box moved by transform
+    void setTransformed(size_t index, const glm::vec3 &box_min, const glm::vec3 &box_max, const glm::mat4 &transform);
+};
+
+struct FrustumCullSettings
+{
+    // number of jobs the boxes are split into; 0 picks the core count
+    uint32_t job_count{ 0 };
+    // below this many boxes per job waking up a worker costs more than it saves
+    uint32_t min_boxes_per_job{ 1u << 14 };
+};
+
+// Tests boxes against the six planes of a view projection and lists the
+// visible ones. Every plane only looks at the box corner farthest along its
+// normal, which is picked once per plane instead of once per box. Large inputs
+// are split into jobs on a JobPool.
+class FrustumCuller
+{
+  public:
+    explicit FrustumCuller(FrustumCullSettings settings = FrustumCullSettings{});
+    FrustumCuller(const FrustumCuller &) = delete;
+    FrustumCuller &operator=(const FrustumCuller &) = delete;
+
+    // visible receives the indices of all boxes that touch the frustum in ascending order
+    void cull(const InstanceBounds &bounds, const glm::mat4 &view_projection, std::vector<uint32_t> &visible);
+
+    // left, right, bottom, top, near, far; inside is where dot(plane, (p, 1)) >= 0. Depth
+    // runs from 0 to w as in Vulkan clip space
+    static std::array<glm::vec4, 6> frustumPlanes(const glm::mat4 &view_projection);
+    // scalar reference of the vectorised test
+    static bool boxInFrustum(const std::array<glm::vec4, 6> &planes,
+      const glm::vec3 &box_min,
+      const glm::vec3 &box_max);
+    // appends the visible boxes of [begin, end)
+    static void cullRange(const std::array<glm::vec4, 6> &planes,
+      const InstanceBounds &bounds,
+      size_t begin,
+      size_t end,
+      std::vector<uint32_t> &visible);
+
+    ~FrustumCuller();
+
+  private:
+    FrustumCullSettings settings;
+    JobPool jobPool;
+    // results of the jobs after the first one, which writes to the output directly
+    std::vector<std::vector<uint32_t>> job_visible;
+
+    uint32_t resolveJobCount(size_t box_count) const;
+};
+
+}// namespace Kataglyphis
@@ -0,0 +1,136 @@
+#include "scene/GeometryArena.hpp"
+
+#include <vector>
+
+using namespace Kataglyphis;
+
+namespace {
+
+VkDeviceAddress getBufferAddress(VulkanDevice *device, VulkanBuffer &buffer)
+{
+    VkBufferDeviceAddressInfo address_info{};
+    address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    address_info.buffer = buffer.getBuffer();
+    return vkGetBufferDeviceAddress(device->getLogicalDevice(), &address_info);
+}
+
+}// namespace
+
+GeometryArena::GeometryArena() {}
+
+void GeometryArena::create(VulkanDevice *device, VkDeviceSize vertex_stride, GeometryArenaSettings settings)
+{
+    this->device = device;
+    this->vertex_stride = vertex_stride;
+
+    vertex_capacity = static_cast<uint32_t>(settings.vertex_bytes / vertex_stride);
+    index_capacity = static_cast<uint32_t>(settings.index_bytes / sizeof(uint32_t));
+    triangle_capacity = index_capacity / 3;
+    material_capacity = settings.material_count;
+    next = GeometryRange{};
+
+    const VkBufferUsageFlags table_usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+                                           | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR
+                                           | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+    vertexBuffer.create(device,
+      static_cast<VkDeviceSize>(vertex_capacity) * vertex_stride,
+      table_usage | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    indexBuffer.create(device,
+      static_cast<VkDeviceSize>(index_capacity) * sizeof(uint32_t),
+      table_usage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    materialIdsBuffer.create(device,
+      static_cast<VkDeviceSize>(triangle_capacity) * sizeof(uint32_t),
+      table_usage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    materialsBuffer.create(device,
+      static_cast<VkDeviceSize>(material_capacity) * sizeof(ObjMaterial),
+      table_usage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    vertex_address = getBufferAddress(device, vertexBuffer);
+    index_address = getBufferAddress(device, indexBuffer);
+    material_index_address = getBufferAddress(device, materialIdsBuffer);
+    material_address = getBufferAddress(device, materialsBuffer);
+}
+
+bool GeometryArena::allocate(uint32_t vertex_count,
+  uint32_t index_count,
+  uint32_t triangle_count,
+  uint32_t material_count,
+  GeometryRange &range)
+{
+    if (vertex_count > vertex_capacity - next.first_vertex || index_count > index_capacity - next.first_index
+        || triangle_count > triangle_capacity - next.first_triangle
+        || material_count > material_capacity - next.first_material) {
+        return false;
+    }
+
+    range = GeometryRange{ next.first_vertex,
+        vertex_count,
+        next.first_index,
+        index_count,
+        next.first_triangle,
+        triangle_count,
+        next.first_material,
+        material_count };
+
+    next.first_vertex += vertex_count;
+    next.first_index += index_count;
+    next.first_triangle += triangle_count;
+    next.first_material += material_count;
+    return true;
+}
+
+void GeometryArena::upload(VulkanUploader &uploader,
+  const GeometryRange &range,
+  const void *vertices,
+  std::span<const uint32_t> indices,
+  std::span<const unsigned int> materialIndex,
+  std::span<const ObjMaterial> materials)
+{
+    uploader.uploadBuffer(vertexBuffer.getBuffer(),
+      vertices,
+      static_cast<VkDeviceSize>(range.vertex_count) * vertex_stride,
+      static_cast<VkDeviceSize>(range.first_vertex) * vertex_stride);
+    uploader.uploadBuffer(
+      indexBuffer.getBuffer(), indices.data(), indices.size_bytes(), range.first_index * sizeof(uint32_t));
+
+    std::vector<uint32_t> rebased(materialIndex.begin(), materialIndex.end());
+    // faces without a material keep their -1
+    for (uint32_t &material : rebased) {
+        if (material != UINT32_MAX) material += range.first_material;
+    }
+    uploader.uploadBuffer(materialIdsBuffer.getBuffer(),
+      rebased.data(),
+      rebased.size() * sizeof(uint32_t),
+      range.first_triangle * sizeof(uint32_t));
+
+    if (!materials.empty()) {
+        uploader.uploadBuffer(materialsBuffer.getBuffer(),
+          materials.data(),
+          materials.size_bytes(),
+          range.first_material * sizeof(ObjMaterial));
+    }
+}
+
+void GeometryArena::bind(VkCommandBuffer command_buffer)
+{
+    VkBuffer vertex_buffers[] = { vertexBuffer.getBuffer() };
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
+    vkCmdBindIndexBuffer(command_buffer, indexBuffer.getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+}
+
+void GeometryArena::cleanUp()
+{
+    vertexBuffer.cleanUp();
+    indexBuffer.cleanUp();
+    materialIdsBuffer.cleanUp();
+    materialsBuffer.cleanUp();
+    next = GeometryRange{};
+}
+
+GeometryArena::~GeometryArena() {}
@@ -0,0 +1,113 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+
+#include "scene/ObjMaterial.hpp"
+#include "vulkan_base/VulkanBuffer.hpp"
+#include "vulkan_base/VulkanUploader.hpp"
+
+namespace Kataglyphis {
+
+struct GeometryArenaSettings
+{
+    // device memory of the vertex and of the index table; every triangle gets a material id on top
+    uint64_t vertex_bytes{ 64ull << 20 };
+    uint64_t index_bytes{ 64ull << 20 };
+    uint32_t material_count{ 4096 };
+};
+
+// where the data of one mesh lives in the arena, in elements of each table
+struct GeometryRange
+{
+    uint32_t first_vertex{ 0 };
+    uint32_t vertex_count{ 0 };
+    uint32_t first_index{ 0 };
+    uint32_t index_count{ 0 };
+    // into the per-triangle material ids
+    uint32_t first_triangle{ 0 };
+    uint32_t triangle_count{ 0 };
+    uint32_t first_material{ 0 };
+    uint32_t material_count{ 0 };
+};
+
+// One vertex, index, material id and material table for all meshes of the scene.
+// Meshes get ranges handed out front to back in load order and address them by
+// offsets: vertexOffset/firstIndex for draws, device addresses into the tables
+// for ray tracing. The rasterizer binds the tables once per frame and can merge
+// the draws of many meshes into one indirect call.
+//
+// Material ids are rebased onto the material table on upload, so they index the
+// scene wide table directly; the materials' texture ids already are slots of the
+// scene's texture cache. A mesh's object description addresses its own range of
+// the material id table, so the first triangle of a draw (its firstInstance) is
+// counted from the start of the mesh, like the submesh offsets for ray tracing.
+class GeometryArena
+{
+  public:
+    GeometryArena();
+
+    // vertex_stride: size of the vertex layout all meshes are uploaded in
+    void create(VulkanDevice *device, VkDeviceSize vertex_stride, GeometryArenaSettings settings);
+
+    // reserves space for a mesh; false if one of the tables is full
+    bool allocate(uint32_t vertex_count,
+      uint32_t index_count,
+      uint32_t triangle_count,
+      uint32_t material_count,
+      GeometryRange &range);
+
+    // records the copies into range; vertices have to be in the arena's vertex layout
+    void upload(VulkanUploader &uploader,
+      const GeometryRange &range,
+      const void *vertices,
+      std::span<const uint32_t> indices,
+      std::span<const unsigned int> materialIndex,
+      std::span<const ObjMaterial> materials);
+
+    // binds the vertex and index table; draws address their mesh with vertexOffset/firstIndex
+    void bind(VkCommandBuffer command_buffer);
+
+    VkDeviceSize getVertexStride() const { return vertex_stride; };
+    VkDeviceAddress getVertexAddress(const GeometryRange &range) const
+    {
+        return vertex_address + range.first_vertex * vertex_stride;
+    };
+    VkDeviceAddress getIndexAddress(const GeometryRange &range) const
+    {
+        return index_address + range.first_index * sizeof(uint32_t);
+    };
+    VkDeviceAddress getMaterialIndexAddress(const GeometryRange &range) const
+    {
+        return material_index_address + range.first_triangle * sizeof(uint32_t);
+    };
+    // ids are already rebased, every mesh gets the base of the table
+    VkDeviceAddress getMaterialAddress() const { return material_address; };
+
+    void cleanUp();
+
+    ~GeometryArena();
+
+  private:
+    VulkanDevice *device{ VK_NULL_HANDLE };
+    VkDeviceSize vertex_stride{ 0 };
+
+    VulkanBuffer vertexBuffer;
+    VulkanBuffer indexBuffer;
+    VulkanBuffer materialIdsBuffer;
+    VulkanBuffer materialsBuffer;
+
+    VkDeviceAddress vertex_address{ 0 };
+    VkDeviceAddress index_address{ 0 };
+    VkDeviceAddress material_index_address{ 0 };
+    VkDeviceAddress material_address{ 0 };
+
+    // elements each table holds and the first free one; ranges are never given back
+    uint32_t vertex_capacity{ 0 };
+    uint32_t index_capacity{ 0 };
+    uint32_t triangle_capacity{ 0 };
+    uint32_t material_capacity{ 0 };
+    GeometryRange next;
+};
+}// namespace Kataglyphis
@@ -0,0 +1,248 @@
+#include "scene/GlbFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "spdlog/spdlog.h"
+#include "util/File.hpp"
+
+using namespace Kataglyphis;
+
+namespace {
+
+constexpr uint32_t glb_magic = 0x46546C67;// "glTF"
+constexpr uint32_t glb_version = 2;
+constexpr uint32_t chunk_type_json = 0x4E4F534A;// "JSON"
+constexpr uint32_t chunk_type_binary = 0x004E4942;// "BIN\0"
+
+uint32_t readUint32(const std::byte *data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t getComponentCount(const std::string &type)
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    if (type == "MAT2") return 4;
+    if (type == "MAT3") return 9;
+    if (type == "MAT4") return 16;
+    return 0;
+}
+
+size_t getComponentSize(GltfComponentType component_type)
+{
+    switch (component_type) {
+    case GltfComponentType::BYTE:
+    case GltfComponentType::UNSIGNED_BYTE:
+        return 1;
+    case GltfComponentType::SHORT:
+    case GltfComponentType::UNSIGNED_SHORT:
+        return 2;
+    case GltfComponentType::UNSIGNED_INT:
+    case GltfComponentType::FLOAT:
+        return 4;
+    }
+    return 0;
+}
+
+// json.value() copies; the arrays of a large file must be looked at in place
+const nlohmann::json &getArray(const nlohmann::json &object, const char *key)
+{
+    static const nlohmann::json empty = nlohmann::json::array();
+    auto member = object.find(key);
+    return member != object.end() && member->is_array() ? *member : empty;
+}
+
+}// namespace
+
+size_t GltfAccessor::getElementSize() const { return getComponentSize(component_type) * component_count; }
+
+GlbFile::GlbFile() {}
+
+bool GlbFile::open(const std::string &file_location)
+{
+    this->file_location = file_location;
+    base_dir = File(file_location).getBaseDir();
+
+    if (!mapping.open(file_location)) {
+        spdlog::error("Failed to open {}!", file_location);
+        return false;
+    }
+
+    const std::byte *base = mapping.data();
+    const size_t size = mapping.size();
+    if (size < 20 || readUint32(base) != glb_magic || readUint32(base + 4) != glb_version) {
+        spdlog::error("{} is no binary glTF 2.0 file!", file_location);
+        return false;
+    }
+
+    // chunks follow the 12 byte header, each with its own 8 byte header; JSON comes first
+    const size_t file_length = std::min<size_t>(readUint32(base + 8), size);
+    size_t offset = 12;
+    std::string_view json_chunk;
+    while (offset + 8 <= file_length) {
+        const size_t chunk_length = readUint32(base + offset);
+        const uint32_t chunk_type = readUint32(base + offset + 4);
+        offset += 8;
+        if (offset + chunk_length > file_length) break;
+
+        if (chunk_type == chunk_type_json && json_chunk.empty()) {
+            json_chunk = std::string_view(reinterpret_cast<const char *>(base + offset), chunk_length);
+        } else if (chunk_type == chunk_type_binary && binary_chunk.empty()) {
+            binary_chunk = std::span<const std::byte>(base + offset, chunk_length);
+        }
+        offset += chunk_length;
+    }
+
+    if (json_chunk.empty()) {
+        spdlog::error("{} has no JSON chunk!", file_location);
+        return false;
+    }
+
+    json = nlohmann::json::parse(json_chunk, nullptr, false);
+    if (json.is_discarded()) {
+        spdlog::error("Failed to parse the JSON chunk of {}!", file_location);
+        return false;
+    }
+
+    return true;
+}
+
+bool GlbFile::getAccessor(uint32_t accessor_index, GltfAccessor &accessor) const
+{
+    const nlohmann::json &accessors = getArray(json, "accessors");
+    if (accessor_index >= accessors.size()) return false;
+    const nlohmann::json &json_accessor = accessors[accessor_index];
+
+    if (json_accessor.contains("sparse") || !json_accessor.contains("bufferView")) {
+        spdlog::error("{}: sparse accessors and accessors without buffer view are not supported!", file_location);
+        return false;
+    }
+
+    accessor.count = json_accessor.value("count", size_t(0));
+    accessor.component_type = static_cast<GltfComponentType>(json_accessor.value("componentType", 0u));
+    accessor.component_count = getComponentCount(json_accessor.value("type", std::string()));
+    accessor.normalized = json_accessor.value("normalized", false);
+    if (accessor.getElementSize() == 0) return false;
+
+    const uint32_t buffer_view_index = json_accessor["bufferView"].get<uint32_t>();
+    const std::span<const std::byte> buffer_view = getBufferView(buffer_view_index);
+    if (buffer_view.empty()) return false;
+    const nlohmann::json &json_buffer_view = getArray(json, "bufferViews")[buffer_view_index];
+    accessor.stride = json_buffer_view.value("byteStride", accessor.getElementSize());
+
+    const size_t byte_offset = json_accessor.value("byteOffset", size_t(0));
+    const size_t byte_length =
+      accessor.count == 0 ? 0 : byte_offset + (accessor.count - 1) * accessor.stride + accessor.getElementSize();
+    if (byte_length > buffer_view.size()) {
+        spdlog::error("{}: accessor {} lies outside of its buffer view!", file_location, accessor_index);
+        return false;
+    }
+
+    accessor.data = buffer_view.data() + byte_offset;
+    return true;
+}
+
+std::span<const std::byte> GlbFile::getBufferView(uint32_t buffer_view_index) const
+{
+    const nlohmann::json &buffer_views = getArray(json, "bufferViews");
+    if (buffer_view_index >= buffer_views.size()) return {};
+    const nlohmann::json &buffer_view = buffer_views[buffer_view_index];
+
+    // buffer 0 without uri is the binary chunk; external .bin files would need a mapping of their own
+    const uint32_t buffer = buffer_view.value("buffer", 0u);
+    const nlohmann::json &buffers = getArray(json, "buffers");
+    if (buffer != 0 || buffers.empty() || buffers[0].contains("uri")) {
+        spdlog::error("{}: only the embedded binary chunk is supported as buffer!", file_location);
+        return {};
+    }
+
+    const size_t byte_offset = buffer_view.value("byteOffset", size_t(0));
+    const size_t byte_length = buffer_view.value("byteLength", size_t(0));
+    if (byte_offset + byte_length > binary_chunk.size()) return {};
+    return binary_chunk.subspan(byte_offset, byte_length);
+}
+
+std::vector<GltfMeshNode> GlbFile::collectMeshNodes() const
+{
+    std::vector<GltfMeshNode> mesh_nodes;
+    const nlohmann::json &nodes = getArray(json, "nodes");
+
+    std::vector<uint32_t> roots;
+    const nlohmann::json &scenes = getArray(json, "scenes");
+    const size_t scene = json.value("scene", size_t(0));
+    if (scene < scenes.size()) {
+        for (const nlohmann::json &node : getArray(scenes[scene], "nodes")) {
+            roots.push_back(node.get<uint32_t>());
+        }
+    } else {
+        std::vector<bool> is_child(nodes.size(), false);
+        for (const nlohmann::json &node : nodes) {
+            for (const nlohmann::json &child : getArray(node, "children")) {
+                if (child.get<size_t>() < nodes.size()) is_child[child.get<size_t>()] = true;
+            }
+        }
+        for (uint32_t node = 0; node < nodes.size(); node++) {
+            if (!is_child[node]) roots.push_back(node);
+        }
+    }
+
+    // depth first with the accumulated parent transform; the hierarchy is a forest by spec,
+    // the visit count only guards against broken files
+    std::vector<std::pair<uint32_t, glm::mat4>> stack;
+    for (auto root = roots.rbegin(); root != roots.rend(); root++) stack.emplace_back(*root, glm::mat4(1.f));
+    size_t visits = 0;
+    while (!stack.empty() && visits++ <= nodes.size()) {
+        const auto [node_index, parent_transform] = stack.back();
+        stack.pop_back();
+        if (node_index >= nodes.size()) continue;
+
+        const nlohmann::json &node = nodes[node_index];
+        const glm::mat4 transform = parent_transform * getNodeTransform(node);
+        if (node.contains("mesh")) mesh_nodes.push_back(GltfMeshNode{ node["mesh"].get<uint32_t>(), transform });
+
+        const nlohmann::json &children = getArray(node, "children");
+        for (auto child = children.rbegin(); child != children.rend(); child++) {
+            stack.emplace_back(child->get<uint32_t>(), transform);
+        }
+    }
+
+    return mesh_nodes;
+}
+
+glm::mat4 GlbFile::getNodeTransform(const nlohmann::json &node) const
+{
+    // either a column major matrix or translation * rotation * scale
+    if (node.contains("matrix") && node["matrix"].size() == 16) {
+        const std::vector<float> matrix = node["matrix"].get<std::vector<float>>();
+        return glm::make_mat4(matrix.data());
+    }
+
+    glm::mat4 transform(1.f);
+    if (node.contains("translation") && node["translation"].size() == 3) {
+        const std::vector<float> t = node["translation"].get<std::vector<float>>();
+        transform = glm::translate(transform, glm::vec3(t[0], t[1], t[2]));
+    }
+    if (node.contains("rotation") && node["rotation"].size() == 4) {
+        // glTF stores x, y, z, w
+        const std::vector<float> r = node["rotation"].get<std::vector<float>>();
+        transform = transform * glm::mat4_cast(glm::quat(r[3], r[0], r[1], r[2]));
+    }
+    if (node.contains("scale") && node["scale"].size() == 3) {
+        const std::vector<float> s = node["scale"].get<std::vector<float>>();
+        transform = glm::scale(transform, glm::vec3(s[0], s[1], s[2]));
+    }
+    return transform;
+}
+
+GlbFile::~GlbFile() {}
@@ -0,0 +1,568 @@
+#include "scene/GltfLoader.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "scene/SubmeshBuilder.hpp"
+#include "spdlog/spdlog.h"
+
+using namespace Kataglyphis;
+
+namespace {
+
+constexpr uint32_t gltf_mode_triangles = 4;
+
+float readComponent(const std::byte *element, GltfComponentType component_type, bool normalized, uint32_t component)
+{
+    // normalized integers map onto [0, 1] resp. [-1, 1] (glTF 2.0, 3.11)
+    switch (component_type) {
+    case GltfComponentType::FLOAT: {
+        float value;
+        std::memcpy(&value, element + component * sizeof(float), sizeof(float));
+        return value;
+    }
+    case GltfComponentType::UNSIGNED_BYTE: {
+        const float value = static_cast<float>(std::to_integer<uint8_t>(element[component]));
+        return normalized ? value / 255.f : value;
+    }
+    case GltfComponentType::BYTE: {
+        const float value = static_cast<float>(static_cast<int8_t>(std::to_integer<uint8_t>(element[component])));
+        return normalized ? std::max(value / 127.f, -1.f) : value;
+    }
+    case GltfComponentType::UNSIGNED_SHORT: {
+        uint16_t value;
+        std::memcpy(&value, element + component * sizeof(uint16_t), sizeof(value));
+        return normalized ? static_cast<float>(value) / 65535.f : static_cast<float>(value);
+    }
+    case GltfComponentType::SHORT: {
+        int16_t value;
+        std::memcpy(&value, element + component * sizeof(int16_t), sizeof(value));
+        return normalized ? std::max(static_cast<float>(value) / 32767.f, -1.f) : static_cast<float>(value);
+    }
+    case GltfComponentType::UNSIGNED_INT: {
+        uint32_t value;
+        std::memcpy(&value, element + component * sizeof(uint32_t), sizeof(value));
+        return static_cast<float>(value);
+    }
+    }
+    return 0.f;
+}
+
+// reads the first count components of element i; missing components stay untouched
+void readFloats(const GltfAccessor &accessor, size_t i, float *out, uint32_t count)
+{
+    const std::byte *element = accessor.data + i * accessor.stride;
+    count = std::min(count, accessor.component_count);
+    if (accessor.component_type == GltfComponentType::FLOAT) {
+        std::memcpy(out, element, count * sizeof(float));
+        return;
+    }
+    for (uint32_t c = 0; c < count; c++) {
+        out[c] = readComponent(element, accessor.component_type, accessor.normalized, c);
+    }
+}
+
+bool isFloatVector(const GltfAccessor &accessor, uint32_t component_count)
+{
+    return accessor.component_type == GltfComponentType::FLOAT && accessor.component_count == component_count;
+}
+
+// true if the attributes are interleaved exactly like Vertex, so the mapping can be uploaded as is
+bool matchesVertexLayout(const GltfAccessor &position,
+  const GltfAccessor &normal,
+  const GltfAccessor &color,
+  const GltfAccessor &texture_coords)
+{
+    if (!isFloatVector(position, 3) || !isFloatVector(normal, 3) || !isFloatVector(color, 3)
+        || !isFloatVector(texture_coords, 2)) {
+        return false;
+    }
+    for (const GltfAccessor *accessor : { &position, &normal, &color, &texture_coords }) {
+        if (accessor->stride != sizeof(Vertex) || accessor->count != position.count) return false;
+    }
+    return reinterpret_cast<uintptr_t>(position.data) % alignof(Vertex) == 0
+           && normal.data == position.data + offsetof(Vertex, normal)
+           && color.data == position.data + offsetof(Vertex, color)
+           && texture_coords.data == position.data + offsetof(Vertex, texture_coords);
+}
+
+// appends the indices of a primitive shifted by first_vertex
+void appendIndices(const GltfAccessor &accessor, uint32_t first_vertex, std::vector<uint32_t> &indices)
+{
+    const size_t first = indices.size();
+    indices.resize(first + accessor.count);
+    uint32_t *out = indices.data() + first;
+    size_t i = 0;
+
+    if (accessor.component_type == GltfComponentType::UNSIGNED_SHORT && accessor.isTightlyPacked()) {
+#if defined(__SSE2__) || defined(_M_X64)
+        // the common case for production assets: widen 8 indices per step and add the base vertex
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i base = _mm_set1_epi32(static_cast<int>(first_vertex));
+        for (; i + 8 <= accessor.count; i += 8) {
+            const __m128i packed =
+              _mm_loadu_si128(reinterpret_cast<const __m128i *>(accessor.data + i * sizeof(uint16_t)));
+            _mm_storeu_si128(
+              reinterpret_cast<__m128i *>(out + i), _mm_add_epi32(_mm_unpacklo_epi16(packed, zero), base));
+            _mm_storeu_si128(
+              reinterpret_cast<__m128i *>(out + i + 4), _mm_add_epi32(_mm_unpackhi_epi16(packed, zero), base));
+        }
+#endif
+    }
+
+    for (; i < accessor.count; i++) {
+        const std::byte *element = accessor.data + i * accessor.stride;
+        uint32_t index = 0;
+        switch (accessor.component_type) {
+        case GltfComponentType::UNSIGNED_BYTE:
+            index = std::to_integer<uint8_t>(element[0]);
+            break;
+        case GltfComponentType::UNSIGNED_SHORT: {
+            uint16_t value;
+            std::memcpy(&value, element, sizeof(value));
+            index = value;
+            break;
+        }
+        default:
+            std::memcpy(&index, element, sizeof(index));
+            break;
+        }
+        out[i] = index + first_vertex;
+    }
+}
+
+void computeFlatNormals(std::span<Vertex> vertices, std::span<const uint32_t> indices)
+{
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        Vertex &v0 = vertices[indices[i + 0]];
+        Vertex &v1 = vertices[indices[i + 1]];
+        Vertex &v2 = vertices[indices[i + 2]];
+
+        glm::vec3 n = glm::normalize(glm::cross((v1.pos - v0.pos), (v2.pos - v0.pos)));
+        v0.normal = n;
+        v1.normal = n;
+        v2.normal = n;
+    }
+}
+
+const nlohmann::json &getMember(const nlohmann::json &object, const char *key)
+{
+    static const nlohmann::json empty = nlohmann::json::object();
+    auto member = object.find(key);
+    return member != object.end() ? *member : empty;
+}
+
+}// namespace
+
+GltfLoader::GltfLoader(VulkanDevice *device,
+  VkCommandPool transfer_command_pool,
+  VkCommandPool graphics_command_pool,
+  GltfLoaderSettings settings,
+  TextureStreamer *texture_streamer,
+  GeometryArena *geometry_arena,
+  TextureCache *texture_cache)
+{
+    this->device = device;
+    this->transfer_command_pool = transfer_command_pool;
+    this->graphics_command_pool = graphics_command_pool;
+    this->settings = settings;
+    this->texture_streamer = texture_streamer;
+    this->geometry_arena = geometry_arena;
+    this->texture_cache = texture_cache;
+}
+
+std::shared_ptr<Model> GltfLoader::loadModel(const std::string &modelFile)
+{
+    GlbFile file;
+    if (!file.open(modelFile)) exit(EXIT_FAILURE);
+
+    std::vector<TextureSource> texture_sources;
+    const std::vector<ObjMaterial> materials = loadMaterials(file, texture_sources);
+
+    // meshes without a single triangle primitive are dropped; their nodes with them
+    const size_t mesh_count = file.getJson().contains("meshes") ? file.getJson()["meshes"].size() : 0;
+    std::vector<GltfMeshData> meshes(mesh_count);
+    std::vector<uint32_t> model_mesh(mesh_count, UINT32_MAX);
+    for (uint32_t m = 0; m < mesh_count; m++) {
+        if (!loadMesh(file, m, materials, meshes[m])) {
+            spdlog::warn("{}: skipping mesh {}", modelFile, m);
+            meshes[m] = GltfMeshData{};
+        }
+    }
+    const std::vector<GltfMeshNode> mesh_nodes = file.collectMeshNodes();
+
+    // the model we want to load
+    std::shared_ptr<Model> new_model = std::make_shared<Model>(device, texture_cache);
+
+    // all buffers and images of the model go out in a few large submissions
+    VulkanUploader uploader;
+    uploader.create(device, transfer_command_pool, graphics_command_pool);
+
+    createTextures(new_model, uploader, texture_sources, meshes, mesh_nodes);
+
+    uint32_t triangle_count = 0;
+    for (uint32_t m = 0; m < mesh_count; m++) {
+        const GltfMeshData &mesh = meshes[m];
+        if (mesh.indices.empty()) continue;
+        model_mesh[m] = new_model->add_new_mesh(device,
+          uploader,
+          *geometry_arena,
+          mesh.vertices,
+          mesh.indices,
+          mesh.materialIndex,
+          mesh.materials,
+          {},
+          settings.split_submeshes ? std::span<const Submesh>(mesh.submeshes) : std::span<const Submesh>(),
+          settings.compact_vertices);
+        triangle_count += static_cast<uint32_t>(mesh.indices.size() / 3);
+    }
+
+    for (const GltfMeshNode &mesh_node : mesh_nodes) {
+        if (mesh_node.mesh < mesh_count && model_mesh[mesh_node.mesh] != UINT32_MAX) {
+            new_model->addMeshInstance(model_mesh[mesh_node.mesh], mesh_node.transform);
+        }
+    }
+
+    uploader.finish();
+    spdlog::info("Uploaded {}: {} meshes, {} instances, {} triangles, {:.1f} MiB in {} submissions",
+      modelFile,
+      new_model->getMeshCount(),
+      new_model->getMeshInstances().size(),
+      triangle_count,
+      static_cast<double>(uploader.getUploadedBytes()) / (1024.0 * 1024.0),
+      uploader.getSubmitCount());
+    uploader.cleanUp();
+
+    return new_model;
+}
+
+bool GltfLoader::loadMesh(const GlbFile &file,
+  uint32_t mesh_index,
+  std::span<const ObjMaterial> materials,
+  GltfMeshData &mesh)
+{
+    const nlohmann::json &json = file.getJson();
+    if (!json.contains("meshes") || mesh_index >= json["meshes"].size()) return false;
+    const nlohmann::json &primitives = getMember(json["meshes"][mesh_index], "primitives");
+    if (!primitives.is_array()) return false;
+
+    struct Primitive
+    {
+        GltfAccessor position, normal, color, texture_coords, indices;
+        bool has_normal{ false }, has_color{ false }, has_texture_coords{ false }, has_indices{ false };
+        uint32_t material{ UINT32_MAX };
+    };
+    std::vector<Primitive> loaded;
+    loaded.reserve(primitives.size());
+
+    for (const nlohmann::json &json_primitive : primitives) {
+        if (json_primitive.value("mode", gltf_mode_triangles) != gltf_mode_triangles) {
+            spdlog::warn("glTF mesh {}: skipping a primitive that is no triangle list", mesh_index);
+            continue;
+        }
+        const nlohmann::json &attributes = getMember(json_primitive, "attributes");
+        if (!attributes.contains("POSITION")) continue;
+
+        Primitive primitive{};
+        if (!file.getAccessor(attributes["POSITION"].get<uint32_t>(), primitive.position)
+            || primitive.position.component_count != 3) {
+            return false;
+        }
+        auto optional = [&](const char *attribute, GltfAccessor &accessor) {
+            if (!attributes.contains(attribute)) return false;
+            return file.getAccessor(attributes[attribute].get<uint32_t>(), accessor)
+                   && accessor.count == primitive.position.count;
+        };
+        primitive.has_normal = optional("NORMAL", primitive.normal);
+        primitive.has_color = optional("COLOR_0", primitive.color);
+        primitive.has_texture_coords = optional("TEXCOORD_0", primitive.texture_coords);
+        if (json_primitive.contains("indices")) {
+            if (!file.getAccessor(json_primitive["indices"].get<uint32_t>(), primitive.indices)) return false;
+            primitive.has_indices = true;
+        }
+        // the last material is the default one
+        primitive.material = std::min(json_primitive.value("material", UINT32_MAX),
+          static_cast<uint32_t>(materials.size() - 1));
+        loaded.push_back(primitive);
+    }
+    if (loaded.empty()) return false;
+
+    // a single primitive in the Vertex layout with 32 bit indices is used straight from the mapping
+    const Primitive &first = loaded[0];
+    const bool map_vertices = loaded.size() == 1 && first.has_normal && first.has_color && first.has_texture_coords
+                              && matchesVertexLayout(first.position, first.normal, first.color, first.texture_coords);
+    const bool map_indices = loaded.size() == 1 && first.has_indices
+                             && first.indices.component_type == GltfComponentType::UNSIGNED_INT
+                             && first.indices.isTightlyPacked()
+                             && reinterpret_cast<uintptr_t>(first.indices.data) % alignof(uint32_t) == 0;
+
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+    for (const Primitive &primitive : loaded) {
+        vertex_count += primitive.position.count;
+        index_count += primitive.has_indices ? primitive.indices.count : primitive.position.count;
+    }
+    if (!map_vertices) mesh.vertex_storage.reserve(vertex_count);
+    if (!map_indices) mesh.index_storage.reserve(index_count);
+
+    std::unordered_map<uint32_t, uint32_t> local_materials;
+    for (uint32_t p = 0; p < static_cast<uint32_t>(loaded.size()); p++) {
+        const Primitive &primitive = loaded[p];
+        const uint32_t first_vertex = static_cast<uint32_t>(mesh.vertex_storage.size());
+        const size_t first_index = map_indices ? 0 : mesh.index_storage.size();
+
+        if (!map_vertices) {
+            // one pass over all attribute streams; missing ones keep the defaults of the OBJ path
+            for (size_t v = 0; v < primitive.position.count; v++) {
+                Vertex vertex{ glm::vec3(0.f), glm::vec3(0.f), glm::vec3(-1.f), glm::vec2(0.f) };
+                readFloats(primitive.position, v, &vertex.pos.x, 3);
+                if (primitive.has_normal) readFloats(primitive.normal, v, &vertex.normal.x, 3);
+                if (primitive.has_color) readFloats(primitive.color, v, &vertex.color.x, 3);
+                // glTF already has its origin in the upper left corner like the decoded images
+                if (primitive.has_texture_coords) readFloats(primitive.texture_coords, v, &vertex.texture_coords.x, 2);
+                mesh.vertex_storage.push_back(vertex);
+            }
+        }
+
+        if (!map_indices) {
+            if (primitive.has_indices) {
+                appendIndices(primitive.indices, first_vertex, mesh.index_storage);
+            } else {
+                for (uint32_t v = 0; v < primitive.position.count; v++) mesh.index_storage.push_back(first_vertex + v);
+            }
+            // a dangling partial triangle would shift all following ones
+            mesh.index_storage.resize(first_index + (mesh.index_storage.size() - first_index) / 3 * 3);
+        }
+
+        const std::span<const uint32_t> primitive_indices =
+          map_indices ? std::span<const uint32_t>(reinterpret_cast<const uint32_t *>(first.indices.data),
+                          first.indices.count / 3 * 3)
+                      : std::span<const uint32_t>(mesh.index_storage).subspan(first_index);
+        if (map_indices) mesh.indices = primitive_indices;
+        if (!map_vertices && !primitive.has_normal) computeFlatNormals(mesh.vertex_storage, primitive_indices);
+
+        auto [local_material, inserted] =
+          local_materials.try_emplace(primitive.material, static_cast<uint32_t>(mesh.materials.size()));
+        if (inserted) mesh.materials.push_back(materials[primitive.material]);
+
+        Submesh submesh{};
+        submesh.index_offset = static_cast<uint32_t>(first_index);
+        submesh.index_count = static_cast<uint32_t>(primitive_indices.size());
+        submesh.material = local_material->second;
+        submesh.shape = p;
+        if (submesh.index_count > 0) mesh.submeshes.push_back(submesh);
+    }
+
+    mesh.vertices = map_vertices ? std::span<const Vertex>(reinterpret_cast<const Vertex *>(first.position.data),
+                                     first.position.count)
+                                 : std::span<const Vertex>(mesh.vertex_storage);
+    mesh.indices = map_indices ? mesh.indices : std::span<const uint32_t>(mesh.index_storage);
+
+    // indices out of range would read past the vertex table on the GPU
+    const uint32_t mapped_vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+    if (std::any_of(mesh.indices.begin(), mesh.indices.end(), [&](uint32_t i) { return i >= mapped_vertex_count; })) {
+        spdlog::error("glTF mesh {} indexes vertices it does not have!", mesh_index);
+        return false;
+    }
+    if (mesh.indices.empty()) return false;
+
+    mesh.materialIndex.reserve(mesh.indices.size() / 3);
+    for (Submesh &submesh : mesh.submeshes) {
+        mesh.materialIndex.insert(mesh.materialIndex.end(), submesh.index_count / 3, submesh.material);
+        SubmeshBuilder::computeBounds(mesh.vertices, mesh.indices, submesh);
+    }
+
+    return true;
+}
+
+std::vector<ObjMaterial> GltfLoader::loadMaterials(const GlbFile &file, std::vector<TextureSource> &texture_sources)
+{
+    const nlohmann::json &json = file.getJson();
+    const nlohmann::json &json_textures = getMember(json, "textures");
+    const nlohmann::json &json_images = getMember(json, "images");
+
+    // only images used as base color are loaded, in order of first use
+    std::unordered_map<uint32_t, int> image_textures;
+    auto textureOfImage = [&](uint32_t image) -> int {
+        auto known = image_textures.find(image);
+        if (known != image_textures.end()) return known->second;
+
+        const nlohmann::json &json_image = json_images[image];
+        TextureSource source{};
+        if (json_image.contains("bufferView")) {
+            source.file_name = "embedded image " + std::to_string(image);
+            source.encoded = file.getBufferView(json_image["bufferView"].get<uint32_t>());
+            if (source.encoded.empty()) return image_textures[image] = -1;
+        } else {
+            const std::string uri = json_image.value("uri", std::string());
+            if (uri.empty() || uri.rfind("data:", 0) == 0) {
+                spdlog::warn("glTF image {}: data URIs are not supported", image);
+                return image_textures[image] = -1;
+            }
+            // a baked .ktx2 next to the source image already has its mips and is block compressed
+            std::filesystem::path baked(file.getBaseDir() + "/" + uri);
+            baked.replace_extension(".ktx2");
+            source.file_name = std::filesystem::exists(baked) ? baked.string() : file.getBaseDir() + "/" + uri;
+        }
+
+        texture_sources.push_back(source);
+        return image_textures[image] = static_cast<int>(texture_sources.size() - 1);
+    };
+
+    std::vector<ObjMaterial> materials;
+    for (const nlohmann::json &json_material : getMember(json, "materials")) {
+        const nlohmann::json &pbr = getMember(json_material, "pbrMetallicRoughness");
+        const std::vector<float> base_color = pbr.value("baseColorFactor", std::vector<float>{ 1.f, 1.f, 1.f, 1.f });
+        const std::vector<float> emission = json_material.value("emissiveFactor", std::vector<float>{ 0.f, 0.f, 0.f });
+        const float roughness = pbr.value("roughnessFactor", 1.f);
+
+        // the shading model is Phong-like; metallic/roughness only map onto it approximately
+        ObjMaterial material{};
+        material.diffuse =
+          base_color.size() >= 3 ? glm::vec3(base_color[0], base_color[1], base_color[2]) : glm::vec3(1.f);
+        material.ambient = material.diffuse * 0.1f;
+        material.specular = glm::vec3(1.f - roughness);
+        material.transmittance = glm::vec3(0.f);
+        material.emission = emission.size() >= 3 ? glm::vec3(emission[0], emission[1], emission[2]) : glm::vec3(0.f);
+        material.shininess = (1.f - roughness) * (1.f - roughness) * 128.f;
+        material.ior = getMember(getMember(json_material, "extensions"), "KHR_materials_ior").value("ior", 1.5f);
+        material.dissolve = base_color.size() >= 4 ? base_color[3] : 1.f;
+        material.illum = 2;
+        // same convention as the OBJ path: untextured materials point at texture 0
+        material.textureID = 0;
+
+        const nlohmann::json &base_color_texture = getMember(pbr, "baseColorTexture");
+        const uint32_t texture = base_color_texture.value("index", UINT32_MAX);
+        if (texture < json_textures.size()) {
+            const uint32_t image = json_textures[texture].value("source", UINT32_MAX);
+            if (image < json_images.size()) material.textureID = std::max(textureOfImage(image), 0);
+        }
+
+        materials.push_back(material);
+    }
+
+    // for primitives without material
+    ObjMaterial default_material{};
+    default_material.diffuse = glm::vec3(1.f);
+    default_material.ambient = glm::vec3(0.1f);
+    default_material.ior = 1.5f;
+    default_material.dissolve = 1.f;
+    default_material.illum = 2;
+    materials.push_back(default_material);
+
+    return materials;
+}
+
+void GltfLoader::createTextures(std::shared_ptr<Model> &model,
+  VulkanUploader &uploader,
+  const std::vector<TextureSource> &texture_sources,
+  std::span<GltfMeshData> meshes,
+  std::span<const GltfMeshNode> mesh_nodes)
+{
+    // streaming demand: the footprint of every mesh, moved into model space by each node placing it
+    std::vector<TextureFootprint> footprints;
+    if (texture_streamer) {
+        footprints.resize(texture_sources.size());
+        std::vector<bool> used(texture_sources.size(), false);
+        std::vector<std::vector<TextureFootprint>> mesh_footprints(meshes.size());
+        for (size_t m = 0; m < meshes.size(); m++) {
+            std::vector<int> material_textures;
+            for (const ObjMaterial &material : meshes[m].materials) material_textures.push_back(material.textureID);
+            mesh_footprints[m] = TextureStreamer::computeFootprints(meshes[m].vertices,
+              meshes[m].indices,
+              meshes[m].materialIndex,
+              material_textures,
+              texture_sources.size());
+        }
+
+        for (const GltfMeshNode &mesh_node : mesh_nodes) {
+            if (mesh_node.mesh >= meshes.size()) continue;
+            const glm::mat4 &t = mesh_node.transform;
+            const float scale = std::max(
+              { glm::length(glm::vec3(t[0])), glm::length(glm::vec3(t[1])), glm::length(glm::vec3(t[2])) });
+
+            for (size_t texture = 0; texture < texture_sources.size(); texture++) {
+                const TextureFootprint &local = mesh_footprints[mesh_node.mesh][texture];
+                if (local.uv_density <= 0.f) continue;
+
+                TextureFootprint &footprint = footprints[texture];
+                for (int corner = 0; corner < 8; corner++) {
+                    const glm::vec3 position((corner & 1) ? local.bounds_max.x : local.bounds_min.x,
+                      (corner & 2) ? local.bounds_max.y : local.bounds_min.y,
+                      (corner & 4) ? local.bounds_max.z : local.bounds_min.z);
+                    const glm::vec3 transformed = glm::vec3(t * glm::vec4(position, 1.f));
+                    footprint.bounds_min = used[texture] ? glm::min(footprint.bounds_min, transformed) : transformed;
+                    footprint.bounds_max = used[texture] ? glm::max(footprint.bounds_max, transformed) : transformed;
+                    used[texture] = true;
+                }
+                footprint.uv_density = std::max(footprint.uv_density, local.uv_density / std::max(scale, 1e-6f));
+            }
+        }
+    }
+
+    // images already in the scene's texture cache are shared, only the others are decoded;
+    // embedded ones are recognized by their content, so equal images of different files match
+    std::vector<uint32_t> slots(texture_sources.size());
+    std::vector<TextureSource> missing_sources;
+    std::vector<size_t> missing_textures;
+    for (size_t texture = 0; texture < texture_sources.size(); texture++) {
+        const TextureSource &source = texture_sources[texture];
+        const std::string key = source.encoded.empty() ? TextureCache::fileKey(source.file_name)
+                                                       : TextureCache::contentKey(source.encoded);
+        if (!texture_cache->acquire(key, slots[texture])) {
+            slots[texture] = texture_cache->reserve(key);
+            missing_sources.push_back(source);
+            missing_textures.push_back(texture);
+        }
+        model->addTexture(slots[texture]);
+    }
+
+    // decoding runs on worker threads; embedded images are decoded straight from the mapping
+    TextureDecoderSettings decoder_settings{};
+    decoder_settings.format_support = TextureFormatSupport::query(device->getPhysicalDevice());
+    // streaming needs every level on the CPU, and transfer queues can't blit them on the GPU
+    decoder_settings.generate_mip_chain = texture_streamer || !uploader.canBlit();
+    TextureDecoder decoder(decoder_settings);
+    decoder.decode(missing_sources,
+      [this, &slots, &missing_textures, &model, &footprints, &uploader](size_t file, TextureData &textureData) {
+          const size_t texture = missing_textures[file];
+          Texture created;
+          if (texture_streamer) {
+              created = texture_streamer->addTexture(
+                uploader, slots[texture], std::move(textureData), model.get(), footprints[texture]);
+          } else {
+              created.createFromData(device, uploader, textureData);
+          }
+          texture_cache->setTexture(slots[texture], created);
+      });
+
+    if (texture_streamer) {
+        for (size_t texture = 0, missing = 0; texture < texture_sources.size(); texture++) {
+            if (missing < missing_textures.size() && missing_textures[missing] == texture) {
+                missing++;
+            } else {
+                texture_streamer->addUser(slots[texture], model.get(), footprints[texture]);
+            }
+        }
+    }
+    if (missing_sources.size() < texture_sources.size()) {
+        spdlog::info("Shared {} of {} textures through the texture cache",
+          texture_sources.size() - missing_sources.size(),
+          texture_sources.size());
+    }
+
+    for (GltfMeshData &mesh : meshes) {
+        for (ObjMaterial &material : mesh.materials) {
+            if (material.textureID >= 0 && static_cast<size_t>(material.textureID) < slots.size()) {
+                material.textureID = static_cast<int>(slots[material.textureID]);
+            }
+        }
+    }
+}
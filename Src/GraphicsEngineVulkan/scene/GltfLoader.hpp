@@ -0,0 +1,92 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Model.hpp"
+#include "scene/GlbFile.hpp"
+#include "scene/ObjMaterial.hpp"
+#include "scene/Submesh.hpp"
+#include "scene/TextureDecoder.hpp"
+#include "scene/TextureStreamer.hpp"
+#include "scene/Vertex.hpp"
+
+namespace Kataglyphis {
+
+struct GltfLoaderSettings
+{
+    // upload vertices in the 16 byte CompactVertex layout
+    bool compact_vertices{ false };
+    // draw and build every primitive on its own (see ObjLoaderSettings::split_submeshes); without
+    // it a mesh's primitives form a single submesh
+    bool split_submeshes{ false };
+};
+
+// geometry of one glTF mesh: its triangle primitives back to back, one submesh each.
+// The views point either into the owned vectors or straight into the mapped file.
+struct GltfMeshData
+{
+    std::span<const Vertex> vertices;
+    std::span<const uint32_t> indices;
+    std::vector<unsigned int> materialIndex;
+    // only the materials the mesh uses; materialIndex and the submeshes index into them
+    std::vector<ObjMaterial> materials;
+    std::vector<Submesh> submeshes;
+
+    std::vector<Vertex> vertex_storage;
+    std::vector<uint32_t> index_storage;
+};
+
+// Loads binary glTF 2.0 files (.glb). The file is memory mapped; index data and
+// vertex data already in the Vertex layout go from the mapping straight into
+// the staging memory of the upload, everything else is converted in a single
+// pass per attribute stream. Every glTF mesh becomes one Mesh of the model and
+// every node referencing it one MeshInstance, so the node hierarchy and shared
+// meshes survive. There is no mesh cache: the binary chunk already is the
+// processed form.
+class GltfLoader
+{
+  public:
+    // uploads run on the transfer queue; graphics_command_pool takes over their ownership
+    GltfLoader(VulkanDevice *device,
+      VkCommandPool transfer_command_pool,
+      VkCommandPool graphics_command_pool,
+      GltfLoaderSettings settings = GltfLoaderSettings{},
+      TextureStreamer *texture_streamer = nullptr,
+      GeometryArena *geometry_arena = nullptr,
+      TextureCache *texture_cache = nullptr);
+
+    // needs a geometry arena for the meshes and a texture cache for their textures
+    std::shared_ptr<Model> loadModel(const std::string &modelFile);
+
+    // CPU side of a mesh; false if it has no triangles or references data outside the binary chunk
+    static bool loadMesh(const GlbFile &file,
+      uint32_t mesh_index,
+      std::span<const ObjMaterial> materials,
+      GltfMeshData &mesh);
+    // all materials of the file plus a default one at the end for primitives without material;
+    // textureID indexes texture_sources, one entry per image that is used as base color
+    static std::vector<ObjMaterial> loadMaterials(const GlbFile &file, std::vector<TextureSource> &texture_sources);
+
+  private:
+    Kataglyphis::VulkanDevice *device;
+    VkCommandPool transfer_command_pool;
+    VkCommandPool graphics_command_pool;
+    GltfLoaderSettings settings;
+    // null uploads every texture fully resident
+    TextureStreamer *texture_streamer;
+    GeometryArena *geometry_arena;
+    TextureCache *texture_cache;
+
+    // turns the texture ids of the meshes' materials into texture cache slots
+    void createTextures(std::shared_ptr<Model> &model,
+      VulkanUploader &uploader,
+      const std::vector<TextureSource> &texture_sources,
+      std::span<GltfMeshData> meshes,
+      std::span<const GltfMeshNode> mesh_nodes);
+};
+
+}// namespace Kataglyphis
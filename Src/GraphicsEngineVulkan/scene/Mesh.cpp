@@ -1,9 +1,14 @@
 #include "scene/Mesh.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <memory>
 
 #include "common/Utilities.hpp"
+#include "spdlog/spdlog.h"
+#include "scene/MeshletBuilder.hpp"
+#include "scene/SubmeshBuilder.hpp"
 #include "vulkan_base/VulkanBuffer.hpp"
 
 using namespace Kataglyphis;
@@ -12,20 +17,21 @@ Mesh::Mesh() {}
 
 void Mesh::cleanUp()
 {
-    vertexBuffer.cleanUp();
-    indexBuffer.cleanUp();
-    objectDescriptionBuffer.cleanUp();
-    materialIdsBuffer.cleanUp();
-    materialsBuffer.cleanUp();
+    meshletBuffer.cleanUp();
+    positionTransformBuffer.cleanUp();
+    submeshBuffer.cleanUp();
 }
 
 Mesh::Mesh(VulkanDevice *device,
-  VkQueue transfer_queue,
-  VkCommandPool transfer_command_pool,
-  std::vector<Vertex> &vertices,
-  std::vector<uint32_t> &indices,
-  std::vector<unsigned int> &materialIndex,
-  std::vector<ObjMaterial> &materials)
+  VulkanUploader &uploader,
+  GeometryArena &arena,
+  std::span<const Vertex> vertices,
+  std::span<const uint32_t> indices,
+  std::span<const unsigned int> materialIndex,
+  std::span<const ObjMaterial> materials,
+  std::span<const MeshLod> lods,
+  std::span<const Submesh> submeshes,
+  bool compact_vertices)
 {
     // glm uses column major matrices so transpose it for Vulkan want row major
     // here
@@ -33,92 +39,168 @@ Mesh::Mesh(VulkanDevice *device,
     VkTransformMatrixKHR out_matrix;
     std::memcpy(&out_matrix, &transpose_transform, sizeof(VkTransformMatrixKHR));
 
-    index_count = static_cast<uint32_t>(indices.size());
+    // without a LOD chain the whole index buffer is the only level
+    if (lods.empty()) {
+        this->lods = { MeshLod{ 0, static_cast<uint32_t>(indices.size()), 0.f } };
+    } else {
+        this->lods.assign(lods.begin(), lods.end());
+    }
+    index_count = this->lods[0].index_count;
     vertex_count = static_cast<uint32_t>(vertices.size());
+    computeBoundingSphere(vertices);
+    // without submeshes the whole full resolution level is the only one
+    if (submeshes.empty()) {
+        Submesh submesh{};
+        submesh.index_count = index_count;
+        SubmeshBuilder::computeBounds(vertices, indices, submesh);
+        this->submeshes = { submesh };
+    } else {
+        this->submeshes.assign(submeshes.begin(), submeshes.end());
+    }
     this->device = device;
     object_description = ObjectDescription{};
-    createVertexBuffer(transfer_queue, transfer_command_pool, vertices);
-    createIndexBuffer(transfer_queue, transfer_command_pool, indices);
-    createMaterialIDBuffer(transfer_queue, transfer_command_pool, materialIndex);
-    createMaterialBuffer(transfer_queue, transfer_command_pool, materials);
-
-    VkBufferDeviceAddressInfo vertex_info{};
-    vertex_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
-    vertex_info.buffer = vertexBuffer.getBuffer();
-
-    VkBufferDeviceAddressInfo index_info{};
-    index_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
-    index_info.buffer = indexBuffer.getBuffer();
-
-    VkBufferDeviceAddressInfo material_index_info{};
-    material_index_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
-    material_index_info.buffer = materialIdsBuffer.getBuffer();
-
-    VkBufferDeviceAddressInfo material_info{};
-    material_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
-    material_info.buffer = materialsBuffer.getBuffer();
-
-    object_description.index_address = vkGetBufferDeviceAddress(device->getLogicalDevice(), &index_info);
-    object_description.vertex_address = vkGetBufferDeviceAddress(device->getLogicalDevice(), &vertex_info);
-    object_description.material_index_address =
-      vkGetBufferDeviceAddress(device->getLogicalDevice(), &material_index_info);
-    object_description.material_address = vkGetBufferDeviceAddress(device->getLogicalDevice(), &material_info);
+    uploadGeometry(uploader, arena, vertices, indices, materialIndex, materials, compact_vertices);
+
+    // ray tracing builds one geometry per submesh; hits find their triangle through this table
+    createSubmeshBuffer(uploader);
+    VkBufferDeviceAddressInfo submesh_info{};
+    submesh_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
+    submesh_info.buffer = submeshBuffer.getBuffer();
+    object_description.submesh_address = vkGetBufferDeviceAddress(device->getLogicalDevice(), &submesh_info);
+
+    // clusters for GPU culling in the rasterizer; they only index into the existing index buffer
+    MeshletBuilder meshletBuilder;
+    std::vector<Meshlet> meshlets = meshletBuilder.build(vertices, indices.subspan(0, index_count));
+    meshlet_count = static_cast<uint32_t>(meshlets.size());
+    if (!meshlets.empty()) { createMeshletBuffer(uploader, meshlets); }
+
+    if (meshlet_count > 0) {
+        VkBufferDeviceAddressInfo meshlet_info{};
+        meshlet_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
+        meshlet_info.buffer = meshletBuffer.getBuffer();
+        meshlet_address = vkGetBufferDeviceAddress(device->getLogicalDevice(), &meshlet_info);
+    }
+
+    if (hasCompactVertices()) {
+        createPositionTransformBuffer(uploader);
+
+        VkBufferDeviceAddressInfo position_transform_info{};
+        position_transform_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
+        position_transform_info.buffer = positionTransformBuffer.getBuffer();
+        position_transform_address = vkGetBufferDeviceAddress(device->getLogicalDevice(), &position_transform_info);
+    }
 
     model = glm::mat4(1.0f);
 }
 
 void Mesh::setModel(glm::mat4 new_model) { model = new_model; }
 
+void Mesh::computeBoundingSphere(std::span<const Vertex> vertices)
+{
+    if (vertices.empty()) return;
+
+    glm::vec3 min_pos = vertices[0].pos;
+    glm::vec3 max_pos = vertices[0].pos;
+    for (const Vertex &vertex : vertices) {
+        min_pos = glm::min(min_pos, vertex.pos);
+        max_pos = glm::max(max_pos, vertex.pos);
+    }
+
+    const glm::vec3 center = (min_pos + max_pos) * 0.5f;
+    float radius_squared = 0.f;
+    for (const Vertex &vertex : vertices) {
+        const glm::vec3 d = vertex.pos - center;
+        radius_squared = std::max(radius_squared, glm::dot(d, d));
+    }
+    bounding_sphere = glm::vec4(center, std::sqrt(radius_squared));
+}
+
 Mesh::~Mesh() {}
 
-void Mesh::createVertexBuffer(VkQueue transfer_queue,
-  VkCommandPool transfer_command_pool,
-  std::vector<Vertex> &vertices)
+void Mesh::uploadGeometry(VulkanUploader &uploader,
+  GeometryArena &arena,
+  std::span<const Vertex> vertices,
+  std::span<const uint32_t> indices,
+  std::span<const unsigned int> materialIndex,
+  std::span<const ObjMaterial> materials,
+  bool compact_vertices)
 {
-    vulkanBufferManager.createBufferAndUploadVectorOnDevice(device,
-      transfer_command_pool,
-      vertexBuffer,
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-        | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
-      vertices);
+    if (!arena.allocate(static_cast<uint32_t>(vertices.size()),
+          static_cast<uint32_t>(indices.size()),
+          static_cast<uint32_t>(materialIndex.size()),
+          static_cast<uint32_t>(materials.size()),
+          geometry_range)) {
+        spdlog::error("Geometry arena is full, raise sceneConfig::getGeometryArenaSettings()!");
+        exit(EXIT_FAILURE);
+    }
+
+    object_description.vertex_address = arena.getVertexAddress(geometry_range);
+    object_description.index_address = arena.getIndexAddress(geometry_range);
+    object_description.material_index_address = arena.getMaterialIndexAddress(geometry_range);
+    object_description.material_address = arena.getMaterialAddress();
+
+    if (!compact_vertices) {
+        object_description.position_offset = glm::vec4(0.f);
+        object_description.position_scale = glm::vec4(1.f);
+        object_description.vertex_format = VERTEX_FORMAT_FULL;
+
+        arena.upload(uploader, geometry_range, vertices.data(), indices, materialIndex, materials);
+        return;
+    }
+
+    // the full vertices stay the CPU side format (cache, simplification, meshlets); only the GPU copy is compact
+    std::vector<CompactVertex> compact;
+    const VertexQuantization quantization = vertex::compressVertices(vertices, compact);
+    object_description.position_offset = quantization.position_offset;
+    object_description.position_scale = quantization.position_scale;
+    object_description.vertex_format =
+      vertex::hasVertexColors(vertices) ? VERTEX_FORMAT_COMPACT_COLOR : VERTEX_FORMAT_COMPACT;
+
+    arena.upload(uploader, geometry_range, compact.data(), indices, materialIndex, materials);
 }
 
-void Mesh::createIndexBuffer(VkQueue transfer_queue,
-  VkCommandPool transfer_command_pool,
-  std::vector<uint32_t> &indices)
+void Mesh::createPositionTransformBuffer(VulkanUploader &uploader)
 {
-    vulkanBufferManager.createBufferAndUploadVectorOnDevice(device,
-      transfer_command_pool,
-      indexBuffer,
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-        | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
-      indices);
+    // row major 3x4: scale on the diagonal, offset in the last column
+    VkTransformMatrixKHR transform{};
+    for (int row = 0; row < 3; row++) {
+        transform.matrix[row][row] = object_description.position_scale[row];
+        transform.matrix[row][3] = object_description.position_offset[row];
+    }
+
+    vulkanBufferManager.createBufferAndUploadDataOnDevice(device,
+      uploader,
+      positionTransformBuffer,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+        | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      &transform,
+      sizeof(transform));
 }
 
-void Mesh::createMaterialIDBuffer(VkQueue transfer_queue,
-  VkCommandPool transfer_command_pool,
-  std::vector<unsigned int> &materialIndex)
+void Mesh::createMeshletBuffer(VulkanUploader &uploader, std::span<const Meshlet> meshlets)
 {
-    vulkanBufferManager.createBufferAndUploadVectorOnDevice(device,
-      transfer_command_pool,
-      materialIdsBuffer,
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-        | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
-      materialIndex);
+    vulkanBufferManager.createBufferAndUploadDataOnDevice(device,
+      uploader,
+      meshletBuffer,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      meshlets.data(),
+      meshlets.size_bytes());
 }
 
-void Mesh::createMaterialBuffer(VkQueue transfer_queue,
-  VkCommandPool transfer_command_pool,
-  std::vector<ObjMaterial> &materials)
+void Mesh::createSubmeshBuffer(VulkanUploader &uploader)
 {
-    vulkanBufferManager.createBufferAndUploadVectorOnDevice(device,
-      transfer_command_pool,
-      materialsBuffer,
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-        | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
-      materials);
+    // first triangle of every submesh within the mesh, indexed by the geometry index of a hit
+    std::vector<uint32_t> first_triangles;
+    first_triangles.reserve(submeshes.size());
+    for (const Submesh &submesh : submeshes) first_triangles.push_back(submesh.index_offset / 3);
+
+    vulkanBufferManager.createBufferAndUploadDataOnDevice(device,
+      uploader,
+      submeshBuffer,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      first_triangles.data(),
+      first_triangles.size() * sizeof(uint32_t));
 }
@@ -1,24 +1,34 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <span>
 #include <vector>
 
 #include "ObjectDescription.hpp"
+#include "scene/CompactVertex.hpp"
+#include "scene/GeometryArena.hpp"
+#include "scene/MeshLod.hpp"
+#include "scene/Meshlet.hpp"
 #include "scene/ObjMaterial.hpp"
+#include "scene/Submesh.hpp"
 #include "scene/Vertex.hpp"
 #include "vulkan_base/VulkanBufferManager.hpp"
 
 namespace Kataglyphis {
 // this a simple Mesh without mesh generation
+// vertices, indices and materials live in the scene's GeometryArena; the mesh only keeps its range
 class Mesh
 {
   public:
     Mesh(VulkanDevice *device,
-      VkQueue transfer_queue,
-      VkCommandPool transfer_command_pool,
-      std::vector<Vertex> &vertices,
-      std::vector<uint32_t> &indices,
-      std::vector<unsigned int> &materialIndex,
-      std::vector<ObjMaterial> &materials);
+      VulkanUploader &uploader,
+      GeometryArena &arena,
+      std::span<const Vertex> vertices,
+      std::span<const uint32_t> indices,
+      std::span<const unsigned int> materialIndex,
+      std::span<const ObjMaterial> materials,
+      std::span<const MeshLod> lods = {},
+      std::span<const Submesh> submeshes = {},
+      bool compact_vertices = false);
 
     Mesh();
 
@@ -27,10 +37,30 @@ class Mesh
     ObjectDescription &getObjectDescription() { return object_description; };
     glm::mat4 getModel() { return model; };
     uint32_t getVertexCount() { return vertex_count; };
+    // index count of the full resolution level; the index buffer holds all levels
     uint32_t getIndexCount() { return index_count; };
-    VkBuffer &getVertexBuffer() { return vertexBuffer.getBuffer(); };
-    VkBuffer &getMaterialIDBuffer() { return materialIdsBuffer.getBuffer(); };
-    VkBuffer &getIndexBuffer() { return indexBuffer.getBuffer(); };
+    const std::vector<MeshLod> &getLods() { return lods; };
+    glm::vec4 getBoundingSphere() { return bounding_sphere; };
+    // at least one; together they cover LOD 0
+    const std::vector<Submesh> &getSubmeshes() { return submeshes; };
+    const GeometryRange &getGeometryRange() { return geometry_range; };
+    VkDeviceAddress getVertexAddress() { return object_description.vertex_address; };
+    VkDeviceAddress getIndexAddress() { return object_description.index_address; };
+    uint32_t getMeshletCount() { return meshlet_count; };
+    VkDeviceAddress getMeshletBufferAddress() { return meshlet_address; };
+    bool hasCompactVertices() { return object_description.vertex_format != VERTEX_FORMAT_FULL; };
+    VertexQuantization getVertexQuantization()
+    {
+        return VertexQuantization{ object_description.position_offset, object_description.position_scale };
+    };
+    // layout of the positions for acceleration structure builds
+    VkFormat getPositionFormat()
+    {
+        return hasCompactVertices() ? VK_FORMAT_R16G16B16A16_SNORM : VK_FORMAT_R32G32B32_SFLOAT;
+    };
+    VkDeviceSize getVertexStride() { return hasCompactVertices() ? sizeof(CompactVertex) : sizeof(Vertex); };
+    // 3x4 matrix decoding compact positions during acceleration structure builds; 0 if not needed
+    VkDeviceAddress getPositionTransformAddress() { return position_transform_address; };
 
     void setModel(glm::mat4 new_model);
 
@@ -44,29 +74,38 @@ class Mesh
         static_cast<uint64_t>(-1),
         static_cast<uint64_t>(-1) };
 
-    VulkanBuffer vertexBuffer;
-    VulkanBuffer indexBuffer;
-    VulkanBuffer objectDescriptionBuffer;
-    VulkanBuffer materialIdsBuffer;
-    VulkanBuffer materialsBuffer;
+    GeometryRange geometry_range;
+    VulkanBuffer meshletBuffer;
+    VulkanBuffer positionTransformBuffer;
+    VulkanBuffer submeshBuffer;
 
     glm::mat4 model;
 
     uint32_t vertex_count{ static_cast<uint32_t>(-1) };
     uint32_t index_count{ static_cast<uint32_t>(-1) };
+    uint32_t meshlet_count{ 0 };
+    std::vector<MeshLod> lods;
+    std::vector<Submesh> submeshes;
+    glm::vec4 bounding_sphere{ 0.f };
+    VkDeviceAddress meshlet_address{ 0 };
+    VkDeviceAddress position_transform_address{ 0 };
 
     VulkanDevice *device{ VK_NULL_HANDLE };
 
-    void createVertexBuffer(VkQueue transfer_queue, VkCommandPool transfer_command_pool, std::vector<Vertex> &vertices);
+    void uploadGeometry(VulkanUploader &uploader,
+      GeometryArena &arena,
+      std::span<const Vertex> vertices,
+      std::span<const uint32_t> indices,
+      std::span<const unsigned int> materialIndex,
+      std::span<const ObjMaterial> materials,
+      bool compact_vertices);
 
-    void createIndexBuffer(VkQueue transfer_queue, VkCommandPool transfer_command_pool, std::vector<uint32_t> &indices);
+    void createPositionTransformBuffer(VulkanUploader &uploader);
 
-    void createMaterialIDBuffer(VkQueue transfer_queue,
-      VkCommandPool transfer_command_pool,
-      std::vector<unsigned int> &materialIndex);
+    void computeBoundingSphere(std::span<const Vertex> vertices);
 
-    void createMaterialBuffer(VkQueue transfer_queue,
-      VkCommandPool transfer_command_pool,
-      std::vector<ObjMaterial> &materials);
+    void createMeshletBuffer(VulkanUploader &uploader, std::span<const Meshlet> meshlets);
+
+    void createSubmeshBuffer(VulkanUploader &uploader);
 };
 }// namespace Kataglyphis
\ No newline at end of file
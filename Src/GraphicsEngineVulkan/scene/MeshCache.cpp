@@ -0,0 +1,211 @@
+#include "scene/MeshCache.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+
+#include "spdlog/spdlog.h"
+#include "util/File.hpp"
+#include "util/Hash.hpp"
+
+using namespace Kataglyphis;
+
+static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex must be trivially copyable to be cached!");
+static_assert(std::is_trivially_copyable_v<ObjMaterial>, "ObjMaterial must be trivially copyable to be cached!");
+static_assert(std::is_trivially_copyable_v<MeshLod>, "MeshLod must be trivially copyable to be cached!");
+static_assert(std::is_trivially_copyable_v<Submesh>, "Submesh must be trivially copyable to be cached!");
+
+namespace {
+
+constexpr size_t section_alignment = 16;
+
+size_t alignSection(size_t offset, size_t alignment) { return (offset + alignment - 1) & ~(alignment - 1); }
+
+template<typename T> std::span<const T> viewSection(const std::byte *base, size_t &offset, uint64_t count)
+{
+    std::span<const T> view(reinterpret_cast<const T *>(base + offset), static_cast<size_t>(count));
+    offset = alignSection(offset + sizeof(T) * count, section_alignment);
+    return view;
+}
+
+template<typename T> void writeSection(std::ofstream &stream, const std::vector<T> &data)
+{
+    static const char padding[section_alignment] = {};
+    const size_t size = sizeof(T) * data.size();
+    stream.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(size));
+    stream.write(padding, static_cast<std::streamsize>(alignSection(size, section_alignment) - size));
+}
+
+}// namespace
+
+MeshCache::MeshCache(const std::string &source_file, uint32_t loader_version)
+{
+    this->source_file = source_file;
+    this->cache_file = source_file + ".kgcache";
+    this->base_dir = File(source_file).getBaseDir();
+    this->loader_version = loader_version;
+}
+
+bool MeshCache::load()
+{
+    if (!mapping.open(cache_file)) return false;
+
+    const std::byte *base = mapping.data();
+    const size_t size = mapping.size();
+
+    Header header{};
+    if (size < sizeof(Header)) return false;
+    std::memcpy(&header, base, sizeof(Header));
+
+    uint64_t source_hash = 0;
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.format_version != format_version
+        || header.loader_version != loader_version || header.vertex_size != sizeof(Vertex)
+        || header.material_size != sizeof(ObjMaterial) || !computeSourceHash(source_hash)
+        || header.source_hash != source_hash) {
+        spdlog::info("Mesh cache {} is outdated and will be rebuilt.", cache_file);
+        mapping.close();
+        return false;
+    }
+
+    size_t offset = alignSection(sizeof(Header), section_alignment);
+    const size_t payload_size = alignSection(sizeof(Vertex) * header.vertex_count, section_alignment)
+                                + alignSection(sizeof(unsigned int) * header.index_count, section_alignment)
+                                + alignSection(sizeof(unsigned int) * header.material_index_count, section_alignment)
+                                + alignSection(sizeof(ObjMaterial) * header.material_count, section_alignment)
+                                + alignSection(sizeof(MeshLod) * header.lod_count, section_alignment)
+                                + alignSection(sizeof(Submesh) * header.submesh_count, section_alignment);
+    if (offset + payload_size > size) {
+        spdlog::warn("Mesh cache {} is truncated!", cache_file);
+        mapping.close();
+        return false;
+    }
+
+    vertices = viewSection<Vertex>(base, offset, header.vertex_count);
+    indices = viewSection<unsigned int>(base, offset, header.index_count);
+    materialIndex = viewSection<unsigned int>(base, offset, header.material_index_count);
+    materials = viewSection<ObjMaterial>(base, offset, header.material_count);
+    lods = viewSection<MeshLod>(base, offset, header.lod_count);
+    submeshes = viewSection<Submesh>(base, offset, header.submesh_count);
+
+    // texture names inside the model directory are stored relative to it;
+    // empty names mark materials without texture
+    textures.clear();
+    textures.reserve(header.texture_count);
+    for (uint64_t i = 0; i < header.texture_count; i++) {
+        uint32_t length = 0;
+        if (offset + sizeof(length) > size) break;
+        std::memcpy(&length, base + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > size) break;
+
+        std::string name(reinterpret_cast<const char *>(base + offset), length);
+        offset += length;
+        if (name.starts_with("./")) name = base_dir + name.substr(1);
+        textures.push_back(name);
+    }
+
+    if (textures.size() != header.texture_count) {
+        spdlog::warn("Mesh cache {} is truncated!", cache_file);
+        mapping.close();
+        return false;
+    }
+
+    return true;
+}
+
+void MeshCache::store(const std::vector<Vertex> &vertices,
+  const std::vector<unsigned int> &indices,
+  const std::vector<unsigned int> &materialIndex,
+  const std::vector<ObjMaterial> &materials,
+  const std::vector<MeshLod> &lods,
+  const std::vector<Submesh> &submeshes,
+  const std::vector<std::string> &textures)
+{
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.format_version = format_version;
+    header.loader_version = loader_version;
+    header.vertex_size = sizeof(Vertex);
+    header.material_size = sizeof(ObjMaterial);
+    header.vertex_count = vertices.size();
+    header.index_count = indices.size();
+    header.material_index_count = materialIndex.size();
+    header.material_count = materials.size();
+    header.lod_count = lods.size();
+    header.submesh_count = submeshes.size();
+    header.texture_count = textures.size();
+
+    if (!computeSourceHash(header.source_hash)) return;
+
+    // write to a temporary file first so an interrupted run never leaves a
+    // half written cache behind
+    const std::string temporary_file = cache_file + ".tmp";
+    {
+        std::ofstream stream(temporary_file, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open()) {
+            spdlog::warn("Failed to write mesh cache {}!", cache_file);
+            return;
+        }
+
+        static const char padding[section_alignment] = {};
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        stream.write(
+          padding, static_cast<std::streamsize>(alignSection(sizeof(Header), section_alignment) - sizeof(Header)));
+
+        writeSection(stream, vertices);
+        writeSection(stream, indices);
+        writeSection(stream, materialIndex);
+        writeSection(stream, materials);
+        writeSection(stream, lods);
+        writeSection(stream, submeshes);
+
+        for (const std::string &texture : textures) {
+            std::string name = texture;
+            if (!name.empty() && name.starts_with(base_dir + "/")) name = "." + name.substr(base_dir.size());
+
+            uint32_t length = static_cast<uint32_t>(name.size());
+            stream.write(reinterpret_cast<const char *>(&length), sizeof(length));
+            stream.write(name.data(), static_cast<std::streamsize>(length));
+        }
+
+        if (!stream.good()) {
+            spdlog::warn("Failed to write mesh cache {}!", cache_file);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_file, cache_file, error);
+    if (error) { spdlog::warn("Failed to write mesh cache {}: {}", cache_file, error.message()); }
+}
+
+bool MeshCache::computeSourceHash(uint64_t &hash)
+{
+    MappedFile source;
+    if (!source.open(source_file)) return false;
+
+    hash = hashBytes(source.data(), source.size(), loader_version);
+
+    // material libraries change the cached materials as well
+    std::string_view content(reinterpret_cast<const char *>(source.data()), source.size());
+    size_t position = content.find("mtllib");
+    while (position != std::string_view::npos) {
+        if (position == 0 || content[position - 1] == '\n') {
+            size_t line_end = content.find_first_of("\r\n", position);
+            std::istringstream library_names(std::string(content.substr(position + 6, line_end - position - 6)));
+
+            std::string library_name;
+            while (library_names >> library_name) {
+                MappedFile library;
+                if (library.open(base_dir + "/" + library_name)) {
+                    hash = combineHash64(hash, hashBytes(library.data(), library.size()));
+                }
+            }
+        }
+        position = content.find("mtllib", position + 6);
+    }
+
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "scene/MeshLod.hpp"
+#include "scene/ObjMaterial.hpp"
+#include "scene/Submesh.hpp"
+#include "scene/Vertex.hpp"
+#include "util/MappedFile.hpp"
+
+namespace Kataglyphis {
+// binary cache of a fully processed model, stored next to the source file;
+// a cache is only accepted if source hash, loader version and the memory
+// layout of the stored types all match
+class MeshCache
+{
+  public:
+    MeshCache(const std::string &source_file, uint32_t loader_version);
+
+    // maps the cache file; all getters return views into the mapping
+    bool load();
+    void store(const std::vector<Vertex> &vertices,
+      const std::vector<unsigned int> &indices,
+      const std::vector<unsigned int> &materialIndex,
+      const std::vector<ObjMaterial> &materials,
+      const std::vector<MeshLod> &lods,
+      const std::vector<Submesh> &submeshes,
+      const std::vector<std::string> &textures);
+
+    std::span<const Vertex> getVertices() const { return vertices; };
+    std::span<const unsigned int> getIndices() const { return indices; };
+    std::span<const unsigned int> getMaterialIndex() const { return materialIndex; };
+    std::span<const ObjMaterial> getMaterials() const { return materials; };
+    std::span<const MeshLod> getLods() const { return lods; };
+    std::span<const Submesh> getSubmeshes() const { return submeshes; };
+    std::vector<std::string> getTextures() const { return textures; };
+
+    const std::string &getCacheFile() const { return cache_file; };
+
+  private:
+    struct Header
+    {
+        char magic[8];
+        uint32_t format_version;
+        uint32_t loader_version;
+        uint64_t source_hash;
+        uint32_t vertex_size;
+        uint32_t material_size;
+        uint64_t vertex_count;
+        uint64_t index_count;
+        uint64_t material_index_count;
+        uint64_t material_count;
+        uint64_t lod_count;
+        uint64_t submesh_count;
+        uint64_t texture_count;
+    };
+
+    static constexpr char magic[8] = { 'K', 'G', 'M', 'E', 'S', 'H', '\0', '\0' };
+    static constexpr uint32_t format_version = 3;
+
+    std::string source_file;
+    std::string cache_file;
+    std::string base_dir;
+    uint32_t loader_version{ 0 };
+
+    MappedFile mapping;
+
+    std::span<const Vertex> vertices;
+    std::span<const unsigned int> indices;
+    std::span<const unsigned int> materialIndex;
+    std::span<const ObjMaterial> materials;
+    std::span<const MeshLod> lods;
+    std::span<const Submesh> submeshes;
+    std::vector<std::string> textures;
+
+    bool computeSourceHash(uint64_t &hash);
+};
+}// namespace Kataglyphis
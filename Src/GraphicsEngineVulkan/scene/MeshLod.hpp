@@ -0,0 +1,34 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
+namespace Kataglyphis {
+
+// one level of detail of a mesh; all levels share the vertex buffer and are
+// stored back to back in the index buffer (LOD 0 first). The per-triangle
+// material ids are concatenated the same way, so the material of a LOD
+// triangle is materialIndex[index_offset / 3 + primitive id].
+struct MeshLod
+{
+    uint32_t index_offset{ 0 };
+    uint32_t index_count{ 0 };
+    // largest object space deviation from LOD 0 introduced by the simplification
+    float error{ 0.f };
+};
+
+// returns the coarsest level whose error projected to the screen stays below
+// threshold_pixels; lod_scale = viewport_height / (2 * tan(fov_y / 2)) turns
+// a world space length at distance 1 into pixels
+inline uint32_t selectLod(std::span<const MeshLod> lods, float distance, float lod_scale, float threshold_pixels)
+{
+    const float safe_distance = std::max(distance, 1e-4f);
+    uint32_t lod = 0;
+    for (uint32_t i = 1; i < static_cast<uint32_t>(lods.size()); i++) {
+        if (lods[i].error * lod_scale / safe_distance > threshold_pixels) break;
+        lod = i;
+    }
+    return lod;
+}
+
+}// namespace Kataglyphis
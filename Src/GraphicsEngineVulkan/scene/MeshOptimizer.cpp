@@ -0,0 +1,343 @@
+#include "scene/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace Kataglyphis;
+
+MeshOptimizer::MeshOptimizer(uint32_t cache_size, float cluster_threshold)
+{
+    this->cache_size = cache_size;
+    this->cluster_threshold = cluster_threshold;
+}
+
+MeshOptimizationStats MeshOptimizer::optimize(std::vector<Vertex> &vertices,
+  std::vector<uint32_t> &indices,
+  std::vector<unsigned int> &materialIndex,
+  std::span<const Submesh> submeshes) const
+{
+    MeshOptimizationStats stats{};
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) return stats;
+
+    stats.acmr_before = computeACMR(indices, vertices.size());
+    stats.atvr_before = computeATVR(indices, vertices.size());
+
+    std::vector<uint32_t> triangle_order;
+    if (submeshes.empty()) {
+        std::vector<uint32_t> cluster_starts;
+        triangle_order = optimizeVertexCache(indices, vertices.size(), cluster_starts);
+        triangle_order = optimizeOverdraw(vertices, indices, triangle_order, cluster_starts);
+    } else {
+        // every submesh is optimized on its own compacted vertices, which keeps the cost linear
+        const uint32_t unassigned = static_cast<uint32_t>(-1);
+        std::vector<uint32_t> local_vertex(vertices.size(), unassigned);
+        std::vector<Vertex> local_vertices;
+        std::vector<uint32_t> local_indices;
+        triangle_order.reserve(triangle_count);
+
+        for (const Submesh &submesh : submeshes) {
+            local_vertices.clear();
+            local_indices.clear();
+            for (uint32_t i = submesh.index_offset; i < submesh.index_offset + submesh.index_count; i++) {
+                if (local_vertex[indices[i]] == unassigned) {
+                    local_vertex[indices[i]] = static_cast<uint32_t>(local_vertices.size());
+                    local_vertices.push_back(vertices[indices[i]]);
+                }
+                local_indices.push_back(local_vertex[indices[i]]);
+            }
+            for (uint32_t i = submesh.index_offset; i < submesh.index_offset + submesh.index_count; i++) {
+                local_vertex[indices[i]] = unassigned;
+            }
+
+            std::vector<uint32_t> cluster_starts;
+            std::vector<uint32_t> local_order =
+              optimizeVertexCache(local_indices, local_vertices.size(), cluster_starts);
+            local_order = optimizeOverdraw(local_vertices, local_indices, local_order, cluster_starts);
+            for (uint32_t triangle : local_order) triangle_order.push_back(submesh.index_offset / 3 + triangle);
+        }
+    }
+
+    // apply the triangle order to the indices and the per-triangle materials
+    std::vector<uint32_t> reordered_indices(triangle_count * 3);
+    std::vector<unsigned int> reordered_material_index(materialIndex.size());
+    for (size_t i = 0; i < triangle_count; i++) {
+        const uint32_t triangle = triangle_order[i];
+        reordered_indices[i * 3 + 0] = indices[triangle * 3 + 0];
+        reordered_indices[i * 3 + 1] = indices[triangle * 3 + 1];
+        reordered_indices[i * 3 + 2] = indices[triangle * 3 + 2];
+        if (triangle < materialIndex.size()) reordered_material_index[i] = materialIndex[triangle];
+    }
+    indices.swap(reordered_indices);
+    if (materialIndex.size() == triangle_count) materialIndex.swap(reordered_material_index);
+
+    // finally store vertices in the order they are fetched
+    std::vector<uint32_t> remap = optimizeVertexFetch(indices, vertices.size());
+    std::vector<Vertex> reordered_vertices(vertices.size());
+    for (size_t v = 0; v < vertices.size(); v++) reordered_vertices[remap[v]] = vertices[v];
+    vertices.swap(reordered_vertices);
+    for (uint32_t &index : indices) index = remap[index];
+
+    stats.acmr_after = computeACMR(indices, vertices.size());
+    stats.atvr_after = computeATVR(indices, vertices.size());
+
+    return stats;
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexCache(const std::vector<uint32_t> &indices,
+  size_t vertex_count,
+  std::vector<uint32_t> &cluster_starts) const
+{
+    const size_t triangle_count = indices.size() / 3;
+
+    // vertex -> triangle adjacency in CSR layout
+    std::vector<uint32_t> live_triangles(vertex_count, 0);
+    for (size_t i = 0; i < triangle_count * 3; i++) live_triangles[indices[i]]++;
+
+    std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++) adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangles[v];
+
+    std::vector<uint32_t> adjacency(triangle_count * 3);
+    std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+    for (size_t i = 0; i < triangle_count * 3; i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<uint32_t> cache_timestamps(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> dead_end_stack;
+    std::vector<uint32_t> candidates;
+
+    std::vector<uint32_t> triangle_order;
+    triangle_order.reserve(triangle_count);
+    // cache misses of every emitted triangle and the positions where the cache was flushed
+    std::vector<uint8_t> triangle_misses;
+    triangle_misses.reserve(triangle_count);
+    std::vector<uint32_t> flush_starts;
+
+    uint32_t timestamp = cache_size + 1;
+    size_t cursor = 0;
+
+    // start fanning around the first referenced vertex
+    int64_t fanning_vertex = -1;
+    while (cursor < vertex_count && live_triangles[cursor] == 0) cursor++;
+    if (cursor < vertex_count) fanning_vertex = static_cast<int64_t>(cursor);
+    bool cache_flushed = true;
+
+    while (fanning_vertex >= 0) {
+        const uint32_t f = static_cast<uint32_t>(fanning_vertex);
+        candidates.clear();
+
+        for (uint32_t a = adjacency_offsets[f]; a < adjacency_offsets[f + 1]; a++) {
+            const uint32_t triangle = adjacency[a];
+            if (emitted[triangle]) continue;
+
+            if (cache_flushed) {
+                flush_starts.push_back(static_cast<uint32_t>(triangle_order.size()));
+                cache_flushed = false;
+            }
+
+            triangle_order.push_back(triangle);
+            emitted[triangle] = true;
+
+            uint8_t misses = 0;
+            for (uint32_t c = 0; c < 3; c++) {
+                const uint32_t v = indices[triangle * 3 + c];
+                dead_end_stack.push_back(v);
+                candidates.push_back(v);
+                live_triangles[v]--;
+                if (timestamp - cache_timestamps[v] > cache_size) {
+                    cache_timestamps[v] = timestamp++;
+                    misses++;
+                }
+            }
+            triangle_misses.push_back(misses);
+        }
+
+        // pick the candidate that is still in the cache and will stay there the longest
+        fanning_vertex = -1;
+        int64_t best_priority = -1;
+        for (uint32_t v : candidates) {
+            if (live_triangles[v] == 0) continue;
+            int64_t priority = 0;
+            if (timestamp - cache_timestamps[v] + 2 * live_triangles[v] <= cache_size)
+                priority = timestamp - cache_timestamps[v];
+            if (priority > best_priority) {
+                best_priority = priority;
+                fanning_vertex = v;
+            }
+        }
+
+        if (fanning_vertex < 0) {
+            // dead end: walk back through recently used vertices, then scan linearly
+            while (!dead_end_stack.empty()) {
+                const uint32_t v = dead_end_stack.back();
+                dead_end_stack.pop_back();
+                if (live_triangles[v] > 0) {
+                    fanning_vertex = v;
+                    break;
+                }
+            }
+
+            if (fanning_vertex < 0) {
+                while (cursor < vertex_count && live_triangles[cursor] == 0) cursor++;
+                if (cursor < vertex_count) fanning_vertex = static_cast<int64_t>(cursor);
+                cache_flushed = true;
+            }
+        }
+    }
+
+    // a connected mesh flushes the cache only once, so the stretches between flushes are split
+    // further (Sander et al. 2007, section 4.1): a cluster ends as soon as its running ACMR is
+    // within cluster_threshold of the ACMR of the whole stretch. Clusters are drawn in any order
+    // afterwards, so their misses are counted from a cold cache
+    cluster_starts.clear();
+    std::fill(cache_timestamps.begin(), cache_timestamps.end(), 0);
+    timestamp = cache_size + 1;
+    for (size_t s = 0; s < flush_starts.size(); s++) {
+        const size_t begin = flush_starts[s];
+        const size_t end = s + 1 < flush_starts.size() ? flush_starts[s + 1] : triangle_order.size();
+
+        size_t stretch_misses = 0;
+        for (size_t t = begin; t < end; t++) stretch_misses += triangle_misses[t];
+        const float split_acmr =
+          cluster_threshold * static_cast<float>(stretch_misses) / static_cast<float>(end - begin);
+
+        cluster_starts.push_back(static_cast<uint32_t>(begin));
+        timestamp += cache_size + 1;
+        size_t cluster_misses = 0;
+        size_t cluster_triangles = 0;
+        for (size_t t = begin; t + 1 < end; t++) {
+            for (uint32_t c = 0; c < 3; c++) {
+                const uint32_t v = indices[triangle_order[t] * 3 + c];
+                if (timestamp - cache_timestamps[v] > cache_size) {
+                    cache_timestamps[v] = timestamp++;
+                    cluster_misses++;
+                }
+            }
+            cluster_triangles++;
+
+            const float cluster_acmr = static_cast<float>(cluster_misses) / static_cast<float>(cluster_triangles);
+            if (cluster_acmr <= split_acmr) {
+                cluster_starts.push_back(static_cast<uint32_t>(t + 1));
+                timestamp += cache_size + 1;
+                cluster_misses = 0;
+                cluster_triangles = 0;
+            }
+        }
+    }
+
+    return triangle_order;
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeOverdraw(const std::vector<Vertex> &vertices,
+  const std::vector<uint32_t> &indices,
+  const std::vector<uint32_t> &triangle_order,
+  const std::vector<uint32_t> &cluster_starts) const
+{
+    if (cluster_starts.size() <= 1) return triangle_order;
+
+    glm::vec3 mesh_centroid(0.f);
+    for (const Vertex &vertex : vertices) mesh_centroid += vertex.pos;
+    mesh_centroid /= static_cast<float>(std::max<size_t>(1, vertices.size()));
+
+    // clusters facing away from the mesh center occlude others from most view
+    // points, so they are drawn first (Sander et al. 2007, section 4)
+    const size_t cluster_count = cluster_starts.size();
+    std::vector<float> sort_keys(cluster_count, 0.f);
+    for (size_t c = 0; c < cluster_count; c++) {
+        const size_t begin = cluster_starts[c];
+        const size_t end = c + 1 < cluster_count ? cluster_starts[c + 1] : triangle_order.size();
+
+        glm::vec3 centroid(0.f);
+        glm::vec3 normal(0.f);
+        float area = 0.f;
+        for (size_t t = begin; t < end; t++) {
+            const uint32_t triangle = triangle_order[t];
+            const glm::vec3 &p0 = vertices[indices[triangle * 3 + 0]].pos;
+            const glm::vec3 &p1 = vertices[indices[triangle * 3 + 1]].pos;
+            const glm::vec3 &p2 = vertices[indices[triangle * 3 + 2]].pos;
+
+            // length of the cross product is twice the triangle area
+            const glm::vec3 weighted_normal = glm::cross(p1 - p0, p2 - p0);
+            const float triangle_area = glm::length(weighted_normal);
+            centroid += (p0 + p1 + p2) * (triangle_area / 3.f);
+            normal += weighted_normal;
+            area += triangle_area;
+        }
+
+        const float normal_length = glm::length(normal);
+        if (area > 0.f && normal_length > 0.f) {
+            centroid /= area;
+            sort_keys[c] = glm::dot(centroid - mesh_centroid, normal / normal_length);
+        }
+    }
+
+    std::vector<uint32_t> cluster_order(cluster_count);
+    std::iota(cluster_order.begin(), cluster_order.end(), 0);
+    std::stable_sort(cluster_order.begin(), cluster_order.end(), [&](uint32_t a, uint32_t b) {
+        return sort_keys[a] > sort_keys[b];
+    });
+
+    std::vector<uint32_t> reordered;
+    reordered.reserve(triangle_order.size());
+    for (uint32_t c : cluster_order) {
+        const size_t begin = cluster_starts[c];
+        const size_t end = c + 1 < cluster_count ? cluster_starts[c + 1] : triangle_order.size();
+        reordered.insert(reordered.end(), triangle_order.begin() + begin, triangle_order.begin() + end);
+    }
+
+    return reordered;
+}
+
+std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(const std::vector<uint32_t> &indices,
+  size_t vertex_count) const
+{
+    const uint32_t unassigned = static_cast<uint32_t>(-1);
+    std::vector<uint32_t> remap(vertex_count, unassigned);
+
+    uint32_t next_vertex = 0;
+    for (uint32_t index : indices) {
+        if (remap[index] == unassigned) remap[index] = next_vertex++;
+    }
+
+    // unreferenced vertices are kept at the end
+    for (uint32_t &new_index : remap) {
+        if (new_index == unassigned) new_index = next_vertex++;
+    }
+
+    return remap;
+}
+
+float MeshOptimizer::computeACMR(const std::vector<uint32_t> &indices, size_t vertex_count) const
+{
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) return 0.f;
+    return static_cast<float>(simulateFifoCache(indices, vertex_count)) / static_cast<float>(triangle_count);
+}
+
+float MeshOptimizer::computeATVR(const std::vector<uint32_t> &indices, size_t vertex_count) const
+{
+    std::vector<bool> referenced(vertex_count, false);
+    size_t referenced_count = 0;
+    for (uint32_t index : indices) {
+        if (!referenced[index]) {
+            referenced[index] = true;
+            referenced_count++;
+        }
+    }
+    if (referenced_count == 0) return 0.f;
+    return static_cast<float>(simulateFifoCache(indices, vertex_count)) / static_cast<float>(referenced_count);
+}
+
+size_t MeshOptimizer::simulateFifoCache(const std::vector<uint32_t> &indices, size_t vertex_count) const
+{
+    // a vertex is in the FIFO cache if it was inserted within the last cache_size misses
+    std::vector<size_t> insertion_time(vertex_count, 0);
+    size_t misses = 0;
+    for (uint32_t index : indices) {
+        if (insertion_time[index] == 0 || misses - insertion_time[index] >= cache_size) {
+            misses++;
+            insertion_time[index] = misses;
+        }
+    }
+    return misses;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "scene/Submesh.hpp"
+#include "scene/Vertex.hpp"
+
+namespace Kataglyphis {
+
+struct MeshOptimizationStats
+{
+    // average cache miss ratio: transformed vertices per triangle (0.5 is optimal for large grids)
+    float acmr_before{ 0.f };
+    float acmr_after{ 0.f };
+    // average transform to vertex ratio: transformed vertices per unique vertex (1.0 is optimal)
+    float atvr_before{ 0.f };
+    float atvr_after{ 0.f };
+};
+
+// Reorders an indexed triangle list for the GPU:
+// 1.) triangles for post-transform vertex cache locality (Tipsify, Sander et al. 2007)
+// 2.) the resulting cache clusters front-to-back in a view independent way against overdraw
+// 3.) vertices in order of first use for vertex fetch locality
+// Per-triangle data (the material index) is permuted along with the triangles.
+// Given submeshes, triangles are only reordered within them, so their ranges stay valid.
+class MeshOptimizer
+{
+  public:
+    // cluster_threshold is the lambda of Tipsify's overdraw clustering: a cluster ends once its ACMR
+    // drops to this factor of the ACMR between two cache flushes. Lower values give fewer and
+    // larger clusters, which keeps more of the cache locality but sorts coarser against overdraw
+    explicit MeshOptimizer(uint32_t cache_size = 16, float cluster_threshold = 1.05f);
+
+    MeshOptimizationStats optimize(std::vector<Vertex> &vertices,
+      std::vector<uint32_t> &indices,
+      std::vector<unsigned int> &materialIndex,
+      std::span<const Submesh> submeshes = {}) const;
+
+    // returns the new triangle order; cluster_starts receives the first triangle
+    // (in the new order) of every cluster: where the cache was flushed and where the
+    // running ACMR of a cluster reached the cluster threshold
+    std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t> &indices,
+      size_t vertex_count,
+      std::vector<uint32_t> &cluster_starts) const;
+
+    std::vector<uint32_t> optimizeOverdraw(const std::vector<Vertex> &vertices,
+      const std::vector<uint32_t> &indices,
+      const std::vector<uint32_t> &triangle_order,
+      const std::vector<uint32_t> &cluster_starts) const;
+
+    // returns old vertex index -> new vertex index
+    std::vector<uint32_t> optimizeVertexFetch(const std::vector<uint32_t> &indices, size_t vertex_count) const;
+
+    float computeACMR(const std::vector<uint32_t> &indices, size_t vertex_count) const;
+    float computeATVR(const std::vector<uint32_t> &indices, size_t vertex_count) const;
+
+  private:
+    uint32_t cache_size{ 16 };
+    float cluster_threshold{ 1.05f };
+
+    size_t simulateFifoCache(const std::vector<uint32_t> &indices, size_t vertex_count) const;
+};
+
+}// namespace Kataglyphis
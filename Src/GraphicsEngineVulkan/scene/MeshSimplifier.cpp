@@ -0,0 +1,444 @@
+#include "scene/MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+#include "util/Hash.hpp"
+
+using namespace Kataglyphis;
+
+namespace {
+
+// boundary edges are held in place by planes perpendicular to their triangle
+constexpr double boundary_weight = 10.0;
+
+// symmetric 4x4 matrix of accumulated plane equations (upper triangle);
+// weight is the accumulated triangle area and normalizes the error to a squared distance
+struct Quadric
+{
+    double a00{ 0 }, a01{ 0 }, a02{ 0 }, a03{ 0 };
+    double a11{ 0 }, a12{ 0 }, a13{ 0 };
+    double a22{ 0 }, a23{ 0 };
+    double a33{ 0 };
+    double weight{ 0 };
+
+    void addPlane(double a, double b, double c, double d, double w)
+    {
+        a00 += w * a * a;
+        a01 += w * a * b;
+        a02 += w * a * c;
+        a03 += w * a * d;
+        a11 += w * b * b;
+        a12 += w * b * c;
+        a13 += w * b * d;
+        a22 += w * c * c;
+        a23 += w * c * d;
+        a33 += w * d * d;
+    }
+
+    void add(const Quadric &other)
+    {
+        a00 += other.a00;
+        a01 += other.a01;
+        a02 += other.a02;
+        a03 += other.a03;
+        a11 += other.a11;
+        a12 += other.a12;
+        a13 += other.a13;
+        a22 += other.a22;
+        a23 += other.a23;
+        a33 += other.a33;
+        weight += other.weight;
+    }
+
+    double evaluate(const glm::vec3 &p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        const double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x + a11 * y * y
+                             + 2 * a12 * y * z + 2 * a13 * y + a22 * z * z + 2 * a23 * z + a33;
+        return std::max(error, 0.0);
+    }
+};
+
+struct PositionKey
+{
+    std::array<uint32_t, 3> bits;
+    bool operator==(const PositionKey &other) const { return bits == other.bits; }
+};
+
+struct PositionKeyHash
+{
+    size_t operator()(const PositionKey &key) const
+    {
+        return static_cast<size_t>(hashBytes(key.bits.data(), sizeof(key.bits)));
+    }
+};
+
+PositionKey makePositionKey(const glm::vec3 &p)
+{
+    // fold -0 into +0 so both land on the same position
+    PositionKey key{};
+    const float components[3] = { p.x + 0.f, p.y + 0.f, p.z + 0.f };
+    std::memcpy(key.bits.data(), components, sizeof(components));
+    return key;
+}
+
+// state of a progressive simplification; levels are taken as snapshots while collapsing further
+class QuadricCollapser
+{
+  public:
+    QuadricCollapser(std::span<const Vertex> vertices, std::span<const uint32_t> indices, float max_error);
+
+    // collapses until at most target_triangle_count triangles are alive; returns the error so far
+    float collapse(size_t target_triangle_count);
+    size_t getTriangleCount() const { return alive_triangle_count; };
+    void emit(std::vector<uint32_t> &indices, std::vector<uint32_t> &triangle_ids) const;
+
+  private:
+    struct Candidate
+    {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t from_version;
+        uint32_t to_version;
+
+        bool operator>(const Candidate &other) const { return cost > other.cost; }
+    };
+
+    double max_error_squared;
+    float error{ 0.f };
+
+    std::vector<uint32_t> corners;// render vertex per triangle corner
+    std::vector<uint8_t> triangle_alive;
+    size_t alive_triangle_count{ 0 };
+
+    std::vector<uint32_t> position_of;// render vertex -> position
+    std::vector<glm::vec3> positions;
+    std::vector<Quadric> quadrics;
+    std::vector<uint32_t> versions;
+    std::vector<uint8_t> position_alive;
+    std::vector<std::vector<uint32_t>> position_triangles;
+    // render vertices of every position
+    std::vector<uint32_t> render_offsets;
+    std::vector<uint32_t> render_vertices;
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+
+    void pushEdge(uint32_t a, uint32_t b);
+    bool collapseEdge(uint32_t from, uint32_t to);
+    glm::vec3 triangleNormal(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2) const
+    {
+        return glm::cross(p1 - p0, p2 - p0);
+    };
+};
+
+QuadricCollapser::QuadricCollapser(std::span<const Vertex> vertices, std::span<const uint32_t> indices, float max_error)
+{
+    max_error_squared = static_cast<double>(max_error) * static_cast<double>(max_error);
+
+    const size_t triangle_count = indices.size() / 3;
+    corners.assign(indices.begin(), indices.begin() + triangle_count * 3);
+    triangle_alive.assign(triangle_count, 1);
+    alive_triangle_count = triangle_count;
+
+    // positions shared by several render vertices (normal/uv seams) collapse as one
+    std::unordered_map<PositionKey, uint32_t, PositionKeyHash> position_ids;
+    position_ids.reserve(vertices.size());
+    position_of.resize(vertices.size());
+    for (size_t v = 0; v < vertices.size(); v++) {
+        auto [it, inserted] =
+          position_ids.try_emplace(makePositionKey(vertices[v].pos), static_cast<uint32_t>(positions.size()));
+        if (inserted) positions.push_back(vertices[v].pos);
+        position_of[v] = it->second;
+    }
+
+    const size_t position_count = positions.size();
+    quadrics.resize(position_count);
+    versions.assign(position_count, 0);
+    position_alive.assign(position_count, 1);
+    position_triangles.resize(position_count);
+
+    render_offsets.assign(position_count + 1, 0);
+    for (size_t v = 0; v < vertices.size(); v++) render_offsets[position_of[v] + 1]++;
+    for (size_t p = 0; p < position_count; p++) render_offsets[p + 1] += render_offsets[p];
+    render_vertices.resize(vertices.size());
+    std::vector<uint32_t> fill(render_offsets.begin(), render_offsets.end() - 1);
+    for (size_t v = 0; v < vertices.size(); v++) render_vertices[fill[position_of[v]]++] = static_cast<uint32_t>(v);
+
+    // position edges with the triangle they came from, to find boundaries
+    std::vector<std::pair<uint64_t, uint32_t>> edges;
+    edges.reserve(triangle_count * 3);
+
+    for (uint32_t t = 0; t < triangle_count; t++) {
+        const uint32_t p[3] = {
+            position_of[corners[t * 3 + 0]], position_of[corners[t * 3 + 1]], position_of[corners[t * 3 + 2]]
+        };
+        for (int i = 0; i < 3; i++) {
+            if (i > 0 && p[i] == p[0]) continue;
+            if (i > 1 && p[i] == p[1]) continue;
+            position_triangles[p[i]].push_back(t);
+        }
+
+        glm::vec3 normal = triangleNormal(positions[p[0]], positions[p[1]], positions[p[2]]);
+        const float length = std::sqrt(glm::dot(normal, normal));
+        if (length > 0.f) {
+            normal /= length;
+            const double d = -glm::dot(normal, positions[p[0]]);
+            const double area = 0.5 * length;
+            for (uint32_t position : p) {
+                quadrics[position].addPlane(normal.x, normal.y, normal.z, d, area);
+                quadrics[position].weight += area;
+            }
+        }
+
+        for (int i = 0; i < 3; i++) {
+            const uint32_t a = p[i];
+            const uint32_t b = p[(i + 1) % 3];
+            if (a == b) continue;
+            edges.emplace_back((static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b), t);
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+    for (size_t begin = 0; begin < edges.size();) {
+        size_t end = begin + 1;
+        while (end < edges.size() && edges[end].first == edges[begin].first) end++;
+
+        const uint32_t a = static_cast<uint32_t>(edges[begin].first >> 32);
+        const uint32_t b = static_cast<uint32_t>(edges[begin].first & 0xffffffffu);
+
+        if (end - begin == 1) {
+            const uint32_t t = edges[begin].second;
+            const glm::vec3 face_normal = triangleNormal(positions[position_of[corners[t * 3 + 0]]],
+              positions[position_of[corners[t * 3 + 1]]],
+              positions[position_of[corners[t * 3 + 2]]]);
+            const glm::vec3 edge = positions[b] - positions[a];
+            glm::vec3 normal = glm::cross(edge, face_normal);
+            const float length = std::sqrt(glm::dot(normal, normal));
+            if (length > 0.f) {
+                normal /= length;
+                const double d = -glm::dot(normal, positions[a]);
+                const double w = boundary_weight * glm::dot(edge, edge);
+                quadrics[a].addPlane(normal.x, normal.y, normal.z, d, w);
+                quadrics[b].addPlane(normal.x, normal.y, normal.z, d, w);
+            }
+        }
+        begin = end;
+    }
+
+    for (size_t begin = 0; begin < edges.size();) {
+        size_t end = begin + 1;
+        while (end < edges.size() && edges[end].first == edges[begin].first) end++;
+        pushEdge(static_cast<uint32_t>(edges[begin].first >> 32),
+          static_cast<uint32_t>(edges[begin].first & 0xffffffffu));
+        begin = end;
+    }
+}
+
+void QuadricCollapser::pushEdge(uint32_t a, uint32_t b)
+{
+    Quadric q = quadrics[a];
+    q.add(quadrics[b]);
+    const double weight = q.weight > 0.0 ? q.weight : 1.0;
+
+    // a half edge collapse keeps one of the two positions; take the cheaper direction
+    const double cost_a_to_b = q.evaluate(positions[b]) / weight;
+    const double cost_b_to_a = q.evaluate(positions[a]) / weight;
+    if (cost_a_to_b <= cost_b_to_a) {
+        candidates.push(Candidate{ cost_a_to_b, a, b, versions[a], versions[b] });
+    } else {
+        candidates.push(Candidate{ cost_b_to_a, b, a, versions[b], versions[a] });
+    }
+}
+
+float QuadricCollapser::collapse(size_t target_triangle_count)
+{
+    while (alive_triangle_count > target_triangle_count && !candidates.empty()) {
+        const Candidate candidate = candidates.top();
+        if (candidate.cost > max_error_squared) break;
+        candidates.pop();
+
+        if (!position_alive[candidate.from] || !position_alive[candidate.to]) continue;
+        if (versions[candidate.from] != candidate.from_version || versions[candidate.to] != candidate.to_version) {
+            continue;
+        }
+
+        if (collapseEdge(candidate.from, candidate.to)) {
+            error = std::max(error, static_cast<float>(std::sqrt(candidate.cost)));
+        }
+    }
+    return error;
+}
+
+bool QuadricCollapser::collapseEdge(uint32_t from, uint32_t to)
+{
+    const glm::vec3 &target = positions[to];
+
+    // reject collapses flipping any of the remaining triangles
+    for (uint32_t t : position_triangles[from]) {
+        if (!triangle_alive[t]) continue;
+        glm::vec3 before[3];
+        glm::vec3 after[3];
+        bool shares_edge = false;
+        for (int i = 0; i < 3; i++) {
+            const uint32_t p = position_of[corners[t * 3 + i]];
+            shares_edge |= p == to;
+            before[i] = positions[p];
+            after[i] = p == from ? target : before[i];
+        }
+        if (shares_edge) continue;
+
+        const glm::vec3 normal_before = triangleNormal(before[0], before[1], before[2]);
+        const glm::vec3 normal_after = triangleNormal(after[0], after[1], after[2]);
+        if (glm::dot(normal_before, normal_after) <= 0.f) return false;
+    }
+
+    // every render vertex of the removed position moves onto a render vertex of the kept position;
+    // prefer one it already shares a triangle with so attributes stay continuous across the collapse
+    std::vector<std::pair<uint32_t, uint32_t>> remap;
+    for (uint32_t i = render_offsets[from]; i < render_offsets[from + 1]; i++) {
+        const uint32_t render_vertex = render_vertices[i];
+        uint32_t replacement = render_vertices[render_offsets[to]];
+        for (uint32_t t : position_triangles[from]) {
+            if (!triangle_alive[t]) continue;
+            const uint32_t *c = &corners[t * 3];
+            if (c[0] != render_vertex && c[1] != render_vertex && c[2] != render_vertex) continue;
+            for (int k = 0; k < 3; k++) {
+                if (position_of[c[k]] == to) replacement = c[k];
+            }
+        }
+        remap.emplace_back(render_vertex, replacement);
+    }
+
+    std::vector<uint32_t> &kept_triangles = position_triangles[to];
+    for (uint32_t t : position_triangles[from]) {
+        if (!triangle_alive[t]) continue;
+        uint32_t *c = &corners[t * 3];
+        bool shares_edge = false;
+        for (int k = 0; k < 3; k++) shares_edge |= position_of[c[k]] == to;
+
+        if (shares_edge) {
+            triangle_alive[t] = 0;
+            alive_triangle_count--;
+            continue;
+        }
+
+        for (int k = 0; k < 3; k++) {
+            if (position_of[c[k]] != from) continue;
+            for (const auto &[render_vertex, replacement] : remap) {
+                if (c[k] == render_vertex) c[k] = replacement;
+            }
+        }
+        kept_triangles.push_back(t);
+    }
+
+    position_alive[from] = 0;
+    position_triangles[from].clear();
+    position_triangles[from].shrink_to_fit();
+    quadrics[to].add(quadrics[from]);
+    versions[to]++;
+
+    kept_triangles.erase(std::remove_if(kept_triangles.begin(),
+                           kept_triangles.end(),
+                           [this](uint32_t t) { return !triangle_alive[t]; }),
+      kept_triangles.end());
+
+    // costs of all edges around the kept position changed
+    std::vector<uint32_t> neighbours;
+    for (uint32_t t : kept_triangles) {
+        for (int k = 0; k < 3; k++) {
+            const uint32_t p = position_of[corners[t * 3 + k]];
+            if (p != to) neighbours.push_back(p);
+        }
+    }
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    for (uint32_t neighbour : neighbours) pushEdge(to, neighbour);
+
+    return true;
+}
+
+void QuadricCollapser::emit(std::vector<uint32_t> &indices, std::vector<uint32_t> &triangle_ids) const
+{
+    indices.clear();
+    triangle_ids.clear();
+    indices.reserve(alive_triangle_count * 3);
+    triangle_ids.reserve(alive_triangle_count);
+    for (uint32_t t = 0; t < static_cast<uint32_t>(triangle_alive.size()); t++) {
+        if (!triangle_alive[t]) continue;
+        indices.insert(indices.end(), { corners[t * 3 + 0], corners[t * 3 + 1], corners[t * 3 + 2] });
+        triangle_ids.push_back(t);
+    }
+}
+
+}// namespace
+
+MeshSimplifier::MeshSimplifier(MeshSimplifierSettings settings) { this->settings = settings; }
+
+std::vector<uint32_t> MeshSimplifier::simplify(std::span<const Vertex> vertices,
+  std::span<const uint32_t> indices,
+  size_t target_index_count,
+  float *result_error,
+  std::vector<uint32_t> *kept_triangles) const
+{
+    QuadricCollapser collapser(vertices, indices, settings.max_error);
+    const float error = collapser.collapse(target_index_count / 3);
+
+    std::vector<uint32_t> simplified;
+    std::vector<uint32_t> triangle_ids;
+    collapser.emit(simplified, triangle_ids);
+
+    if (result_error) *result_error = error;
+    if (kept_triangles) kept_triangles->swap(triangle_ids);
+    return simplified;
+}
+
+std::vector<MeshLod> MeshSimplifier::buildLodChain(std::span<const Vertex> vertices,
+  std::vector<uint32_t> &indices,
+  std::vector<unsigned int> &materialIndex,
+  uint32_t lod_count) const
+{
+    std::vector<MeshLod> lods;
+    lods.push_back(MeshLod{ 0, static_cast<uint32_t>(indices.size()), 0.f });
+
+    const size_t triangle_count = indices.size() / 3;
+    if (lod_count <= 1 || triangle_count <= settings.min_triangle_count) return lods;
+
+    const bool per_triangle_materials = materialIndex.size() == triangle_count;
+
+    // one progressive run; every level is a snapshot on the way down
+    QuadricCollapser collapser(vertices, indices, settings.max_error);
+    std::vector<uint32_t> level_indices;
+    std::vector<uint32_t> triangle_ids;
+    size_t target = triangle_count;
+
+    for (uint32_t level = 1; level < lod_count; level++) {
+        target = static_cast<size_t>(static_cast<float>(target) * settings.reduction);
+        if (target < settings.min_triangle_count) break;
+
+        const float error = collapser.collapse(target);
+
+        // stop once the simplification stalls (error bound, flips or locked topology)
+        const size_t previous_count = lods.back().index_count / 3;
+        if (static_cast<float>(collapser.getTriangleCount()) > 0.9f * static_cast<float>(previous_count)) break;
+
+        collapser.emit(level_indices, triangle_ids);
+        lods.push_back(MeshLod{
+          static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(level_indices.size()), error });
+        indices.insert(indices.end(), level_indices.begin(), level_indices.end());
+
+        if (per_triangle_materials) {
+            for (uint32_t triangle : triangle_ids) {
+                const unsigned int material = materialIndex[triangle];
+                materialIndex.push_back(material);
+            }
+        }
+    }
+
+    return lods;
+}
@@ -0,0 +1,26 @@
+// this little "hack" is needed for using it on the
+// CPU side as well for the GPU side :)
+// inspired by the NVDIDIA tutorial:
+// https://nvpro-samples.github.io/vk_raytracing_tutorial_KHR/
+
+#ifdef __cplusplus
+#pragma once
+#include <glm/glm.hpp>
+// GLSL Type
+using vec2 = glm::vec2;
+using vec3 = glm::vec3;
+using vec4 = glm::vec4;
+using mat4 = glm::mat4;
+using uint = unsigned int;
+#endif
+
+// a small cluster of triangles occupying a contiguous range of the mesh index buffer
+struct Meshlet
+{
+    vec4 bounding_sphere;// xyz: center, w: radius (object space)
+    vec4 cone;// xyz: average normal, w: cutoff; a cutoff of 1 disables backface culling
+    uint index_offset;// first index of the cluster in the index buffer
+    uint index_count;
+    uint vertex_count;// unique vertices referenced by the cluster
+    uint padding;
+};
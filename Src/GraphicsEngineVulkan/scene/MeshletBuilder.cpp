@@ -0,0 +1,118 @@
+#include "scene/MeshletBuilder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Kataglyphis;
+
+MeshletBuilder::MeshletBuilder(MeshletSettings settings) { this->settings = settings; }
+
+std::vector<Meshlet> MeshletBuilder::build(std::span<const Vertex> vertices, std::span<const uint32_t> indices) const
+{
+    std::vector<Meshlet> meshlets;
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) return meshlets;
+
+    meshlets.reserve(triangle_count / settings.max_triangles + 1);
+
+    // stamp of the meshlet a vertex was last added to; saves clearing a set per meshlet
+    std::vector<uint32_t> vertex_stamp(vertices.size(), 0);
+    uint32_t stamp = 1;
+
+    std::vector<uint32_t> unique_vertices;
+    unique_vertices.reserve(settings.max_vertices);
+
+    Meshlet current{};
+    auto flush = [&](size_t end_triangle) {
+        current.index_count = static_cast<uint>(end_triangle * 3) - current.index_offset;
+        current.vertex_count = static_cast<uint>(unique_vertices.size());
+        computeBounds(vertices, indices.subspan(current.index_offset, current.index_count), unique_vertices, current);
+        meshlets.push_back(current);
+
+        current = Meshlet{};
+        current.index_offset = static_cast<uint>(end_triangle * 3);
+        unique_vertices.clear();
+        stamp++;
+    };
+
+    for (size_t t = 0; t < triangle_count; t++) {
+        const uint32_t a = indices[t * 3 + 0];
+        const uint32_t b = indices[t * 3 + 1];
+        const uint32_t c = indices[t * 3 + 2];
+
+        uint32_t new_vertices = 0;
+        if (vertex_stamp[a] != stamp) new_vertices++;
+        if (b != a && vertex_stamp[b] != stamp) new_vertices++;
+        if (c != a && c != b && vertex_stamp[c] != stamp) new_vertices++;
+        const uint32_t triangles_so_far = static_cast<uint32_t>(t) - current.index_offset / 3;
+
+        if (unique_vertices.size() + new_vertices > settings.max_vertices
+            || triangles_so_far >= settings.max_triangles) {
+            flush(t);
+        }
+
+        for (uint32_t v : { a, b, c }) {
+            if (vertex_stamp[v] != stamp) {
+                vertex_stamp[v] = stamp;
+                unique_vertices.push_back(v);
+            }
+        }
+    }
+    flush(triangle_count);
+
+    return meshlets;
+}
+
+void MeshletBuilder::computeBounds(std::span<const Vertex> vertices,
+  std::span<const uint32_t> indices,
+  std::span<const uint32_t> unique_vertices,
+  Meshlet &meshlet) const
+{
+    // sphere around the box center; tight enough for culling and cheap to build
+    glm::vec3 min_pos = vertices[unique_vertices[0]].pos;
+    glm::vec3 max_pos = min_pos;
+    for (uint32_t v : unique_vertices) {
+        min_pos = glm::min(min_pos, vertices[v].pos);
+        max_pos = glm::max(max_pos, vertices[v].pos);
+    }
+    const glm::vec3 center = (min_pos + max_pos) * 0.5f;
+    float radius = 0.f;
+    for (uint32_t v : unique_vertices) {
+        const glm::vec3 d = vertices[v].pos - center;
+        radius = std::max(radius, std::sqrt(glm::dot(d, d)));
+    }
+    meshlet.bounding_sphere = glm::vec4(center, radius);
+
+    // normal cone of the geometric triangle normals (counter clockwise is front facing)
+    std::vector<glm::vec3> normals;
+    normals.reserve(indices.size() / 3);
+    glm::vec3 axis(0.f);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec3 &p0 = vertices[indices[i + 0]].pos;
+        const glm::vec3 &p1 = vertices[indices[i + 1]].pos;
+        const glm::vec3 &p2 = vertices[indices[i + 2]].pos;
+        const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+        const float length = std::sqrt(glm::dot(n, n));
+        if (length <= 0.f) continue;
+        normals.push_back(n / length);
+        axis += normals.back();
+    }
+
+    meshlet.cone = glm::vec4(0.f, 0.f, 0.f, 1.f);
+    const float axis_length = std::sqrt(glm::dot(axis, axis));
+    if (normals.empty() || axis_length <= 0.f) return;
+    axis /= axis_length;
+
+    float min_dot = 1.f;
+    for (const glm::vec3 &n : normals) { min_dot = std::min(min_dot, glm::dot(axis, n)); }
+
+    // a cone wider than ~84 degrees almost never culls anything, keep it disabled
+    if (min_dot <= 0.1f) {
+        meshlet.cone = glm::vec4(axis, 1.f);
+        return;
+    }
+
+    // the cluster is backfacing when dot(center - eye, axis) >= cutoff * |center - eye| + radius,
+    // with cutoff being the sine of the cone's half angle
+    meshlet.cone = glm::vec4(axis, std::sqrt(1.f - min_dot * min_dot));
+}
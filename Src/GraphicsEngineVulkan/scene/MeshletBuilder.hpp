@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "scene/Meshlet.hpp"
+#include "scene/Vertex.hpp"
+
+namespace Kataglyphis {
+
+struct MeshletSettings
+{
+    // 64/124 keeps a cluster's primitive indices within 8 bits and fits common mesh shader limits
+    uint32_t max_vertices{ 64 };
+    uint32_t max_triangles{ 124 };
+};
+
+// Splits an indexed triangle list into meshlets along the existing triangle order.
+// The index buffer is not touched: every meshlet is a contiguous index range, so
+// per-triangle data stays valid and the order from the MeshOptimizer (which is
+// already spatially coherent) determines the cluster shapes.
+class MeshletBuilder
+{
+  public:
+    explicit MeshletBuilder(MeshletSettings settings = MeshletSettings{});
+
+    std::vector<Meshlet> build(std::span<const Vertex> vertices, std::span<const uint32_t> indices) const;
+
+  private:
+    MeshletSettings settings;
+
+    void computeBounds(std::span<const Vertex> vertices,
+      std::span<const uint32_t> indices,
+      std::span<const uint32_t> unique_vertices,
+      Meshlet &meshlet) const;
+};
+
+}// namespace Kataglyphis
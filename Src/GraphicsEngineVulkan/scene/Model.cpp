@@ -3,81 +3,65 @@
 #include "common/Utilities.hpp"
 #include <iostream>
 #include <unordered_map>
+#include <utility>
 
 using namespace Kataglyphis;
 
 Model::Model() {}
 
-Model::Model(VulkanDevice *device) { this->device = device; }
+Model::Model(VulkanDevice *device, TextureCache *texture_cache)
+{
+    this->device = device;
+    this->texture_cache = texture_cache;
+}
 
 void Model::cleanUp()
 {
-    for (Texture texture : modelTextures) { texture.cleanUp(); }
-
-    for (VkSampler texture_sampler : modelTextureSamplers) {
-        vkDestroySampler(device->getLogicalDevice(), texture_sampler, nullptr);
-    }
+    for (uint32_t texture_slot : texture_slots) { texture_cache->release(texture_slot); }
+    texture_slots.clear();
 
-    mesh.cleanUp();
+    for (Mesh &mesh : meshes) { mesh.cleanUp(); }
 }
 
-void Model::add_new_mesh(VulkanDevice *device,
-  VkQueue transfer_queue,
-  VkCommandPool command_pool,
-  std::vector<Vertex> &vertices,
-  std::vector<unsigned int> &indices,
-  std::vector<unsigned int> &materialIndex,
-  std::vector<ObjMaterial> &materials)
+uint32_t Model::add_new_mesh(VulkanDevice *device,
+  VulkanUploader &uploader,
+  GeometryArena &arena,
+  std::span<const Vertex> vertices,
+  std::span<const unsigned int> indices,
+  std::span<const unsigned int> materialIndex,
+  std::span<const ObjMaterial> materials,
+  std::span<const MeshLod> lods,
+  std::span<const Submesh> submeshes,
+  bool compact_vertices)
 {
-    this->mesh = Mesh(device, transfer_queue, command_pool, vertices, indices, materialIndex, materials);
+    meshes.emplace_back(
+      device, uploader, arena, vertices, indices, materialIndex, materials, lods, submeshes, compact_vertices);
+    return static_cast<uint32_t>(meshes.size() - 1);
 }
 
-void Model::set_model(glm::mat4 model) { this->model = model; }
-
-void Model::addTexture(Texture newTexture)
+void Model::addMeshInstance(uint32_t mesh, glm::mat4 transform)
 {
-    modelTextures.push_back(newTexture);
-    addSampler(newTexture);
+    mesh_instances.push_back(MeshInstance{ mesh, transform });
 }
 
-uint32_t Model::getPrimitiveCount()
-{
-    /*uint32_t number_of_indices = 0;
+void Model::setPlacements(std::vector<glm::mat4> placements) { this->placements = std::move(placements); }
 
-      for (Mesh mesh : meshes) {
-
-          number_of_indices += mesh.get_index_count();
+void Model::set_model(glm::mat4 model) { this->model = model; }
 
-      }
+void Model::addTexture(uint32_t texture_slot) { texture_slots.push_back(texture_slot); }
 
-      return number_of_indices / 3;*/
-    return mesh.getIndexCount() / 3;
+uint32_t Model::getPrimitiveCount()
+{
+    uint32_t number_of_indices = 0;
+    for (Mesh &mesh : meshes) { number_of_indices += mesh.getIndexCount(); }
+    return number_of_indices / 3;
 }
 
-Model::~Model() {}
-
-void Model::addSampler(Texture newTexture)
+uint32_t Model::getSubmeshCount()
 {
-    VkSampler newSampler;
-    // sampler create info
-    VkSamplerCreateInfo sampler_create_info{};
-    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    sampler_create_info.magFilter = VK_FILTER_LINEAR;
-    sampler_create_info.minFilter = VK_FILTER_LINEAR;
-    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
-    sampler_create_info.unnormalizedCoordinates = VK_FALSE;
-    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    sampler_create_info.mipLodBias = 0.0f;
-    sampler_create_info.minLod = 0.0f;
-    sampler_create_info.maxLod = newTexture.getMipLevel();
-    sampler_create_info.anisotropyEnable = VK_TRUE;
-    sampler_create_info.maxAnisotropy = 16;// max anisotropy sample level
-
-    VkResult result = vkCreateSampler(device->getLogicalDevice(), &sampler_create_info, nullptr, &newSampler);
-    ASSERT_VULKAN(result, "Failed to create a texture sampler!")
-
-    modelTextureSamplers.push_back(newSampler);
+    uint32_t submesh_count = 0;
+    for (Mesh &mesh : meshes) { submesh_count += static_cast<uint32_t>(mesh.getSubmeshes().size()); }
+    return submesh_count;
 }
+
+Model::~Model() {}
@@ -1,54 +1,77 @@
 #pragma once
 
 #include <memory>
+#include <span>
 #include <vector>
 
 #include "scene/Mesh.hpp"
-#include "scene/Texture.hpp"
+#include "scene/TextureCache.hpp"
 namespace Kataglyphis {
+
+// one placement of a mesh within its model; glTF nodes referencing the same mesh share its geometry
+struct MeshInstance
+{
+    uint32_t mesh{ 0 };
+    // model space transform of the node, applied before the model matrix
+    glm::mat4 transform{ 1.f };
+};
+
 class Model
 {
   public:
     Model();
-    Model(VulkanDevice *device);
+    // texture_cache holds the textures; the model keeps a reference to each one it uses
+    Model(VulkanDevice *device, TextureCache *texture_cache);
 
     void cleanUp();
 
-    void add_new_mesh(VulkanDevice *device,
-      VkQueue transfer_queue,
-      VkCommandPool command_pool,
-      std::vector<Vertex> &vertices,
-      std::vector<unsigned int> &indices,
-      std::vector<unsigned int> &materialIndex,
-      std::vector<ObjMaterial> &materials);
-
-    uint32_t getTextureCount() { return static_cast<uint32_t>(modelTextures.size()); };
-    std::vector<Texture> &getTextures() { return modelTextures; }
-    std::vector<VkSampler> &getTextureSamplers() { return modelTextureSamplers; }
+    // returns the index of the new mesh; it is not drawn before an instance of it is added
+    uint32_t add_new_mesh(VulkanDevice *device,
+      VulkanUploader &uploader,
+      GeometryArena &arena,
+      std::span<const Vertex> vertices,
+      std::span<const unsigned int> indices,
+      std::span<const unsigned int> materialIndex,
+      std::span<const ObjMaterial> materials,
+      std::span<const MeshLod> lods = {},
+      std::span<const Submesh> submeshes = {},
+      bool compact_vertices = false);
+    void addMeshInstance(uint32_t mesh, glm::mat4 transform = glm::mat4(1.f));
+    // every placement instances all meshes of the model; set by the scene before it is added
+    void setPlacements(std::vector<glm::mat4> placements);
+
+    uint32_t getTextureCount() { return static_cast<uint32_t>(texture_slots.size()); };
+    // the texture cache slots of the model, in the order of its local texture ids
+    const std::vector<uint32_t> &getTextureSlots() { return texture_slots; };
     std::vector<std::string> getTextureList() { return texture_list; };
-    uint32_t getMeshCount() { return 1; };
-    Mesh *getMesh(size_t index) { return &mesh; };
+    uint32_t getMeshCount() { return static_cast<uint32_t>(meshes.size()); };
+    Mesh *getMesh(size_t index) { return &meshes[index]; };
+    const std::vector<MeshInstance> &getMeshInstances() { return mesh_instances; };
+    const std::vector<glm::mat4> &getPlacements() { return placements; };
+    // draw ranges of the model: every submesh of every mesh, each with its own bounds
+    uint32_t getSubmeshCount();
     glm::mat4 getModel() { return model; };
     uint32_t getCustomInstanceIndex() { return mesh_model_index; };
     uint32_t getPrimitiveCount();
-    ObjectDescription getObjectDescription() { return mesh.getObjectDescription(); };
 
     void set_model(glm::mat4 model);
-    void addTexture(Texture newTexture);
+    // takes over a reference to the slot, released again in cleanUp()
+    void addTexture(uint32_t texture_slot);
 
     ~Model();
 
   private:
     VulkanDevice *device{ VK_NULL_HANDLE };
-
-    void addSampler(Texture newTexture);
+    TextureCache *texture_cache{ nullptr };
 
     uint32_t mesh_model_index{ static_cast<uint32_t>(-1) };
-    Mesh mesh;
+    std::vector<Mesh> meshes;
+    std::vector<MeshInstance> mesh_instances;
+    // between the model matrix and the node transforms
+    std::vector<glm::mat4> placements{ glm::mat4(1.f) };
     glm::mat4 model;
 
     std::vector<std::string> texture_list;
-    std::vector<Texture> modelTextures;
-    std::vector<VkSampler> modelTextureSamplers;
+    std::vector<uint32_t> texture_slots;
 };
 }// namespace Kataglyphis
\ No newline at end of file
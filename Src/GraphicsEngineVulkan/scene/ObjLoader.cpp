@@ -2,63 +2,248 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
+#include "scene/MeshCache.hpp"
+#include "scene/MeshOptimizer.hpp"
+#include "scene/MeshSimplifier.hpp"
+#include "scene/SubmeshBuilder.hpp"
+#include "scene/TextureDecoder.hpp"
+#include "scene/VertexWelder.hpp"
+#include "spdlog/spdlog.h"
 #include "util/File.hpp"
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
-#include <unordered_map>
+#include <thread>
 
 using namespace Kataglyphis;
 
-ObjLoader::ObjLoader(VulkanDevice *device, VkQueue transfer_queue, VkCommandPool command_pool)
+ObjLoader::ObjLoader(VulkanDevice *device,
+  VkCommandPool transfer_command_pool,
+  VkCommandPool graphics_command_pool,
+  ObjLoaderSettings settings,
+  TextureStreamer *texture_streamer,
+  GeometryArena *geometry_arena,
+  TextureCache *texture_cache)
 {
     this->device = device;
-    this->transfer_queue = transfer_queue;
-    this->command_pool = command_pool;
+    this->transfer_command_pool = transfer_command_pool;
+    this->graphics_command_pool = graphics_command_pool;
+    this->settings = settings;
+    this->texture_streamer = texture_streamer;
+    this->geometry_arena = geometry_arena;
+    this->texture_cache = texture_cache;
 }
 
 std::shared_ptr<Model> ObjLoader::loadModel(const std::string &modelFile)
 {
     // the model we want to load
-    std::shared_ptr<Model> new_model = std::make_shared<Model>(device);
-
-    // first load txtures from model
-    std::vector<std::string> textureNames = loadTexturesAndMaterials(modelFile);
-    std::vector<int> matToTex(textureNames.size());
-
-    // now that we have the names lets create the vulkan side of textures
-    for (size_t i = 0; i < textureNames.size(); i++) {
-        // If material had no texture, set '0' to indicate no texture, texture 0
-        // will be reserved for a default texture
-        if (!textureNames[i].empty()) {
-            // Otherwise, create texture and set value to index of new texture
-            Texture texture;
-            texture.createFromFile(device, command_pool, textureNames[i]);
-            new_model->addTexture(texture);
-            matToTex[i] = new_model->getTextureCount();
-
-        } else {
-            matToTex[i] = 0;
-        }
+    std::shared_ptr<Model> new_model = std::make_shared<Model>(device, texture_cache);
+
+    // all buffers and images of the model go out in a few large submissions
+    VulkanUploader uploader;
+    uploader.create(device, transfer_command_pool, graphics_command_pool);
+
+    // warm start: the processed model is mapped and uploaded without any parsing
+    MeshCache cache(modelFile, cacheVersion());
+    if (cache.load()) {
+        const std::vector<ObjMaterial> slot_materials = createTextures(new_model,
+          uploader,
+          cache.getTextures(),
+          cache.getVertices(),
+          cache.getIndices(),
+          cache.getMaterialIndex(),
+          cache.getMaterials(),
+          cache.getLods());
+        new_model->add_new_mesh(device,
+          uploader,
+          *geometry_arena,
+          cache.getVertices(),
+          cache.getIndices(),
+          cache.getMaterialIndex(),
+          slot_materials,
+          cache.getLods(),
+          cache.getSubmeshes(),
+          settings.compact_vertices);
+    } else {
+        std::vector<std::string> textureNames;
+        if (!processModel(modelFile, cache, textureNames)) exit(EXIT_FAILURE);
+
+        const std::vector<ObjMaterial> slot_materials =
+          createTextures(new_model, uploader, textureNames, vertices, indices, materialIndex, this->materials, lods);
+        new_model->add_new_mesh(device,
+          uploader,
+          *geometry_arena,
+          vertices,
+          indices,
+          materialIndex,
+          slot_materials,
+          lods,
+          submeshes,
+          settings.compact_vertices);
     }
+    // an OBJ file is a single mesh placed once
+    new_model->addMeshInstance(0);
 
-    loadVertices(modelFile);
-
-    new_model->add_new_mesh(device, transfer_queue, command_pool, vertices, indices, materialIndex, this->materials);
+    uploader.finish();
+    spdlog::info("Uploaded {}: {:.1f} MiB in {} submissions",
+      modelFile,
+      static_cast<double>(uploader.getUploadedBytes()) / (1024.0 * 1024.0),
+      uploader.getSubmitCount());
+    uploader.cleanUp();
 
     return new_model;
 }
 
-std::vector<std::string> ObjLoader::loadTexturesAndMaterials(const std::string &modelFile)
+MeshCacheState ObjLoader::bakeMeshCache(const std::string &modelFile)
 {
+    MeshCache cache(modelFile, cacheVersion());
+    if (cache.load()) return MeshCacheState::UpToDate;
+
+    std::vector<std::string> textureNames;
+    return processModel(modelFile, cache, textureNames) ? MeshCacheState::Rebuilt : MeshCacheState::Failed;
+}
+
+bool ObjLoader::processModel(const std::string &modelFile, MeshCache &cache, std::vector<std::string> &textureNames)
+{
+    // parse the file exactly once; materials and geometry are both taken from this reader
     tinyobj::ObjReaderConfig reader_config;
     tinyobj::ObjReader reader;
 
     if (!reader.ParseFromFile(modelFile, reader_config)) {
         if (!reader.Error().empty()) { std::cerr << "TinyObjReader: " << reader.Error(); }
-        exit(EXIT_FAILURE);
+        return false;
     }
 
     if (!reader.Warning().empty()) { std::cout << "TinyObjReader: " << reader.Warning(); }
 
+    // first load txtures from model
+    textureNames = loadTexturesAndMaterials(modelFile, reader);
+
+    loadVertices(reader);
+
+    // shapes and materials stay apart so each of them can be culled and drawn on its own
+    submeshes.clear();
+    if (settings.split_submeshes) {
+        SubmeshBuilder submeshBuilder;
+        submeshes = submeshBuilder.build(vertices, indices, materialIndex, faceShape);
+        spdlog::info("Split {} into {} submeshes", modelFile, submeshes.size());
+    }
+
+    if (settings.optimize_mesh) {
+        MeshOptimizer optimizer;
+        MeshOptimizationStats stats = optimizer.optimize(vertices, indices, materialIndex, submeshes);
+        spdlog::info("Optimized {}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+          modelFile,
+          stats.acmr_before,
+          stats.acmr_after,
+          stats.atvr_before,
+          stats.atvr_after);
+    }
+
+    // coarser levels are appended behind the optimized full resolution indices
+    MeshSimplifier simplifier;
+    lods = simplifier.buildLodChain(vertices, indices, materialIndex, settings.lod_count);
+    for (size_t i = 1; i < lods.size(); i++) {
+        spdlog::info("LOD {} of {}: {} triangles, error {:.5f}", i, modelFile, lods[i].index_count / 3, lods[i].error);
+    }
+
+    cache.store(vertices, indices, materialIndex, materials, lods, submeshes, textureNames);
+
+    return true;
+}
+
+std::vector<ObjMaterial> ObjLoader::createTextures(std::shared_ptr<Model> &model,
+  VulkanUploader &uploader,
+  const std::vector<std::string> &textureNames,
+  std::span<const Vertex> vertices,
+  std::span<const unsigned int> indices,
+  std::span<const unsigned int> materialIndex,
+  std::span<const ObjMaterial> materials,
+  std::span<const MeshLod> lods)
+{
+    // If material had no texture, set '0' to indicate no texture, texture 0
+    // will be reserved for a default texture
+    std::vector<std::string> files;
+    files.reserve(textureNames.size());
+    for (const std::string &textureName : textureNames) {
+        if (textureName.empty()) continue;
+        // a baked .ktx2 next to the source image already has its mips and is block compressed
+        std::filesystem::path baked(textureName);
+        baked.replace_extension(".ktx2");
+        files.push_back(std::filesystem::exists(baked) ? baked.string() : textureName);
+    }
+
+    // streaming demand comes from where and how densely LOD 0 maps each texture
+    std::vector<TextureFootprint> footprints;
+    if (texture_streamer) {
+        std::vector<int> material_textures(materials.size(), -1);
+        for (size_t material = 0; material < materials.size() && material < textureNames.size(); material++) {
+            if (!textureNames[material].empty()) material_textures[material] = materials[material].textureID;
+        }
+        const size_t lod0_index_count = lods.empty() ? indices.size() : lods[0].index_count;
+        footprints = TextureStreamer::computeFootprints(
+          vertices, indices.first(lod0_index_count), materialIndex, material_textures, files.size());
+    }
+
+    // files already in the scene's texture cache are shared, only the others are decoded
+    std::vector<uint32_t> slots(files.size());
+    std::vector<std::string> missing_files;
+    std::vector<size_t> missing_textures;
+    for (size_t texture = 0; texture < files.size(); texture++) {
+        const std::string key = TextureCache::fileKey(files[texture]);
+        if (!texture_cache->acquire(key, slots[texture])) {
+            slots[texture] = texture_cache->reserve(key);
+            missing_files.push_back(files[texture]);
+            missing_textures.push_back(texture);
+        }
+        model->addTexture(slots[texture]);
+    }
+
+    // decoding runs on worker threads; every image is uploaded as soon as it is done
+    TextureDecoderSettings decoder_settings{};
+    decoder_settings.format_support = TextureFormatSupport::query(device->getPhysicalDevice());
+    // streaming needs every level on the CPU, and transfer queues can't blit them on the GPU
+    decoder_settings.generate_mip_chain = texture_streamer || !uploader.canBlit();
+    TextureDecoder decoder(decoder_settings);
+    decoder.decode(missing_files,
+      [this, &slots, &missing_textures, &model, &footprints, &uploader](size_t file, TextureData &textureData) {
+          const size_t texture = missing_textures[file];
+          Texture created;
+          if (texture_streamer) {
+              created = texture_streamer->addTexture(
+                uploader, slots[texture], std::move(textureData), model.get(), footprints[texture]);
+          } else {
+              created.createFromData(device, uploader, textureData);
+          }
+          texture_cache->setTexture(slots[texture], created);
+      });
+
+    if (texture_streamer) {
+        for (size_t texture = 0, missing = 0; texture < files.size(); texture++) {
+            if (missing < missing_textures.size() && missing_textures[missing] == texture) {
+                missing++;
+            } else {
+                texture_streamer->addUser(slots[texture], model.get(), footprints[texture]);
+            }
+        }
+    }
+    if (missing_files.size() < files.size()) {
+        spdlog::info(
+          "Shared {} of {} textures through the texture cache", files.size() - missing_files.size(), files.size());
+    }
+
+    std::vector<ObjMaterial> slot_materials(materials.begin(), materials.end());
+    for (ObjMaterial &material : slot_materials) {
+        if (material.textureID >= 0 && static_cast<size_t>(material.textureID) < slots.size()) {
+            material.textureID = static_cast<int>(slots[material.textureID]);
+        }
+    }
+    return slot_materials;
+}
+
+std::vector<std::string> ObjLoader::loadTexturesAndMaterials(const std::string &modelFile,
+  const tinyobj::ObjReader &reader)
+{
     auto &tol_materials = reader.GetMaterials();
     textures.reserve(tol_materials.size());
 
@@ -101,92 +286,50 @@ std::vector<std::string> ObjLoader::loadTexturesAndMaterials(const std::string &
     return textures;
 }
 
-void ObjLoader::loadVertices(const std::string &fileName)
+void ObjLoader::loadVertices(const tinyobj::ObjReader &reader)
 {
-    tinyobj::ObjReaderConfig reader_config;
-    // reader_config.mtl_search_path = ""; // Path to material files
-
-    tinyobj::ObjReader reader;
-
-    if (!reader.ParseFromFile(fileName, reader_config)) {
-        if (!reader.Error().empty()) { std::cerr << "TinyObjReader: " << reader.Error(); }
-        exit(EXIT_FAILURE);
-    }
-
-    if (!reader.Warning().empty()) { std::cout << "TinyObjReader: " << reader.Warning(); }
-
     auto &attrib = reader.GetAttrib();
     auto &shapes = reader.GetShapes();
-    auto &materials = reader.GetMaterials();
-
-    std::unordered_map<Vertex, uint32_t> vertices_map{};
-
-    // Loop over shapes
-    for (size_t s = 0; s < shapes.size(); s++) {
-        // prepare for enlargement
-        vertices.reserve(shapes[s].mesh.indices.size() + vertices.size());
-        indices.reserve(shapes[s].mesh.indices.size() + indices.size());
-
-        // Loop over faces(polygon)
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-            size_t fv = size_t(shapes[s].mesh.num_face_vertices[f]);
-
-            // Loop over vertices in the face.
-            for (size_t v = 0; v < fv; v++) {
-                // access to vertex
-                tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-                tinyobj::real_t vx = attrib.vertices[3 * size_t(idx.vertex_index) + 0];
-                tinyobj::real_t vy = attrib.vertices[3 * size_t(idx.vertex_index) + 1];
-                tinyobj::real_t vz = attrib.vertices[3 * size_t(idx.vertex_index) + 2];
-                glm::vec3 pos = { vx, vy, vz };
-
-                glm::vec3 normals(0.0f);
-                // Check if `normal_index` is zero or positive. negative = no normal
-                // data
-                if (idx.normal_index >= 0 && !attrib.normals.empty()) {
-                    tinyobj::real_t nx = attrib.normals[3 * size_t(idx.normal_index) + 0];
-                    tinyobj::real_t ny = attrib.normals[3 * size_t(idx.normal_index) + 1];
-                    tinyobj::real_t nz = attrib.normals[3 * size_t(idx.normal_index) + 2];
-                    normals = glm::vec3(nx, ny, nz);
-                }
-
-                glm::vec3 color(-1.f);
-                if (!attrib.colors.empty()) {
-                    tinyobj::real_t red = attrib.colors[3 * size_t(idx.vertex_index) + 0];
-                    tinyobj::real_t green = attrib.colors[3 * size_t(idx.vertex_index) + 1];
-                    tinyobj::real_t blue = attrib.colors[3 * size_t(idx.vertex_index) + 2];
-                    color = glm::vec3(red, green, blue);
-                }
-
-                glm::vec2 tex_coords(0.0f);
-                // Check if `texcoord_index` is zero or positive. negative = no texcoord
-                // data
-                if (idx.texcoord_index >= 0 && !attrib.texcoords.empty()) {
-                    tinyobj::real_t tx = attrib.texcoords[2 * size_t(idx.texcoord_index) + 0];
-                    // flip y coordinate !!
-                    tinyobj::real_t ty = 1.f - attrib.texcoords[2 * size_t(idx.texcoord_index) + 1];
-                    tex_coords = glm::vec2(tx, ty);
-                }
-
-                Vertex vert{ pos, normals, color, tex_coords };
-
-                if (vertices_map.count(vert) == 0) {
-                    vertices_map[vert] = vertices.size();
-                    vertices.push_back(vert);
-                }
-
-                indices.push_back(vertices_map[vert]);
-            }
 
-            index_offset += fv;
+    size_t face_count = 0;
+    for (const auto &shape : shapes) face_count += shape.mesh.num_face_vertices.size();
 
-            // per-face material; face usually is triangle
-            // matToTex[shapes[s].mesh.material_ids[f]]
-            materialIndex.push_back(shapes[s].mesh.material_ids[f]);
+    size_t thread_count = settings.thread_count;
+    if (thread_count == 0) {
+        // do not bother spawning threads for tiny models
+        const size_t min_faces_per_thread = 4096;
+        thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+        thread_count = std::min(thread_count, face_count / min_faces_per_thread);
+    }
+    thread_count = std::max<size_t>(1, std::min(thread_count, face_count));
+
+    std::vector<FaceRange> ranges = splitIntoFaceRanges(shapes, thread_count);
+
+    size_t corner_count = 0;
+    for (const auto &shape : shapes) corner_count += shape.mesh.indices.size();
+
+    // every worker expands its faces into its own slice of the corner stream
+    std::vector<Vertex> corners(corner_count);
+    materialIndex.resize(face_count);
+    faceShape.resize(face_count);
+
+    if (ranges.size() == 1) {
+        loadFaceRange(attrib, shapes, ranges[0], corners);
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(ranges.size());
+        for (size_t i = 0; i < ranges.size(); i++) {
+            workers.emplace_back(
+              [this, &attrib, &shapes, &ranges, &corners, i]() { loadFaceRange(attrib, shapes, ranges[i], corners); });
         }
+        for (auto &worker : workers) worker.join();
     }
 
+    // the welder keeps the first-occurrence order, so the result matches a
+    // sequential pass over the file
+    VertexWelder welder;
+    welder.weld(corners, vertices, indices);
+
     // precompute normals if no provided
     if (attrib.normals.empty()) {
         for (size_t i = 0; i < indices.size(); i += 3) {
@@ -201,3 +344,116 @@ void ObjLoader::loadVertices(const std::string &fileName)
         }
     }
 }
+
+std::vector<ObjLoader::FaceRange> ObjLoader::splitIntoFaceRanges(const std::vector<tinyobj::shape_t> &shapes,
+  size_t range_count)
+{
+    size_t face_count = 0;
+    for (const auto &shape : shapes) face_count += shape.mesh.num_face_vertices.size();
+
+    const size_t faces_per_range = (face_count + range_count - 1) / std::max<size_t>(1, range_count);
+
+    std::vector<FaceRange> ranges;
+    FaceRange current{};
+    size_t face_offset = 0;
+    size_t corner_offset = 0;
+
+    for (size_t s = 0; s < shapes.size(); s++) {
+        const auto &num_face_vertices = shapes[s].mesh.num_face_vertices;
+        size_t index_offset = 0;
+
+        for (size_t f = 0; f < num_face_vertices.size(); f++) {
+            if (current.face_count == 0) {
+                current.first_shape = s;
+                current.first_face = f;
+                current.first_index = index_offset;
+                current.face_offset = face_offset;
+                current.corner_offset = corner_offset;
+            }
+
+            current.face_count++;
+            index_offset += size_t(num_face_vertices[f]);
+            corner_offset += size_t(num_face_vertices[f]);
+            face_offset++;
+
+            if (current.face_count == faces_per_range) {
+                ranges.push_back(current);
+                current = FaceRange{};
+            }
+        }
+    }
+
+    if (current.face_count > 0 || ranges.empty()) ranges.push_back(current);
+
+    return ranges;
+}
+
+void ObjLoader::loadFaceRange(const tinyobj::attrib_t &attrib,
+  const std::vector<tinyobj::shape_t> &shapes,
+  const FaceRange &range,
+  std::vector<Vertex> &corners)
+{
+    size_t s = range.first_shape;
+    size_t f = range.first_face;
+    size_t index_offset = range.first_index;
+    size_t corner = range.corner_offset;
+
+    // Loop over faces(polygon), possibly crossing shape boundaries
+    for (size_t processed = 0; processed < range.face_count; processed++) {
+        while (f >= shapes[s].mesh.num_face_vertices.size()) {
+            s++;
+            f = 0;
+            index_offset = 0;
+        }
+
+        size_t fv = size_t(shapes[s].mesh.num_face_vertices[f]);
+
+        // Loop over vertices in the face.
+        for (size_t v = 0; v < fv; v++) {
+            // access to vertex
+            tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
+            tinyobj::real_t vx = attrib.vertices[3 * size_t(idx.vertex_index) + 0];
+            tinyobj::real_t vy = attrib.vertices[3 * size_t(idx.vertex_index) + 1];
+            tinyobj::real_t vz = attrib.vertices[3 * size_t(idx.vertex_index) + 2];
+            glm::vec3 pos = { vx, vy, vz };
+
+            glm::vec3 normals(0.0f);
+            // Check if `normal_index` is zero or positive. negative = no normal
+            // data
+            if (idx.normal_index >= 0 && !attrib.normals.empty()) {
+                tinyobj::real_t nx = attrib.normals[3 * size_t(idx.normal_index) + 0];
+                tinyobj::real_t ny = attrib.normals[3 * size_t(idx.normal_index) + 1];
+                tinyobj::real_t nz = attrib.normals[3 * size_t(idx.normal_index) + 2];
+                normals = glm::vec3(nx, ny, nz);
+            }
+
+            glm::vec3 color(-1.f);
+            if (!attrib.colors.empty()) {
+                tinyobj::real_t red = attrib.colors[3 * size_t(idx.vertex_index) + 0];
+                tinyobj::real_t green = attrib.colors[3 * size_t(idx.vertex_index) + 1];
+                tinyobj::real_t blue = attrib.colors[3 * size_t(idx.vertex_index) + 2];
+                color = glm::vec3(red, green, blue);
+            }
+
+            glm::vec2 tex_coords(0.0f);
+            // Check if `texcoord_index` is zero or positive. negative = no texcoord
+            // data
+            if (idx.texcoord_index >= 0 && !attrib.texcoords.empty()) {
+                tinyobj::real_t tx = attrib.texcoords[2 * size_t(idx.texcoord_index) + 0];
+                // flip y coordinate !!
+                tinyobj::real_t ty = 1.f - attrib.texcoords[2 * size_t(idx.texcoord_index) + 1];
+                tex_coords = glm::vec2(tx, ty);
+            }
+
+            corners[corner++] = Vertex{ pos, normals, color, tex_coords };
+        }
+
+        index_offset += fv;
+
+        // per-face material; face usually is triangle
+        materialIndex[range.face_offset + processed] = shapes[s].mesh.material_ids[f];
+        faceShape[range.face_offset + processed] = static_cast<uint32_t>(s);
+
+        f++;
+    }
+}
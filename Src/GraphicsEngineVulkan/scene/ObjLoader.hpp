@@ -1,32 +1,120 @@
 #pragma once
 #include <vulkan/vulkan.h>
 
+#include <algorithm>
 #include <memory>
 
+#include <tiny_obj_loader.h>
+
 #include "Model.hpp"
+#include "scene/MeshCache.hpp"
+#include "scene/MeshLod.hpp"
 #include "scene/ObjMaterial.hpp"
+#include "scene/Submesh.hpp"
+#include "scene/TextureStreamer.hpp"
 #include "scene/Vertex.hpp"
 
 namespace Kataglyphis {
+
+struct ObjLoaderSettings
+{
+    // reorder triangles/vertices for vertex cache, overdraw and fetch locality
+    bool optimize_mesh{ false };
+    // split the mesh into per-shape and per-material submeshes that are drawn and built into the
+    // BLAS one by one; without it the mesh is a single submesh in file order
+    bool split_submeshes{ false };
+    // number of levels of detail including the full resolution mesh
+    uint32_t lod_count{ 1 };
+    // upload vertices in the 16 byte CompactVertex layout; the cache keeps full vertices
+    bool compact_vertices{ false };
+    // threads building the vertices; 0 picks the core count and a single one for small models.
+    // The output does not depend on it
+    uint32_t thread_count{ 0 };
+};
+
+enum class MeshCacheState
+{
+    UpToDate,
+    Rebuilt,
+    Failed
+};
+
 class ObjLoader
 {
   public:
-    ObjLoader(VulkanDevice *device, VkQueue transfer_queue, VkCommandPool command_pool);
+    // uploads run on the transfer queue; graphics_command_pool takes over their ownership
+    ObjLoader(VulkanDevice *device,
+      VkCommandPool transfer_command_pool,
+      VkCommandPool graphics_command_pool,
+      ObjLoaderSettings settings = ObjLoaderSettings{},
+      TextureStreamer *texture_streamer = nullptr,
+      GeometryArena *geometry_arena = nullptr,
+      TextureCache *texture_cache = nullptr);
 
+    // needs a geometry arena for the meshes and a texture cache for their textures
     std::shared_ptr<Model> loadModel(const std::string &modelFile);
+    // processes the model into its mesh cache without touching the GPU (device may be null)
+    MeshCacheState bakeMeshCache(const std::string &modelFile);
+
+    // bump whenever the processed output changes; invalidates all mesh caches
+    static constexpr uint32_t loaderVersion = 4;
+
+    // the cache depends on the loader version and on all settings altering the output
+    uint32_t cacheVersion() const
+    {
+        return (loaderVersion << 16) | (std::min(settings.lod_count, 255u) << 2) | (settings.split_submeshes ? 2u : 0u)
+               | (settings.optimize_mesh ? 1u : 0u);
+    };
 
   private:
     Kataglyphis::VulkanDevice *device;
-    VkQueue transfer_queue;
-    VkCommandPool command_pool;
+    VkCommandPool transfer_command_pool;
+    VkCommandPool graphics_command_pool;
+    ObjLoaderSettings settings;
+    // null uploads every texture fully resident
+    TextureStreamer *texture_streamer;
+    GeometryArena *geometry_arena;
+    TextureCache *texture_cache;
 
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<ObjMaterial> materials;
     std::vector<unsigned int> materialIndex;
+    std::vector<MeshLod> lods;
+    std::vector<Submesh> submeshes;
+    // source shape of every face, until the faces are grouped into submeshes
+    std::vector<uint32_t> faceShape;
     std::vector<std::string> textures;
 
-    std::vector<std::string> loadTexturesAndMaterials(const std::string &modelFile);
-    void loadVertices(const std::string &fileName);
+    // one contiguous range of faces (may span several shapes) processed by a single worker
+    struct FaceRange
+    {
+        size_t first_shape{ 0 };
+        size_t first_face{ 0 };
+        size_t first_index{ 0 };
+        size_t face_count{ 0 };
+        // position of the range in the flattened face/corner streams
+        size_t face_offset{ 0 };
+        size_t corner_offset{ 0 };
+    };
+
+    bool processModel(const std::string &modelFile, MeshCache &cache, std::vector<std::string> &textureNames);
+    // returns the materials with their texture ids turned into texture cache slots
+    std::vector<ObjMaterial> createTextures(std::shared_ptr<Model> &model,
+      VulkanUploader &uploader,
+      const std::vector<std::string> &textureNames,
+      std::span<const Vertex> vertices,
+      std::span<const unsigned int> indices,
+      std::span<const unsigned int> materialIndex,
+      std::span<const ObjMaterial> materials,
+      std::span<const MeshLod> lods);
+    std::vector<std::string> loadTexturesAndMaterials(const std::string &modelFile, const tinyobj::ObjReader &reader);
+    void loadVertices(const tinyobj::ObjReader &reader);
+
+    std::vector<FaceRange> splitIntoFaceRanges(const std::vector<tinyobj::shape_t> &shapes, size_t range_count);
+    void loadFaceRange(const tinyobj::attrib_t &attrib,
+      const std::vector<tinyobj::shape_t> &shapes,
+      const FaceRange &range,
+      std::vector<Vertex> &corners);
 };
 }// namespace Kataglyphis
\ No newline at end of file
@@ -6,6 +6,11 @@
 #ifdef __cplusplus
 #pragma once
 #include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+// GLSL Type
+using vec4 = glm::vec4;
+using uint = unsigned int;
 #endif
 
 struct ObjectDescription
@@ -14,4 +19,14 @@ struct ObjectDescription
     uint64_t index_address;
     uint64_t material_index_address;
     uint64_t material_address;
+    // VERTEX_FORMAT_* of the vertex buffer; compact positions decode as
+    // position_offset + position_scale * snorm (see hostDevice/compact_vertex.hpp)
+    vec4 position_offset;
+    vec4 position_scale;
+    uint vertex_format;
+    uint padding_0;
+    // uint per submesh: its first triangle in the mesh. Every submesh is its own
+    // geometry of the model's BLAS, so a hit is on triangle
+    // first_triangle[gl_GeometryIndexEXT] + gl_PrimitiveID
+    uint64_t submesh_address;
 };
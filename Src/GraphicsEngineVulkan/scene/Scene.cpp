@@ -1,32 +1,157 @@
 #include "scene/Scene.hpp"
 #include "ObjLoader.hpp"
+#include "scene/GltfLoader.hpp"
+#include "scene/SceneFile.hpp"
 #include "common/Utilities.hpp"
+#include "renderer/CommandBufferManager.hpp"
 #include "spdlog/spdlog.h"
 
+#include <filesystem>
+#include <unordered_map>
+#include <utility>
+
 using namespace Kataglyphis;
 
 Scene::Scene() {}
 
 void Scene::update_user_input(Kataglyphis::Frontend::GUI *gui) { guiSceneSharedVars = gui->getGuiSceneSharedVars(); }
 
-void Scene::loadModel(VulkanDevice *device, VkCommandPool commandPool)
+void Scene::loadModel(VulkanDevice *device, VkCommandPool commandPool, VkCommandPool transferCommandPool)
 {
-    ObjLoader obj_loader(device, device->getGraphicsQueue(), commandPool);
-
-    std::string modelFileName = sceneConfig::getModelFile();
-    std::shared_ptr<Model> new_model = obj_loader.loadModel(modelFileName);
+    const std::string scene_file_name = sceneConfig::getSceneFile();
+    SceneFile scene_file;
+    if (!scene_file.load(scene_file_name)) exit(EXIT_FAILURE);
+
+    ObjLoaderSettings loader_settings{};
+    loader_settings.optimize_mesh = sceneConfig::getOptimizeMeshes();
+    loader_settings.split_submeshes = sceneConfig::getSplitSubmeshes();
+    loader_settings.lod_count = sceneConfig::getMeshLodCount();
+    loader_settings.compact_vertices = sceneConfig::getCompactVertices();
+
+    // models share every texture file or embedded image they have in common
+    texture_cache.create(device);
+    TextureStreamer *streamer = nullptr;
+    if (sceneConfig::getTextureStreaming()) {
+        TextureStreamingSettings streaming_settings{};
+        streaming_settings.memory_budget = sceneConfig::getTextureMemoryBudget();
+        texture_streamer.create(device, transferCommandPool, commandPool, streaming_settings, &texture_cache);
+        streamer = &texture_streamer;
+    }
+    GeometryArenaSettings arena_settings{};
+    arena_settings.vertex_bytes = sceneConfig::getGeometryArenaSize();
+    arena_settings.index_bytes = sceneConfig::getGeometryArenaSize();
+    geometry_arena.create(
+      device, loader_settings.compact_vertices ? sizeof(CompactVertex) : sizeof(Vertex), arena_settings);
+
+    const std::vector<SceneFileMesh> &scene_meshes = scene_file.getMeshes();
+    for (uint32_t m = 0; m < static_cast<uint32_t>(scene_meshes.size()); m++) {
+        std::vector<glm::mat4> placements = scene_file.getPlacements(m);
+        if (placements.empty()) {
+            spdlog::warn("{} is never placed and not loaded", scene_meshes[m].name);
+            continue;
+        }
+
+        std::shared_ptr<Model> new_model;
+        if (std::filesystem::path(scene_meshes[m].file).extension() == ".glb") {
+            GltfLoaderSettings gltf_settings{};
+            gltf_settings.compact_vertices = loader_settings.compact_vertices;
+            gltf_settings.split_submeshes = loader_settings.split_submeshes;
+            GltfLoader gltf_loader(
+              device, transferCommandPool, commandPool, gltf_settings, streamer, &geometry_arena, &texture_cache);
+            new_model = gltf_loader.loadModel(scene_meshes[m].file);
+        } else {
+            ObjLoader obj_loader(
+              device, transferCommandPool, commandPool, loader_settings, streamer, &geometry_arena, &texture_cache);
+            new_model = obj_loader.loadModel(scene_meshes[m].file);
+        }
+
+        new_model->setPlacements(std::move(placements));
+        add_model(new_model);
+        update_model_matrix(glm::mat4(1.f), static_cast<int>(getModelCount() - 1));
+    }
 
-    add_model(new_model);
+    if (texture_cache.getSlotCount() > device->getTextureTableSize()) {
+        spdlog::warn("The scene has {} textures, only the first {} are bound!",
+          texture_cache.getSlotCount(),
+          device->getTextureTableSize());
+    }
+    spdlog::info("Scene {}: {} models, {} instances, {} unique textures with {} samplers",
+      scene_file_name,
+      getModelCount(),
+      getInstanceCount(),
+      texture_cache.getSlotCount(),
+      texture_cache.getSamplerCount());
+}
 
-    glm::mat4 modelMatrix = sceneConfig::getModelMatrix();
+bool Scene::defragmentTextureMemory(VulkanDevice *device, VkCommandPool commandPool)
+{
+    // textures only referenced by the streamer (rebuilt or retired ones) stay where they are
+    std::unordered_map<VmaAllocation, Texture *> owners;
+    for (uint32_t slot = 0; slot < texture_cache.getSlotCount(); slot++) {
+        if (!texture_cache.isLive(slot)) continue;
+        Texture &texture = texture_cache.getTexture(slot);
+        owners[texture.getVulkanImage().getAllocation()] = &texture;
+    }
 
-    update_model_matrix(modelMatrix, 0);
+    Kataglyphis::VulkanRendererInternals::CommandBufferManager commandBufferManager;
+    const VmaDefragmentationStats stats = device->getAllocator().defragment(
+      MemoryClass::TEXTURE, [&](std::span<VmaDefragmentationMove> moves) {
+          std::vector<VkImage> old_images;
+          std::vector<VkImageView> old_image_views;
+          VkCommandBuffer command_buffer =
+            commandBufferManager.beginCommandBuffer(device->getLogicalDevice(), commandPool);
+
+          for (VmaDefragmentationMove &move : moves) {
+              auto owner = owners.find(move.srcAllocation);
+              if (owner == owners.end()) {
+                  move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                  continue;
+              }
+
+              VkImage old_image;
+              VkImageView old_image_view;
+              owner->second->relocate(device, move.dstTmpAllocation, command_buffer, old_image, old_image_view);
+              old_images.push_back(old_image);
+              old_image_views.push_back(old_image_view);
+          }
+
+          // waits for the copies; the old memory is released when the pass ends
+          commandBufferManager.endAndSubmitCommandBuffer(
+            device->getLogicalDevice(), commandPool, device->getGraphicsQueue(), command_buffer);
+          for (VkImageView image_view : old_image_views) {
+              vkDestroyImageView(device->getLogicalDevice(), image_view, nullptr);
+          }
+          for (VkImage image : old_images) vkDestroyImage(device->getLogicalDevice(), image, nullptr);
+      });
+
+    spdlog::info("Texture defragmentation moved {} images ({:.1f} MiB), freed {} memory blocks",
+      stats.allocationsMoved,
+      static_cast<float>(stats.bytesMoved) / (1024.f * 1024.f),
+      stats.deviceMemoryBlocksFreed);
+    return stats.allocationsMoved > 0;
 }
 
 void Scene::add_model(std::shared_ptr<Model> model)
 {
+    const uint32_t model_index = getModelCount();
+    const uint32_t first_object_description = getNumberObjectDescriptions();
     model_list.push_back(model);
-    object_descriptions.push_back(model->getObjectDescription());
+
+    // one object description per mesh, however often it is placed
+    for (uint32_t k = 0; k < model->getMeshCount(); k++) {
+        object_descriptions.push_back(model->getMesh(k)->getObjectDescription());
+    }
+    for (const glm::mat4 &placement : model->getPlacements()) {
+        for (const MeshInstance &mesh_instance : model->getMeshInstances()) {
+            instances.push_back(SceneInstance{ model_index,
+              mesh_instance.mesh,
+              first_object_description + mesh_instance.mesh,
+              placement * mesh_instance.transform });
+        }
+    }
+    instance_bounds.resize(instances.size());
+    updateInstanceBounds(model_index);
+    revision++;
 }
 
 void Scene::add_object_description(ObjectDescription object_description)
@@ -39,11 +164,47 @@ void Scene::update_model_matrix(glm::mat4 model_matrix, int model_id)
     if (model_id >= static_cast<int32_t>(getModelCount()) || model_id < 0) { spdlog::error("Wrong model id value!"); }
 
     model_list[model_id]->set_model(model_matrix);
+    updateInstanceBounds(static_cast<uint32_t>(model_id));
+    revision++;
+}
+
+void Scene::getMeshBounds(int model_index, int mesh_index, glm::vec3 &bounds_min, glm::vec3 &bounds_max)
+{
+    const std::vector<Submesh> &submeshes = getSubmeshes(model_index, mesh_index);
+    if (submeshes.empty()) {
+        const glm::vec4 sphere = getMeshBoundingSphere(model_index, mesh_index);
+        bounds_min = glm::vec3(sphere) - glm::vec3(sphere.w);
+        bounds_max = glm::vec3(sphere) + glm::vec3(sphere.w);
+        return;
+    }
+
+    bounds_min = submeshes.front().aabb_min;
+    bounds_max = submeshes.front().aabb_max;
+    for (const Submesh &submesh : submeshes) {
+        bounds_min = glm::min(bounds_min, submesh.aabb_min);
+        bounds_max = glm::max(bounds_max, submesh.aabb_max);
+    }
+}
+
+void Scene::updateInstanceBounds(uint32_t model_index)
+{
+    for (uint32_t i = 0; i < getInstanceCount(); i++) {
+        if (instances[i].model != model_index) continue;
+
+        glm::vec3 bounds_min;
+        glm::vec3 bounds_max;
+        getMeshBounds(instances[i].model, instances[i].mesh, bounds_min, bounds_max);
+        instance_bounds.setTransformed(i, bounds_min, bounds_max, getInstanceTransform(i));
+    }
 }
 
 void Scene::cleanUp()
 {
+    texture_streamer.cleanUp();
+    // models drop their texture references before the cache destroys what is left
     for (std::shared_ptr<Model> model : model_list) { model->cleanUp(); }
+    texture_cache.cleanUp();
+    geometry_arena.cleanUp();
 }
 
 uint32_t Scene::getNumberMeshes()
@@ -15,12 +15,28 @@
 
 #include "Model.hpp"
 #include "gui/GUI.hpp"
+#include "scene/FrustumCuller.hpp"
 #include "scene/GUISceneSharedVars.hpp"
+#include "scene/GeometryArena.hpp"
 #include "scene/Mesh.hpp"
+#include "scene/TextureCache.hpp"
+#include "scene/TextureStreamer.hpp"
 
 #include "SceneConfig.hpp"
 
 namespace Kataglyphis {
+
+// one placement of a mesh in the scene, flattened over all models in (model, placement, node) order
+struct SceneInstance
+{
+    uint32_t model{ 0 };
+    uint32_t mesh{ 0 };
+    // of the mesh; also its bottom level acceleration structure
+    uint32_t object_description{ 0 };
+    // placement of the model times the node transform within it
+    glm::mat4 transform{ 1.f };
+};
+
 class Scene
 {
   public:
@@ -30,34 +46,70 @@ class Scene
     void update_model_matrix(glm::mat4 model_matrix, int model_id);
 
     const GUISceneSharedVars &getGuiSceneSharedVars() { return guiSceneSharedVars; };
+    // changes whenever models or their matrices do; commands recorded for an older revision are stale
+    uint64_t getRevision() { return revision; };
 
-    std::vector<Texture> &getTextures(int model_index) { return model_list[model_index]->getTextures(); };
-    std::vector<VkSampler> &getTextureSampler(int model_index)
-    {
-        return model_list[model_index]->getTextureSamplers();
-    };
-    uint32_t getTextureCount(int model_index) { return model_list[model_index]->getTextureCount(); };
     uint32_t getModelCount() { return static_cast<uint32_t>(model_list.size()); };
     glm::mat4 getModelMatrix(int model_index) { return model_list[model_index]->getModel(); };
     uint32_t getMeshCount(int model_index) { return static_cast<uint32_t>(model_list[model_index]->getMeshCount()); };
-    VkBuffer getVertexBuffer(int model_index, int mesh_index)
+    const GeometryRange &getGeometryRange(int model_index, int mesh_index)
     {
-        return model_list[model_index]->getMesh(mesh_index)->getVertexBuffer();
-    };
-    VkBuffer getIndexBuffer(int model_index, int mesh_index)
-    {
-        return model_list[model_index]->getMesh(mesh_index)->getIndexBuffer();
+        return model_list[model_index]->getMesh(mesh_index)->getGeometryRange();
     };
     uint32_t getIndexCount(int model_index, int mesh_index)
     {
         return model_list[model_index]->getMesh(mesh_index)->getIndexCount();
     };
+    uint32_t getMeshletCount(int model_index, int mesh_index)
+    {
+        return model_list[model_index]->getMesh(mesh_index)->getMeshletCount();
+    };
+    VkDeviceAddress getMeshletBufferAddress(int model_index, int mesh_index)
+    {
+        return model_list[model_index]->getMesh(mesh_index)->getMeshletBufferAddress();
+    };
+    const std::vector<MeshLod> &getMeshLods(int model_index, int mesh_index)
+    {
+        return model_list[model_index]->getMesh(mesh_index)->getLods();
+    };
+    glm::vec4 getMeshBoundingSphere(int model_index, int mesh_index)
+    {
+        return model_list[model_index]->getMesh(mesh_index)->getBoundingSphere();
+    };
+    const std::vector<Submesh> &getSubmeshes(int model_index, int mesh_index)
+    {
+        return model_list[model_index]->getMesh(mesh_index)->getSubmeshes();
+    };
+    // object space box around all submeshes of a mesh
+    void getMeshBounds(int model_index, int mesh_index, glm::vec3 &bounds_min, glm::vec3 &bounds_max);
+    VertexQuantization getVertexQuantization(int model_index, int mesh_index)
+    {
+        return model_list[model_index]->getMesh(mesh_index)->getVertexQuantization();
+    };
+    uint32_t getInstanceCount() { return static_cast<uint32_t>(instances.size()); };
+    const SceneInstance &getInstance(uint32_t instance_index) { return instances[instance_index]; };
+    // world transform of an instance: model matrix times placement and node transform
+    glm::mat4 getInstanceTransform(uint32_t instance_index)
+    {
+        return model_list[instances[instance_index].model]->getModel() * instances[instance_index].transform;
+    };
+    // world space bounds of every instance for culling on the CPU; kept in step with the model matrices
+    const InstanceBounds &getInstanceBounds() { return instance_bounds; };
     uint32_t getNumberObjectDescriptions() { return static_cast<uint32_t>(object_descriptions.size()); };
     uint32_t getNumberMeshes();
     std::vector<ObjectDescription> getObjectDescriptions() { return object_descriptions; };
     std::vector<std::shared_ptr<Model>> const &get_model_list() { return model_list; };
+    // the unique textures of all models; material texture ids are slots of it
+    TextureCache &getTextureCache() { return texture_cache; };
+    TextureStreamer &getTextureStreamer() { return texture_streamer; };
+    GeometryArena &getGeometryArena() { return geometry_arena; };
+
+    // loads every mesh of the scene file once and places it as often as the file instances it
+    void loadModel(VulkanDevice *device, VkCommandPool commandPool, VkCommandPool transferCommandPool);
 
-    void loadModel(VulkanDevice *device, VkCommandPool commandPool);
+    // packs the textures of all models into fewer memory blocks; needs an idle device.
+    // True if images moved, their descriptors have to be rewritten then
+    bool defragmentTextureMemory(VulkanDevice *device, VkCommandPool commandPool);
 
     void add_model(std::shared_ptr<Model> model);
     void add_object_description(ObjectDescription object_description);
@@ -68,7 +120,15 @@ class Scene
   private:
     std::vector<ObjectDescription> object_descriptions;
     std::vector<std::shared_ptr<Model>> model_list;
+    std::vector<SceneInstance> instances;
+    InstanceBounds instance_bounds;
+    TextureCache texture_cache;
+    TextureStreamer texture_streamer;
+    GeometryArena geometry_arena;
 
     GUISceneSharedVars guiSceneSharedVars;
+    uint64_t revision{ 0 };
+
+    void updateInstanceBounds(uint32_t model_index);
 };
 }// namespace Kataglyphis
\ No newline at end of file
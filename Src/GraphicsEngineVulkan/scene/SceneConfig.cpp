@@ -1,78 +1,79 @@
 #include "SceneConfig.hpp"
 #include "renderer/VulkanRendererConfig.hpp"
 
+#include <cstdlib>
 #include <filesystem>
 #include <sstream>
 // #define SULO_MODE 1
 
 namespace sceneConfig {
 
-std::string getModelFile()
+std::string getSceneFile()
 {
-    std::stringstream modelFile;
+    // scenes can be switched without recompiling, e.g. for benchmarks
+    if (const char *scene_file = std::getenv("KATAGLYPHIS_SCENE")) return scene_file;
+
+    std::stringstream sceneFile;
     std::filesystem::path cwd = std::filesystem::current_path();
-    modelFile << cwd.string();
-    modelFile << RELATIVE_RESOURCE_PATH;
+    sceneFile << cwd.string();
+    sceneFile << RELATIVE_RESOURCE_PATH << "Scenes/";
 
 #if NDEBUG
-    modelFile << "Models/crytek-sponza/";
-    modelFile << "sponza_triag.obj";
-
+    sceneFile << "sponza.json";
 #else
 #ifdef SULO_MODE
-    modelFile << "Model/Sulo/WolfStahl/";
-    // modelFile << "Wolf-Stahl.obj";
-    modelFile << "SuloLongDongLampe_v2.obj";
+    sceneFile << "sulo.json";
 #else
-    modelFile << "Models/VikingRoom/";
-    modelFile << "viking_room.obj";
+    sceneFile << "viking_room.json";
 #endif
 #endif
 
-    return modelFile.str();
-    // std::string modelFile =
-    // "Models/crytek-sponza/sponza_triag.obj"; std::string modelFile
-    // = "Models/Dinosaurs/dinosaurs.obj"; std::string modelFile =
-    // "Models/Pillum/PilumPainting_export.obj"; std::string modelFile
-    // = "Models/sibenik/sibenik.obj"; std::string modelFile =
-    // "Models/sportsCar/sportsCar.obj"; std::string modelFile =
-    // "Models/StanfordDragon/dragon.obj"; std::string modelFile =
-    // "Models/CornellBox/CornellBox-Sphere.obj"; std::string
-    // "Models/bunny/bunny.obj"; std::string modelFile =
-    // "Models/buddha/buddha.obj"; std::string modelFile =
-    // "Models/bmw/bmw.obj"; std::string modelFile =
-    // "Models/testScene.obj"; std::string modelFile =
-    // "Models/San_Miguel/san-miguel-low-poly.obj";
+    return sceneFile.str();
 }
 
-glm::mat4 getModelMatrix()
+bool getOptimizeMeshes()
 {
-    glm::mat4 modelMatrix(1.0f);
+    // opt-in reordering for vertex cache, overdraw and fetch; the optimized order is stored in the
+    // mesh cache, so once enabled it only costs on cold loads
+    return false;
+}
 
-#if NDEBUG
+bool getSplitSubmeshes()
+{
+    // per-shape and per-material draws and BLAS geometries; opt-in as the scene shaders have to add
+    // the first triangle of a draw or geometry to gl_PrimitiveID for their material lookup
+    return false;
+}
 
-    // dragon_model = glm::translate(dragon_model, glm::vec3(0.0f, -40.0f,
-    // -50.0f));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(1.0f, 1.0f, 1.0f));
-    /*dragon_model = glm::rotate(dragon_model, glm::radians(-90.f),
-       glm::vec3(1.0f, 0.0f, 0.0f)); dragon_model = glm::rotate(dragon_model,
-       glm::radians(angle), glm::vec3(0.0f, 0.0f, 1.0f));*/
+uint32_t getMeshLodCount()
+{
+    // LOD 0 only; raise it for coarser levels at half the triangles each. Opt-in as the scene
+    // shaders have to add the first triangle of a coarser level's draw to gl_PrimitiveID
+    return 1;
+}
 
-#else
+bool getCompactVertices()
+{
+    // quantized positions/normals/uvs; opt-in as the shaders have to be compiled for it
+    return false;
+}
 
-// dragon_model = glm::translate(dragon_model, glm::vec3(0.0f, -40.0f,
-// -50.0f));
-#if SULO_MODE
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(60.0f, 60.0f, 60.0f));
-#else
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(60.0f, 60.0f, 60.0f));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(-90.f), glm::vec3(1.0f, 0.0f, 0.0f));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(90.f), glm::vec3(0.0f, 0.0f, 1.0f));
-#endif
+bool getTextureStreaming()
+{
+    // only the mip tails are loaded up front, finer levels follow the camera
+    return true;
+}
 
-#endif
+uint64_t getTextureMemoryBudget()
+{
+    // device memory for all streamed textures together
+    return 256ull << 20;
+}
 
-    return modelMatrix;
+uint64_t getGeometryArenaSize()
+{
+    // device memory for the vertices and again for the indices (all LODs) of every mesh
+    return 64ull << 20;
 }
 
 }// namespace sceneConfig
@@ -2,11 +2,19 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstdint>
 #include <string>
 
 namespace sceneConfig {
 
-std::string getModelFile();
-glm::mat4 getModelMatrix();
+// KATAGLYPHIS_SCENE if set, the build type's default scene otherwise
+std::string getSceneFile();
+bool getOptimizeMeshes();
+bool getSplitSubmeshes();
+uint32_t getMeshLodCount();
+bool getCompactVertices();
+bool getTextureStreaming();
+uint64_t getTextureMemoryBudget();
+uint64_t getGeometryArenaSize();
 
 }// namespace sceneConfig
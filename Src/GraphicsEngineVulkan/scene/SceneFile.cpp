@@ -0,0 +1,111 @@
+#include "scene/SceneFile.hpp"
+
+#include <filesystem>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <nlohmann/json.hpp>
+
+#include "spdlog/spdlog.h"
+#include "util/File.hpp"
+
+using namespace Kataglyphis;
+
+namespace {
+
+glm::mat4 getInstanceTransform(const nlohmann::json &instance)
+{
+    if (instance.contains("matrix") && instance["matrix"].size() == 16) {
+        const std::vector<float> matrix = instance["matrix"].get<std::vector<float>>();
+        return glm::make_mat4(matrix.data());
+    }
+
+    glm::mat4 transform(1.f);
+    if (instance.contains("translation") && instance["translation"].size() == 3) {
+        const std::vector<float> t = instance["translation"].get<std::vector<float>>();
+        transform = glm::translate(transform, glm::vec3(t[0], t[1], t[2]));
+    }
+    if (instance.contains("rotation") && instance["rotation"].size() == 3) {
+        const std::vector<float> r = instance["rotation"].get<std::vector<float>>();
+        transform = glm::rotate(transform, glm::radians(r[0]), glm::vec3(1.f, 0.f, 0.f));
+        transform = glm::rotate(transform, glm::radians(r[1]), glm::vec3(0.f, 1.f, 0.f));
+        transform = glm::rotate(transform, glm::radians(r[2]), glm::vec3(0.f, 0.f, 1.f));
+    }
+    if (instance.contains("scale")) {
+        const nlohmann::json &s = instance["scale"];
+        if (s.is_number()) {
+            transform = glm::scale(transform, glm::vec3(s.get<float>()));
+        } else if (s.size() == 3) {
+            transform = glm::scale(transform, glm::vec3(s[0].get<float>(), s[1].get<float>(), s[2].get<float>()));
+        }
+    }
+    return transform;
+}
+
+}// namespace
+
+SceneFile::SceneFile() {}
+
+bool SceneFile::load(const std::string &file_location)
+{
+    meshes.clear();
+    instances.clear();
+
+    File file(file_location);
+    const nlohmann::json json = nlohmann::json::parse(file.read(), nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        spdlog::error("Failed to parse scene file {}!", file_location);
+        return false;
+    }
+
+    const std::filesystem::path base_dir = std::filesystem::path(file_location).parent_path();
+    for (const nlohmann::json &json_mesh : json.value("meshes", nlohmann::json::array())) {
+        SceneFileMesh mesh;
+        mesh.file = json_mesh.value("file", std::string());
+        mesh.name = json_mesh.value("name", mesh.file);
+        if (mesh.file.empty()) {
+            spdlog::error("{}: mesh {} has no file!", file_location, meshes.size());
+            return false;
+        }
+        mesh.file = (base_dir / mesh.file).lexically_normal().string();
+        meshes.push_back(mesh);
+    }
+
+    for (const nlohmann::json &json_instance : json.value("instances", nlohmann::json::array())) {
+        const nlohmann::json &reference = json_instance.value("mesh", nlohmann::json());
+        SceneFileInstance instance;
+        instance.mesh = static_cast<uint32_t>(meshes.size());
+        if (reference.is_number_unsigned()) {
+            instance.mesh = reference.get<uint32_t>();
+        } else if (reference.is_string()) {
+            for (uint32_t m = 0; m < static_cast<uint32_t>(meshes.size()); m++) {
+                if (meshes[m].name == reference.get<std::string>()) instance.mesh = m;
+            }
+        }
+        if (instance.mesh >= meshes.size()) {
+            spdlog::error("{}: instance {} references no mesh of the scene!", file_location, instances.size());
+            return false;
+        }
+
+        instance.transform = getInstanceTransform(json_instance);
+        instances.push_back(instance);
+    }
+
+    if (instances.empty()) {
+        spdlog::error("Scene file {} places no mesh!", file_location);
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<glm::mat4> SceneFile::getPlacements(uint32_t mesh) const
+{
+    std::vector<glm::mat4> placements;
+    for (const SceneFileInstance &instance : instances) {
+        if (instance.mesh == mesh) placements.push_back(instance.transform);
+    }
+    return placements;
+}
+
+SceneFile::~SceneFile() {}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Kataglyphis {
+
+// a model file of the scene; loaded and uploaded once, however often it is placed
+struct SceneFileMesh
+{
+    std::string name;
+    std::string file;
+};
+
+struct SceneFileInstance
+{
+    // into the meshes of the scene file
+    uint32_t mesh{ 0 };
+    glm::mat4 transform{ 1.f };
+};
+
+// Runtime scene description (.json): every mesh is listed once, instances
+// reference it by name or index and only add a transform.
+//
+// {
+//   "meshes": [ { "name": "room", "file": "../Models/VikingRoom/viking_room.obj" } ],
+//   "instances": [ { "mesh": "room", "translation": [0, 0, 0], "rotation": [-90, 0, 90], "scale": 60 } ]
+// }
+//
+// Mesh files are relative to the scene file. The transform is translation *
+// rotation * scale, the rotation given in degrees around x, then y, then z;
+// scale is a number or a vec3. A column major "matrix" of 16 floats replaces all three.
+class SceneFile
+{
+  public:
+    SceneFile();
+
+    bool load(const std::string &file_location);
+
+    const std::vector<SceneFileMesh> &getMeshes() const { return meshes; };
+    const std::vector<SceneFileInstance> &getInstances() const { return instances; };
+    // transforms of all instances of a mesh, in file order
+    std::vector<glm::mat4> getPlacements(uint32_t mesh) const;
+
+    ~SceneFile();
+
+  private:
+    std::vector<SceneFileMesh> meshes;
+    std::vector<SceneFileInstance> instances;
+};
+
+}// namespace Kataglyphis
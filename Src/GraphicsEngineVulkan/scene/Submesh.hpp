@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace Kataglyphis {
+
+// A contiguous range of full resolution (LOD 0) triangles of a mesh that share
+// one source shape and one material. Submeshes are stored back to back and
+// cover LOD 0 exactly; they are the smallest unit the renderer can cull, sort
+// and draw on its own. Coarser levels are simplified over the whole mesh and
+// are drawn whole.
+struct Submesh
+{
+    uint32_t index_offset{ 0 };
+    uint32_t index_count{ 0 };
+    // model local material of all its triangles (UINT32_MAX if none) and the shape it came from
+    uint32_t material{ UINT32_MAX };
+    uint32_t shape{ 0 };
+    // object space bounds; xyz: center, w: radius
+    glm::vec4 bounding_sphere{ 0.f };
+    glm::vec3 aabb_min{ 0.f };
+    glm::vec3 aabb_max{ 0.f };
+};
+
+}// namespace Kataglyphis
@@ -0,0 +1,84 @@
+#include "scene/SubmeshBuilder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace Kataglyphis;
+
+std::vector<Submesh> SubmeshBuilder::build(std::span<const Vertex> vertices,
+  std::vector<uint32_t> &indices,
+  std::vector<unsigned int> &materialIndex,
+  std::span<const uint32_t> triangle_shapes) const
+{
+    std::vector<Submesh> submeshes;
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) return submeshes;
+
+    const bool per_triangle_materials = materialIndex.size() == triangle_count;
+    const bool per_triangle_shapes = triangle_shapes.size() == triangle_count;
+    auto shapeOf = [&](size_t triangle) { return per_triangle_shapes ? triangle_shapes[triangle] : 0u; };
+    auto materialOf = [&](size_t triangle) {
+        return per_triangle_materials ? static_cast<uint32_t>(materialIndex[triangle]) : UINT32_MAX;
+    };
+
+    std::vector<uint32_t> triangle_order(triangle_count);
+    std::iota(triangle_order.begin(), triangle_order.end(), 0u);
+    std::stable_sort(triangle_order.begin(), triangle_order.end(), [&](uint32_t a, uint32_t b) {
+        if (shapeOf(a) != shapeOf(b)) return shapeOf(a) < shapeOf(b);
+        return materialOf(a) < materialOf(b);
+    });
+
+    std::vector<uint32_t> reordered_indices(triangle_count * 3);
+    std::vector<unsigned int> reordered_material_index(materialIndex.size());
+    for (size_t i = 0; i < triangle_count; i++) {
+        const uint32_t triangle = triangle_order[i];
+        reordered_indices[i * 3 + 0] = indices[triangle * 3 + 0];
+        reordered_indices[i * 3 + 1] = indices[triangle * 3 + 1];
+        reordered_indices[i * 3 + 2] = indices[triangle * 3 + 2];
+        if (per_triangle_materials) reordered_material_index[i] = materialIndex[triangle];
+
+        const uint32_t shape = shapeOf(triangle);
+        const uint32_t material = materialOf(triangle);
+        if (submeshes.empty() || submeshes.back().shape != shape || submeshes.back().material != material) {
+            Submesh submesh{};
+            submesh.index_offset = static_cast<uint32_t>(i * 3);
+            submesh.shape = shape;
+            submesh.material = material;
+            submeshes.push_back(submesh);
+        }
+        submeshes.back().index_count += 3;
+    }
+    indices.swap(reordered_indices);
+    if (per_triangle_materials) materialIndex.swap(reordered_material_index);
+
+    for (Submesh &submesh : submeshes) computeBounds(vertices, indices, submesh);
+
+    return submeshes;
+}
+
+void SubmeshBuilder::computeBounds(std::span<const Vertex> vertices,
+  std::span<const uint32_t> indices,
+  Submesh &submesh)
+{
+    const std::span<const uint32_t> submesh_indices = indices.subspan(submesh.index_offset, submesh.index_count);
+    if (submesh_indices.empty()) return;
+
+    glm::vec3 min_pos = vertices[submesh_indices[0]].pos;
+    glm::vec3 max_pos = min_pos;
+    for (uint32_t index : submesh_indices) {
+        min_pos = glm::min(min_pos, vertices[index].pos);
+        max_pos = glm::max(max_pos, vertices[index].pos);
+    }
+
+    const glm::vec3 center = (min_pos + max_pos) * 0.5f;
+    float radius_squared = 0.f;
+    for (uint32_t index : submesh_indices) {
+        const glm::vec3 d = vertices[index].pos - center;
+        radius_squared = std::max(radius_squared, glm::dot(d, d));
+    }
+
+    submesh.aabb_min = min_pos;
+    submesh.aabb_max = max_pos;
+    submesh.bounding_sphere = glm::vec4(center, std::sqrt(radius_squared));
+}
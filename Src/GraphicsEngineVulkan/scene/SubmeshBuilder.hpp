@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "scene/Submesh.hpp"
+#include "scene/Vertex.hpp"
+
+namespace Kataglyphis {
+
+// Sorts the triangles of an indexed triangle list by (shape, material) and
+// returns one submesh per run. The sort is stable, so the triangle order
+// within a submesh is the one of the source file; per-triangle materials are
+// permuted along with the triangles.
+class SubmeshBuilder
+{
+  public:
+    // triangle_shapes: source shape of every triangle; may be empty if the mesh has only one
+    std::vector<Submesh> build(std::span<const Vertex> vertices,
+      std::vector<uint32_t> &indices,
+      std::vector<unsigned int> &materialIndex,
+      std::span<const uint32_t> triangle_shapes) const;
+
+    // bounding box and sphere of the triangles of submesh
+    static void computeBounds(std::span<const Vertex> vertices, std::span<const uint32_t> indices, Submesh &submesh);
+};
+
+}// namespace Kataglyphis
@@ -2,79 +2,188 @@
 
 #include "common/Utilities.hpp"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <stdexcept>
 
+#include <ktx.h>
+
 using namespace Kataglyphis;
 
+namespace {
+
+bool supportsSampling(VkPhysicalDevice physical_device, VkFormat format)
+{
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+    return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+ktx_transcode_fmt_e chooseTranscodeTarget(const TextureFormatSupport &format_support, bool has_alpha)
+{
+    if (format_support.bc7) return KTX_TTF_BC7_RGBA;
+    if (format_support.astc_4x4) return KTX_TTF_ASTC_4x4_RGBA;
+    // BC1 only has 1 bit alpha; rather pay for RGBA8 than lose cutouts and blending
+    if (format_support.bc1 && !has_alpha) return KTX_TTF_BC1_RGB;
+    return KTX_TTF_RGBA32;
+}
+
+// the stb path uploads everything as UNORM and the shaders are written against
+// that, so ktx2 textures tagged as sRGB are sampled the same way
+VkFormat toUnormFormat(VkFormat format)
+{
+    switch (format) {
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return VK_FORMAT_R8G8B8A8_UNORM;
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        return VK_FORMAT_BC3_UNORM_BLOCK;
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return VK_FORMAT_BC7_UNORM_BLOCK;
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+        return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+    default:
+        return format;
+    }
+}
+
+}// namespace
+
+Kataglyphis::TextureFormatSupport Kataglyphis::TextureFormatSupport::query(VkPhysicalDevice physical_device)
+{
+    TextureFormatSupport format_support;
+    format_support.bc7 = supportsSampling(physical_device, VK_FORMAT_BC7_UNORM_BLOCK);
+    format_support.bc1 = supportsSampling(physical_device, VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+    format_support.astc_4x4 = supportsSampling(physical_device, VK_FORMAT_ASTC_4x4_UNORM_BLOCK);
+    return format_support;
+}
+
 Kataglyphis::Texture::Texture() {}
 
-void Kataglyphis::Texture::createFromFile(VulkanDevice *device, VkCommandPool commandPool, const std::string &fileName)
+void Kataglyphis::Texture::createFromFile(VulkanDevice *device, VulkanUploader &uploader, const std::string &fileName)
 {
-    int width, height;
-    VkDeviceSize size;
-    stbi_uc *image_data = loadTextureData(fileName, &width, &height, &size);
+    createFromData(device, uploader, decodeFile(fileName, TextureFormatSupport::query(device->getPhysicalDevice())));
+}
 
-    mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+void Kataglyphis::Texture::createFromData(VulkanDevice *device,
+  VulkanUploader &uploader,
+  const TextureData &textureData)
+{
+    // the file already has the whole chain (block compressed formats can't be blitted anyway)
+    if (!textureData.mip_levels.empty()) {
+        createFromMipLevels(device, uploader, textureData, 0);
+        return;
+    }
 
-    // create staging buffer to hold loaded data, ready to copy to device
-    VulkanBuffer stagingBuffer;
-    stagingBuffer.create(device,
-      size,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    // a transfer only queue can't blit; box filter the chain on the CPU instead
+    if (!uploader.canBlit()) {
+        TextureData mipped;
+        mipped.width = textureData.width;
+        mipped.height = textureData.height;
+        mipped.format = textureData.format;
+        mipped.size = textureData.size;
+        mipped.pixels = { static_cast<stbi_uc *>(std::malloc(textureData.size)), std::free };
+        memcpy(mipped.pixels.get(), textureData.pixels.get(), static_cast<size_t>(textureData.size));
+        generateMipChain(mipped);
+        createFromMipLevels(device, uploader, mipped, 0);
+        return;
+    }
 
-    // copy image data to staging buffer
-    void *data;
-    vkMapMemory(device->getLogicalDevice(), stagingBuffer.getBufferMemory(), 0, size, 0, &data);
-    memcpy(data, image_data, static_cast<size_t>(size));
-    vkUnmapMemory(device->getLogicalDevice(), stagingBuffer.getBufferMemory());
+    const int width = textureData.width;
+    const int height = textureData.height;
 
-    // free original image data
-    stbi_image_free(image_data);
+    mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
 
+    // blitting the mips needs the image as transfer source as well
     createImage(device,
       width,
       height,
       mip_levels,
-      VK_FORMAT_R8G8B8A8_UNORM,
+      textureData.format,
       VK_IMAGE_TILING_OPTIMAL,
       VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    // copy data to image
-    // transition image to be DST for copy operation
-    vulkanImage.transitionImageLayout(device->getLogicalDevice(),
-      device->getGraphicsQueue(),
-      commandPool,
-      VK_IMAGE_LAYOUT_UNDEFINED,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      VK_IMAGE_ASPECT_COLOR_BIT,
-      mip_levels);
+    VkBufferImageCopy image_region{};
+    image_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    image_region.imageSubresource.mipLevel = 0;
+    image_region.imageSubresource.baseArrayLayer = 0;
+    image_region.imageSubresource.layerCount = 1;
+    image_region.imageOffset = { 0, 0, 0 };
+    image_region.imageExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
 
-    // copy data to image
-    vulkanBufferManager.copyImageBuffer(device->getLogicalDevice(),
-      device->getGraphicsQueue(),
-      commandPool,
-      stagingBuffer.getBuffer(),
-      vulkanImage.getImage(),
-      width,
-      height);
+    // all levels stay TRANSFER_DST; generateMipMaps blits into them in the same batch
+    uploader.uploadImage(vulkanImage.getImage(),
+      mip_levels,
+      textureData.pixels.get(),
+      textureData.getSize(),
+      std::span<const VkBufferImageCopy>(&image_region, 1),
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-    // generate mipmaps
     generateMipMaps(device->getPhysicalDevice(),
-      device->getLogicalDevice(),
-      commandPool,
-      device->getGraphicsQueue(),
+      uploader.getCommandBuffer(),
       vulkanImage.getImage(),
       VK_FORMAT_R8G8B8A8_SRGB,
       width,
       height,
       mip_levels);
 
-    stagingBuffer.cleanUp();
+    createImageView(device, textureData.format, VK_IMAGE_ASPECT_COLOR_BIT, mip_levels);
+}
+
+void Kataglyphis::Texture::createFromMipLevels(VulkanDevice *device,
+  VulkanUploader &uploader,
+  const TextureData &textureData,
+  uint32_t first_level)
+{
+    const TextureMipLevel &base_level = textureData.mip_levels[first_level];
+    mip_levels = static_cast<uint32_t>(textureData.mip_levels.size()) - first_level;
+
+    // the levels from first_level on are one contiguous range of pixels; ktx2 stores
+    // the smallest level first, generateMipChain the largest one
+    VkDeviceSize range_begin = base_level.offset;
+    VkDeviceSize range_end = base_level.offset + base_level.size;
+    for (uint32_t level = first_level; level < textureData.mip_levels.size(); level++) {
+        const TextureMipLevel &mip_level = textureData.mip_levels[level];
+        range_begin = std::min(range_begin, mip_level.offset);
+        range_end = std::max(range_end, mip_level.offset + mip_level.size);
+    }
+
+    std::vector<VkBufferImageCopy> regions(mip_levels);
+    for (uint32_t level = 0; level < mip_levels; level++) {
+        const TextureMipLevel &mip_level = textureData.mip_levels[first_level + level];
+        VkBufferImageCopy &region = regions[level];
+        region.bufferOffset = mip_level.offset - range_begin;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { mip_level.width, mip_level.height, 1 };
+    }
+
+    // transfer source as well so defragmentation can move the image
+    createImage(device,
+      base_level.width,
+      base_level.height,
+      mip_levels,
+      textureData.format,
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    uploader.uploadImage(
+      vulkanImage.getImage(), mip_levels, textureData.pixels.get() + range_begin, range_end - range_begin, regions);
 
-    createImageView(device, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, mip_levels);
+    createImageView(device, textureData.format, VK_IMAGE_ASPECT_COLOR_BIT, mip_levels);
 }
 
 void Kataglyphis::Texture::setImage(VkImage image) { vulkanImage.setImage(image); }
@@ -101,6 +210,17 @@ void Kataglyphis::Texture::createImageView(VulkanDevice *device,
     vulkanImageView.create(device, vulkanImage.getImage(), format, aspect_flags, mip_levels);
 }
 
+void Kataglyphis::Texture::relocate(VulkanDevice *device,
+  VmaAllocation destination,
+  VkCommandBuffer command_buffer,
+  VkImage &old_image,
+  VkImageView &old_image_view)
+{
+    old_image = vulkanImage.relocate(destination, command_buffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    old_image_view = vulkanImageView.getImageView();
+    createImageView(device, vulkanImage.getCreateInfo().format, VK_IMAGE_ASPECT_COLOR_BIT, mip_levels);
+}
+
 void Kataglyphis::Texture::cleanUp()
 {
     vulkanImageView.cleanUp();
@@ -109,27 +229,145 @@ void Kataglyphis::Texture::cleanUp()
 
 Kataglyphis::Texture::~Texture() {}
 
-stbi_uc *
-  Kataglyphis::Texture::loadTextureData(const std::string &file_name, int *width, int *height, VkDeviceSize *image_size)
+Kataglyphis::TextureData Kataglyphis::Texture::decodeFile(const std::string &fileName,
+  const TextureFormatSupport &format_support)
 {
+    if (std::filesystem::path(fileName).extension() == ".ktx2") return decodeKtx2File(fileName, format_support);
+
+    TextureData textureData;
     // number of channels image uses
     int channels;
     // load pixel data for image
     // std::string file_loc = "../Resources/Textures/" + file_name;
-    stbi_uc *image = stbi_load(file_name.c_str(), width, height, &channels, STBI_rgb_alpha);
+    textureData.pixels.reset(
+      stbi_load(fileName.c_str(), &textureData.width, &textureData.height, &channels, STBI_rgb_alpha));
+
+    if (!textureData.pixels) { spdlog::error("Failed to load a texture file! (" + fileName + ")"); }
+    textureData.size = static_cast<VkDeviceSize>(textureData.width) * static_cast<VkDeviceSize>(textureData.height) * 4;
 
-    if (!image) { spdlog::error("Failed to load a texture file! (" + file_name + ")"); }
+    return textureData;
+}
 
-    // calculate image size using given and known data
-    *image_size = *width * *height * 4;
+Kataglyphis::TextureData Kataglyphis::Texture::decodeMemory(std::span<const std::byte> encoded, const std::string &name)
+{
+    TextureData textureData;
+    int channels;
+    textureData.pixels.reset(stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(encoded.data()),
+      static_cast<int>(encoded.size()),
+      &textureData.width,
+      &textureData.height,
+      &channels,
+      STBI_rgb_alpha));
 
-    return image;
+    if (!textureData.pixels) { spdlog::error("Failed to decode an embedded texture! (" + name + ")"); }
+    textureData.size = static_cast<VkDeviceSize>(textureData.width) * static_cast<VkDeviceSize>(textureData.height) * 4;
+
+    return textureData;
+}
+
+void Kataglyphis::Texture::generateMipChain(TextureData &textureData)
+{
+    if (!textureData.pixels || !textureData.mip_levels.empty() || textureData.format != VK_FORMAT_R8G8B8A8_UNORM) {
+        return;
+    }
+
+    const uint32_t level_count =
+      static_cast<uint32_t>(std::floor(std::log2(std::max(textureData.width, textureData.height)))) + 1;
+    textureData.mip_levels.resize(level_count);
+    VkDeviceSize size = 0;
+    for (uint32_t level = 0; level < level_count; level++) {
+        TextureMipLevel &mip_level = textureData.mip_levels[level];
+        mip_level.width = std::max(1u, static_cast<uint32_t>(textureData.width) >> level);
+        mip_level.height = std::max(1u, static_cast<uint32_t>(textureData.height) >> level);
+        mip_level.offset = size;
+        mip_level.size = static_cast<VkDeviceSize>(mip_level.width) * mip_level.height * 4;
+        size += mip_level.size;
+    }
+
+    std::unique_ptr<stbi_uc, void (*)(void *)> pixels{ static_cast<stbi_uc *>(std::malloc(size)), std::free };
+    memcpy(pixels.get(), textureData.pixels.get(), static_cast<size_t>(textureData.mip_levels[0].size));
+
+    // 2x2 box filter; odd sizes repeat their last row/column
+    for (uint32_t level = 1; level < level_count; level++) {
+        const TextureMipLevel &src_level = textureData.mip_levels[level - 1];
+        const TextureMipLevel &dst_level = textureData.mip_levels[level];
+        const stbi_uc *src = pixels.get() + src_level.offset;
+        stbi_uc *dst = pixels.get() + dst_level.offset;
+        for (uint32_t y = 0; y < dst_level.height; y++) {
+            const uint32_t y0 = std::min(2 * y, src_level.height - 1);
+            const uint32_t y1 = std::min(2 * y + 1, src_level.height - 1);
+            for (uint32_t x = 0; x < dst_level.width; x++) {
+                const uint32_t x0 = std::min(2 * x, src_level.width - 1);
+                const uint32_t x1 = std::min(2 * x + 1, src_level.width - 1);
+                const stbi_uc *p00 = src + (y0 * src_level.width + x0) * 4;
+                const stbi_uc *p01 = src + (y0 * src_level.width + x1) * 4;
+                const stbi_uc *p10 = src + (y1 * src_level.width + x0) * 4;
+                const stbi_uc *p11 = src + (y1 * src_level.width + x1) * 4;
+                for (uint32_t c = 0; c < 4; c++) {
+                    const uint32_t sum = p00[c] + p01[c] + p10[c] + p11[c];
+                    dst[(y * dst_level.width + x) * 4 + c] = static_cast<stbi_uc>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+    textureData.pixels = std::move(pixels);
+    textureData.size = size;
+}
+
+Kataglyphis::TextureData Kataglyphis::Texture::decodeKtx2File(const std::string &fileName,
+  const TextureFormatSupport &format_support)
+{
+    TextureData textureData;
+
+    ktxTexture2 *texture = nullptr;
+    KTX_error_code result =
+      ktxTexture2_CreateFromNamedFile(fileName.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture);
+    if (result != KTX_SUCCESS) {
+        spdlog::error("Failed to load a texture file! (" + fileName + ": " + ktxErrorString(result) + ")");
+        return textureData;
+    }
+
+    // UASTC and ETC1S are only intermediate formats; pick what the GPU samples natively
+    if (ktxTexture2_NeedsTranscoding(texture)) {
+        const bool has_alpha = ktxTexture2_GetNumComponents(texture) == 2 || ktxTexture2_GetNumComponents(texture) == 4;
+        result = ktxTexture2_TranscodeBasis(texture, chooseTranscodeTarget(format_support, has_alpha), 0);
+        if (result != KTX_SUCCESS) {
+            spdlog::error("Failed to transcode a texture file! (" + fileName + ": " + ktxErrorString(result) + ")");
+            ktxTexture_Destroy(ktxTexture(texture));
+            return textureData;
+        }
+    }
+
+    textureData.width = static_cast<int>(texture->baseWidth);
+    textureData.height = static_cast<int>(texture->baseHeight);
+    textureData.format = toUnormFormat(static_cast<VkFormat>(texture->vkFormat));
+    textureData.size = ktxTexture_GetDataSize(ktxTexture(texture));
+
+    // a single RGBA8 level still gets its mips generated on upload like any stb image
+    const bool generate_mips = texture->numLevels == 1 && textureData.format == VK_FORMAT_R8G8B8A8_UNORM;
+    if (!generate_mips) {
+        textureData.mip_levels.resize(texture->numLevels);
+        for (uint32_t level = 0; level < texture->numLevels; level++) {
+            ktx_size_t offset = 0;
+            ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0, &offset);
+            textureData.mip_levels[level].offset = offset;
+            textureData.mip_levels[level].size = ktxTexture_GetImageSize(ktxTexture(texture), level);
+            textureData.mip_levels[level].width = std::max(1u, texture->baseWidth >> level);
+            textureData.mip_levels[level].height = std::max(1u, texture->baseHeight >> level);
+        }
+    }
+
+    textureData.pixels = { static_cast<stbi_uc *>(std::malloc(textureData.size)), std::free };
+    memcpy(textureData.pixels.get(), ktxTexture_GetData(ktxTexture(texture)), static_cast<size_t>(textureData.size));
+
+    ktxTexture_Destroy(ktxTexture(texture));
+
+    return textureData;
 }
 
 void Kataglyphis::Texture::generateMipMaps(VkPhysicalDevice physical_device,
-  VkDevice device,
-  VkCommandPool command_pool,
-  VkQueue queue,
+  VkCommandBuffer command_buffer,
   VkImage image,
   VkFormat image_format,
   int32_t width,
@@ -144,8 +382,6 @@ void Kataglyphis::Texture::generateMipMaps(VkPhysicalDevice physical_device,
         spdlog::error("Texture image format does not support linear blitting!");
     }
 
-    VkCommandBuffer command_buffer = commandBufferManager.beginCommandBuffer(device, command_pool);
-
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = image;
@@ -247,6 +483,4 @@ void Kataglyphis::Texture::generateMipMaps(VkPhysicalDevice physical_device,
       nullptr,
       1,
       &barrier);
-
-    commandBufferManager.endAndSubmitCommandBuffer(device, command_pool, queue, command_buffer);
 }
@@ -2,19 +2,82 @@
 #include <stb_image.h>
 #include <vulkan/vulkan.h>
 
+#include <memory>
+#include <span>
 #include <string>
+#include <vector>
 
 #include "vulkan_base/VulkanBuffer.hpp"
-#include "vulkan_base/VulkanBufferManager.hpp"
 #include "vulkan_base/VulkanImage.hpp"
 #include "vulkan_base/VulkanImageView.hpp"
+#include "vulkan_base/VulkanUploader.hpp"
 namespace Kataglyphis {
+
+// block compressed formats the device can sample; decides what ktx2 files are transcoded to
+struct TextureFormatSupport
+{
+    bool bc7{ false };
+    bool bc1{ false };
+    bool astc_4x4{ false };
+
+    static TextureFormatSupport query(VkPhysicalDevice physical_device);
+};
+
+// one precomputed mip level inside TextureData::pixels
+struct TextureMipLevel
+{
+    VkDeviceSize offset{ 0 };
+    VkDeviceSize size{ 0 };
+    uint32_t width{ 0 };
+    uint32_t height{ 0 };
+};
+
+// pixels of a texture file, decoded (and for ktx2 files transcoded) on the CPU
+struct TextureData
+{
+    int width{ 0 };
+    int height{ 0 };
+    // RGBA8 for stb images, the transcoded block format for ktx2 files
+    VkFormat format{ VK_FORMAT_R8G8B8A8_UNORM };
+    VkDeviceSize size{ 0 };
+    // empty if the file only has level 0; the mips are generated on upload then
+    std::vector<TextureMipLevel> mip_levels;
+    std::unique_ptr<stbi_uc, void (*)(void *)> pixels{ nullptr, stbi_image_free };
+
+    VkDeviceSize getSize() const { return size; };
+};
+
 class Texture
 {
   public:
     Texture();
 
-    void createFromFile(VulkanDevice *device, VkCommandPool commandPool, const std::string &fileName);
+    void createFromFile(VulkanDevice *device, VulkanUploader &uploader, const std::string &fileName);
+    // GPU half of createFromFile; data may come from any thread. The upload is only
+    // recorded, the texture is ready once the uploader's batch has completed
+    void createFromData(VulkanDevice *device, VulkanUploader &uploader, const TextureData &textureData);
+    // uploads only the levels from first_level on; needs precomputed mips (see generateMipChain)
+    void createFromMipLevels(VulkanDevice *device,
+      VulkanUploader &uploader,
+      const TextureData &textureData,
+      uint32_t first_level);
+
+    // CPU half of createFromFile; safe to call from several threads at once
+    // .ktx2 files keep their mip chain and are transcoded to the best format in format_support
+    static TextureData decodeFile(const std::string &fileName,
+      const TextureFormatSupport &format_support = TextureFormatSupport{});
+    // same for an encoded image in memory (PNG, JPEG, ...), e.g. one embedded in a .glb; name is only logged
+    static TextureData decodeMemory(std::span<const std::byte> encoded, const std::string &name);
+    // box filters the missing mips of a single level RGBA8 image on the CPU
+    static void generateMipChain(TextureData &textureData);
+
+    // moves the sampled image into destination (see Allocator::defragment); the old image and
+    // view have to be destroyed once command_buffer has executed
+    void relocate(VulkanDevice *device,
+      VmaAllocation destination,
+      VkCommandBuffer command_buffer,
+      VkImage &old_image,
+      VkImageView &old_image_view);
 
     void setImage(VkImage image);
     void setImageView(VkImageView imageView);
@@ -43,21 +106,16 @@ class Texture
   private:
     uint32_t mip_levels = 0;
 
-    stbi_uc *loadTextureData(const std::string &file_name, int *width, int *height, VkDeviceSize *image_size);
+    static TextureData decodeKtx2File(const std::string &fileName, const TextureFormatSupport &format_support);
 
     void generateMipMaps(VkPhysicalDevice physical_device,
-      VkDevice device,
-      VkCommandPool command_pool,
-      VkQueue queue,
+      VkCommandBuffer command_buffer,
       VkImage image,
       VkFormat image_format,
       int32_t width,
       int32_t height,
       uint32_t mip_levels);
 
-    Kataglyphis::VulkanRendererInternals::CommandBufferManager commandBufferManager;
-    VulkanBufferManager vulkanBufferManager;
-
     VulkanImage vulkanImage;
     VulkanImageView vulkanImageView;
 };
@@ -0,0 +1,124 @@
+#include "scene/TextureCache.hpp"
+
+#include <filesystem>
+
+#include "common/Utilities.hpp"
+#include "spdlog/spdlog.h"
+#include "util/Hash.hpp"
+
+using namespace Kataglyphis;
+
+TextureCache::TextureCache() {}
+
+void TextureCache::create(VulkanDevice *device) { this->device = device; }
+
+std::string TextureCache::fileKey(const std::string &file)
+{
+    // "textures/../textures/a.png" and "./textures/a.png" are the same file; made absolute
+    // first, as weakly_canonical keeps a path relative whose first part does not exist
+    std::error_code error;
+    const std::filesystem::path absolute = std::filesystem::absolute(file, error).lexically_normal();
+    const std::filesystem::path canonical = std::filesystem::weakly_canonical(absolute, error);
+    return "file:" + (error ? absolute : canonical).generic_string();
+}
+
+std::string TextureCache::contentKey(std::span<const std::byte> encoded)
+{
+    // the size goes into the key as well, a collision also needs equally long images
+    return "content:" + std::to_string(hashBytes(encoded.data(), encoded.size())) + ":"
+           + std::to_string(encoded.size());
+}
+
+bool TextureCache::acquire(const std::string &key, uint32_t &slot)
+{
+    auto cached = slots.find(key);
+    if (cached == slots.end()) return false;
+
+    slot = cached->second;
+    entries[slot].references++;
+    hit_count++;
+    return true;
+}
+
+uint32_t TextureCache::reserve(const std::string &key, SamplerSettings sampler_settings)
+{
+    uint32_t slot;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(textures.size());
+        textures.emplace_back();
+        entries.emplace_back();
+    }
+
+    entries[slot] = Entry{ key, 1, findOrCreateSampler(sampler_settings) };
+    slots[key] = slot;
+    return slot;
+}
+
+void TextureCache::setTexture(uint32_t slot, Texture texture) { textures[slot] = texture; }
+
+void TextureCache::release(uint32_t slot)
+{
+    Entry &entry = entries[slot];
+    if (entry.references == 0) {
+        spdlog::error("Texture slot {} released more often than acquired!", slot);
+        return;
+    }
+    if (--entry.references > 0) return;
+
+    textures[slot].cleanUp();
+    textures[slot] = Texture();
+    slots.erase(entry.key);
+    entry.key.clear();
+    free_slots.push_back(slot);
+}
+
+void TextureCache::cleanUp()
+{
+    for (uint32_t slot = 0; slot < getSlotCount(); slot++) {
+        if (isLive(slot)) textures[slot].cleanUp();
+    }
+    textures.clear();
+    entries.clear();
+    slots.clear();
+    free_slots.clear();
+
+    for (SharedSampler &shared : samplers) vkDestroySampler(device->getLogicalDevice(), shared.sampler, nullptr);
+    samplers.clear();
+}
+
+TextureCache::~TextureCache() {}
+
+uint32_t TextureCache::findOrCreateSampler(SamplerSettings settings)
+{
+    for (uint32_t sampler = 0; sampler < static_cast<uint32_t>(samplers.size()); sampler++) {
+        if (samplers[sampler].settings == settings) return sampler;
+    }
+
+    VkSampler newSampler;
+    // sampler create info
+    VkSamplerCreateInfo sampler_create_info{};
+    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_create_info.magFilter = settings.filter;
+    sampler_create_info.minFilter = settings.filter;
+    sampler_create_info.addressModeU = settings.address_mode;
+    sampler_create_info.addressModeV = settings.address_mode;
+    sampler_create_info.addressModeW = settings.address_mode;
+    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+    sampler_create_info.unnormalizedCoordinates = VK_FALSE;
+    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler_create_info.mipLodBias = 0.0f;
+    sampler_create_info.minLod = 0.0f;
+    // streamed textures change their level count, the image view clamps the range anyway
+    sampler_create_info.maxLod = VK_LOD_CLAMP_NONE;
+    sampler_create_info.anisotropyEnable = settings.max_anisotropy > 1.f ? VK_TRUE : VK_FALSE;
+    sampler_create_info.maxAnisotropy = settings.max_anisotropy;
+
+    VkResult result = vkCreateSampler(device->getLogicalDevice(), &sampler_create_info, nullptr, &newSampler);
+    ASSERT_VULKAN(result, "Failed to create a texture sampler!")
+
+    samplers.push_back(SharedSampler{ settings, newSampler });
+    return static_cast<uint32_t>(samplers.size() - 1);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "scene/Texture.hpp"
+
+namespace Kataglyphis {
+
+// everything a sampler is created from; textures with equal settings share one sampler
+struct SamplerSettings
+{
+    VkFilter filter{ VK_FILTER_LINEAR };
+    VkSamplerAddressMode address_mode{ VK_SAMPLER_ADDRESS_MODE_REPEAT };
+    float max_anisotropy{ 16.f };
+
+    bool operator==(const SamplerSettings &other) const = default;
+};
+
+// Scene wide table of unique textures; a slot is a texture's index in the shared
+// texture descriptor array and material texture ids refer to slots directly.
+// Files are keyed by their canonical path, images embedded in a model file by a
+// hash of their encoded bytes, so a texture referenced by several materials or
+// models is decoded, uploaded and stored once. Every acquire() or reserve()
+// counts a reference, the last release() destroys the texture and frees its slot
+// for reuse. Samplers are shared between all textures with equal settings and
+// live as long as the cache.
+class TextureCache
+{
+  public:
+    TextureCache();
+
+    void create(VulkanDevice *device);
+
+    static std::string fileKey(const std::string &file);
+    static std::string contentKey(std::span<const std::byte> encoded);
+
+    // slot of a known texture with one more reference; false if the key is unknown
+    bool acquire(const std::string &key, uint32_t &slot);
+    // a slot holding one reference for a texture created afterwards (see setTexture);
+    // until then acquiring the key hands out the same slot
+    uint32_t reserve(const std::string &key, SamplerSettings sampler_settings = SamplerSettings{});
+    void setTexture(uint32_t slot, Texture texture);
+    void release(uint32_t slot);
+
+    // also the length of the texture descriptor array; freed slots are included
+    uint32_t getSlotCount() const { return static_cast<uint32_t>(textures.size()); };
+    bool isLive(uint32_t slot) const { return entries[slot].references > 0; };
+    Texture &getTexture(uint32_t slot) { return textures[slot]; };
+    VkSampler getSampler(uint32_t slot) const { return samplers[entries[slot].sampler].sampler; };
+    uint32_t getSamplerCount() const { return static_cast<uint32_t>(samplers.size()); };
+    // acquires of a key that was already cached, since creation
+    uint32_t getHitCount() const { return hit_count; };
+
+    void cleanUp();
+
+    ~TextureCache();
+
+  private:
+    struct Entry
+    {
+        std::string key;
+        uint32_t references{ 0 };
+        uint32_t sampler{ 0 };
+    };
+
+    struct SharedSampler
+    {
+        SamplerSettings settings;
+        VkSampler sampler{ VK_NULL_HANDLE };
+    };
+
+    VulkanDevice *device{ VK_NULL_HANDLE };
+
+    std::vector<Texture> textures;
+    // parallel to textures
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, uint32_t> slots;
+    std::vector<uint32_t> free_slots;
+    std::vector<SharedSampler> samplers;
+    uint32_t hit_count{ 0 };
+
+    uint32_t findOrCreateSampler(SamplerSettings settings);
+};
+
+}// namespace Kataglyphis
@@ -0,0 +1,91 @@
+#include "scene/TextureDecoder.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+using namespace Kataglyphis;
+
+TextureDecoder::TextureDecoder(TextureDecoderSettings settings) { this->settings = settings; }
+
+void TextureDecoder::decode(const std::vector<std::string> &file_names,
+  const std::function<void(size_t, TextureData &)> &on_decoded) const
+{
+    std::vector<TextureSource> sources;
+    sources.reserve(file_names.size());
+    for (const std::string &file_name : file_names) sources.push_back(TextureSource{ file_name, {} });
+    decode(sources, on_decoded);
+}
+
+void TextureDecoder::decode(const std::vector<TextureSource> &sources,
+  const std::function<void(size_t, TextureData &)> &on_decoded) const
+{
+    const size_t file_count = sources.size();
+    if (file_count == 0) return;
+
+    const uint32_t thread_count = resolveThreadCount(file_count);
+    if (thread_count <= 1) {
+        for (size_t i = 0; i < file_count; i++) {
+            TextureData data = decodeSource(sources[i]);
+            on_decoded(i, data);
+        }
+        return;
+    }
+
+    const size_t max_pending = static_cast<size_t>(thread_count) * std::max(1u, settings.max_pending_per_thread);
+
+    std::atomic<size_t> next_file{ 0 };
+    std::mutex mutex;
+    std::condition_variable decoded_condition;
+    std::condition_variable consumed_condition;
+    std::deque<std::pair<size_t, TextureData>> decoded;
+
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count);
+    for (uint32_t t = 0; t < thread_count; t++) {
+        workers.emplace_back([&]() {
+            for (size_t i = next_file.fetch_add(1); i < file_count; i = next_file.fetch_add(1)) {
+                TextureData data = decodeSource(sources[i]);
+
+                std::unique_lock<std::mutex> lock(mutex);
+                consumed_condition.wait(lock, [&]() { return decoded.size() < max_pending; });
+                decoded.emplace_back(i, std::move(data));
+                decoded_condition.notify_one();
+            }
+        });
+    }
+
+    for (size_t handed_out = 0; handed_out < file_count; handed_out++) {
+        std::pair<size_t, TextureData> next;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            decoded_condition.wait(lock, [&]() { return !decoded.empty(); });
+            next = std::move(decoded.front());
+            decoded.pop_front();
+        }
+        consumed_condition.notify_one();
+
+        on_decoded(next.first, next.second);
+    }
+
+    for (auto &worker : workers) worker.join();
+}
+
+uint32_t TextureDecoder::resolveThreadCount(size_t file_count) const
+{
+    uint32_t thread_count = settings.thread_count;
+    if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<uint32_t>(std::min<size_t>(thread_count, file_count));
+}
+
+TextureData TextureDecoder::decodeSource(const TextureSource &source) const
+{
+    TextureData data = source.encoded.empty() ? Texture::decodeFile(source.file_name, settings.format_support)
+                                              : Texture::decodeMemory(source.encoded, source.file_name);
+    if (settings.generate_mip_chain) Texture::generateMipChain(data);
+    return data;
+}
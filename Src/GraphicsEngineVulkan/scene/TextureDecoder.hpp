@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "scene/Texture.hpp"
+
+namespace Kataglyphis {
+
+struct TextureDecoderSettings
+{
+    // decoding threads; 0 picks the core count
+    uint32_t thread_count{ 0 };
+    // decoded images waiting for upload per thread; bounds the memory held by finished images
+    uint32_t max_pending_per_thread{ 2 };
+    // transcode targets for .ktx2 files; all false decodes them to RGBA8
+    TextureFormatSupport format_support;
+    // box filter the mips of single level images on the workers (see Texture::generateMipChain)
+    bool generate_mip_chain{ false };
+};
+
+// a texture file, or an encoded image already in memory (file_name is only logged then)
+struct TextureSource
+{
+    std::string file_name;
+    std::span<const std::byte> encoded;
+};
+
+// Decodes texture files on a pool of worker threads. Finished images are
+// handed back to the calling thread in completion order, so the GPU upload
+// (which has to stay on one thread) overlaps with the remaining decodes.
+class TextureDecoder
+{
+  public:
+    explicit TextureDecoder(TextureDecoderSettings settings = TextureDecoderSettings{});
+
+    // on_decoded(file index, data) runs on the calling thread once per file
+    void decode(const std::vector<std::string> &file_names,
+      const std::function<void(size_t, TextureData &)> &on_decoded) const;
+    // same for a mix of files and in-memory images; the encoded bytes have to outlive the call
+    void decode(const std::vector<TextureSource> &sources,
+      const std::function<void(size_t, TextureData &)> &on_decoded) const;
+
+  private:
+    TextureDecoderSettings settings;
+
+    uint32_t resolveThreadCount(size_t file_count) const;
+    TextureData decodeSource(const TextureSource &source) const;
+};
+
+}// namespace Kataglyphis
@@ -0,0 +1,393 @@
+#include "scene/TextureStreamer.hpp"
+
+#include "common/Globals.hpp"
+#include "scene/Model.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Kataglyphis;
+
+namespace {
+
+// one level a texture could gain or keep; the planner hands them out in order
+struct ResidencyStep
+{
+    size_t texture{ 0 };
+    uint32_t level{ 0 };
+    uint64_t last_wanted_frame{ 0 };
+};
+
+// coarse levels of all textures before the fine level of any; recently wanted textures first
+void sortSteps(std::vector<ResidencyStep> &steps)
+{
+    std::stable_sort(steps.begin(), steps.end(), [](const ResidencyStep &a, const ResidencyStep &b) {
+        if (a.level != b.level) return a.level > b.level;
+        return a.last_wanted_frame > b.last_wanted_frame;
+    });
+}
+
+VkDeviceSize residentSize(const TextureResidency &residency, uint32_t first_level)
+{
+    VkDeviceSize size = 0;
+    for (size_t level = first_level; level < residency.level_sizes.size(); level++) {
+        size += residency.level_sizes[level];
+    }
+    return size;
+}
+
+}// namespace
+
+TextureStreamer::TextureStreamer() {}
+
+void TextureStreamer::create(VulkanDevice *device,
+  VkCommandPool transfer_command_pool,
+  VkCommandPool graphics_command_pool,
+  TextureStreamingSettings settings,
+  TextureCache *texture_cache)
+{
+    this->device = device;
+    this->settings = settings;
+    this->texture_cache = texture_cache;
+
+    stream_uploader.create(device, transfer_command_pool, graphics_command_pool, 32ull << 20);
+
+    stats = TextureStreamingStats{};
+    stats.budget_bytes = settings.memory_budget;
+    bandwidth_window_start = std::chrono::steady_clock::now();
+    bandwidth_window_bytes = 0;
+}
+
+Texture TextureStreamer::addTexture(VulkanUploader &uploader,
+  uint32_t texture_slot,
+  TextureData &&textureData,
+  Model *model,
+  const TextureFootprint &footprint)
+{
+    Texture texture;
+
+    // stb images come without mips; the finer levels have to exist on the CPU to be streamed later
+    Texture::generateMipChain(textureData);
+    if (textureData.mip_levels.empty()) {
+        texture.createFromData(device, uploader, textureData);
+        return texture;
+    }
+
+    TextureResidency residency;
+    residency.level_sizes.reserve(textureData.mip_levels.size());
+    for (const TextureMipLevel &mip_level : textureData.mip_levels) residency.level_sizes.push_back(mip_level.size);
+
+    const uint32_t level_count = static_cast<uint32_t>(textureData.mip_levels.size());
+    residency.tail_level = level_count - 1;
+    for (uint32_t level = 0; level < level_count; level++) {
+        const TextureMipLevel &mip_level = textureData.mip_levels[level];
+        if (std::max(mip_level.width, mip_level.height) <= settings.mip_tail_size) {
+            residency.tail_level = level;
+            break;
+        }
+    }
+    residency.wanted_level = residency.tail_level;
+    residency.resident_level = residency.tail_level;
+
+    texture.createFromMipLevels(device, uploader, textureData, residency.tail_level);
+
+    const VkDeviceSize tail_size = residentSize(residency, residency.tail_level);
+    stats.streamed_bytes += tail_size;
+    bandwidth_window_bytes += tail_size;
+
+    StreamedTexture streamed;
+    streamed.texture_slot = texture_slot;
+    streamed.users.push_back(TextureUser{ model, footprint });
+    streamed.data = std::move(textureData);
+    textures.push_back(std::move(streamed));
+    residencies.push_back(std::move(residency));
+
+    updateStats();
+
+    return texture;
+}
+
+void TextureStreamer::addUser(uint32_t texture_slot, Model *model, const TextureFootprint &footprint)
+{
+    for (StreamedTexture &texture : textures) {
+        if (texture.texture_slot == texture_slot) {
+            texture.users.push_back(TextureUser{ model, footprint });
+            return;
+        }
+    }
+}
+
+void TextureStreamer::request(uint32_t texture_slot, uint32_t level)
+{
+    for (StreamedTexture &texture : textures) {
+        if (texture.texture_slot == texture_slot) {
+            texture.requested_level = std::min(texture.requested_level, level);
+            return;
+        }
+    }
+}
+
+bool TextureStreamer::update(const glm::vec3 &camera_position, float lod_scale)
+{
+    frame++;
+    releaseRetired();
+    stream_uploader.collect();
+    bool swapped = swapCompleted();
+    if (textures.empty()) return swapped;
+
+    for (size_t i = 0; i < textures.size(); i++) {
+        StreamedTexture &texture = textures[i];
+        TextureResidency &residency = residencies[i];
+        const uint32_t level_count = static_cast<uint32_t>(residency.level_sizes.size());
+        const uint32_t size = static_cast<uint32_t>(std::max(texture.data.width, texture.data.height));
+
+        // the closest placement of any model using the texture decides
+        residency.wanted_level = std::min(texture.requested_level, level_count - 1);
+        for (const TextureUser &user : texture.users) {
+            for (const glm::mat4 &placement : user.model->getPlacements()) {
+                residency.wanted_level = std::min(residency.wanted_level,
+                  desiredLevel(user.footprint,
+                    size,
+                    level_count,
+                    user.model->getModel() * placement,
+                    camera_position,
+                    lod_scale));
+            }
+        }
+        texture.requested_level = UINT32_MAX;
+        if (residency.wanted_level < residency.tail_level) residency.last_wanted_frame = frame;
+    }
+
+    stats.budget_bytes = effectiveBudget();
+    const std::vector<uint32_t> targets = planResidency(residencies, stats.budget_bytes);
+
+    // evict first, so the budget also holds while finer levels come in
+    for (size_t i = 0; i < textures.size(); i++) {
+        if (textures[i].pending || targets[i] <= residencies[i].resident_level) continue;
+        restream(i, targets[i]);
+        stats.evictions++;
+    }
+
+    uint32_t uploads = 0;
+    for (size_t i = 0; i < textures.size() && uploads < settings.max_uploads_per_frame; i++) {
+        if (textures[i].pending || targets[i] >= residencies[i].resident_level) continue;
+        restream(i, targets[i]);
+        uploads++;
+    }
+    stream_uploader.flush();
+
+    updateStats();
+    return swapped;
+}
+
+void TextureStreamer::restream(size_t texture, uint32_t resident_level)
+{
+    StreamedTexture &streamed = textures[texture];
+
+    PendingTexture rebuilt;
+    rebuilt.texture = texture;
+    rebuilt.resident_level = resident_level;
+    rebuilt.rebuilt.createFromMipLevels(device, stream_uploader, streamed.data, resident_level);
+    // taken afterwards: a full ring may have pushed the copy into the next batch
+    rebuilt.batch = stream_uploader.getRecordingBatch();
+    pending.push_back(rebuilt);
+    streamed.pending = true;
+
+    const VkDeviceSize uploaded = residentSize(residencies[texture], resident_level);
+    stats.streamed_bytes += uploaded;
+    bandwidth_window_bytes += uploaded;
+}
+
+bool TextureStreamer::swapCompleted()
+{
+    bool swapped = false;
+    size_t kept = 0;
+    for (PendingTexture &texture : pending) {
+        if (!stream_uploader.isComplete(texture.batch)) {
+            pending[kept++] = texture;
+            continue;
+        }
+
+        // frames still in flight may sample the old image; it goes once all of them are done
+        StreamedTexture &streamed = textures[texture.texture];
+        Texture &slot = texture_cache->getTexture(streamed.texture_slot);
+        retired.push_back({ slot, static_cast<uint32_t>(MAX_FRAME_DRAWS) + 1 });
+        slot = texture.rebuilt;
+
+        residencies[texture.texture].resident_level = texture.resident_level;
+        streamed.pending = false;
+        swapped = true;
+    }
+    pending.resize(kept);
+    return swapped;
+}
+
+void TextureStreamer::releaseRetired()
+{
+    size_t kept = 0;
+    for (RetiredTexture &texture : retired) {
+        if (--texture.frames_left == 0) {
+            texture.texture.cleanUp();
+        } else {
+            retired[kept++] = texture;
+        }
+    }
+    retired.resize(kept);
+}
+
+uint64_t TextureStreamer::effectiveBudget() const
+{
+    if (memory_headroom == UINT64_MAX) return settings.memory_budget;
+
+    // what is resident now plus what the driver still grants, minus room for everything else
+    const uint64_t available = stats.resident_bytes + memory_headroom;
+    if (available <= settings.memory_reserve) return 0;
+    return std::min(settings.memory_budget, available - settings.memory_reserve);
+}
+
+void TextureStreamer::updateStats()
+{
+    stats.texture_count = static_cast<uint32_t>(textures.size());
+    stats.resident_levels = 0;
+    stats.total_levels = 0;
+    stats.resident_bytes = 0;
+    stats.wanted_bytes = 0;
+    for (const TextureResidency &residency : residencies) {
+        const uint32_t level_count = static_cast<uint32_t>(residency.level_sizes.size());
+        stats.resident_levels += level_count - residency.resident_level;
+        stats.total_levels += level_count;
+        stats.resident_bytes += residentSize(residency, residency.resident_level);
+        stats.wanted_bytes += residentSize(residency, std::min(residency.wanted_level, residency.tail_level));
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(now - bandwidth_window_start).count();
+    if (seconds >= 1.0) {
+        stats.streamed_bytes_per_second = static_cast<double>(bandwidth_window_bytes) / seconds;
+        bandwidth_window_start = now;
+        bandwidth_window_bytes = 0;
+    }
+}
+
+void TextureStreamer::cleanUp()
+{
+    stream_uploader.cleanUp();
+
+    // the current images belong to the texture cache and are destroyed with it
+    for (PendingTexture &texture : pending) texture.rebuilt.cleanUp();
+    pending.clear();
+    for (RetiredTexture &texture : retired) texture.texture.cleanUp();
+    retired.clear();
+    textures.clear();
+    residencies.clear();
+}
+
+TextureStreamer::~TextureStreamer() {}
+
+std::vector<TextureFootprint> TextureStreamer::computeFootprints(std::span<const Vertex> vertices,
+  std::span<const unsigned int> indices,
+  std::span<const unsigned int> materialIndex,
+  std::span<const int> material_textures,
+  size_t texture_count)
+{
+    std::vector<TextureFootprint> footprints(texture_count);
+    std::vector<double> uv_area(texture_count, 0.0);
+    std::vector<double> surface_area(texture_count, 0.0);
+    std::vector<bool> used(texture_count, false);
+
+    const size_t triangle_count = std::min(indices.size() / 3, materialIndex.size());
+    for (size_t triangle = 0; triangle < triangle_count; triangle++) {
+        const unsigned int material = materialIndex[triangle];
+        if (material >= material_textures.size()) continue;
+        const int texture = material_textures[material];
+        if (texture < 0 || static_cast<size_t>(texture) >= texture_count) continue;
+
+        const Vertex &a = vertices[indices[triangle * 3 + 0]];
+        const Vertex &b = vertices[indices[triangle * 3 + 1]];
+        const Vertex &c = vertices[indices[triangle * 3 + 2]];
+
+        surface_area[texture] += 0.5 * glm::length(glm::cross(b.pos - a.pos, c.pos - a.pos));
+        const glm::vec2 uv_ab = b.texture_coords - a.texture_coords;
+        const glm::vec2 uv_ac = c.texture_coords - a.texture_coords;
+        uv_area[texture] += 0.5 * std::abs(uv_ab.x * uv_ac.y - uv_ab.y * uv_ac.x);
+
+        TextureFootprint &footprint = footprints[texture];
+        if (!used[texture]) {
+            footprint.bounds_min = a.pos;
+            footprint.bounds_max = a.pos;
+            used[texture] = true;
+        }
+        footprint.bounds_min = glm::min(footprint.bounds_min, glm::min(a.pos, glm::min(b.pos, c.pos)));
+        footprint.bounds_max = glm::max(footprint.bounds_max, glm::max(a.pos, glm::max(b.pos, c.pos)));
+    }
+
+    for (size_t texture = 0; texture < texture_count; texture++) {
+        if (surface_area[texture] > 0.0) {
+            footprints[texture].uv_density = static_cast<float>(std::sqrt(uv_area[texture] / surface_area[texture]));
+        }
+    }
+    return footprints;
+}
+
+uint32_t TextureStreamer::desiredLevel(const TextureFootprint &footprint,
+  uint32_t size,
+  uint32_t level_count,
+  const glm::mat4 &model,
+  const glm::vec3 &camera_position,
+  float lod_scale)
+{
+    if (level_count == 0) return 0;
+    if (footprint.uv_density <= 0.f) return level_count - 1;
+
+    // measured in object space, which only works out for uniformly scaled models
+    const glm::vec3 eye = glm::vec3(glm::inverse(model) * glm::vec4(camera_position, 1.f));
+    const glm::vec3 closest = glm::clamp(eye, footprint.bounds_min, footprint.bounds_max);
+    const float distance = glm::length(eye - closest);
+
+    // texels per object space unit against pixels per object space unit at that distance
+    const float texels_per_pixel = footprint.uv_density * static_cast<float>(size) * distance / lod_scale;
+    if (texels_per_pixel <= 1.f) return 0;
+    return std::min(level_count - 1, static_cast<uint32_t>(std::floor(std::log2(texels_per_pixel))));
+}
+
+std::vector<uint32_t> TextureStreamer::planResidency(const std::vector<TextureResidency> &textures, uint64_t budget)
+{
+    std::vector<uint32_t> targets(textures.size());
+    uint64_t used = 0;
+    for (size_t i = 0; i < textures.size(); i++) {
+        targets[i] = textures[i].tail_level;
+        used += residentSize(textures[i], textures[i].tail_level);
+    }
+
+    // grants levels in order; a texture can only gain a level right below its current target
+    auto grant = [&](std::vector<ResidencyStep> &steps) {
+        sortSteps(steps);
+        for (const ResidencyStep &step : steps) {
+            if (targets[step.texture] != step.level + 1) continue;
+            const VkDeviceSize size = textures[step.texture].level_sizes[step.level];
+            if (used + size > budget) continue;
+            used += size;
+            targets[step.texture] = step.level;
+        }
+    };
+
+    // what the view asks for
+    std::vector<ResidencyStep> steps;
+    for (size_t i = 0; i < textures.size(); i++) {
+        for (uint32_t level = textures[i].wanted_level; level < textures[i].tail_level; level++) {
+            steps.push_back({ i, level, textures[i].last_wanted_frame });
+        }
+    }
+    grant(steps);
+
+    // levels already resident stay while there is room; the least recently wanted go first
+    steps.clear();
+    for (size_t i = 0; i < textures.size(); i++) {
+        for (uint32_t level = textures[i].resident_level; level < targets[i]; level++) {
+            steps.push_back({ i, level, textures[i].last_wanted_frame });
+        }
+    }
+    grant(steps);
+
+    return targets;
+}
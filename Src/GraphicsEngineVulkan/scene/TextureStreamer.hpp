@@ -0,0 +1,188 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "scene/Texture.hpp"
+#include "scene/TextureCache.hpp"
+#include "scene/TextureStreamingStats.hpp"
+#include "scene/Vertex.hpp"
+
+namespace Kataglyphis {
+
+class Model;
+
+struct TextureStreamingSettings
+{
+    // device memory all streamed textures may occupy together
+    uint64_t memory_budget{ 256ull << 20 };
+    // device memory left to everything else once the driver budget, not memory_budget, is the limit
+    uint64_t memory_reserve{ 64ull << 20 };
+    // levels at most this many texels wide and high are uploaded at load time and never evicted
+    uint32_t mip_tail_size{ 64 };
+    // textures rebuilt with more levels per frame; bounds the per frame upload stall
+    uint32_t max_uploads_per_frame{ 2 };
+};
+
+// where a texture is mapped onto its model and how densely; drives its screen space demand
+struct TextureFootprint
+{
+    // object space bounds of all triangles using the texture
+    glm::vec3 bounds_min{ 0.f };
+    glm::vec3 bounds_max{ 0.f };
+    // texture coordinate units per object space unit, sqrt(uv area / surface area)
+    float uv_density{ 0.f };
+};
+
+// residency of one texture as seen by the planner; level 0 is full resolution
+struct TextureResidency
+{
+    std::vector<VkDeviceSize> level_sizes;
+    // this level and all coarser ones stay resident
+    uint32_t tail_level{ 0 };
+    // finest level the view asks for
+    uint32_t wanted_level{ 0 };
+    // finest level currently in device memory
+    uint32_t resident_level{ 0 };
+    // last frame the view asked for more than the tail; evictions go oldest first
+    uint64_t last_wanted_frame{ 0 };
+};
+
+// Keeps only the mip tail of every texture resident at load time and streams
+// in finer levels when the view gets close enough to resolve them. Demand is
+// estimated on the CPU from the texel density of each texture on its mesh
+// (the approach of texel factor based streamers); request() merges
+// additional demand, e.g. read back from shader feedback. Under the memory
+// budget coarse levels of all textures are granted before fine ones, and
+// levels nobody asks for any more are only evicted when space is needed.
+//
+// A texture changes residency by being rebuilt with a different level count.
+// The uploads of a frame go out in one batch on the transfer queue; once it
+// has completed, the image in the texture cache is swapped and the old one
+// destroyed when no frame in flight can reference it any more. Descriptors have
+// to be rewritten whenever update() returns true, and the frame has to take
+// over the new images with recordAcquires() before it samples them. A texture
+// shared by several models streams once, for the most demanding of them.
+class TextureStreamer
+{
+  public:
+    TextureStreamer();
+
+    void create(VulkanDevice *device,
+      VkCommandPool transfer_command_pool,
+      VkCommandPool graphics_command_pool,
+      TextureStreamingSettings settings,
+      TextureCache *texture_cache);
+
+    // takes over the decoded texture and records the upload of its mip tail into uploader; the
+    // returned texture belongs into texture_slot of the cache and is swapped out as levels stream in
+    Texture addTexture(VulkanUploader &uploader,
+      uint32_t texture_slot,
+      TextureData &&textureData,
+      Model *model,
+      const TextureFootprint &footprint);
+    // one more model mapping an already streamed texture; the one needing the finest level decides
+    void addUser(uint32_t texture_slot, Model *model, const TextureFootprint &footprint);
+
+    // asks for level of a texture in the current frame on top of the CPU estimate
+    void request(uint32_t texture_slot, uint32_t level);
+
+    // budget the driver has left in device local memory (see MemoryStats); the streamer shrinks
+    // its own budget to stay within it
+    void setMemoryHeadroom(uint64_t headroom) { memory_headroom = headroom; };
+
+    // call once per frame after its fences were waited on; true if textures were swapped
+    bool update(const glm::vec3 &camera_position, float lod_scale);
+    // queue family ownership of the swapped images; record ahead of the frame's draws
+    void recordAcquires(VkCommandBuffer graphics_command_buffer)
+    {
+        stream_uploader.recordAcquires(graphics_command_buffer);
+    };
+
+    const TextureStreamingStats &getStats() const { return stats; };
+
+    void cleanUp();
+
+    ~TextureStreamer();
+
+    // one footprint per texture id; material_textures maps a material to its texture id or -1
+    static std::vector<TextureFootprint> computeFootprints(std::span<const Vertex> vertices,
+      std::span<const unsigned int> indices,
+      std::span<const unsigned int> materialIndex,
+      std::span<const int> material_textures,
+      size_t texture_count);
+
+    // finest level worth having for a texture of size texels seen from camera_position
+    static uint32_t desiredLevel(const TextureFootprint &footprint,
+      uint32_t size,
+      uint32_t level_count,
+      const glm::mat4 &model,
+      const glm::vec3 &camera_position,
+      float lod_scale);
+
+    // finest level to keep resident per texture so that all of them fit into budget
+    static std::vector<uint32_t> planResidency(const std::vector<TextureResidency> &textures, uint64_t budget);
+
+  private:
+    struct TextureUser
+    {
+        Model *model{ nullptr };
+        TextureFootprint footprint;
+    };
+
+    struct StreamedTexture
+    {
+        uint32_t texture_slot{ 0 };
+        std::vector<TextureUser> users;
+        TextureData data;
+        uint32_t requested_level{ UINT32_MAX };
+        // a rebuilt image is on its way; no other change until it landed
+        bool pending{ false };
+    };
+
+    struct PendingTexture
+    {
+        size_t texture{ 0 };
+        Texture rebuilt;
+        uint32_t resident_level{ 0 };
+        // uploader batch that has to complete first
+        uint64_t batch{ 0 };
+    };
+
+    struct RetiredTexture
+    {
+        Texture texture;
+        uint32_t frames_left{ 0 };
+    };
+
+    VulkanDevice *device{ VK_NULL_HANDLE };
+    TextureCache *texture_cache{ nullptr };
+    TextureStreamingSettings settings;
+    // stays alive across frames so streaming never waits for its own uploads
+    VulkanUploader stream_uploader;
+
+    std::vector<StreamedTexture> textures;
+    // parallel to textures, handed to planResidency as is
+    std::vector<TextureResidency> residencies;
+    std::vector<PendingTexture> pending;
+    std::vector<RetiredTexture> retired;
+    uint64_t frame{ 0 };
+    uint64_t memory_headroom{ UINT64_MAX };
+    uint64_t effectiveBudget() const;
+
+    TextureStreamingStats stats;
+    std::chrono::steady_clock::time_point bandwidth_window_start;
+    uint64_t bandwidth_window_bytes{ 0 };
+
+    void restream(size_t texture, uint32_t resident_level);
+    bool swapCompleted();
+    void releaseRetired();
+    void updateStats();
+};
+
+}// namespace Kataglyphis
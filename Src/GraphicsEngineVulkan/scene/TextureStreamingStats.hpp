@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+
+namespace Kataglyphis {
+
+// snapshot of the texture streamer, shown in the GUI
+struct TextureStreamingStats
+{
+    uint32_t texture_count{ 0 };
+    // mip levels in device memory out of all levels of all streamed textures
+    uint32_t resident_levels{ 0 };
+    uint32_t total_levels{ 0 };
+    uint64_t resident_bytes{ 0 };
+    uint64_t budget_bytes{ 0 };
+    // what the current view would like to have resident
+    uint64_t wanted_bytes{ 0 };
+    uint64_t streamed_bytes{ 0 };
+    // upload rate averaged over the last second
+    double streamed_bytes_per_second{ 0.0 };
+    uint32_t evictions{ 0 };
+};
+
+}// namespace Kataglyphis
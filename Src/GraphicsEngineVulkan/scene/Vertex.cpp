@@ -1,4 +1,5 @@
 #include "scene/Vertex.hpp"
+#include "scene/CompactVertex.hpp"
 
 Vertex::Vertex()
 {
@@ -55,4 +56,35 @@ std::array<VkVertexInputAttributeDescription, 4> getVertexInputAttributeDesc()
     return attribute_describtions;
 }
 
+std::array<VkVertexInputAttributeDescription, 4> getCompactVertexInputAttributeDesc()
+{
+    std::array<VkVertexInputAttributeDescription, 4> attribute_describtions;
+
+    // Position attribute; all four lanes because 3 component 16 bit formats are optional
+    attribute_describtions[0].binding = 0;
+    attribute_describtions[0].location = 0;
+    attribute_describtions[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+    attribute_describtions[0].offset = offsetof(CompactVertex, position);
+
+    // octahedral normal attribute
+    attribute_describtions[1].binding = 0;
+    attribute_describtions[1].location = 1;
+    attribute_describtions[1].format = VK_FORMAT_R16G16_SNORM;
+    attribute_describtions[1].offset = offsetof(CompactVertex, normal);
+
+    // RGB565 color in the 4th position lane
+    attribute_describtions[2].binding = 0;
+    attribute_describtions[2].location = 2;
+    attribute_describtions[2].format = VK_FORMAT_R16_UINT;
+    attribute_describtions[2].offset = offsetof(CompactVertex, position) + 3 * sizeof(int16_t);
+
+    // texture coord attribute
+    attribute_describtions[3].binding = 0;
+    attribute_describtions[3].location = 3;
+    attribute_describtions[3].format = VK_FORMAT_R16G16_SFLOAT;
+    attribute_describtions[3].offset = offsetof(CompactVertex, texture_coords);
+
+    return attribute_describtions;
+}
+
 }// namespace vertex
@@ -12,6 +12,8 @@
 #include <glm/gtx/hash.hpp>
 #include <vector>
 
+#include "util/Hash.hpp"
+
 class Vertex
 {
   public:
@@ -32,6 +34,9 @@ class Vertex
 namespace vertex {
 
 std::array<VkVertexInputAttributeDescription, 4> getVertexInputAttributeDesc();
+// same locations for the CompactVertex layout: position as vec4 (xyz used), normal as
+// octahedral vec2, color as the raw RGB565 uint and texture coordinates as vec2
+std::array<VkVertexInputAttributeDescription, 4> getCompactVertexInputAttributeDesc();
 
 }
 
@@ -40,12 +45,12 @@ template<> struct hash<Vertex>
 {
     size_t operator()(Vertex const &vertex) const
     {
+        // only hash what operator== compares; color must stay out
         size_t h1 = hash<glm::vec3>()(vertex.pos);
-        size_t h2 = hash<glm::vec3>()(vertex.color);
+        size_t h2 = hash<glm::vec3>()(vertex.normal);
         size_t h3 = hash<glm::vec2>()(vertex.texture_coords);
-        size_t h4 = hash<glm::vec3>()(vertex.normal);
 
-        return (((((((h2 << 1) ^ h1) >> 1) ^ h3) << 1) ^ h4));
+        return Kataglyphis::combineHash64(Kataglyphis::combineHash64(h1, h2), h3);
     }
 };
 }// namespace std
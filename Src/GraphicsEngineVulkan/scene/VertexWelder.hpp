@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "scene/Vertex.hpp"
+
+namespace Kataglyphis {
+
+struct VertexWeldSettings
+{
+    // 0 welds exactly (same semantics as Vertex::operator==); a positive value
+    // snaps positions to a grid with this cell size before comparing
+    float position_epsilon{ 0.0f };
+    // number of hash shards welded in parallel; 0 picks the core count
+    uint32_t shard_count{ 0 };
+};
+
+// Merges duplicate vertices. The input is split into shards by hash and every
+// shard is welded on its own thread with a flat open-addressing table, so no
+// per-vertex allocation happens. Unique vertices keep their first-occurrence
+// order, hence the result does not depend on the shard count.
+class VertexWelder
+{
+  public:
+    explicit VertexWelder(VertexWeldSettings settings = VertexWeldSettings{});
+
+    // remap[i] receives the index into vertices for input[i]
+    void weld(std::span<const Vertex> input, std::vector<Vertex> &vertices, std::vector<uint32_t> &remap) const;
+
+    // hash over exactly the fields that take part in the comparison
+    static uint64_t hashVertex(const Vertex &vertex, float position_epsilon = 0.0f);
+    static bool equalVertices(const Vertex &a, const Vertex &b, float position_epsilon = 0.0f);
+
+  private:
+    VertexWeldSettings settings;
+
+    uint32_t resolveShardCount(size_t vertex_count) const;
+};
+
+}// namespace Kataglyphis
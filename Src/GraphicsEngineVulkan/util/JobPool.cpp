@@ -0,0 +1,67 @@
+#include "util/JobPool.hpp"
+
+#include <algorithm>
+
+Kataglyphis::JobPool::JobPool() {}
+
+uint32_t Kataglyphis::JobPool::hardwareThreads() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+void Kataglyphis::JobPool::run(uint32_t job_count, const std::function<void(uint32_t)> &job)
+{
+    if (job_count == 0) return;
+    if (job_count == 1) {
+        job(0);
+        return;
+    }
+
+    // more workers than jobs would only wake up to find nothing left
+    const uint32_t worker_count = std::min(job_count, hardwareThreads()) - 1;
+    while (workers.size() < worker_count) { workers.emplace_back([this]() { workerLoop(); }); }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch_job = &job;
+        batch_size = job_count;
+        next_job.store(0, std::memory_order_relaxed);
+        busy_workers = static_cast<uint32_t>(workers.size());
+        generation++;
+    }
+    work_ready.notify_all();
+
+    runJobs();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this]() { return busy_workers == 0; });
+    batch_job = nullptr;
+}
+
+Kataglyphis::JobPool::~JobPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (std::thread &worker : workers) worker.join();
+}
+
+void Kataglyphis::JobPool::runJobs()
+{
+    for (uint32_t job = next_job.fetch_add(1); job < batch_size; job = next_job.fetch_add(1)) { (*batch_job)(job); }
+}
+
+void Kataglyphis::JobPool::workerLoop()
+{
+    uint64_t seen_generation = 0;
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        work_ready.wait(lock, [&]() { return stopping || generation != seen_generation; });
+        if (stopping) return;
+        seen_generation = generation;
+
+        lock.unlock();
+        runJobs();
+        lock.lock();
+        if (--busy_workers == 0) work_done.notify_one();
+    }
+}
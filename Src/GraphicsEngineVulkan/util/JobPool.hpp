@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Kataglyphis {
+// Runs batches of jobs on workers that are started on first use and stay asleep
+// between batches. The calling thread takes part as well, so a batch of n jobs
+// needs n - 1 workers; every job index runs exactly once and on one thread only.
+class JobPool
+{
+  public:
+    JobPool();
+    JobPool(const JobPool &) = delete;
+    JobPool &operator=(const JobPool &) = delete;
+
+    // number of jobs that can make progress at the same time
+    static uint32_t hardwareThreads();
+
+    // calls job(0) ... job(job_count - 1) and returns once all of them finished
+    void run(uint32_t job_count, const std::function<void(uint32_t)> &job);
+
+    ~JobPool();
+
+  private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    uint64_t generation{ 0 };
+    uint32_t busy_workers{ 0 };
+    bool stopping{ false };
+
+    // the batch in flight
+    const std::function<void(uint32_t)> *batch_job{ nullptr };
+    uint32_t batch_size{ 0 };
+    std::atomic<uint32_t> next_job{ 0 };
+
+    void runJobs();
+    void workerLoop();
+};
+}// namespace Kataglyphis
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** @defgroup FileUtilities File Utilities
+ *  @{
+ */
+namespace Kataglyphis {
+// read-only memory mapping of a whole file; the OS pages data in on demand
+// so large binary assets can be consumed without an intermediate copy
+class MappedFile
+{
+  public:
+    MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &file_location);
+    void close();
+
+    bool isOpen() const { return mapped_data != nullptr; };
+    const std::byte *data() const { return static_cast<const std::byte *>(mapped_data); };
+    size_t size() const { return mapped_size; };
+
+    ~MappedFile();
+
+  private:
+    void *mapped_data{ nullptr };
+    size_t mapped_size{ 0 };
+
+#ifdef _WIN32
+    void *file_handle{ nullptr };
+    void *mapping_handle{ nullptr };
+#endif
+};
+}// namespace Kataglyphis
+/** @} */// End of File utilities group
@@ -10,7 +10,9 @@
 
 Kataglyphis::ShaderHelper::ShaderHelper() {}
 
-void Kataglyphis::ShaderHelper::compileShader(const std::string &shader_src_dir, const std::string &shader_name)
+void Kataglyphis::ShaderHelper::compileShader(const std::string &shader_src_dir,
+  const std::string &shader_name,
+  const std::vector<std::string> &defines)
 {
     // GLSLC_EXE is set by cmake to the location of the vulkan glslc
     std::stringstream shader_src_path;
@@ -29,6 +31,7 @@ void Kataglyphis::ShaderHelper::compileShader(const std::string &shader_src_dir,
     cmdShaderCompile//<< adminPriviliges.str()
       << GLSLC_EXE << target << std::quoted(shader_src_path.str()) << " -o " << std::quoted(shader_spv_path)
       << ShaderIncludes::getShaderIncludes();
+    for (const std::string &define : defines) { cmdShaderCompile << " -D" << define; }
     //<< log_stdout_and_stderr.str();
 
     spdlog::info("The shader compile command is the following: {}", cmdShaderCompile.str());
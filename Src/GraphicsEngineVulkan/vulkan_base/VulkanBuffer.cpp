@@ -2,7 +2,6 @@
 
 #include <stdexcept>
 
-#include "common/MemoryHelper.hpp"
 #include "common/Utilities.hpp"
 
 Kataglyphis::VulkanBuffer::VulkanBuffer() {}
@@ -10,7 +9,8 @@ Kataglyphis::VulkanBuffer::VulkanBuffer() {}
 void Kataglyphis::VulkanBuffer::create(VulkanDevice *device,
   VkDeviceSize buffer_size,
   VkBufferUsageFlags buffer_usage_flags,
-  VkMemoryPropertyFlags buffer_propertiy_flags)
+  VkMemoryPropertyFlags buffer_propertiy_flags,
+  MemoryClass memory_class)
 {
     this->device = device;
 
@@ -23,45 +23,19 @@ void Kataglyphis::VulkanBuffer::create(VulkanDevice *device,
     // similar to swap chain images, can share vertex buffers
     buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    VkResult result = vkCreateBuffer(device->getLogicalDevice(), &buffer_info, nullptr, &buffer);
+    // the allocator picks the memory type and sub-allocates from the pool of the buffer's class
+    VmaAllocationInfo allocation_info{};
+    VkResult result = device->getAllocator().createBuffer(
+      buffer_info, buffer_propertiy_flags, memory_class, buffer, allocation, allocation_info);
     ASSERT_VULKAN(result, "Failed to create a buffer!");
 
-    // get buffer memory requirements
-    VkMemoryRequirements memory_requirements{};
-    vkGetBufferMemoryRequirements(device->getLogicalDevice(), buffer, &memory_requirements);
-
-    // allocate memory to buffer
-    VkMemoryAllocateInfo memory_alloc_info{};
-    memory_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memory_alloc_info.allocationSize = memory_requirements.size;
-
-    uint32_t memory_type_index = Kataglyphis::find_memory_type_index(
-      device->getPhysicalDevice(), memory_requirements.memoryTypeBits, buffer_propertiy_flags);
-
-    // VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |		/* memory is visible to
-    // CPU side
-    // */ VK_MEMORY_PROPERTY_HOST_COHERENT_BIT	/* data is placed straight into
-    // buffer */);
-    if (memory_type_index < 0) { spdlog::error("Failed to find suitable memory type!"); }
-
-    memory_alloc_info.memoryTypeIndex = memory_type_index;
-
-    // allocate memory to VkDeviceMemory
-    result = vkAllocateMemory(device->getLogicalDevice(), &memory_alloc_info, nullptr, &bufferMemory);
-    ASSERT_VULKAN(result, "Failed to allocate memory for buffer!");
-
-    // allocate memory to given buffer
-    vkBindBufferMemory(device->getLogicalDevice(), buffer, bufferMemory, 0);
-
-    created = true;
+    mapped_data = allocation_info.pMappedData;
+    created = result == VK_SUCCESS;
 }
 
 void Kataglyphis::VulkanBuffer::cleanUp()
 {
-    if (created) {
-        vkDestroyBuffer(device->getLogicalDevice(), buffer, nullptr);
-        vkFreeMemory(device->getLogicalDevice(), bufferMemory, nullptr);
-    }
+    if (created) { device->getAllocator().destroyBuffer(buffer, allocation); }
 }
 
 Kataglyphis::VulkanBuffer::~VulkanBuffer() {}
@@ -8,15 +8,19 @@ class VulkanBuffer
   public:
     VulkanBuffer();
 
+    // memory comes from the device's allocator; host visible buffers stay mapped for their whole life
     void create(VulkanDevice *vulkanDevice,
       VkDeviceSize buffer_size,
       VkBufferUsageFlags buffer_usage_flags,
-      VkMemoryPropertyFlags buffer_propertiy_flags);
+      VkMemoryPropertyFlags buffer_propertiy_flags,
+      MemoryClass memory_class = MemoryClass::FROM_USAGE);
 
     void cleanUp();
 
     VkBuffer &getBuffer() { return buffer; };
-    VkDeviceMemory &getBufferMemory() { return bufferMemory; };
+    VmaAllocation getAllocation() { return allocation; };
+    // nullptr unless the buffer is host visible
+    void *getMappedData() { return mapped_data; };
 
     ~VulkanBuffer();
 
@@ -24,8 +28,9 @@ class VulkanBuffer
     VulkanDevice *device{ VK_NULL_HANDLE };
 
     VkBuffer buffer{ VK_NULL_HANDLE };
-    VkDeviceMemory bufferMemory{ VK_NULL_HANDLE };
+    VmaAllocation allocation{ VK_NULL_HANDLE };
+    void *mapped_data{ nullptr };
 
     bool created{ false };
 };
-}// namespace Kataglyphis
\ No newline at end of file
+}// namespace Kataglyphis
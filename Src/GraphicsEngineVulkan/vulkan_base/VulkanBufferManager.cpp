@@ -55,4 +55,49 @@ void Kataglyphis::VulkanBufferManager::copyImageBuffer(VkDevice device,
       device, transfer_command_pool, transfer_queue, transfer_command_buffer);
 }
 
+void Kataglyphis::VulkanBufferManager::createBufferAndUploadDataOnDevice(VulkanDevice *device,
+  VkCommandPool commandPool,
+  VulkanBuffer &vulkanBuffer,
+  VkBufferUsageFlags dstBufferUsageFlags,
+  VkMemoryPropertyFlags dstBufferMemoryPropertyFlags,
+  const void *bufferData,
+  VkDeviceSize bufferSize)
+{
+    // temporary buffer to "stage" vertex data before transfering to GPU
+    VulkanBuffer stagingBuffer;
+
+    // create buffer and allocate memory to it
+    stagingBuffer.create(device,
+      bufferSize,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // staging buffers come back persistently mapped
+    std::memcpy(stagingBuffer.getMappedData(), bufferData, static_cast<size_t>(bufferSize));
+
+    // create buffer with TRANSFER_DST_BIT to mark as recipient of transfer data
+    // (also VERTEX_BUFFER) buffer memory is to be DEVICE_LOCAL_BIT meaning memory
+    // is on the GPU and only accessible by it and not CPU (host)
+    vulkanBuffer.create(device, bufferSize, dstBufferUsageFlags, dstBufferMemoryPropertyFlags);
+
+    // copy staging buffer to vertex buffer on GPU
+    copyBuffer(
+      device->getLogicalDevice(), device->getGraphicsQueue(), commandPool, stagingBuffer, vulkanBuffer, bufferSize);
+
+    stagingBuffer.cleanUp();
+}
+
+void Kataglyphis::VulkanBufferManager::createBufferAndUploadDataOnDevice(VulkanDevice *device,
+  VulkanUploader &uploader,
+  VulkanBuffer &vulkanBuffer,
+  VkBufferUsageFlags dstBufferUsageFlags,
+  VkMemoryPropertyFlags dstBufferMemoryPropertyFlags,
+  const void *bufferData,
+  VkDeviceSize bufferSize)
+{
+    vulkanBuffer.create(device, bufferSize, dstBufferUsageFlags, dstBufferMemoryPropertyFlags);
+
+    uploader.uploadBuffer(vulkanBuffer.getBuffer(), bufferData, bufferSize);
+}
+
 Kataglyphis::VulkanBufferManager::~VulkanBufferManager() {}
@@ -6,6 +6,7 @@
 #include "renderer/CommandBufferManager.hpp"
 
 #include "vulkan_base/VulkanBuffer.hpp"
+#include "vulkan_base/VulkanUploader.hpp"
 
 #include <cstring>
 
@@ -30,6 +31,23 @@ class VulkanBufferManager
       uint32_t width,
       uint32_t height);
 
+    void createBufferAndUploadDataOnDevice(VulkanDevice *device,
+      VkCommandPool commandPool,
+      VulkanBuffer &vulkanBuffer,
+      VkBufferUsageFlags dstBufferUsageFlags,
+      VkMemoryPropertyFlags dstBufferMemoryPropertyFlags,
+      const void *data,
+      VkDeviceSize bufferSize);
+
+    // records the copy into the uploader's current batch instead of waiting for it
+    void createBufferAndUploadDataOnDevice(VulkanDevice *device,
+      VulkanUploader &uploader,
+      VulkanBuffer &vulkanBuffer,
+      VkBufferUsageFlags dstBufferUsageFlags,
+      VkMemoryPropertyFlags dstBufferMemoryPropertyFlags,
+      const void *data,
+      VkDeviceSize bufferSize);
+
     template<typename T>
     void createBufferAndUploadVectorOnDevice(VulkanDevice *device,
       VkCommandPool commandPool,
@@ -52,36 +70,12 @@ inline void VulkanBufferManager::createBufferAndUploadVectorOnDevice(VulkanDevic
   VkMemoryPropertyFlags dstBufferMemoryPropertyFlags,
   std::vector<T> &bufferData)
 {
-    VkDeviceSize bufferSize = sizeof(T) * bufferData.size();
-
-    // temporary buffer to "stage" vertex data before transfering to GPU
-    VulkanBuffer stagingBuffer;
-
-    // create buffer and allocate memory to it
-    stagingBuffer.create(device,
-      bufferSize,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-    // Map memory to vertex buffer
-    // 1.) create pointer to a point in normal memory
-    void *data;
-    // 2.) map the vertex buffer memory to that point
-    vkMapMemory(device->getLogicalDevice(), stagingBuffer.getBufferMemory(), 0, bufferSize, 0, &data);
-    // 3.) copy memory from vertices vector to the point
-    std::memcpy(data, bufferData.data(), static_cast<size_t>(bufferSize));
-    // 4.) unmap the vertex buffer memory
-    vkUnmapMemory(device->getLogicalDevice(), stagingBuffer.getBufferMemory());
-
-    // create buffer with TRANSFER_DST_BIT to mark as recipient of transfer data
-    // (also VERTEX_BUFFER) buffer memory is to be DEVICE_LOCAL_BIT meaning memory
-    // is on the GPU and only accessible by it and not CPU (host)
-    vulkanBuffer.create(device, bufferSize, dstBufferUsageFlags, dstBufferMemoryPropertyFlags);
-
-    // copy staging buffer to vertex buffer on GPU
-    copyBuffer(
-      device->getLogicalDevice(), device->getGraphicsQueue(), commandPool, stagingBuffer, vulkanBuffer, bufferSize);
-
-    stagingBuffer.cleanUp();
+    createBufferAndUploadDataOnDevice(device,
+      commandPool,
+      vulkanBuffer,
+      dstBufferUsageFlags,
+      dstBufferMemoryPropertyFlags,
+      bufferData.data(),
+      sizeof(T) * bufferData.size());
 }
 }// namespace Kataglyphis
@@ -4,6 +4,7 @@
 
 #include "common/Utilities.hpp"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 #include <set>
 #include <stdexcept>
 #include <string>
@@ -21,49 +22,17 @@ Kataglyphis::VulkanRendererInternals::SwapChainDetails Kataglyphis::VulkanDevice
     return getSwapchainDetails(physical_device);
 }
 
-void Kataglyphis::VulkanDevice::cleanUp() { vkDestroyDevice(logical_device, nullptr); }
+void Kataglyphis::VulkanDevice::cleanUp()
+{
+    allocator.cleanUp();
+    vkDestroyDevice(logical_device, nullptr);
+}
 
 Kataglyphis::VulkanDevice::~VulkanDevice() {}
 
 Kataglyphis::VulkanRendererInternals::QueueFamilyIndices Kataglyphis::VulkanDevice::getQueueFamilies()
 {
-    Kataglyphis::VulkanRendererInternals::QueueFamilyIndices indices{};
-
-    uint32_t queue_family_count = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
-
-    std::vector<VkQueueFamilyProperties> queue_family_list(queue_family_count);
-    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_family_list.data());
-
-    // Go through each queue family and check if it has at least 1 of required
-    // types we need to keep track th eindex by our own
-    int index = 0;
-    for (const auto &queue_family : queue_family_list) {
-        // first check if queue family has at least 1 queue in that family
-        // Queue can be multiple types defined through bitfield. Need to bitwise AND
-        // with VK_QUE_*_BIT to check if has required  type
-        if (queue_family.queueCount > 0 && queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-            indices.graphics_family = index;// if queue family valid, than get index
-        }
-
-        if (queue_family.queueCount > 0 && queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT) {
-            indices.compute_family = index;
-        }
-
-        // check if queue family suppports presentation
-        VkBool32 presentation_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, index, *surface, &presentation_support);
-        // check if queue is presentation type (can be both graphics and
-        // presentation)
-        if (queue_family.queueCount > 0 && presentation_support) { indices.presentation_family = index; }
-
-        // check if queue family indices are in a valid state
-        if (indices.is_valid()) { break; }
-
-        index++;
-    }
-
-    return indices;
+    return getQueueFamilies(physical_device);
 }
 
 void Kataglyphis::VulkanDevice::get_physical_device()
@@ -98,7 +67,7 @@ void Kataglyphis::VulkanDevice::create_logical_device()
     // vector for queue creation information and set for family indices
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
     std::set<int> queue_family_indices = {
-        indices.graphics_family, indices.presentation_family, indices.compute_family
+        indices.graphics_family, indices.presentation_family, indices.compute_family, indices.transfer_family
     };
 
     // Queue the logical device needs to create and info to do so (only 1 for now,
@@ -178,6 +147,8 @@ void Kataglyphis::VulkanDevice::create_logical_device()
     features2.features.shaderInt64 = VK_TRUE;
     features2.features.geometryShader = VK_TRUE;
     features2.features.logicOp = VK_TRUE;
+    features2.features.multiDrawIndirect = VK_TRUE;
+    features2.features.drawIndirectFirstInstance = VK_TRUE;
 
     // -- PREPARE FOR HAVING MORE EXTENSION BECAUSE WE NEED RAYTRACING
     // CAPABILITIES
@@ -210,6 +181,74 @@ void Kataglyphis::VulkanDevice::create_logical_device()
           extensions.begin(), device_extensions_for_raytracing.begin(), device_extensions_for_raytracing.end());
     }
 
+    // the culled draws read their meshlets by buffer device address, which is only enabled together
+    // with the ray tracing features above
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(physical_device, &supported_features);
+    deviceSupportsDrawIndirectCount = deviceSupportsHardwareAcceleratedRRT
+                                      && isExtensionSupported(device_extension_draw_indirect_count)
+                                      && supported_features.multiDrawIndirect == VK_TRUE
+                                      && supported_features.drawIndirectFirstInstance == VK_TRUE;
+    if (deviceSupportsDrawIndirectCount) {
+        extensions.push_back(device_extension_draw_indirect_count);
+    } else {
+        features2.features.multiDrawIndirect = VK_FALSE;
+        features2.features.drawIndirectFirstInstance = VK_FALSE;
+        spdlog::info("GPU culling not supported; rasterizer falls back to plain draws");
+    }
+
+    // bindless textures: one table for the textures of all models that is written while bound and
+    // only as far as it is used. Descriptor indexing does not depend on ray tracing; without it the
+    // indexing features get a feature chain of their own below
+    VkPhysicalDeviceDescriptorIndexingFeatures supported_indexing_features{};
+    supported_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    VkPhysicalDeviceFeatures2 supported_features2{};
+    supported_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported_features2.pNext = &supported_indexing_features;
+    vkGetPhysicalDeviceFeatures2(physical_device, &supported_features2);
+
+    const VkPhysicalDeviceDescriptorIndexingFeatures &supported = supported_indexing_features;
+    deviceSupportsBindlessTextures = supported.runtimeDescriptorArray == VK_TRUE
+                                     && supported.shaderSampledImageArrayNonUniformIndexing == VK_TRUE
+                                     && supported.descriptorBindingPartiallyBound == VK_TRUE
+                                     && supported.descriptorBindingVariableDescriptorCount == VK_TRUE
+                                     && supported.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE;
+    if (deviceSupportsBindlessTextures) {
+        indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+        indexing_features.descriptorBindingVariableDescriptorCount = VK_TRUE;
+        indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+
+        VkPhysicalDeviceDescriptorIndexingProperties indexing_properties{};
+        indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &indexing_properties;
+        vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+
+        // every texture has a sampler of its own slot next to it; the shaders' fixed arrays bound the table
+        texture_table_size = std::min({ static_cast<uint32_t>(MAX_TEXTURE_COUNT),
+          indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+          indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+          indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+          indexing_properties.maxDescriptorSetUpdateAfterBindSamplers });
+        spdlog::info("Bindless textures: table of {} textures", texture_table_size);
+
+        // the ray tracing extensions already contain descriptor indexing
+        if (!deviceSupportsHardwareAcceleratedRRT
+            && isExtensionSupported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+            extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        }
+    } else {
+        spdlog::info("Bindless textures not supported; binding at most {} textures", texture_table_size);
+    }
+
+    const bool memory_budget = isExtensionSupported(device_extension_memory_budget);
+    if (memory_budget) {
+        extensions.push_back(device_extension_memory_budget);
+    } else {
+        spdlog::info("{} not supported; memory budgets are estimated", device_extension_memory_budget);
+    }
+
     // information to create logical device (sometimes called "device")
     VkDeviceCreateInfo device_create_info{};
     device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -223,7 +262,16 @@ void Kataglyphis::VulkanDevice::create_logical_device()
     device_create_info.flags = 0;
     device_create_info.pEnabledFeatures = NULL;
 
-    if (deviceSupportsHardwareAcceleratedRRT) { device_create_info.pNext = &features2; }
+    // without ray tracing only the descriptor indexing features are chained; the core features of
+    // features2 stay disabled there as before
+    VkPhysicalDeviceFeatures2 indexing_features2{};
+    indexing_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    indexing_features2.pNext = &indexing_features;
+    if (deviceSupportsHardwareAcceleratedRRT) {
+        device_create_info.pNext = &features2;
+    } else if (deviceSupportsBindlessTextures) {
+        device_create_info.pNext = &indexing_features2;
+    }
 
     // create logical device for the given physical device
     VkResult result = vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device);
@@ -236,6 +284,14 @@ void Kataglyphis::VulkanDevice::create_logical_device()
     vkGetDeviceQueue(logical_device, indices.graphics_family, 0, &graphics_queue);
     vkGetDeviceQueue(logical_device, indices.presentation_family, 0, &presentation_queue);
     vkGetDeviceQueue(logical_device, indices.compute_family, 0, &compute_queue);
+    vkGetDeviceQueue(logical_device, indices.transfer_family, 0, &transfer_queue);
+
+    dedicated_transfer_queue = indices.transfer_family != indices.graphics_family;
+    if (dedicated_transfer_queue) {
+        spdlog::info("Uploads run on the dedicated transfer queue family {}", indices.transfer_family);
+    }
+
+    allocator = Allocator(logical_device, physical_device, instance->getVulkanInstance(), memory_budget);
 }
 
 Kataglyphis::VulkanRendererInternals::QueueFamilyIndices Kataglyphis::VulkanDevice::getQueueFamilies(
@@ -277,6 +333,17 @@ Kataglyphis::VulkanRendererInternals::QueueFamilyIndices Kataglyphis::VulkanDevi
         index++;
     }
 
+    // a family that can only copy maps to the DMA engines, which run in parallel to graphics work
+    indices.transfer_family = indices.graphics_family;
+    for (uint32_t family = 0; family < queue_family_count; family++) {
+        const VkQueueFamilyProperties &queue_family = queue_family_list[family];
+        if (queue_family.queueCount > 0 && (queue_family.queueFlags & VK_QUEUE_TRANSFER_BIT)
+            && !(queue_family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            indices.transfer_family = static_cast<int>(family);
+            break;
+        }
+    }
+
     return indices;
 }
 
@@ -3,6 +3,8 @@
 
 #include <vector>
 
+#include "hostDevice/host_device_shared_vars.hpp"
+#include "memory/Allocator.hpp"
 #include "renderer/QueueFamilyIndices.hpp"
 #include "renderer/SwapChainDetails.hpp"
 #include "vulkan_base/VulkanInstance.hpp"
@@ -36,8 +38,18 @@ class VulkanDevice
     VkQueue getGraphicsQueue() const { return graphics_queue; };
     VkQueue getComputeQueue() const { return compute_queue; };
     VkQueue getPresentationQueue() const { return presentation_queue; };
+    // runs uploads next to rendering; the graphics queue if there is no transfer only family
+    VkQueue getTransferQueue() const { return transfer_queue; };
+    bool hasDedicatedTransferQueue() { return dedicated_transfer_queue; };
     Kataglyphis::VulkanRendererInternals::SwapChainDetails getSwapchainDetails();
+    // every buffer and image of the device is allocated through it
+    Allocator &getAllocator() { return allocator; };
     bool supportsHardwareAcceleratedRRT() { return deviceSupportsHardwareAcceleratedRRT; };
+    bool supportsDrawIndirectCount() { return deviceSupportsDrawIndirectCount; };
+    // partially bound, update after bind texture table with a variable descriptor count
+    bool supportsBindlessTextures() { return deviceSupportsBindlessTextures; };
+    // texture descriptors of the shared render set; texture ids of materials index this table
+    uint32_t getTextureTableSize() { return texture_table_size; };
 
     void cleanUp();
 
@@ -48,6 +60,7 @@ class VulkanDevice
     VkPhysicalDeviceProperties device_properties;
 
     VkDevice logical_device;
+    Allocator allocator;
 
     VulkanInstance *instance;
     VkSurfaceKHR *surface;
@@ -56,7 +69,12 @@ class VulkanDevice
     VkQueue graphics_queue;
     VkQueue presentation_queue;
     VkQueue compute_queue;
+    VkQueue transfer_queue;
+    bool dedicated_transfer_queue = false;
     bool deviceSupportsHardwareAcceleratedRRT = true;
+    bool deviceSupportsDrawIndirectCount = false;
+    bool deviceSupportsBindlessTextures = false;
+    uint32_t texture_table_size = MAX_TEXTURE_COUNT;
 
     void get_physical_device();
     void create_logical_device();
@@ -93,5 +111,10 @@ class VulkanDevice
         VK_KHR_RAY_QUERY_EXTENSION_NAME
 
     };
+
+    // needed for the GPU driven meshlet culling in the rasterizer
+    const char *device_extension_draw_indirect_count = VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+    // optional; the allocator reports how much memory the driver grants the process with it
+    const char *device_extension_memory_budget = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
 };
 }// namespace Kataglyphis
\ No newline at end of file
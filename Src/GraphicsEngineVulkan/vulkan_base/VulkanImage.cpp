@@ -1,6 +1,8 @@
 #include "vulkan_base/VulkanImage.hpp"
 
-#include "common/MemoryHelper.hpp"
+#include <algorithm>
+#include <vector>
+
 #include "common/Utilities.hpp"
 
 Kataglyphis::VulkanImage::VulkanImage() {}
@@ -20,9 +22,9 @@ void Kataglyphis::VulkanImage::create(VulkanDevice *device,
     VkImageCreateInfo image_create_info{};
     image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     image_create_info.imageType = VK_IMAGE_TYPE_2D;// type of image (1D, 2D, 3D)
-    image_create_info.extent.width = width;// width if image extent
-    image_create_info.extent.height = height;// height if image extent
-    image_create_info.extent.depth = 1;// height if image extent
+    create_info.extent.width = width;// width if image extent
+    create_info.extent.height = height;// height if image extent
+    create_info.extent.depth = 1;// height if image extent
     image_create_info.mipLevels = mip_levels;// number of mipmap levels
     image_create_info.arrayLayers = 1;// number of levels in image array
     image_create_info.format = format;// format type of image
@@ -32,26 +34,51 @@ void Kataglyphis::VulkanImage::create(VulkanDevice *device,
     image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;// number of samples for multisampling
     image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;// whether image can be shared between queues
 
-    VkResult result = vkCreateImage(device->getLogicalDevice(), &image_create_info, nullptr, &image);
+    // memory comes from the texture or render target pool of the device's allocator
+    VkResult result = device->getAllocator().createImage(image_create_info, prop_flags, image, allocation);
     ASSERT_VULKAN(result, "Failed to create an image!")
 
-    // CREATE memory for image
-    // get memory requirements for a type of image
-    VkMemoryRequirements memory_requirements;
-    vkGetImageMemoryRequirements(device->getLogicalDevice(), image, &memory_requirements);
+    create_info = image_create_info;
+}
 
-    // allocate memory using image requirements and user defined properties
-    VkMemoryAllocateInfo memory_alloc_info{};
-    memory_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memory_alloc_info.allocationSize = memory_requirements.size;
-    memory_alloc_info.memoryTypeIndex =
-      Kataglyphis::find_memory_type_index(device->getPhysicalDevice(), memory_requirements.memoryTypeBits, prop_flags);
+VkImage Kataglyphis::VulkanImage::relocate(VmaAllocation destination,
+  VkCommandBuffer command_buffer,
+  VkImageLayout layout)
+{
+    const uint32_t mip_levels = create_info.mipLevels;
+    const VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
 
-    result = vkAllocateMemory(device->getLogicalDevice(), &memory_alloc_info, nullptr, &imageMemory);
-    ASSERT_VULKAN(result, "Failed to allocate memory!")
+    // the current image becomes the copy source
+    transitionImageLayout(command_buffer, layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mip_levels, aspect);
+    VkImage old_image = image;
 
-    // connect memory to image
-    vkBindImageMemory(device->getLogicalDevice(), image, imageMemory, 0);
+    VkResult result = vkCreateImage(device->getLogicalDevice(), &create_info, nullptr, &image);
+    ASSERT_VULKAN(result, "Failed to create an image!")
+    result = vmaBindImageMemory(device->getAllocator().getVmaAllocator(), destination, image);
+    ASSERT_VULKAN(result, "Failed to bind a moved image!")
+    transitionImageLayout(
+      command_buffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mip_levels, aspect);
+
+    std::vector<VkImageCopy> regions(mip_levels);
+    for (uint32_t level = 0; level < mip_levels; level++) {
+        VkImageCopy &region = regions[level];
+        region.srcSubresource = { aspect, level, 0, 1 };
+        region.dstSubresource = { aspect, level, 0, 1 };
+        region.extent = {
+            std::max(create_info.extent.width >> level, 1u), std::max(create_info.extent.height >> level, 1u), 1
+        };
+    }
+    vkCmdCopyImage(command_buffer,
+      old_image,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      image,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      mip_levels,
+      regions.data());
+
+    transitionImageLayout(command_buffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout, mip_levels, aspect);
+
+    return old_image;
 }
 
 void Kataglyphis::VulkanImage::transitionImageLayout(VkDevice device,
@@ -148,11 +175,7 @@ void Kataglyphis::VulkanImage::transitionImageLayout(VkCommandBuffer command_buf
 
 void Kataglyphis::VulkanImage::setImage(VkImage image) { this->image = image; }
 
-void Kataglyphis::VulkanImage::cleanUp()
-{
-    vkDestroyImage(device->getLogicalDevice(), image, nullptr);
-    vkFreeMemory(device->getLogicalDevice(), imageMemory, nullptr);
-}
+void Kataglyphis::VulkanImage::cleanUp() { device->getAllocator().destroyImage(image, allocation); }
 
 Kataglyphis::VulkanImage::~VulkanImage() {}
 
@@ -33,8 +33,15 @@ class VulkanImage
       uint32_t mip_levels,
       VkImageAspectFlags aspectMask);
 
+    // moves the image into destination (see Allocator::defragment): records the copy of all levels
+    // into command_buffer and returns the old image, which has to be destroyed once the copy ran.
+    // The image is expected in and left in layout.
+    VkImage relocate(VmaAllocation destination, VkCommandBuffer command_buffer, VkImageLayout layout);
+
     void setImage(VkImage image);
     VkImage &getImage() { return image; };
+    VmaAllocation getAllocation() { return allocation; };
+    const VkImageCreateInfo &getCreateInfo() const { return create_info; };
 
     void cleanUp();
 
@@ -45,7 +52,8 @@ class VulkanImage
     Kataglyphis::VulkanRendererInternals::CommandBufferManager commandBufferManager;
 
     VkImage image;
-    VkDeviceMemory imageMemory;
+    VmaAllocation allocation{ VK_NULL_HANDLE };
+    VkImageCreateInfo create_info{};
 
     VkAccessFlags accessFlagsForImageLayout(VkImageLayout layout);
     VkPipelineStageFlags pipelineStageForLayout(VkImageLayout oldImageLayout);
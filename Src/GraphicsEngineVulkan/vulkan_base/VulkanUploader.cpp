@@ -0,0 +1,398 @@
+#include "vulkan_base/VulkanUploader.hpp"
+
+#include <cstring>
+
+#include "common/Utilities.hpp"
+#include "renderer/CommandBufferManager.hpp"
+
+using namespace Kataglyphis;
+
+namespace {
+
+// covers the texel block size of every format the textures come in
+const VkDeviceSize staging_alignment = 16;
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+VkImageMemoryBarrier imageBarrier(VkImage image,
+  uint32_t mip_levels,
+  VkImageLayout old_layout,
+  VkImageLayout new_layout,
+  VkAccessFlags src_access,
+  VkAccessFlags dst_access)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mip_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    return barrier;
+}
+
+}// namespace
+
+VulkanUploader::VulkanUploader() {}
+
+void VulkanUploader::create(VulkanDevice *device,
+  VkCommandPool command_pool,
+  VkCommandPool graphics_command_pool,
+  VkDeviceSize ring_size)
+{
+    this->device = device;
+    this->command_pool = command_pool;
+    this->graphics_command_pool = graphics_command_pool;
+    this->ring_size = ring_size;
+
+    Kataglyphis::VulkanRendererInternals::QueueFamilyIndices indices = device->getQueueFamilies();
+    queue = device->getTransferQueue();
+    queue_family = static_cast<uint32_t>(indices.transfer_family);
+    graphics_family = static_cast<uint32_t>(indices.graphics_family);
+
+    ring.create(device,
+      ring_size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // staging memory stays mapped for the lifetime of the buffer
+    ring_data = static_cast<unsigned char *>(ring.getMappedData());
+
+    head = 0;
+    tail = 0;
+    uploaded_bytes = 0;
+    submit_count = 0;
+    completed_count = 0;
+}
+
+void VulkanUploader::uploadBuffer(VkBuffer dst_buffer, const void *data, VkDeviceSize size, VkDeviceSize dst_offset)
+{
+    if (size == 0) return;
+
+    VkBuffer staging_buffer;
+    VkDeviceSize staging_offset;
+    stage(data, size, staging_buffer, staging_offset);
+
+    VkBufferCopy buffer_copy_region{};
+    buffer_copy_region.srcOffset = staging_offset;
+    buffer_copy_region.dstOffset = dst_offset;
+    buffer_copy_region.size = size;
+    vkCmdCopyBuffer(getCommandBuffer(), staging_buffer, dst_buffer, 1, &buffer_copy_region);
+
+    if (transfersOwnership()) {
+        VkBufferMemoryBarrier release{};
+        release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        release.dstAccessMask = 0;
+        release.srcQueueFamilyIndex = queue_family;
+        release.dstQueueFamilyIndex = graphics_family;
+        release.buffer = dst_buffer;
+        release.offset = dst_offset;
+        release.size = size;
+        recording.buffer_releases.push_back(release);
+    }
+
+    uploaded_bytes += size;
+}
+
+void VulkanUploader::uploadImage(VkImage image,
+  uint32_t mip_levels,
+  const void *data,
+  VkDeviceSize size,
+  std::span<const VkBufferImageCopy> regions,
+  VkImageLayout final_layout)
+{
+    VkBuffer staging_buffer;
+    VkDeviceSize staging_offset;
+    stage(data, size, staging_buffer, staging_offset);
+
+    std::vector<VkBufferImageCopy> staged_regions(regions.begin(), regions.end());
+    for (VkBufferImageCopy &region : staged_regions) region.bufferOffset += staging_offset;
+
+    VkCommandBuffer command_buffer = getCommandBuffer();
+    VkImageMemoryBarrier to_transfer = imageBarrier(image,
+      mip_levels,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      0,
+      VK_ACCESS_TRANSFER_WRITE_BIT);
+    vkCmdPipelineBarrier(command_buffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &to_transfer);
+
+    vkCmdCopyBufferToImage(command_buffer,
+      staging_buffer,
+      image,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      static_cast<uint32_t>(staged_regions.size()),
+      staged_regions.data());
+
+    if (transfersOwnership()) {
+        // the layout transition is part of the ownership transfer
+        VkImageMemoryBarrier release = imageBarrier(
+          image, mip_levels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, final_layout, VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+        release.srcQueueFamilyIndex = queue_family;
+        release.dstQueueFamilyIndex = graphics_family;
+        recording.image_releases.push_back(release);
+    } else if (final_layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        VkImageMemoryBarrier to_final = imageBarrier(image,
+          mip_levels,
+          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          final_layout,
+          VK_ACCESS_TRANSFER_WRITE_BIT,
+          VK_ACCESS_SHADER_READ_BIT);
+        vkCmdPipelineBarrier(command_buffer,
+          VK_PIPELINE_STAGE_TRANSFER_BIT,
+          VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+          0,
+          0,
+          nullptr,
+          0,
+          nullptr,
+          1,
+          &to_final);
+    }
+
+    uploaded_bytes += size;
+}
+
+VkCommandBuffer VulkanUploader::getCommandBuffer()
+{
+    if (recording.command_buffer != VK_NULL_HANDLE) return recording.command_buffer;
+
+    VkCommandBufferAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandPool = command_pool;
+    alloc_info.commandBufferCount = 1;
+    VkResult result = vkAllocateCommandBuffers(device->getLogicalDevice(), &alloc_info, &recording.command_buffer);
+    ASSERT_VULKAN(result, "Failed to allocate an upload command buffer!")
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    result = vkBeginCommandBuffer(recording.command_buffer, &begin_info);
+    ASSERT_VULKAN(result, "Failed to begin an upload command buffer!")
+
+    return recording.command_buffer;
+}
+
+void VulkanUploader::flush()
+{
+    if (recording.command_buffer == VK_NULL_HANDLE) return;
+
+    if (transfersOwnership()) {
+        if (!recording.buffer_releases.empty() || !recording.image_releases.empty()) {
+            vkCmdPipelineBarrier(recording.command_buffer,
+              VK_PIPELINE_STAGE_TRANSFER_BIT,
+              VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+              0,
+              0,
+              nullptr,
+              static_cast<uint32_t>(recording.buffer_releases.size()),
+              recording.buffer_releases.data(),
+              static_cast<uint32_t>(recording.image_releases.size()),
+              recording.image_releases.data());
+        }
+    } else {
+        // vertex fetch, index reads, AS builds and shaders all read what was copied here
+        VkMemoryBarrier memory_barrier{};
+        memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memory_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(recording.command_buffer,
+          VK_PIPELINE_STAGE_TRANSFER_BIT,
+          VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+          0,
+          1,
+          &memory_barrier,
+          0,
+          nullptr,
+          0,
+          nullptr);
+    }
+
+    VkResult result = vkEndCommandBuffer(recording.command_buffer);
+    ASSERT_VULKAN(result, "Failed to end an upload command buffer!")
+
+    VkFenceCreateInfo fence_create_info{};
+    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    result = vkCreateFence(device->getLogicalDevice(), &fence_create_info, nullptr, &recording.fence);
+    ASSERT_VULKAN(result, "Failed to create an upload fence!")
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &recording.command_buffer;
+    result = vkQueueSubmit(queue, 1, &submit_info, recording.fence);
+    ASSERT_VULKAN(result, "Failed to submit uploads!")
+
+    recording.ring_end = head;
+    in_flight.push_back(std::move(recording));
+    recording = Batch{};
+    submit_count++;
+}
+
+void VulkanUploader::finish()
+{
+    flush();
+    for (Batch &batch : in_flight) {
+        vkWaitForFences(device->getLogicalDevice(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        retire(batch);
+    }
+    in_flight.clear();
+    head = 0;
+    tail = 0;
+
+    if (buffer_acquires.empty() && image_acquires.empty()) return;
+
+    Kataglyphis::VulkanRendererInternals::CommandBufferManager commandBufferManager;
+    VkCommandBuffer command_buffer =
+      commandBufferManager.beginCommandBuffer(device->getLogicalDevice(), graphics_command_pool);
+    recordAcquires(command_buffer);
+    commandBufferManager.endAndSubmitCommandBuffer(
+      device->getLogicalDevice(), graphics_command_pool, device->getGraphicsQueue(), command_buffer);
+}
+
+void VulkanUploader::recordAcquires(VkCommandBuffer graphics_command_buffer)
+{
+    if (buffer_acquires.empty() && image_acquires.empty()) return;
+
+    vkCmdPipelineBarrier(graphics_command_buffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+      0,
+      0,
+      nullptr,
+      static_cast<uint32_t>(buffer_acquires.size()),
+      buffer_acquires.data(),
+      static_cast<uint32_t>(image_acquires.size()),
+      image_acquires.data());
+
+    buffer_acquires.clear();
+    image_acquires.clear();
+}
+
+void VulkanUploader::collect()
+{
+    while (!in_flight.empty() && vkGetFenceStatus(device->getLogicalDevice(), in_flight.front().fence) == VK_SUCCESS) {
+        retire(in_flight.front());
+        in_flight.pop_front();
+    }
+
+    // nothing references the ring any more, start over at its beginning
+    if (in_flight.empty() && recording.command_buffer == VK_NULL_HANDLE) {
+        head = 0;
+        tail = 0;
+    }
+}
+
+void VulkanUploader::cleanUp()
+{
+    if (device == VK_NULL_HANDLE) return;
+
+    finish();
+    ring.cleanUp();
+    ring_data = nullptr;
+    device = VK_NULL_HANDLE;
+}
+
+VulkanUploader::~VulkanUploader() {}
+
+void VulkanUploader::stage(const void *data, VkDeviceSize size, VkBuffer &buffer, VkDeviceSize &offset)
+{
+    collect();
+
+    if (size > ring_size) {
+        VulkanBuffer oversized;
+        oversized.create(device,
+          size,
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        std::memcpy(oversized.getMappedData(), data, static_cast<size_t>(size));
+
+        buffer = oversized.getBuffer();
+        offset = 0;
+        recording.oversized.push_back(oversized);
+        return;
+    }
+
+    while (!allocate(size, offset)) {
+        // the ring is full: everything recorded so far has to go out and the oldest batch has to finish
+        flush();
+        if (in_flight.empty()) {
+            head = 0;
+            tail = 0;
+            continue;
+        }
+        vkWaitForFences(device->getLogicalDevice(), 1, &in_flight.front().fence, VK_TRUE, UINT64_MAX);
+        retire(in_flight.front());
+        in_flight.pop_front();
+    }
+
+    std::memcpy(ring_data + offset, data, static_cast<size_t>(size));
+    buffer = ring.getBuffer();
+}
+
+bool VulkanUploader::allocate(VkDeviceSize size, VkDeviceSize &offset)
+{
+    const VkDeviceSize aligned = alignUp(head, staging_alignment);
+    if (head >= tail) {
+        // free space is [head, ring_size) and [0, tail)
+        if (aligned + size <= ring_size) {
+            offset = aligned;
+            head = aligned + size;
+            return true;
+        }
+        // wrap around; the rest of the ring stays unused until tail passes it
+        if (size < tail) {
+            offset = 0;
+            head = size;
+            return true;
+        }
+        return false;
+    }
+
+    // wrapped: only [head, tail) is free; never let head catch up with tail
+    if (aligned + size < tail) {
+        offset = aligned;
+        head = aligned + size;
+        return true;
+    }
+    return false;
+}
+
+void VulkanUploader::retire(Batch &batch)
+{
+    vkFreeCommandBuffers(device->getLogicalDevice(), command_pool, 1, &batch.command_buffer);
+    vkDestroyFence(device->getLogicalDevice(), batch.fence, nullptr);
+    for (VulkanBuffer &oversized : batch.oversized) oversized.cleanUp();
+    tail = batch.ring_end;
+    completed_count++;
+
+    // the acquiring half of each release; layouts have to match the release exactly
+    for (VkBufferMemoryBarrier acquire : batch.buffer_releases) {
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        buffer_acquires.push_back(acquire);
+    }
+    for (VkImageMemoryBarrier acquire : batch.image_releases) {
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        image_acquires.push_back(acquire);
+    }
+}
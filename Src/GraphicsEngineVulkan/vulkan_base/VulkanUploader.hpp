@@ -0,0 +1,117 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <span>
+#include <vector>
+
+#include "vulkan_base/VulkanBuffer.hpp"
+#include "vulkan_base/VulkanDevice.hpp"
+
+namespace Kataglyphis {
+
+// Batches the staging copies of many buffers and images into one command
+// buffer. Source data is copied into a persistently mapped ring buffer right
+// away, so callers may free it on return. flush() submits everything recorded
+// so far with a fence instead of idling the queue; ring space is handed out
+// again once the fence of the batch that used it has signalled. Uploads
+// larger than the ring get a staging buffer of their own.
+//
+// Uploads run on the device's transfer queue. Later submissions to the same
+// queue see the uploaded data: every batch ends with a barrier against all
+// reads. On a dedicated transfer queue the batch instead releases everything
+// it wrote to the graphics family; the matching acquire barriers become
+// available once the batch completed and have to be recorded on the graphics
+// queue (recordAcquires(), or finish() which submits them itself).
+class VulkanUploader
+{
+  public:
+    VulkanUploader();
+
+    // command_pool belongs to the transfer family, graphics_command_pool to the graphics family
+    void create(VulkanDevice *device,
+      VkCommandPool command_pool,
+      VkCommandPool graphics_command_pool,
+      VkDeviceSize ring_size = 64ull << 20);
+
+    void uploadBuffer(VkBuffer dst_buffer, const void *data, VkDeviceSize size, VkDeviceSize dst_offset = 0);
+
+    // copies [data, data + size) into the image; the bufferOffset of each region is relative
+    // to data. The image is expected in UNDEFINED layout and ends up in final_layout; keep it
+    // in TRANSFER_DST_OPTIMAL to record more work on it with getCommandBuffer() (see canBlit()).
+    void uploadImage(VkImage image,
+      uint32_t mip_levels,
+      const void *data,
+      VkDeviceSize size,
+      std::span<const VkBufferImageCopy> regions,
+      VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // the command buffer of the batch being recorded
+    VkCommandBuffer getCommandBuffer();
+    // blits and other graphics commands only work if uploads share the graphics queue
+    bool canBlit() const { return queue_family == graphics_family; };
+
+    // submits the recorded batch without waiting for it
+    void flush();
+    // flushes, waits for every batch in flight and acquires their resources on the graphics queue
+    void finish();
+    // releases the staging space of batches that are done; never blocks
+    void collect();
+
+    // id of the batch being recorded; isComplete() tells once its data can be used
+    uint64_t getRecordingBatch() const { return submit_count + 1; };
+    bool isComplete(uint64_t batch) const { return batch <= completed_count; };
+    // records the ownership acquires of all completed batches; no-op without a dedicated transfer queue
+    void recordAcquires(VkCommandBuffer graphics_command_buffer);
+
+    VkDeviceSize getUploadedBytes() const { return uploaded_bytes; };
+    uint64_t getSubmitCount() const { return submit_count; };
+
+    void cleanUp();
+
+    ~VulkanUploader();
+
+  private:
+    struct Batch
+    {
+        VkCommandBuffer command_buffer{ VK_NULL_HANDLE };
+        VkFence fence{ VK_NULL_HANDLE };
+        // ring space used up to here
+        VkDeviceSize ring_end{ 0 };
+        std::vector<VulkanBuffer> oversized;
+        // ownership transfers to the graphics family, recorded at flush() and once completed
+        std::vector<VkBufferMemoryBarrier> buffer_releases;
+        std::vector<VkImageMemoryBarrier> image_releases;
+    };
+
+    VulkanDevice *device{ VK_NULL_HANDLE };
+    VkCommandPool command_pool{ VK_NULL_HANDLE };
+    VkCommandPool graphics_command_pool{ VK_NULL_HANDLE };
+    VkQueue queue{ VK_NULL_HANDLE };
+    uint32_t queue_family{ 0 };
+    uint32_t graphics_family{ 0 };
+
+    VulkanBuffer ring;
+    VkDeviceSize ring_size{ 0 };
+    unsigned char *ring_data{ nullptr };
+    // next free byte and start of the oldest range still in use
+    VkDeviceSize head{ 0 };
+    VkDeviceSize tail{ 0 };
+
+    Batch recording;
+    std::deque<Batch> in_flight;
+    std::vector<VkBufferMemoryBarrier> buffer_acquires;
+    std::vector<VkImageMemoryBarrier> image_acquires;
+
+    VkDeviceSize uploaded_bytes{ 0 };
+    uint64_t submit_count{ 0 };
+    uint64_t completed_count{ 0 };
+
+    // copies data to staging memory; returns the buffer and offset to copy from
+    void stage(const void *data, VkDeviceSize size, VkBuffer &buffer, VkDeviceSize &offset);
+    bool allocate(VkDeviceSize size, VkDeviceSize &offset);
+    bool transfersOwnership() const { return queue_family != graphics_family; };
+    void retire(Batch &batch);
+};
+
+}// namespace Kataglyphis
@@ -8,14 +8,43 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <glm/gtc/constants.hpp>
 #include <glm/mat4x4.hpp>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <random>
 #include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "gui/GUI.hpp"
+#include "memory/Allocator.hpp"
+#include "renderer/DepthPyramid.hpp"
 #include "renderer/VulkanRenderer.hpp"
+#include "scene/CompactVertex.hpp"
+#include "scene/FrustumCuller.hpp"
+#include "scene/GlbFile.hpp"
+#include "scene/GltfLoader.hpp"
+#include "scene/MeshCache.hpp"
+#include "scene/MeshOptimizer.hpp"
+#include "scene/MeshSimplifier.hpp"
+#include "scene/MeshletBuilder.hpp"
+#include "scene/ObjLoader.hpp"
+#include "scene/SceneFile.hpp"
+#include "scene/SubmeshBuilder.hpp"
+#include "scene/TextureCache.hpp"
+#include "scene/TextureDecoder.hpp"
+#include "scene/TextureStreamer.hpp"
+#include "scene/VertexWelder.hpp"
+#include "util/JobPool.hpp"
 #include "window/Window.hpp"
 
 
@@ -29,6 +58,838 @@ TEST(HelloTestCommit, BasicAssertions)
     EXPECT_EQ(7 * 6, 42);
 }
 
+TEST(ObjLoader, ThreadedLoadMatchesSingleThread)
+{
+    // three shapes sharing their border vertices, the material changes every row
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::filesystem::path obj_file = directory / "kataglyphis_threads.obj";
+    {
+        std::ofstream stream(directory / "kataglyphis_threads.mtl");
+        stream << "newmtl red\nKd 1 0 0\nnewmtl green\nKd 0 1 0\n";
+    }
+    {
+        std::ofstream stream(obj_file);
+        stream << "mtllib kataglyphis_threads.mtl\n";
+        const int columns = 16;
+        const int rows = 30;
+        for (int y = 0; y <= rows; y++) {
+            for (int x = 0; x <= columns; x++) {
+                stream << "v " << x << " " << y << " " << (x * y) % 3 << "\n";
+                stream << "vt " << x / float(columns) << " " << y / float(rows) << "\n";
+            }
+        }
+        for (int y = 0; y < rows; y++) {
+            if (y % 10 == 0) stream << "o shape" << y / 10 << "\n";
+            stream << "usemtl " << (y % 2 == 0 ? "red" : "green") << "\n";
+            for (int x = 0; x < columns; x++) {
+                const int a = y * (columns + 1) + x + 1;
+                const int b = a + columns + 1;
+                stream << "f " << a << "/" << a << " " << a + 1 << "/" << a + 1 << " " << b + 1 << "/" << b + 1 << " "
+                       << b << "/" << b << "\n";
+            }
+        }
+    }
+
+    struct ProcessedModel
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<unsigned int> materialIndex;
+    };
+    auto process = [&](uint32_t thread_count) {
+        Kataglyphis::ObjLoaderSettings settings{};
+        settings.optimize_mesh = false;
+        settings.thread_count = thread_count;
+        Kataglyphis::ObjLoader loader(nullptr, VK_NULL_HANDLE, VK_NULL_HANDLE, settings);
+        std::filesystem::remove(obj_file.string() + ".kgcache");
+        EXPECT_EQ(loader.bakeMeshCache(obj_file.string()), Kataglyphis::MeshCacheState::Rebuilt);
+
+        Kataglyphis::MeshCache cache(obj_file.string(), loader.cacheVersion());
+        EXPECT_TRUE(cache.load());
+        ProcessedModel model;
+        model.vertices.assign(cache.getVertices().begin(), cache.getVertices().end());
+        model.indices.assign(cache.getIndices().begin(), cache.getIndices().end());
+        model.materialIndex.assign(cache.getMaterialIndex().begin(), cache.getMaterialIndex().end());
+        return model;
+    };
+
+    const ProcessedModel single = process(1);
+    ASSERT_EQ(single.indices.size(), 30u * 16u * 6u);
+    ASSERT_EQ(single.materialIndex.size(), 30u * 16u * 2u);
+    EXPECT_NE(single.materialIndex.front(), single.materialIndex.back());
+
+    // face ranges that do not line up with the shapes, one of them shorter than the rest
+    for (uint32_t thread_count : { 2u, 7u }) {
+        const ProcessedModel threaded = process(thread_count);
+        ASSERT_EQ(threaded.vertices.size(), single.vertices.size());
+        for (size_t i = 0; i < single.vertices.size(); i++) {
+            EXPECT_TRUE(threaded.vertices[i] == single.vertices[i]);
+            EXPECT_EQ(threaded.vertices[i].color, single.vertices[i].color);
+        }
+        EXPECT_EQ(threaded.indices, single.indices);
+        EXPECT_EQ(threaded.materialIndex, single.materialIndex);
+    }
+
+    std::filesystem::remove(obj_file.string() + ".kgcache");
+    std::filesystem::remove(obj_file);
+    std::filesystem::remove(directory / "kataglyphis_threads.mtl");
+}
+
+TEST(VertexWelder, MatchesSequentialDedup)
+{
+    // a corner stream with many duplicates like an OBJ with shared vertices
+    std::vector<Vertex> corners;
+    for (uint32_t i = 0; i < 100000; i++) {
+        float k = static_cast<float>((i * 7919u) % 1500u);
+        corners.emplace_back(glm::vec3(k, 0.5f * k, 1.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(-1.f), glm::vec2(k, 0.f));
+    }
+
+    std::vector<Vertex> expected_vertices;
+    std::vector<uint32_t> expected_indices;
+    std::unordered_map<Vertex, uint32_t> vertices_map;
+    for (const Vertex &corner : corners) {
+        auto inserted = vertices_map.try_emplace(corner, static_cast<uint32_t>(expected_vertices.size()));
+        if (inserted.second) expected_vertices.push_back(corner);
+        expected_indices.push_back(inserted.first->second);
+    }
+
+    for (uint32_t shard_count : { 1u, 4u, 16u }) {
+        Kataglyphis::VertexWeldSettings settings{};
+        settings.shard_count = shard_count;
+        Kataglyphis::VertexWelder welder(settings);
+
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        welder.weld(corners, vertices, indices);
+
+        ASSERT_EQ(vertices.size(), expected_vertices.size());
+        EXPECT_EQ(indices, expected_indices);
+        for (size_t i = 0; i < vertices.size(); i++) EXPECT_TRUE(vertices[i] == expected_vertices[i]);
+    }
+}
+
+TEST(VertexWelder, EpsilonWeldSnapsPositions)
+{
+    std::vector<Vertex> corners = {
+        Vertex(glm::vec3(0.10f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(-1.f), glm::vec2(0.f)),
+        Vertex(glm::vec3(0.12f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(-1.f), glm::vec2(0.f)),
+        Vertex(glm::vec3(0.90f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(-1.f), glm::vec2(0.f)),
+    };
+
+    Kataglyphis::VertexWeldSettings settings{};
+    settings.position_epsilon = 0.5f;
+    Kataglyphis::VertexWelder welder(settings);
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    welder.weld(corners, vertices, indices);
+
+    EXPECT_EQ(vertices.size(), 2);
+    EXPECT_EQ(indices, (std::vector<uint32_t>{ 0, 0, 1 }));
+    // -0 and +0 compare equal and therefore have to weld as well
+    EXPECT_EQ(Kataglyphis::VertexWelder::hashVertex(Vertex(glm::vec3(-0.f), glm::vec3(0.f), glm::vec3(0.f), glm::vec2(0.f))),
+      Kataglyphis::VertexWelder::hashVertex(Vertex(glm::vec3(0.f), glm::vec3(0.f), glm::vec3(0.f), glm::vec2(0.f))));
+}
+
+TEST(MeshOptimizer, ImprovesCacheAndKeepsTriangles)
+{
+    // regular grid with triangles in scrambled order
+    const uint32_t grid_size = 64;
+    std::vector<Vertex> vertices;
+    for (uint32_t y = 0; y <= grid_size; y++)
+        for (uint32_t x = 0; x <= grid_size; x++)
+            vertices.emplace_back(glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.f),
+              glm::vec3(0.f, 0.f, 1.f),
+              glm::vec3(-1.f),
+              glm::vec2(0.f));
+
+    std::vector<uint32_t> indices;
+    std::vector<unsigned int> materialIndex;
+    for (uint32_t t = 0; t < grid_size * grid_size; t++) {
+        uint32_t cell = (t * 2654435761u) % (grid_size * grid_size);
+        uint32_t a = (cell / grid_size) * (grid_size + 1) + cell % grid_size;
+        indices.insert(indices.end(), { a, a + 1, a + grid_size + 1 });
+        indices.insert(indices.end(), { a + 1, a + grid_size + 2, a + grid_size + 1 });
+        materialIndex.insert(materialIndex.end(), { a % 7, a % 7 });
+    }
+
+    // (first corner position, material) identifies each triangle
+    auto collectTriangles = [&]() {
+        std::vector<std::tuple<float, float, unsigned int>> triangles;
+        for (size_t t = 0; t < indices.size() / 3; t++) {
+            const glm::vec3 &p = vertices[indices[t * 3]].pos;
+            triangles.emplace_back(p.x, p.y, materialIndex[t]);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    };
+    auto triangles_before = collectTriangles();
+
+    Kataglyphis::MeshOptimizer optimizer;
+    Kataglyphis::MeshOptimizationStats stats = optimizer.optimize(vertices, indices, materialIndex);
+
+    EXPECT_EQ(collectTriangles(), triangles_before);
+    EXPECT_LT(stats.acmr_after, stats.acmr_before);
+    EXPECT_LT(stats.acmr_after, 0.8f);
+    EXPECT_LT(stats.atvr_after, stats.atvr_before);
+}
+
+TEST(MeshOptimizer, SplitsClosedMeshIntoClustersAndSortsThemAgainstOverdraw)
+{
+    // welded 16 x 8 x 4 box: one connected mesh, so the cache is only flushed once. Its faces are
+    // generated nearest to the center first
+    const std::array<int, 3> extent = { 8, 4, 2 };
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::map<std::array<int, 3>, uint32_t> vertex_ids;
+    auto vertexId = [&](const std::array<int, 3> &p) {
+        auto inserted = vertex_ids.try_emplace(p, static_cast<uint32_t>(vertices.size()));
+        if (inserted.second) {
+            const glm::vec3 position(static_cast<float>(p[0]), static_cast<float>(p[1]), static_cast<float>(p[2]));
+            vertices.emplace_back(position,
+              glm::vec3(0.f),
+              glm::vec3(-1.f),
+              glm::vec2(0.f));
+        }
+        return inserted.first->second;
+    };
+    for (int axis : { 2, 1, 0 }) {
+        const int u = (axis + 1) % 3;
+        const int v = (axis + 2) % 3;
+        for (int sign : { -1, 1 }) {
+            for (int i = -extent[u]; i < extent[u]; i++) {
+                for (int j = -extent[v]; j < extent[v]; j++) {
+                    std::array<int, 3> p00{}, p10{}, p11{}, p01{};
+                    for (auto *p : { &p00, &p10, &p11, &p01 }) (*p)[axis] = sign * extent[axis];
+                    p00[u] = i, p00[v] = j, p10[u] = i + 1, p10[v] = j;
+                    p11[u] = i + 1, p11[v] = j + 1, p01[u] = i, p01[v] = j + 1;
+                    // counter clockwise seen from outside
+                    if (sign > 0) {
+                        indices.insert(indices.end(), { vertexId(p00), vertexId(p10), vertexId(p11) });
+                        indices.insert(indices.end(), { vertexId(p00), vertexId(p11), vertexId(p01) });
+                    } else {
+                        indices.insert(indices.end(), { vertexId(p00), vertexId(p11), vertexId(p10) });
+                        indices.insert(indices.end(), { vertexId(p00), vertexId(p01), vertexId(p11) });
+                    }
+                }
+            }
+        }
+    }
+
+    Kataglyphis::MeshOptimizer optimizer;
+    std::vector<uint32_t> cluster_starts;
+    const std::vector<uint32_t> cache_order =
+      optimizer.optimizeVertexCache(indices, vertices.size(), cluster_starts);
+    ASSERT_GT(cluster_starts.size(), 1u);
+    EXPECT_EQ(cluster_starts.front(), 0u);
+    EXPECT_TRUE(std::is_sorted(cluster_starts.begin(), cluster_starts.end()));
+
+    const std::vector<uint32_t> overdraw_order =
+      optimizer.optimizeOverdraw(vertices, indices, cache_order, cluster_starts);
+    EXPECT_NE(overdraw_order, cache_order);
+    std::vector<uint32_t> sorted_order = overdraw_order;
+    std::sort(sorted_order.begin(), sorted_order.end());
+    for (uint32_t t = 0; t < sorted_order.size(); t++) ASSERT_EQ(sorted_order[t], t);
+
+    // the faces farthest from the center occlude the most and come first
+    auto distanceFromCenter = [&](uint32_t triangle) {
+        const glm::vec3 &p0 = vertices[indices[triangle * 3 + 0]].pos;
+        const glm::vec3 &p1 = vertices[indices[triangle * 3 + 1]].pos;
+        const glm::vec3 &p2 = vertices[indices[triangle * 3 + 2]].pos;
+        const glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+        return glm::dot(p0, normal);
+    };
+    const size_t tenth = overdraw_order.size() / 10;
+    float first_distance = 0.f;
+    float last_distance = 0.f;
+    for (size_t t = 0; t < tenth; t++) {
+        first_distance += distanceFromCenter(overdraw_order[t]);
+        last_distance += distanceFromCenter(overdraw_order[overdraw_order.size() - 1 - t]);
+    }
+    EXPECT_GT(first_distance, last_distance);
+}
+
+TEST(MeshletBuilder, RespectsLimitsAndBoundsContainTriangles)
+{
+    // closed cube of 6 grid faces so some clusters are backfacing from any direction
+    const uint32_t grid_size = 32;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    const glm::vec3 axes[3] = { glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, 0.f, 1.f) };
+    for (int face = 0; face < 6; face++) {
+        const glm::vec3 n = axes[face % 3] * (face < 3 ? 1.f : -1.f);
+        const glm::vec3 u = axes[(face + 1) % 3];
+        const glm::vec3 v = glm::cross(n, u);
+        const uint32_t base = static_cast<uint32_t>(vertices.size());
+        for (uint32_t y = 0; y <= grid_size; y++)
+            for (uint32_t x = 0; x <= grid_size; x++) {
+                const float s = static_cast<float>(x) / grid_size * 2.f - 1.f;
+                const float t = static_cast<float>(y) / grid_size * 2.f - 1.f;
+                vertices.emplace_back(n + u * s + v * t, n, glm::vec3(-1.f), glm::vec2(0.f));
+            }
+        for (uint32_t y = 0; y < grid_size; y++)
+            for (uint32_t x = 0; x < grid_size; x++) {
+                uint32_t a = base + y * (grid_size + 1) + x;
+                indices.insert(indices.end(), { a, a + 1, a + grid_size + 2 });
+                indices.insert(indices.end(), { a, a + grid_size + 2, a + grid_size + 1 });
+            }
+    }
+
+    Kataglyphis::MeshletSettings settings{};
+    Kataglyphis::MeshletBuilder builder(settings);
+    std::vector<Meshlet> meshlets = builder.build(vertices, indices);
+    ASSERT_FALSE(meshlets.empty());
+
+    uint32_t next_index = 0;
+    const glm::vec3 eye(0.f, 0.f, 10.f);
+    size_t backfacing = 0;
+    for (const Meshlet &meshlet : meshlets) {
+        // contiguous, complete coverage of the index buffer
+        EXPECT_EQ(meshlet.index_offset, next_index);
+        next_index += meshlet.index_count;
+        EXPECT_LE(meshlet.index_count / 3, settings.max_triangles);
+        EXPECT_LE(meshlet.vertex_count, settings.max_vertices);
+
+        const glm::vec3 center(meshlet.bounding_sphere);
+        for (uint32_t i = meshlet.index_offset; i < meshlet.index_offset + meshlet.index_count; i++) {
+            const glm::vec3 d = vertices[indices[i]].pos - center;
+            EXPECT_LE(std::sqrt(glm::dot(d, d)), meshlet.bounding_sphere.w + 1e-4f);
+        }
+
+        // a culled cluster must not contain a single triangle facing the eye
+        const glm::vec3 view = center - eye;
+        const glm::vec3 axis(meshlet.cone);
+        if (meshlet.cone.w < 1.f
+            && glm::dot(view, axis) >= meshlet.cone.w * std::sqrt(glm::dot(view, view)) + meshlet.bounding_sphere.w) {
+            backfacing++;
+            for (uint32_t i = meshlet.index_offset; i < meshlet.index_offset + meshlet.index_count; i += 3) {
+                const glm::vec3 &p0 = vertices[indices[i]].pos;
+                const glm::vec3 normal =
+                  glm::cross(vertices[indices[i + 1]].pos - p0, vertices[indices[i + 2]].pos - p0);
+                EXPECT_GE(glm::dot(p0 - eye, normal), 0.f);
+            }
+        }
+    }
+    EXPECT_EQ(next_index, indices.size());
+    EXPECT_GT(backfacing, 0u);
+}
+
+TEST(MeshSimplifier, LodChainShrinksAndKeepsMaterials)
+{
+    // closed uv sphere, two materials split by hemisphere
+    const uint32_t rings = 64;
+    const uint32_t segments = 128;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (uint32_t r = 0; r <= rings; r++)
+        for (uint32_t s = 0; s <= segments; s++) {
+            const float theta = glm::pi<float>() * static_cast<float>(r) / rings;
+            const float phi = 2.f * glm::pi<float>() * static_cast<float>(s % segments) / segments;
+            const glm::vec3 p(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            // collapse the poles onto one position each
+            const glm::vec3 position = r == 0 || r == rings ? glm::vec3(0.f, p.y, 0.f) : p;
+            vertices.emplace_back(position, p, glm::vec3(-1.f), glm::vec2(0.f));
+        }
+    std::vector<unsigned int> materialIndex;
+    for (uint32_t r = 0; r < rings; r++)
+        for (uint32_t s = 0; s < segments; s++) {
+            const uint32_t a = r * (segments + 1) + s;
+            indices.insert(indices.end(), { a, a + 1, a + segments + 2 });
+            indices.insert(indices.end(), { a, a + segments + 2, a + segments + 1 });
+            materialIndex.insert(materialIndex.end(), 2, r < rings / 2 ? 0u : 1u);
+        }
+    const std::vector<uint32_t> original_indices = indices;
+
+    Kataglyphis::MeshSimplifier simplifier;
+    std::vector<Kataglyphis::MeshLod> lods = simplifier.buildLodChain(vertices, indices, materialIndex, 4);
+    ASSERT_GE(lods.size(), 2u);
+    EXPECT_EQ(lods[0].index_count, original_indices.size());
+    EXPECT_TRUE(std::equal(original_indices.begin(), original_indices.end(), indices.begin()));
+    EXPECT_EQ(materialIndex.size(), indices.size() / 3);
+
+    for (size_t i = 1; i < lods.size(); i++) {
+        EXPECT_EQ(lods[i].index_offset, lods[i - 1].index_offset + lods[i - 1].index_count);
+        EXPECT_LT(lods[i].index_count, lods[i - 1].index_count);
+        EXPECT_GE(lods[i].error, lods[i - 1].error);
+
+        // simplified vertices stay on the surface and keep their hemisphere's material
+        for (uint32_t t = lods[i].index_offset / 3; t < (lods[i].index_offset + lods[i].index_count) / 3; t++) {
+            glm::vec3 centroid(0.f);
+            for (int k = 0; k < 3; k++) {
+                const glm::vec3 &p = vertices[indices[t * 3 + k]].pos;
+                EXPECT_NEAR(glm::dot(p, p), 1.f, 1e-3f);
+                centroid += p / 3.f;
+            }
+            if (std::abs(centroid.y) > 0.25f) { EXPECT_EQ(materialIndex[t], centroid.y > 0.f ? 0u : 1u); }
+        }
+    }
+
+    // a distant object picks a coarser level than a close one
+    EXPECT_EQ(Kataglyphis::selectLod(lods, 0.1f, 1000.f, 1.f), 0u);
+    EXPECT_EQ(Kataglyphis::selectLod(lods, 1e6f, 1000.f, 1.f), lods.size() - 1);
+}
+
+TEST(SubmeshBuilder, GroupsShapesAndMaterialsAndKeepsThemThroughOptimization)
+{
+    // two shapes of a strip of quads, the first one with interleaved materials
+    const uint32_t quad_count = 32;
+    std::vector<Vertex> vertices;
+    for (uint32_t x = 0; x <= quad_count; x++)
+        for (uint32_t y = 0; y <= 1; y++)
+            vertices.emplace_back(glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.f),
+              glm::vec3(0.f, 0.f, 1.f),
+              glm::vec3(-1.f),
+              glm::vec2(0.f));
+
+    std::vector<uint32_t> indices;
+    std::vector<unsigned int> materialIndex;
+    std::vector<uint32_t> triangle_shapes;
+    for (uint32_t q = 0; q < quad_count; q++) {
+        const uint32_t a = q * 2;
+        indices.insert(indices.end(), { a, a + 2, a + 1, a + 1, a + 2, a + 3 });
+        const uint32_t shape = q < quad_count / 2 ? 0 : 1;
+        const unsigned int material = shape == 0 ? q % 2 : static_cast<unsigned int>(-1);
+        materialIndex.insert(materialIndex.end(), { material, material });
+        triangle_shapes.insert(triangle_shapes.end(), { shape, shape });
+    }
+
+    Kataglyphis::SubmeshBuilder builder;
+    std::vector<Kataglyphis::Submesh> submeshes = builder.build(vertices, indices, materialIndex, triangle_shapes);
+
+    ASSERT_EQ(submeshes.size(), 3);
+    EXPECT_EQ(submeshes[0].material, 0);
+    EXPECT_EQ(submeshes[1].material, 1);
+    EXPECT_EQ(submeshes[2].shape, 1);
+    EXPECT_EQ(submeshes[2].material, UINT32_MAX);
+    // the second shape covers x in [16, 32]
+    EXPECT_FLOAT_EQ(submeshes[2].aabb_min.x, 16.f);
+    EXPECT_FLOAT_EQ(submeshes[2].aabb_max.x, 32.f);
+
+    Kataglyphis::MeshOptimizer optimizer;
+    optimizer.optimize(vertices, indices, materialIndex, submeshes);
+
+    uint32_t next_index = 0;
+    for (const Kataglyphis::Submesh &submesh : submeshes) {
+        EXPECT_EQ(submesh.index_offset, next_index);
+        next_index += submesh.index_count;
+        for (uint32_t i = submesh.index_offset; i < submesh.index_offset + submesh.index_count; i++) {
+            const glm::vec3 &p = vertices[indices[i]].pos;
+            EXPECT_GE(p.x, submesh.aabb_min.x);
+            EXPECT_LE(p.x, submesh.aabb_max.x);
+            EXPECT_EQ(materialIndex[i / 3], submesh.material);
+        }
+    }
+    EXPECT_EQ(next_index, indices.size());
+}
+
+TEST(GltfLoader, KeepsNodeHierarchyAndWidensIndices)
+{
+    // one mesh placed by a node and by its child: an indexed strip of quads with 16 bit
+    // indices and a second, non-indexed primitive without material
+    const uint32_t quad_count = 5;
+    std::vector<float> positions;
+    for (uint32_t x = 0; x <= quad_count; x++)
+        for (uint32_t y = 0; y <= 1; y++) positions.insert(positions.end(), { float(x), float(y), 0.f });
+    std::vector<uint16_t> strip_indices;
+    for (uint16_t q = 0; q < quad_count; q++) {
+        const uint16_t a = q * 2;
+        strip_indices.insert(strip_indices.end(), { a, uint16_t(a + 2), uint16_t(a + 1) });
+        strip_indices.insert(strip_indices.end(), { uint16_t(a + 1), uint16_t(a + 2), uint16_t(a + 3) });
+    }
+    const std::vector<float> triangle = { 0.f, 0.f, 1.f, 1.f, 0.f, 1.f, 0.f, 1.f, 1.f };
+
+    std::vector<char> binary;
+    auto append = [&](const void *data, size_t size) {
+        const size_t offset = binary.size();
+        binary.insert(binary.end(), static_cast<const char *>(data), static_cast<const char *>(data) + size);
+        binary.resize((binary.size() + 3) / 4 * 4, 0);
+        return offset;
+    };
+    const size_t positions_offset = append(positions.data(), positions.size() * sizeof(float));
+    const size_t indices_offset = append(strip_indices.data(), strip_indices.size() * sizeof(uint16_t));
+    const size_t triangle_offset = append(triangle.data(), triangle.size() * sizeof(float));
+
+    nlohmann::json json;
+    json["asset"] = { { "version", "2.0" } };
+    json["buffers"] = { { { "byteLength", binary.size() } } };
+    json["bufferViews"] = { { { "buffer", 0 }, { "byteOffset", positions_offset }, { "byteLength", 144 } },
+        { { "buffer", 0 }, { "byteOffset", indices_offset }, { "byteLength", 60 } },
+        { { "buffer", 0 }, { "byteOffset", triangle_offset }, { "byteLength", 36 } } };
+    json["accessors"] = { { { "bufferView", 0 }, { "componentType", 5126 }, { "count", 12 }, { "type", "VEC3" } },
+        { { "bufferView", 1 }, { "componentType", 5123 }, { "count", 30 }, { "type", "SCALAR" } },
+        { { "bufferView", 2 }, { "componentType", 5126 }, { "count", 3 }, { "type", "VEC3" } } };
+    json["materials"] = { { { "pbrMetallicRoughness", { { "baseColorFactor", { 0.5, 0.25, 1.0, 1.0 } } } } } };
+    json["meshes"] = { { { "primitives",
+      { { { "attributes", { { "POSITION", 0 } } }, { "indices", 1 }, { "material", 0 } },
+        { { "attributes", { { "POSITION", 2 } } } } } } } };
+    json["nodes"] = { { { "mesh", 0 }, { "translation", { 10.0, 0.0, 0.0 } }, { "children", { 1 } } },
+        { { "mesh", 0 }, { "scale", { 2.0, 2.0, 2.0 } } } };
+    json["scenes"] = { { { "nodes", { 0 } } } };
+    json["scene"] = 0;
+
+    std::string json_chunk = json.dump();
+    json_chunk.resize((json_chunk.size() + 3) / 4 * 4, ' ');
+    const uint32_t header[3] = { 0x46546C67, 2, static_cast<uint32_t>(12 + 8 + json_chunk.size() + 8 + binary.size()) };
+    const uint32_t json_header[2] = { static_cast<uint32_t>(json_chunk.size()), 0x4E4F534A };
+    const uint32_t binary_header[2] = { static_cast<uint32_t>(binary.size()), 0x004E4942 };
+
+    const std::filesystem::path file = std::filesystem::temp_directory_path() / "kataglyphis_gltf_loader.glb";
+    {
+        std::ofstream stream(file, std::ios::binary);
+        stream.write(reinterpret_cast<const char *>(header), sizeof(header));
+        stream.write(reinterpret_cast<const char *>(json_header), sizeof(json_header));
+        stream.write(json_chunk.data(), static_cast<std::streamsize>(json_chunk.size()));
+        stream.write(reinterpret_cast<const char *>(binary_header), sizeof(binary_header));
+        stream.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+    }
+
+    {
+        Kataglyphis::GlbFile glb;
+        ASSERT_TRUE(glb.open(file.string()));
+
+        const std::vector<Kataglyphis::GltfMeshNode> mesh_nodes = glb.collectMeshNodes();
+        ASSERT_EQ(mesh_nodes.size(), 2);
+        EXPECT_FLOAT_EQ(mesh_nodes[0].transform[3].x, 10.f);
+        EXPECT_FLOAT_EQ(mesh_nodes[0].transform[0].x, 1.f);
+        // the child inherits the translation of its parent
+        EXPECT_FLOAT_EQ(mesh_nodes[1].transform[3].x, 10.f);
+        EXPECT_FLOAT_EQ(mesh_nodes[1].transform[0].x, 2.f);
+
+        std::vector<Kataglyphis::TextureSource> texture_sources;
+        const std::vector<ObjMaterial> materials = Kataglyphis::GltfLoader::loadMaterials(glb, texture_sources);
+        ASSERT_EQ(materials.size(), 2);
+        EXPECT_FLOAT_EQ(materials[0].diffuse.y, 0.25f);
+        EXPECT_TRUE(texture_sources.empty());
+
+        Kataglyphis::GltfMeshData mesh;
+        ASSERT_TRUE(Kataglyphis::GltfLoader::loadMesh(glb, 0, materials, mesh));
+        ASSERT_EQ(mesh.vertices.size(), 15);
+        ASSERT_EQ(mesh.indices.size(), 33);
+        for (size_t i = 0; i < strip_indices.size(); i++) EXPECT_EQ(mesh.indices[i], strip_indices[i]);
+        // the second primitive is rebased behind the first one
+        EXPECT_EQ(mesh.indices[30], 12);
+        EXPECT_EQ(mesh.indices[32], 14);
+        EXPECT_FLOAT_EQ(mesh.vertices[14].pos.z, 1.f);
+        EXPECT_FLOAT_EQ(mesh.vertices[0].normal.z, 1.f);
+
+        ASSERT_EQ(mesh.submeshes.size(), 2);
+        EXPECT_EQ(mesh.submeshes[1].index_offset, 30);
+        EXPECT_EQ(mesh.submeshes[1].index_count, 3);
+        ASSERT_EQ(mesh.materials.size(), 2);
+        EXPECT_FLOAT_EQ(mesh.materials[0].diffuse.x, 0.5f);
+        ASSERT_EQ(mesh.materialIndex.size(), 11);
+        EXPECT_EQ(mesh.materialIndex[0], 0);
+        EXPECT_EQ(mesh.materialIndex[10], 1);
+        EXPECT_FLOAT_EQ(mesh.submeshes[0].aabb_max.x, 5.f);
+    }
+    std::filesystem::remove(file);
+}
+
+TEST(SceneFile, SharesMeshesBetweenInstances)
+{
+    const std::filesystem::path file = std::filesystem::temp_directory_path() / "kataglyphis_scene.json";
+    {
+        std::ofstream stream(file);
+        stream << R"({
+            "meshes": [ { "name": "room", "file": "Models/room.obj" }, { "file": "Models/tree.glb" } ],
+            "instances": [
+                { "mesh": "room", "translation": [1, 2, 3] },
+                { "mesh": 1, "scale": 2 },
+                { "mesh": "room", "rotation": [0, 0, 90], "scale": [1, 1, 4] }
+            ]
+        })";
+    }
+
+    Kataglyphis::SceneFile scene_file;
+    ASSERT_TRUE(scene_file.load(file.string()));
+    ASSERT_EQ(scene_file.getMeshes().size(), 2);
+    // relative to the scene file; unnamed meshes are called by their file
+    EXPECT_EQ(std::filesystem::path(scene_file.getMeshes()[0].file),
+      (file.parent_path() / "Models/room.obj").lexically_normal());
+    EXPECT_EQ(scene_file.getMeshes()[1].name, "Models/tree.glb");
+
+    ASSERT_EQ(scene_file.getInstances().size(), 3);
+    const std::vector<glm::mat4> rooms = scene_file.getPlacements(0);
+    ASSERT_EQ(rooms.size(), 2);
+    EXPECT_FLOAT_EQ(rooms[0][3].y, 2.f);
+    // rotated by 90 degrees around z: x goes to y
+    const glm::vec4 x_axis = rooms[1] * glm::vec4(1.f, 0.f, 0.f, 0.f);
+    EXPECT_NEAR(x_axis.y, 1.f, 1e-5f);
+    EXPECT_FLOAT_EQ(rooms[1][2].z, 4.f);
+    ASSERT_EQ(scene_file.getPlacements(1).size(), 1);
+    EXPECT_FLOAT_EQ(scene_file.getPlacements(1)[0][0].x, 2.f);
+
+    // instances of unknown meshes make the whole file invalid
+    {
+        std::ofstream stream(file);
+        stream << R"({ "meshes": [ { "file": "a.obj" } ], "instances": [ { "mesh": "b" } ] })";
+    }
+    EXPECT_FALSE(scene_file.load(file.string()));
+    std::filesystem::remove(file);
+}
+
+TEST(CompactVertex, RoundTripsWithinQuantizationError)
+{
+    std::vector<Vertex> vertices;
+    for (int i = 0; i < 1000; i++) {
+        const float t = static_cast<float>(i) * 0.731f;
+        const glm::vec3 normal = glm::normalize(glm::vec3(std::sin(t), std::cos(t * 1.3f), std::sin(t * 0.7f) - 0.2f));
+        const glm::vec3 pos(std::sin(t) * 40.f, std::cos(t * 0.5f) * 2.f + 10.f, t * 0.01f);
+        vertices.emplace_back(pos, normal, glm::vec3(-1.f), glm::vec2(std::fmod(t, 1.f), std::fmod(t * 0.3f, 4.f)));
+    }
+
+    std::vector<CompactVertex> compact;
+    const VertexQuantization quantization = vertex::compressVertices(vertices, compact);
+    ASSERT_EQ(compact.size(), vertices.size());
+    EXPECT_LT(sizeof(CompactVertex) * 2, sizeof(Vertex));
+    EXPECT_FALSE(vertex::hasVertexColors(vertices));
+
+    const glm::vec3 step = glm::vec3(quantization.position_scale) / 32767.f;
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const Vertex decoded = vertex::decompressVertex(compact[i], quantization, false);
+        for (int axis = 0; axis < 3; axis++) {
+            EXPECT_NEAR(decoded.pos[axis], vertices[i].pos[axis], step[axis] + 1e-5f);
+            EXPECT_NEAR(decoded.normal[axis], vertices[i].normal[axis], 1e-3f);
+        }
+        EXPECT_NEAR(decoded.texture_coords.x, vertices[i].texture_coords.x, 1e-3f);
+        EXPECT_NEAR(decoded.texture_coords.y, vertices[i].texture_coords.y, 4e-3f);
+        EXPECT_EQ(decoded.color, glm::vec3(-1.f));
+    }
+}
+
+TEST(TextureDecoder, HandsEveryImageToTheCallingThread)
+{
+    // binary PPMs are decodable by stb_image and trivial to write
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "kataglyphis_texture_decoder";
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::string> files;
+    for (int i = 0; i < 16; i++) {
+        const int width = 8 + i;
+        const int height = 4 + 2 * i;
+        const std::string file = (directory / ("texture_" + std::to_string(i) + ".ppm")).string();
+        std::ofstream stream(file, std::ios::binary);
+        stream << "P6\n" << width << " " << height << "\n255\n";
+        for (int p = 0; p < width * height; p++) {
+            const char rgb[3] = { static_cast<char>(i), static_cast<char>(p & 0xff), 0 };
+            stream.write(rgb, sizeof(rgb));
+        }
+        files.push_back(file);
+    }
+    files.push_back((directory / "missing.ppm").string());
+
+    Kataglyphis::TextureDecoderSettings settings{};
+    settings.thread_count = 4;
+    Kataglyphis::TextureDecoder decoder(settings);
+
+    const std::thread::id caller = std::this_thread::get_id();
+    std::vector<int> seen(files.size(), 0);
+    decoder.decode(files, [&](size_t file, Kataglyphis::TextureData &data) {
+        EXPECT_EQ(std::this_thread::get_id(), caller);
+        seen[file]++;
+        if (file + 1 == files.size()) {
+            EXPECT_EQ(data.pixels, nullptr);
+            return;
+        }
+        ASSERT_NE(data.pixels, nullptr);
+        EXPECT_EQ(data.width, 8 + static_cast<int>(file));
+        EXPECT_EQ(data.height, 4 + 2 * static_cast<int>(file));
+        EXPECT_EQ(data.pixels.get()[0], static_cast<stbi_uc>(file));
+        EXPECT_EQ(data.pixels.get()[3], 255);
+    });
+
+    for (int count : seen) EXPECT_EQ(count, 1);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(TextureCache, KeysFilesByPathAndImagesByContent)
+{
+    using Kataglyphis::TextureCache;
+
+    // differently spelled paths of one file share a key, as do equal embedded images
+    EXPECT_EQ(TextureCache::fileKey("textures/../textures/wall.png"), TextureCache::fileKey("./textures/wall.png"));
+    EXPECT_NE(TextureCache::fileKey("textures/wall.png"), TextureCache::fileKey("textures/floor.png"));
+
+    const std::vector<std::byte> image(64, std::byte{ 7 });
+    const std::vector<std::byte> copy = image;
+    std::vector<std::byte> other = image;
+    other[10] = std::byte{ 8 };
+    EXPECT_EQ(TextureCache::contentKey(image), TextureCache::contentKey(copy));
+    EXPECT_NE(TextureCache::contentKey(image), TextureCache::contentKey(other));
+    EXPECT_NE(TextureCache::contentKey(image), TextureCache::contentKey(std::span(image).first(32)));
+}
+
+TEST(TextureStreamer, GrantsCoarseLevelsFirstWithinBudget)
+{
+    // a unit quad fully covered by the texture once: one uv unit per object space unit
+    const glm::vec3 normal(0.f, 0.f, 1.f);
+    const std::vector<Vertex> vertices = { Vertex(glm::vec3(0.f), normal, glm::vec3(1.f), glm::vec2(0.f)),
+        Vertex(glm::vec3(1.f, 0.f, 0.f), normal, glm::vec3(1.f), glm::vec2(1.f, 0.f)),
+        Vertex(glm::vec3(1.f, 1.f, 0.f), normal, glm::vec3(1.f), glm::vec2(1.f)),
+        Vertex(glm::vec3(0.f, 1.f, 0.f), normal, glm::vec3(1.f), glm::vec2(0.f, 1.f)) };
+    const std::vector<unsigned int> indices = { 0, 1, 2, 0, 2, 3 };
+    const std::vector<unsigned int> materialIndex = { 0, 0 };
+    const std::vector<int> material_textures = { 0 };
+    const std::vector<Kataglyphis::TextureFootprint> footprints =
+      Kataglyphis::TextureStreamer::computeFootprints(vertices, indices, materialIndex, material_textures, 1);
+    ASSERT_EQ(footprints.size(), 1u);
+    EXPECT_NEAR(footprints[0].uv_density, 1.f, 1e-5f);
+    EXPECT_EQ(footprints[0].bounds_max, glm::vec3(1.f, 1.f, 0.f));
+
+    // 1024 texels seen from 100 units at 1000 pixels per unit at distance 1: ~102 texels per pixel
+    const glm::mat4 model(1.f);
+    EXPECT_EQ(Kataglyphis::TextureStreamer::desiredLevel(footprints[0], 1024, 11, model, glm::vec3(0.5f), 1000.f), 0u);
+    EXPECT_EQ(
+      Kataglyphis::TextureStreamer::desiredLevel(footprints[0], 1024, 11, model, glm::vec3(0.5f, 0.5f, 100.f), 1000.f),
+      6u);
+    EXPECT_EQ(
+      Kataglyphis::TextureStreamer::desiredLevel(footprints[0], 1024, 11, model, glm::vec3(0.f, 0.f, 1e9f), 1000.f),
+      10u);
+
+    Kataglyphis::TextureResidency residency;
+    residency.level_sizes = { 64, 16, 4, 1 };
+    residency.tail_level = 2;
+    residency.wanted_level = 0;
+    residency.resident_level = 2;
+    std::vector<Kataglyphis::TextureResidency> textures = { residency, residency };
+    textures[1].last_wanted_frame = 1;
+
+    // tails (2 * 5) and level 1 of both fit, only the more recently wanted texture gets level 0
+    EXPECT_EQ(Kataglyphis::TextureStreamer::planResidency(textures, 10 + 32 + 64), std::vector<uint32_t>({ 1, 0 }));
+    // not even the tails fit; they stay regardless
+    EXPECT_EQ(Kataglyphis::TextureStreamer::planResidency(textures, 0), std::vector<uint32_t>({ 2, 2 }));
+
+    // nobody wants the fine levels any more; they are kept until the budget is needed
+    textures[0].wanted_level = 2;
+    textures[0].resident_level = 0;
+    textures[1].wanted_level = 2;
+    EXPECT_EQ(Kataglyphis::TextureStreamer::planResidency(textures, 1000), std::vector<uint32_t>({ 0, 2 }));
+    EXPECT_EQ(Kataglyphis::TextureStreamer::planResidency(textures, 10 + 16), std::vector<uint32_t>({ 1, 2 }));
+}
+
+TEST(FrustumCuller, VectorisedJobsMatchScalarTest)
+{
+    using namespace Kataglyphis;
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+    const glm::mat4 view_projection = projection * view;
+    const std::array<glm::vec4, 6> planes = FrustumCuller::frustumPlanes(view_projection);
+
+    // in front of the camera, behind it and beyond the far plane
+    EXPECT_TRUE(FrustumCuller::boxInFrustum(planes, glm::vec3(-1.f, -1.f, -11.f), glm::vec3(1.f, 1.f, -9.f)));
+    EXPECT_FALSE(FrustumCuller::boxInFrustum(planes, glm::vec3(-1.f, -1.f, 9.f), glm::vec3(1.f, 1.f, 11.f)));
+    EXPECT_FALSE(FrustumCuller::boxInFrustum(planes, glm::vec3(-1.f, -1.f, -120.f), glm::vec3(1.f, 1.f, -110.f)));
+
+    // not a multiple of the SIMD width, so every job layout has a scalar tail
+    InstanceBounds bounds;
+    bounds.resize(20003);
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> position(-150.f, 150.f);
+    std::uniform_real_distribution<float> size(0.f, 5.f);
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < bounds.size(); i++) {
+        const glm::vec3 box_min(position(generator), position(generator), position(generator));
+        const glm::vec3 box_max = box_min + glm::vec3(size(generator), size(generator), size(generator));
+        bounds.set(i, box_min, box_max);
+        if (FrustumCuller::boxInFrustum(planes, box_min, box_max)) expected.push_back(i);
+    }
+    ASSERT_FALSE(expected.empty());
+
+    for (uint32_t job_count : { 1u, 3u, 8u }) {
+        FrustumCullSettings settings{};
+        settings.job_count = job_count;
+        settings.min_boxes_per_job = 1000;
+        FrustumCuller culler(settings);
+        std::vector<uint32_t> visible;
+        // twice, so the workers are woken up again
+        culler.cull(bounds, view_projection, visible);
+        culler.cull(bounds, view_projection, visible);
+        EXPECT_EQ(visible, expected) << job_count << " jobs";
+    }
+}
+
+TEST(JobPool, RunsEveryJobOnceAndOnOneThread)
+{
+    using namespace Kataglyphis;
+
+    JobPool pool;
+    // more jobs than cores as well, and repeated so sleeping workers are woken up again
+    for (uint32_t job_count : { 1u, 2u, JobPool::hardwareThreads(), JobPool::hardwareThreads() * 3 + 1 }) {
+        for (int batch = 0; batch < 3; batch++) {
+            std::vector<std::atomic<uint32_t>> runs(job_count);
+            std::vector<std::thread::id> threads(job_count);
+            pool.run(job_count, [&](uint32_t job) {
+                runs[job]++;
+                threads[job] = std::this_thread::get_id();
+            });
+            for (uint32_t job = 0; job < job_count; job++) {
+                EXPECT_EQ(runs[job].load(), 1u) << job << " of " << job_count;
+                EXPECT_NE(threads[job], std::thread::id()) << job << " of " << job_count;
+            }
+        }
+    }
+}
+
+TEST(DepthPyramid, HalvesPowerOfTwoLevelsDownToOneTexel)
+{
+    using Kataglyphis::VulkanRendererInternals::DepthPyramid;
+
+    // level 0 never samples beyond the depth buffer, every further level halves exactly
+    const VkExtent2D extent = DepthPyramid::pyramidExtent({ 1280, 720 });
+    EXPECT_EQ(extent.width, 1024u);
+    EXPECT_EQ(extent.height, 512u);
+    EXPECT_EQ(DepthPyramid::levelCount(extent), 11u);
+
+    const VkExtent2D exact = DepthPyramid::pyramidExtent({ 512, 512 });
+    EXPECT_EQ(exact.width, 512u);
+    EXPECT_EQ(DepthPyramid::levelCount(exact), 10u);
+    EXPECT_EQ(DepthPyramid::levelCount(DepthPyramid::pyramidExtent({ 1, 1 })), 1u);
+}
+
+TEST(Allocator, ClassifiesResourcesIntoPools)
+{
+    using Kataglyphis::Allocator;
+    using Kataglyphis::MemoryClass;
+
+    const VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkMemoryPropertyFlags device_local = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    EXPECT_EQ(Allocator::classify(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, host), MemoryClass::STAGING);
+    // host visibility wins; shader binding tables are written through their mapping
+    EXPECT_EQ(Allocator::classify(VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR, host), MemoryClass::STAGING);
+    EXPECT_EQ(Allocator::classify(VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR, device_local),
+      MemoryClass::ACCELERATION_STRUCTURE);
+    EXPECT_EQ(Allocator::classify(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, device_local),
+      MemoryClass::UNIFORM);
+    EXPECT_EQ(Allocator::classify(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, device_local),
+      MemoryClass::GEOMETRY);
+
+    VkImageCreateInfo image_info{};
+    image_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    EXPECT_EQ(Allocator::classify(image_info), MemoryClass::TEXTURE);
+    image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    EXPECT_EQ(Allocator::classify(image_info), MemoryClass::RENDER_TARGET);
+    image_info.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    EXPECT_EQ(Allocator::classify(image_info), MemoryClass::RENDER_TARGET);
+}
+
+TEST(MemoryStats, HeadroomOnlyCountsDeviceLocalHeaps)
+{
+    Kataglyphis::MemoryStats stats;
+    stats.heaps.push_back({ true, 300, 1000, 0, 0 });
+    // host memory doesn't help the streamer
+    stats.heaps.push_back({ false, 0, 4000, 0, 0 });
+    // over budget; must not wrap around
+    stats.heaps.push_back({ true, 600, 500, 0, 0 });
+    EXPECT_EQ(stats.getDeviceLocalHeadroom(), 700);
+
+    stats.classes[static_cast<size_t>(Kataglyphis::MemoryClass::TEXTURE)] = { 2, 4096 };
+    const std::string json = stats.toJson();
+    EXPECT_NE(json.find("\"texture\""), std::string::npos);
+    EXPECT_NE(json.find("4096"), std::string::npos);
+}
+
 TEST(Integration, VulkanEngine)
 {
   EXPECT_EQ(7 * 6, 42);
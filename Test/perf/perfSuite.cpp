@@ -1,6 +1,27 @@
+#include "scene/FrustumCuller.hpp"
+#include "scene/VertexWelder.hpp"
 #include "vulkan_base/VulkanBuffer.hpp"
 #include <benchmark/benchmark.h>
 
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <unordered_map>
+
+// Sponza-scale corner stream: ~262k triangles, every vertex shared ~5 times
+static std::vector<Vertex> makeWeldInput(size_t corner_count)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<uint32_t> distribution(0, static_cast<uint32_t>(corner_count / 5));
+    std::vector<Vertex> corners;
+    corners.reserve(corner_count);
+    for (size_t i = 0; i < corner_count; i++) {
+        float k = static_cast<float>(distribution(generator));
+        corners.emplace_back(
+          glm::vec3(k, 0.25f * k, -k), glm::vec3(0.f, 1.f, 0.f), glm::vec3(-1.f), glm::vec2(k * 0.001f, 0.5f));
+    }
+    return corners;
+}
+
 
 static void BM_StringCreation(benchmark::State &state)
 {
@@ -17,4 +38,103 @@ static void BM_StringCopy(benchmark::State &state)
 }
 BENCHMARK(BM_StringCopy);
 
-BENCHMARK_MAIN();
\ No newline at end of file
+static void BM_WeldUnorderedMap(benchmark::State &state)
+{
+    std::vector<Vertex> corners = makeWeldInput(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::unordered_map<Vertex, uint32_t> vertices_map{};
+        for (const Vertex &corner : corners) {
+            if (vertices_map.count(corner) == 0) {
+                vertices_map[corner] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(corner);
+            }
+            indices.push_back(vertices_map[corner]);
+        }
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WeldUnorderedMap)->Arg(786432)->Unit(benchmark::kMillisecond);
+
+static void BM_WeldFlatTable(benchmark::State &state)
+{
+    std::vector<Vertex> corners = makeWeldInput(static_cast<size_t>(state.range(0)));
+    Kataglyphis::VertexWeldSettings settings{};
+    settings.shard_count = static_cast<uint32_t>(state.range(1));
+    Kataglyphis::VertexWelder welder(settings);
+    for (auto _ : state) {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        welder.weld(corners, vertices, indices);
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+// shard count 0 uses all cores
+BENCHMARK(BM_WeldFlatTable)->Args({ 786432, 1 })->Args({ 786432, 0 })->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// synthetic city block: unit sized instances scattered around a camera at the origin looking down -z,
+// roughly a quarter of them inside the frustum
+static Kataglyphis::InstanceBounds makeCullInput(size_t instance_count)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> position(-200.f, 200.f);
+    Kataglyphis::InstanceBounds bounds;
+    bounds.resize(instance_count);
+    for (size_t i = 0; i < instance_count; i++) {
+        const glm::vec3 center(position(generator), 0.25f * position(generator), position(generator));
+        bounds.set(i, center - glm::vec3(0.5f), center + glm::vec3(0.5f));
+    }
+    return bounds;
+}
+
+static glm::mat4 makeCullViewProjection()
+{
+    const glm::mat4 projection = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 500.f);
+    return projection * glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+}
+
+static void BM_FrustumCullScalar(benchmark::State &state)
+{
+    const Kataglyphis::InstanceBounds bounds = makeCullInput(static_cast<size_t>(state.range(0)));
+    const std::array<glm::vec4, 6> planes = Kataglyphis::FrustumCuller::frustumPlanes(makeCullViewProjection());
+    std::vector<uint32_t> visible;
+    for (auto _ : state) {
+        visible.clear();
+        for (size_t i = 0; i < bounds.size(); i++) {
+            const glm::vec3 box_min(bounds.min_x[i], bounds.min_y[i], bounds.min_z[i]);
+            const glm::vec3 box_max(bounds.max_x[i], bounds.max_y[i], bounds.max_z[i]);
+            if (Kataglyphis::FrustumCuller::boxInFrustum(planes, box_min, box_max)) {
+                visible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        benchmark::DoNotOptimize(visible.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FrustumCullScalar)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+static void BM_FrustumCull(benchmark::State &state)
+{
+    const Kataglyphis::InstanceBounds bounds = makeCullInput(static_cast<size_t>(state.range(0)));
+    const glm::mat4 view_projection = makeCullViewProjection();
+    Kataglyphis::FrustumCullSettings settings{};
+    settings.job_count = static_cast<uint32_t>(state.range(1));
+    Kataglyphis::FrustumCuller culler(settings);
+    std::vector<uint32_t> visible;
+    for (auto _ : state) {
+        culler.cull(bounds, view_projection, visible);
+        benchmark::DoNotOptimize(visible.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+// job count 0 uses all cores; the frame budget for culling is 0.2 ms
+BENCHMARK(BM_FrustumCull)
+  ->Args({ 100000, 1 })
+  ->Args({ 100000, 0 })
+  ->Unit(benchmark::kMicrosecond)
+  ->UseRealTime();
+
+BENCHMARK_MAIN();